@@ -0,0 +1,234 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       control_pipeline.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Hand-off of timestamped samples from gyro to actuator
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+#include "control_pipeline.h"
+#include "pios_semaphore.h"
+
+/*
+ * Of the three slots of a hand-off, one is the latest published, one is
+ * held by the reader (often the same one) and the writer fills one that is
+ * neither.
+ */
+#define NUM_SLOTS 3
+
+//! Which slot is where in a hand-off
+struct slot_state {
+	volatile uint8_t current;	//!< latest published
+	volatile uint8_t held;		//!< in use by the reader
+	uint8_t claimed;		//!< being filled by the writer
+};
+
+// Private variables
+static struct control_pipeline_gyro gyro_slots[NUM_SLOTS];
+static struct slot_state gyro_state;
+static struct pios_semaphore *gyro_sem;
+static volatile bool gyro_producer;
+
+static struct control_pipeline_actuator actuator_slots[NUM_SLOTS];
+static struct slot_state actuator_state;
+static struct pios_semaphore *actuator_sem;
+
+static volatile bool direct;
+
+/**
+ * Pick the slot for the writer to fill: neither the latest one nor the one
+ * the reader holds.  Only the writer changes current, and the reader only
+ * ever sets held to a value current had, so this choice stays safe until
+ * the slot is published.
+ */
+static uint8_t slot_claim(struct slot_state *state)
+{
+	uint8_t slot = 0;
+
+	while (slot == state->current || slot == state->held)
+		slot++;
+
+	state->claimed = slot;
+
+	return slot;
+}
+
+/**
+ * Make the claimed slot the latest one, after its contents.
+ */
+static void slot_publish(struct slot_state *state)
+{
+	__sync_synchronize();
+	state->current = state->claimed;
+}
+
+/**
+ * Take the latest slot for the reader.  If the writer published while
+ * held was being set, it may have claimed the slot just read, so try again
+ * with the newer one; once held matches current, no later claim picks it.
+ */
+static uint8_t slot_take(struct slot_state *state)
+{
+	uint8_t slot;
+
+	do {
+		slot = state->current;
+		state->held = slot;
+		__sync_synchronize();
+	} while (state->current != slot);
+
+	return slot;
+}
+
+/**
+ * Create the wakeup semaphores.  Called from the initialization of each
+ * module taking part; those run one after the other before the scheduler
+ * starts, so only the first call does anything.
+ * @return 0 if successful, -1 if not
+ */
+int32_t control_pipeline_initialize(void)
+{
+	if (gyro_sem == NULL)
+		gyro_sem = PIOS_Semaphore_Create();
+
+	if (actuator_sem == NULL)
+		actuator_sem = PIOS_Semaphore_Create();
+
+	if (gyro_sem == NULL || actuator_sem == NULL)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Select whether the stages are woken from the pipeline (direct) or from
+ * their UAVO queues.  Either way the slots keep being filled, so the
+ * latency stays measurable in both modes.
+ */
+void control_pipeline_set_direct(bool enable)
+{
+	direct = enable;
+}
+
+bool control_pipeline_is_direct(void)
+{
+	return direct;
+}
+
+/**
+ * Get the gyro slot to fill next.  This is never the one readers see.
+ */
+struct control_pipeline_gyro *control_pipeline_gyro_claim(void)
+{
+	return &gyro_slots[slot_claim(&gyro_state)];
+}
+
+/**
+ * Make the claimed gyro slot the latest one and, in direct mode, wake
+ * stabilization.
+ */
+void control_pipeline_gyro_publish(void)
+{
+	PIOS_Assert(gyro_sem);
+
+	slot_publish(&gyro_state);
+	gyro_producer = true;
+
+	if (direct)
+		PIOS_Semaphore_Give(gyro_sem);
+}
+
+/**
+ * Whether the gyros come through the pipeline at all.  The simulated
+ * sensors and some attitude modules only set the Gyros UAVO, in which
+ * case stabilization has to keep waiting on that.
+ */
+bool control_pipeline_has_gyro(void)
+{
+	return gyro_producer;
+}
+
+const struct control_pipeline_gyro *control_pipeline_gyro_latest(void)
+{
+	return &gyro_slots[slot_take(&gyro_state)];
+}
+
+/**
+ * Wait for the next gyro sample in direct mode.
+ * @param[in] timeout_ms how long to wait
+ * @return the latest sample, or NULL on timeout
+ */
+const struct control_pipeline_gyro *control_pipeline_gyro_wait(uint32_t timeout_ms)
+{
+	PIOS_Assert(gyro_sem);
+
+	if (!PIOS_Semaphore_Take(gyro_sem, timeout_ms))
+		return NULL;
+
+	return &gyro_slots[slot_take(&gyro_state)];
+}
+
+/**
+ * Get the actuator slot to fill next.  This is never the one readers see.
+ */
+struct control_pipeline_actuator *control_pipeline_actuator_claim(void)
+{
+	return &actuator_slots[slot_claim(&actuator_state)];
+}
+
+/**
+ * Make the claimed actuator slot the latest one and, in direct mode, wake
+ * the actuator.
+ */
+void control_pipeline_actuator_publish(void)
+{
+	PIOS_Assert(actuator_sem);
+
+	slot_publish(&actuator_state);
+
+	if (direct)
+		PIOS_Semaphore_Give(actuator_sem);
+}
+
+const struct control_pipeline_actuator *control_pipeline_actuator_latest(void)
+{
+	return &actuator_slots[slot_take(&actuator_state)];
+}
+
+/**
+ * Wait for the next actuator command in direct mode.
+ * @param[in] timeout_ms how long to wait
+ * @return the latest command, or NULL on timeout
+ */
+const struct control_pipeline_actuator *control_pipeline_actuator_wait(uint32_t timeout_ms)
+{
+	PIOS_Assert(actuator_sem);
+
+	if (!PIOS_Semaphore_Take(actuator_sem, timeout_ms))
+		return NULL;
+
+	return &actuator_slots[slot_take(&actuator_state)];
+}
+
+/**
+ * @}
+ */
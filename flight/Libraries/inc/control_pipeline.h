@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       control_pipeline.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Hand-off of timestamped samples from gyro to actuator
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef CONTROL_PIPELINE_H
+#define CONTROL_PIPELINE_H
+
+#include "actuatordesired.h"
+
+/**
+ * The control modules always publish Gyros and ActuatorDesired as
+ * UAVOs.  Alongside that they fill the triple buffered slots below, which
+ * carry the time the gyro sample was read down to the actuator.  In
+ * direct mode the next stage is also woken straight from the slot, so it
+ * neither waits for the UAVO event dispatch nor copies the object out of
+ * the object manager.
+ *
+ * Each hand-off has a single reader, which may keep using the slot it got
+ * from _latest() or _wait() until it asks for the next one.  The writer
+ * never fills that slot, whatever the relative priorities of the tasks.
+ */
+
+//! A gyro sample as published by the sensors module
+struct control_pipeline_gyro {
+	float x;		//!< deg/s, calibrated and rotated as in Gyros
+	float y;
+	float z;
+	float temperature;
+	uint32_t timestamp;	//!< PIOS_DELAY_GetRaw() when the sample was read
+};
+
+//! An actuator command as published by stabilization
+struct control_pipeline_actuator {
+	ActuatorDesiredData desired;
+	uint32_t timestamp;	//!< timestamp of the gyro sample it was made from
+	float stabilization_latency;	//!< us from the gyro sample to stabilization starting on it
+};
+
+int32_t control_pipeline_initialize(void);
+
+void control_pipeline_set_direct(bool direct);
+bool control_pipeline_is_direct(void);
+
+struct control_pipeline_gyro *control_pipeline_gyro_claim(void);
+void control_pipeline_gyro_publish(void);
+bool control_pipeline_has_gyro(void);
+const struct control_pipeline_gyro *control_pipeline_gyro_latest(void);
+const struct control_pipeline_gyro *control_pipeline_gyro_wait(uint32_t timeout_ms);
+
+struct control_pipeline_actuator *control_pipeline_actuator_claim(void);
+void control_pipeline_actuator_publish(void);
+const struct control_pipeline_actuator *control_pipeline_actuator_latest(void);
+const struct control_pipeline_actuator *control_pipeline_actuator_wait(uint32_t timeout_ms);
+
+#endif /* CONTROL_PIPELINE_H */
+
+/**
+ * @}
+ */
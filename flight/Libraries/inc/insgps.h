@@ -30,6 +30,7 @@
 #ifndef INSGPS_H_
 #define INSGPS_H_
 
+#include "stddef.h"
 #include "stdint.h"
 #include "stdbool.h"
 
@@ -93,6 +94,45 @@ void INSGetVariance(float *p);
 
 uint16_t ins_get_num_states();
 
+/****************************************************/
+/**  Running several independent filters           **/
+/****************************************************/
+
+/*
+ * The calls above run the filter kept inside the library, which is
+ * what the flight code uses. The calls below do the same work on
+ * storage owned by the caller, so a host can keep any number of
+ * filters and step them from different threads. The storage must be
+ * INSGetInstanceSize() bytes and set up with insgps_init(). Only
+ * provided by the 14 state filter.
+ */
+
+//! Opaque storage for the complete state of one filter
+struct insgps_instance;
+
+//! Size in bytes of the storage for one filter instance
+size_t INSGetInstanceSize();
+
+void insgps_init(struct insgps_instance *ins);
+void insgps_state_prediction(struct insgps_instance *ins, const float gyro_data[3], const float accel_data[3], float dT);
+void insgps_covariance_prediction(struct insgps_instance *ins, float dT);
+void insgps_correction(struct insgps_instance *ins, const float mag_data[3], const float Pos[3], const float Vel[3], float BaroAlt, uint16_t SensorsUsed);
+void insgps_get_state(struct insgps_instance *ins, float *pos, float *vel, float *attitude, float *gyro_bias, float *accel_bias);
+void insgps_get_variance(struct insgps_instance *ins, float *p);
+void insgps_set_armed(struct insgps_instance *ins, bool armed);
+
+void insgps_reset_p(struct insgps_instance *ins, const float *PDiag);
+void insgps_set_state(struct insgps_instance *ins, const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3]);
+void insgps_set_pos_vel_var(struct insgps_instance *ins, float PosVar, float VelVar, float VertPosVar);
+void insgps_set_gyro_bias(struct insgps_instance *ins, const float gyro_bias[3]);
+void insgps_set_accel_bias(struct insgps_instance *ins, const float accel_bias[3]);
+void insgps_set_accel_var(struct insgps_instance *ins, const float accel_var[3]);
+void insgps_set_gyro_var(struct insgps_instance *ins, const float gyro_var[3]);
+void insgps_set_mag_north(struct insgps_instance *ins, const float B[3]);
+void insgps_set_mag_var(struct insgps_instance *ins, const float scaled_mag_var[3]);
+void insgps_set_baro_var(struct insgps_instance *ins, float baro_var);
+void insgps_pos_vel_reset(struct insgps_instance *ins, const float pos[3], const float vel[3]);
+
 #endif /* INSGPS_H_ */
 
 /**
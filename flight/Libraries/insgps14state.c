@@ -33,6 +33,7 @@
 #include "insgps.h"
 #include "physical_constants.h"
 #include <math.h>
+#include <stddef.h>
 #include <stdint.h>
 
 // constants/macros/typdefs
@@ -52,7 +53,7 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 			  float Q[NUMW], float dT, float P[NUMX][NUMX]);
 void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
-		  uint16_t SensorsUsed);
+		  float K[NUMX][NUMV], uint16_t SensorsUsed);
 void RungeKutta(float X[NUMX], float U[NUMU], float dT);
 void StateEq(float X[NUMX], float U[NUMU], float Xdot[NUMX]);
 void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
@@ -60,13 +61,18 @@ void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
 void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
 void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
 
+//! Complete state of one filter instance
+struct insgps_instance {
+	float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
+														// kept in the instance to maintain zero elements
+	float Be[3];			// local magnetic unit vector in NED frame
+	float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
+	float Q[NUMW], R[NUMV];		// input noise and measurement noise variances
+	float K[NUMX][NUMV];		// feedback gain matrix
+};
+
 // Private variables
-float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
-													// global to init to zero and maintain zero elements
-float Be[3];			// local magnetic unit vector in NED frame
-float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
-float Q[NUMW], R[NUMV];		// input noise and measurement noise variances
-float K[NUMX][NUMV];		// feedback gain matrix
+static struct insgps_instance ins_default;	// instance used by the flight code
 
 //  *************  Exposed Functions ****************
 //  *************************************************
@@ -76,69 +82,74 @@ uint16_t ins_get_num_states()
 	return NUMX;
 }
 
-void INSGPSInit()		//pretty much just a place holder for now
+size_t INSGetInstanceSize()
+{
+	return sizeof(struct insgps_instance);
+}
+
+void insgps_init(struct insgps_instance *ins)		//pretty much just a place holder for now
 {
-	Be[0] = 1.0f;
-	Be[1] = 0;
-	Be[2] = 0;		// local magnetic unit vector
+	ins->Be[0] = 1.0f;
+	ins->Be[1] = 0;
+	ins->Be[2] = 0;		// local magnetic unit vector
 
 	for (int i = 0; i < NUMX; i++) {
 		for (int j = 0; j < NUMX; j++) {
-			P[i][j] = 0.0f; // zero all terms
-			F[i][j] = 0.0f;
+			ins->P[i][j] = 0.0f; // zero all terms
+			ins->F[i][j] = 0.0f;
 		}
 		for (int j = 0; j < NUMW; j++)
-			G[i][j] = 0.0f;
+			ins->G[i][j] = 0.0f;
 			
 		for (int j = 0; j < NUMV; j++) {
-			H[j][i] = 0.0f;
-			K[i][j] = 0.0f;
+			ins->H[j][i] = 0.0f;
+			ins->K[i][j] = 0.0f;
 		}
 			
-		X[i] = 0.0f;
+		ins->X[i] = 0.0f;
 	}
 	for (int i = 0; i < NUMW; i++)
-		Q[i] = 0.0f;
+		ins->Q[i] = 0.0f;
 	for (int i = 0; i < NUMV; i++) 
-		R[i] = 0.0f;
+		ins->R[i] = 0.0f;
 	
-	P[0][0] = P[1][1] = P[2][2] = 25.0f;	// initial position variance (m^2)
-	P[3][3] = P[4][4] = P[5][5] = 5.0f;	// initial velocity variance (m/s)^2
-	P[6][6] = P[7][7] = P[8][8] = P[9][9] = 1e-5f;	// initial quaternion variance
-	P[10][10] = P[11][11] = P[12][12] = 1e-6f;	// initial gyro bias variance (rad/s)^2
-	P[13][13] = 1e-5f;	                        // initial accel bias variance (deg/s)^2
-
-	X[0] = X[1] = X[2] = X[3] = X[4] = X[5] = 0.0f;	// initial pos and vel (m)
-	X[6] = 1.0f;
-	X[7] = X[8] = X[9] = 0.0f;	    // initial quaternion (level and North) (m/s)
-	X[10] = X[11] = X[12] = 0.0f;	// initial gyro bias (rad/s)
-	X[13] = 0.0f;                   // initial accel bias
-
-	Q[0] = Q[1] = Q[2] = 1e-5f;	    // gyro noise variance (rad/s)^2
-	Q[3] = Q[4] = Q[5] = 1e-5f;	    // accelerometer noise variance (m/s^2)^2
-	Q[6] = Q[7]        = 1e-6f;	    // gyro x and y bias random walk variance (rad/s^2)^2
-	Q[8]               = 1e-6f;	    // gyro z bias random walk variance (rad/s^2)^2
-	Q[9] = 5e-4f;	                // accel bias random walk variance (m/s^3)^2
-
-	R[0] = R[1] = 0.004f;	// High freq GPS horizontal position noise variance (m^2)
-	R[2] = 0.036f;		// High freq GPS vertical position noise variance (m^2)
-	R[3] = R[4] = 0.004f;	// High freq GPS horizontal velocity noise variance (m/s)^2
-	R[5] = 0.004f;		// High freq GPS vertical velocity noise variance (m/s)^2
-	R[6] = R[7] = R[8] = 0.005f;	// magnetometer unit vector noise variance
-	R[9] = .05f;		// High freq altimeter noise variance (m^2)
+	ins->P[0][0] = ins->P[1][1] = ins->P[2][2] = 25.0f;	// initial position variance (m^2)
+	ins->P[3][3] = ins->P[4][4] = ins->P[5][5] = 5.0f;	// initial velocity variance (m/s)^2
+	ins->P[6][6] = ins->P[7][7] = ins->P[8][8] = ins->P[9][9] = 1e-5f;	// initial quaternion variance
+	ins->P[10][10] = ins->P[11][11] = ins->P[12][12] = 1e-6f;	// initial gyro bias variance (rad/s)^2
+	ins->P[13][13] = 1e-5f;	                        // initial accel bias variance (deg/s)^2
+
+	ins->X[0] = ins->X[1] = ins->X[2] = ins->X[3] = ins->X[4] = ins->X[5] = 0.0f;	// initial pos and vel (m)
+	ins->X[6] = 1.0f;
+	ins->X[7] = ins->X[8] = ins->X[9] = 0.0f;	    // initial quaternion (level and North) (m/s)
+	ins->X[10] = ins->X[11] = ins->X[12] = 0.0f;	// initial gyro bias (rad/s)
+	ins->X[13] = 0.0f;                   // initial accel bias
+
+	ins->Q[0] = ins->Q[1] = ins->Q[2] = 1e-5f;	    // gyro noise variance (rad/s)^2
+	ins->Q[3] = ins->Q[4] = ins->Q[5] = 1e-5f;	    // accelerometer noise variance (m/s^2)^2
+	ins->Q[6] = ins->Q[7]        = 1e-6f;	    // gyro x and y bias random walk variance (rad/s^2)^2
+	ins->Q[8]               = 1e-6f;	    // gyro z bias random walk variance (rad/s^2)^2
+	ins->Q[9] = 5e-4f;	                // accel bias random walk variance (m/s^3)^2
+
+	ins->R[0] = ins->R[1] = 0.004f;	// High freq GPS horizontal position noise variance (m^2)
+	ins->R[2] = 0.036f;		// High freq GPS vertical position noise variance (m^2)
+	ins->R[3] = ins->R[4] = 0.004f;	// High freq GPS horizontal velocity noise variance (m/s)^2
+	ins->R[5] = 0.004f;		// High freq GPS vertical velocity noise variance (m/s)^2
+	ins->R[6] = ins->R[7] = ins->R[8] = 0.005f;	// magnetometer unit vector noise variance
+	ins->R[9] = .05f;		// High freq altimeter noise variance (m^2)
 }
 
 //! Set the current flight state
-void INSSetArmed(bool armed)
+void insgps_set_armed(struct insgps_instance *ins, bool armed)
 {
 	return; 
 	// Speed up convergence of accel and gyro bias when not armed
 	if (armed) {
-		Q[9] = 1e-4f;
-		Q[8] = 2e-9f;
+		ins->Q[9] = 1e-4f;
+		ins->Q[8] = 2e-9f;
 	} else {
-		Q[9] = 1e-2f;
-		Q[8] = 2e-8f;
+		ins->Q[9] = 1e-2f;
+		ins->Q[8] = 2e-8f;
 	}
 }
 
@@ -150,37 +161,37 @@ void INSSetArmed(bool armed)
  * @param[out] gyros_bias Estimate of gyro bias (rad/s)
  * @param[out] accel_bias Estiamte of the accel bias (m/s^2)
  */
-void INSGetState(float *pos, float *vel, float *attitude, float *gyro_bias, float *accel_bias)
+void insgps_get_state(struct insgps_instance *ins, float *pos, float *vel, float *attitude, float *gyro_bias, float *accel_bias)
 {
        if (pos) {
-               pos[0] = X[0];
-               pos[1] = X[1];
-               pos[2] = X[2];
+               pos[0] = ins->X[0];
+               pos[1] = ins->X[1];
+               pos[2] = ins->X[2];
        }
 
        if (vel) {
-               vel[0] = X[3];
-               vel[1] = X[4];
-               vel[2] = X[5];
+               vel[0] = ins->X[3];
+               vel[1] = ins->X[4];
+               vel[2] = ins->X[5];
        }
 
        if (attitude) {
-               attitude[0] = X[6];
-               attitude[1] = X[7];
-               attitude[2] = X[8];
-               attitude[3] = X[9];
+               attitude[0] = ins->X[6];
+               attitude[1] = ins->X[7];
+               attitude[2] = ins->X[8];
+               attitude[3] = ins->X[9];
        }
 
        if (gyro_bias) {
-               gyro_bias[0] = X[10];
-               gyro_bias[1] = X[11];
-               gyro_bias[2] = X[12];
+               gyro_bias[0] = ins->X[10];
+               gyro_bias[1] = ins->X[11];
+               gyro_bias[2] = ins->X[12];
        }
 
        if (accel_bias) {
        			accel_bias[0] = 0.0f;
        			accel_bias[1] = 0.0f;
-				accel_bias[2] = X[13];
+				accel_bias[2] = ins->X[13];
        }
 }
 
@@ -188,13 +199,13 @@ void INSGetState(float *pos, float *vel, float *attitude, float *gyro_bias, floa
  * Get the variance, for visualizing the filter performance
  * @param[out var_out The variances
  */
-void INSGetVariance(float *var_out)
+void insgps_get_variance(struct insgps_instance *ins, float *var_out)
  {
    for (uint32_t i = 0; i < NUMX; i++)
-           var_out[i] = P[i][i];
+           var_out[i] = ins->P[i][i];
  }
  
-void INSResetP(const float *PDiag)
+void insgps_reset_p(struct insgps_instance *ins, const float *PDiag)
 {
 	uint8_t i,j;
 
@@ -202,106 +213,106 @@ void INSResetP(const float *PDiag)
 	for (i=0;i<NUMX;i++){
 		if (PDiag != 0){
 			for (j=0;j<NUMX;j++)
-				P[i][j]=P[j][i]=0.0f;
-			P[i][i]=PDiag[i];
+				ins->P[i][j]=ins->P[j][i]=0.0f;
+			ins->P[i][i]=PDiag[i];
 		}
 	}
 }
 
-void INSSetState(const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3])
+void insgps_set_state(struct insgps_instance *ins, const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3])
 {
-	X[0] = pos[0];
-	X[1] = pos[1];
-	X[2] = pos[2];
-	X[3] = vel[0];
-	X[4] = vel[1];
-	X[5] = vel[2];
-	X[6] = q[0];
-	X[7] = q[1];
-	X[8] = q[2];
-	X[9] = q[3];
-	X[10] = gyro_bias[0];
-	X[11] = gyro_bias[1];
-	X[12] = gyro_bias[2];
-	X[13] = accel_bias[2];
+	ins->X[0] = pos[0];
+	ins->X[1] = pos[1];
+	ins->X[2] = pos[2];
+	ins->X[3] = vel[0];
+	ins->X[4] = vel[1];
+	ins->X[5] = vel[2];
+	ins->X[6] = q[0];
+	ins->X[7] = q[1];
+	ins->X[8] = q[2];
+	ins->X[9] = q[3];
+	ins->X[10] = gyro_bias[0];
+	ins->X[11] = gyro_bias[1];
+	ins->X[12] = gyro_bias[2];
+	ins->X[13] = accel_bias[2];
 }
 
-void INSPosVelReset(const float pos[3], const float vel[3]) 
+void insgps_pos_vel_reset(struct insgps_instance *ins, const float pos[3], const float vel[3]) 
 {
 	for (int i = 0; i < 6; i++) {
 		for(int j = i; j < NUMX; j++) {
-			P[i][j] = 0.0f;  // zero the first 6 rows and columns
-			P[j][i] = 0.0f; 
+			ins->P[i][j] = 0.0f;  // zero the first 6 rows and columns
+			ins->P[j][i] = 0.0f; 
 		}
 	}
 	
-	P[0][0] = P[1][1] = P[2][2] = 25.0f;	// initial position variance (m^2)
-	P[3][3] = P[4][4] = P[5][5] = 5.0f;	// initial velocity variance (m/s)^2
+	ins->P[0][0] = ins->P[1][1] = ins->P[2][2] = 25.0f;	// initial position variance (m^2)
+	ins->P[3][3] = ins->P[4][4] = ins->P[5][5] = 5.0f;	// initial velocity variance (m/s)^2
 	
-	X[0] = pos[0];
-	X[1] = pos[1];
-	X[2] = pos[2];
-	X[3] = vel[0];
-	X[4] = vel[1];
-	X[5] = vel[2];	
+	ins->X[0] = pos[0];
+	ins->X[1] = pos[1];
+	ins->X[2] = pos[2];
+	ins->X[3] = vel[0];
+	ins->X[4] = vel[1];
+	ins->X[5] = vel[2];	
 }
 
-void INSSetPosVelVar(float PosVar, float VelVar, float VertPosVar)
+void insgps_set_pos_vel_var(struct insgps_instance *ins, float PosVar, float VelVar, float VertPosVar)
 {
-	R[0] = PosVar;
-	R[1] = PosVar;
-	R[2] = VertPosVar;
-	R[3] = VelVar;
-	R[4] = VelVar;
-	R[5] = VelVar;  // Don't change vertical velocity, not measured
+	ins->R[0] = PosVar;
+	ins->R[1] = PosVar;
+	ins->R[2] = VertPosVar;
+	ins->R[3] = VelVar;
+	ins->R[4] = VelVar;
+	ins->R[5] = VelVar;  // Don't change vertical velocity, not measured
 }
 
-void INSSetGyroBias(const float gyro_bias[3])
+void insgps_set_gyro_bias(struct insgps_instance *ins, const float gyro_bias[3])
 {
-	X[10] = gyro_bias[0];
-	X[11] = gyro_bias[1];
-	X[12] = gyro_bias[2];
+	ins->X[10] = gyro_bias[0];
+	ins->X[11] = gyro_bias[1];
+	ins->X[12] = gyro_bias[2];
 }
 
-void INSSetAccelBias(const float accel_bias[3])
+void insgps_set_accel_bias(struct insgps_instance *ins, const float accel_bias[3])
 {
-	X[13] = accel_bias[2];
+	ins->X[13] = accel_bias[2];
 }
 
-void INSSetAccelVar(const float accel_var[3])
+void insgps_set_accel_var(struct insgps_instance *ins, const float accel_var[3])
 {
-	Q[3] = accel_var[0];
-	Q[4] = accel_var[1];
-	Q[5] = accel_var[2];
+	ins->Q[3] = accel_var[0];
+	ins->Q[4] = accel_var[1];
+	ins->Q[5] = accel_var[2];
 }
 
-void INSSetGyroVar(const float gyro_var[3])
+void insgps_set_gyro_var(struct insgps_instance *ins, const float gyro_var[3])
 {
-	Q[0] = gyro_var[0];
-	Q[1] = gyro_var[1];
-	Q[2] = gyro_var[2];
+	ins->Q[0] = gyro_var[0];
+	ins->Q[1] = gyro_var[1];
+	ins->Q[2] = gyro_var[2];
 }
 
-void INSSetMagVar(const float scaled_mag_var[3])
+void insgps_set_mag_var(struct insgps_instance *ins, const float scaled_mag_var[3])
 {
-	R[6] = scaled_mag_var[0];
-	R[7] = scaled_mag_var[1];
-	R[8] = scaled_mag_var[2];
+	ins->R[6] = scaled_mag_var[0];
+	ins->R[7] = scaled_mag_var[1];
+	ins->R[8] = scaled_mag_var[2];
 }
 
-void INSSetBaroVar(const float baro_var)
+void insgps_set_baro_var(struct insgps_instance *ins, const float baro_var)
 {
-	R[9] = baro_var;
+	ins->R[9] = baro_var;
 }
 
-void INSSetMagNorth(const float B[3])
+void insgps_set_mag_north(struct insgps_instance *ins, const float B[3])
 {
-	Be[0] = B[0];
-	Be[1] = B[1];
-	Be[2] = B[2];
+	ins->Be[0] = B[0];
+	ins->Be[1] = B[1];
+	ins->Be[2] = B[2];
 }
 
-void INSLimitBias()
+static void insgps_limit_bias(float X[NUMX])
 {
 	// The Z accel bias should never wander too much. This helps ensure the filter
 	// remains stable.
@@ -322,7 +333,7 @@ void INSLimitBias()
 	}
 }
 
-void INSStatePrediction(const float gyro_data[3], const float accel_data[3], float dT)
+void insgps_state_prediction(struct insgps_instance *ins, const float gyro_data[3], const float accel_data[3], float dT)
 {
 	float U[6];
 	float qmag;
@@ -338,21 +349,21 @@ void INSStatePrediction(const float gyro_data[3], const float accel_data[3], flo
 	U[5] = accel_data[2];
 
 	// EKF prediction step
-	LinearizeFG(X, U, F, G);
-	RungeKutta(X, U, dT);
-	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
-	X[6] /= qmag;
-	X[7] /= qmag;
-	X[8] /= qmag;
-	X[9] /= qmag;
+	LinearizeFG(ins->X, U, ins->F, ins->G);
+	RungeKutta(ins->X, U, dT);
+	qmag = sqrtf(ins->X[6] * ins->X[6] + ins->X[7] * ins->X[7] + ins->X[8] * ins->X[8] + ins->X[9] * ins->X[9]);
+	ins->X[6] /= qmag;
+	ins->X[7] /= qmag;
+	ins->X[8] /= qmag;
+	ins->X[9] /= qmag;
 }
 
-void INSCovariancePrediction(float dT)
+void insgps_covariance_prediction(struct insgps_instance *ins, float dT)
 {
-	CovariancePrediction(F, G, Q, dT, P);
+	CovariancePrediction(ins->F, ins->G, ins->Q, dT, ins->P);
 }
 
-void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3],
+void insgps_correction(struct insgps_instance *ins, const float mag_data[3], const float Pos[3], const float Vel[3],
 		   float BaroAlt, uint16_t SensorsUsed)
 {
 	float Z[10], Y[10];
@@ -371,10 +382,10 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 	if (SensorsUsed & MAG_SENSORS) {
 		// magnetometer data in any units (use unit vector) and in body frame
 		float Rbe_a[3][3];
-		float q0 = X[6];
-		float q1 = X[7];
-		float q2 = X[8];
-		float q3 = X[9];
+		float q0 = ins->X[6];
+		float q1 = ins->X[7];
+		float q2 = ins->X[8];
+		float q3 = ins->X[9];
 		float k1 = 1.0f/sqrtf(powf(q0*q1*2.0f+q2*q3*2.0f,2.0f)+powf(q0*q0-q1*q1-q2*q2+q3*q3,2.0f));
 		float k2 = sqrtf(-powf(q0*q2*2.0f-q1*q3*2.0f,2.0f)+1.0f);
 
@@ -397,16 +408,111 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 	Z[9] = BaroAlt;
 
 	// EKF correction step
-	LinearizeH(X, Be, H);
-	MeasurementEq(X, Be, Y);
-	SerialUpdate(H, R, Z, Y, P, X, SensorsUsed);
-	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
-	X[6] /= qmag;
-	X[7] /= qmag;
-	X[8] /= qmag;
-	X[9] /= qmag;
+	LinearizeH(ins->X, ins->Be, ins->H);
+	MeasurementEq(ins->X, ins->Be, Y);
+	SerialUpdate(ins->H, ins->R, Z, Y, ins->P, ins->X, ins->K, SensorsUsed);
+	qmag = sqrtf(ins->X[6] * ins->X[6] + ins->X[7] * ins->X[7] + ins->X[8] * ins->X[8] + ins->X[9] * ins->X[9]);
+	ins->X[6] /= qmag;
+	ins->X[7] /= qmag;
+	ins->X[8] /= qmag;
+	ins->X[9] /= qmag;
+
+	insgps_limit_bias(ins->X);
+}
+
+//  *************  Default instance ****************
+//  The INS* calls used by the flight code run the filter in ins_default
+//  *************************************************
+
+void INSGPSInit()
+{
+	insgps_init(&ins_default);
+}
+
+void INSSetArmed(bool armed)
+{
+	insgps_set_armed(&ins_default, armed);
+}
+
+void INSGetState(float *pos, float *vel, float *attitude, float *gyro_bias, float *accel_bias)
+{
+	insgps_get_state(&ins_default, pos, vel, attitude, gyro_bias, accel_bias);
+}
+
+void INSGetVariance(float *var_out)
+{
+	insgps_get_variance(&ins_default, var_out);
+}
+
+void INSResetP(const float *PDiag)
+{
+	insgps_reset_p(&ins_default, PDiag);
+}
+
+void INSSetState(const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3])
+{
+	insgps_set_state(&ins_default, pos, vel, q, gyro_bias, accel_bias);
+}
 
-	INSLimitBias();
+void INSPosVelReset(const float pos[3], const float vel[3])
+{
+	insgps_pos_vel_reset(&ins_default, pos, vel);
+}
+
+void INSSetPosVelVar(float PosVar, float VelVar, float VertPosVar)
+{
+	insgps_set_pos_vel_var(&ins_default, PosVar, VelVar, VertPosVar);
+}
+
+void INSSetGyroBias(const float gyro_bias[3])
+{
+	insgps_set_gyro_bias(&ins_default, gyro_bias);
+}
+
+void INSSetAccelBias(const float accel_bias[3])
+{
+	insgps_set_accel_bias(&ins_default, accel_bias);
+}
+
+void INSSetAccelVar(const float accel_var[3])
+{
+	insgps_set_accel_var(&ins_default, accel_var);
+}
+
+void INSSetGyroVar(const float gyro_var[3])
+{
+	insgps_set_gyro_var(&ins_default, gyro_var);
+}
+
+void INSSetMagVar(const float scaled_mag_var[3])
+{
+	insgps_set_mag_var(&ins_default, scaled_mag_var);
+}
+
+void INSSetBaroVar(const float baro_var)
+{
+	insgps_set_baro_var(&ins_default, baro_var);
+}
+
+void INSSetMagNorth(const float B[3])
+{
+	insgps_set_mag_north(&ins_default, B);
+}
+
+void INSStatePrediction(const float gyro_data[3], const float accel_data[3], float dT)
+{
+	insgps_state_prediction(&ins_default, gyro_data, accel_data, dT);
+}
+
+void INSCovariancePrediction(float dT)
+{
+	insgps_covariance_prediction(&ins_default, dT);
+}
+
+void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3],
+		   float BaroAlt, uint16_t SensorsUsed)
+{
+	insgps_correction(&ins_default, mag_data, Pos, Vel, BaroAlt, SensorsUsed);
 }
 
 //  *************  CovariancePrediction *************
@@ -594,7 +700,7 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 
 void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
-		  uint16_t SensorsUsed)
+		  float K[NUMX][NUMV], uint16_t SensorsUsed)
 {
 	float HP[NUMX], HPHR, Error;
 	uint8_t i, j, k, m;
@@ -630,7 +736,7 @@ void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		}
 	}
 
-	INSLimitBias();
+	insgps_limit_bias(X);
 }
 
 //  *************  RungeKutta **********************
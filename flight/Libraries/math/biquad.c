@@ -0,0 +1,168 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       biquad.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Second order IIR (biquad) filters
+ *
+ * Coefficients follow the RBJ audio EQ cookbook. Changing the coefficients
+ * keeps the filter state, so a notch can be retuned while running without
+ * a transient from resetting it.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include "biquad.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * Check that a frequency can be represented at a sample rate
+ */
+static bool frequency_valid(float sample_rate, float freq, float q)
+{
+	return sample_rate > 0 && freq > 0 && freq < 0.5f * sample_rate && q > 0;
+}
+
+/**
+ * Make the filter pass its input through unchanged
+ * @param[in] bq The filter
+ */
+void biquad_set_passthrough(struct biquad *bq)
+{
+	bq->b0 = 1;
+	bq->b1 = 0;
+	bq->b2 = 0;
+	bq->a1 = 0;
+	bq->a2 = 0;
+}
+
+/**
+ * Configure a second order low pass
+ * @param[in] bq The filter
+ * @param[in] sample_rate The rate the filter is applied at [Hz]
+ * @param[in] cutoff The -3 dB frequency for a Butterworth Q [Hz]
+ * @param[in] q The quality factor, @ref BIQUAD_Q_BUTTERWORTH for no peaking
+ * @returns true if configured, false if the parameters were invalid and the
+ * filter is now a passthrough
+ */
+bool biquad_set_lowpass(struct biquad *bq, float sample_rate, float cutoff, float q)
+{
+	if (!frequency_valid(sample_rate, cutoff, q)) {
+		biquad_set_passthrough(bq);
+		return false;
+	}
+
+	float w0 = 2 * (float) M_PI * cutoff / sample_rate;
+	float cs = cosf(w0);
+	float alpha = sinf(w0) / (2 * q);
+	float a0_inv = 1 / (1 + alpha);
+
+	bq->b0 = (1 - cs) * 0.5f * a0_inv;
+	bq->b1 = (1 - cs) * a0_inv;
+	bq->b2 = bq->b0;
+	bq->a1 = -2 * cs * a0_inv;
+	bq->a2 = (1 - alpha) * a0_inv;
+
+	return true;
+}
+
+/**
+ * Configure a notch (band stop) filter
+ * @param[in] bq The filter
+ * @param[in] sample_rate The rate the filter is applied at [Hz]
+ * @param[in] center The frequency that is removed [Hz]
+ * @param[in] q The quality factor, center frequency over the -3 dB bandwidth
+ * @returns true if configured, false if the parameters were invalid and the
+ * filter is now a passthrough
+ */
+bool biquad_set_notch(struct biquad *bq, float sample_rate, float center, float q)
+{
+	if (!frequency_valid(sample_rate, center, q) ||
+			!frequency_valid(sample_rate, center / q, 1)) {
+		biquad_set_passthrough(bq);
+		return false;
+	}
+
+	float w0 = 2 * (float) M_PI * center / sample_rate;
+	float cs = cosf(w0);
+
+	// Chosen so that the digital -3 dB bandwidth is exactly center / q;
+	// the cookbook sin(w0) / 2q narrows it as the center nears Nyquist
+	float alpha = tanf((float) M_PI * center / (q * sample_rate));
+	float a0_inv = 1 / (1 + alpha);
+
+	bq->b0 = a0_inv;
+	bq->b1 = -2 * cs * a0_inv;
+	bq->b2 = a0_inv;
+	bq->a1 = bq->b1;
+	bq->a2 = (1 - alpha) * a0_inv;
+
+	return true;
+}
+
+/**
+ * Set the state as if the input had been constant for a long time
+ * @param[in] bq The filter
+ * @param[in] value The constant input, which is also the output for
+ * filters with unity DC gain
+ */
+void biquad_reset(struct biquad *bq, float value)
+{
+	float den = 1 + bq->a1 + bq->a2;
+	float y = (den != 0) ? value * (bq->b0 + bq->b1 + bq->b2) / den : 0;
+
+	bq->z1 = y - bq->b0 * value;
+	bq->z2 = bq->b2 * value - bq->a2 * y;
+}
+
+/**
+ * Compute the gain of the filter at a frequency
+ * @param[in] bq The filter
+ * @param[in] sample_rate The rate the filter is applied at [Hz]
+ * @param[in] freq The frequency to evaluate [Hz]
+ * @returns The magnitude of the frequency response, 1 for unity gain
+ */
+float biquad_magnitude(const struct biquad *bq, float sample_rate, float freq)
+{
+	float w = 2 * (float) M_PI * freq / sample_rate;
+	float c1 = cosf(w), s1 = sinf(w);
+	float c2 = cosf(2 * w), s2 = sinf(2 * w);
+
+	// H(z) evaluated at z = e^jw, numerator and denominator separately
+	float num_re = bq->b0 + bq->b1 * c1 + bq->b2 * c2;
+	float num_im = -bq->b1 * s1 - bq->b2 * s2;
+	float den_re = 1 + bq->a1 * c1 + bq->a2 * c2;
+	float den_im = -bq->a1 * s1 - bq->a2 * s2;
+
+	return sqrtf((num_re * num_re + num_im * num_im) /
+			(den_re * den_re + den_im * den_im));
+}
+
+/**
+ * @}
+ * @}
+ */
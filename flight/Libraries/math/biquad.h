@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       biquad.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Second order IIR (biquad) filters
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef BIQUAD_H
+#define BIQUAD_H
+
+#include "stdbool.h"
+
+//! Coefficients (normalized so a0 = 1) and state of one biquad section
+struct biquad {
+	float b0;
+	float b1;
+	float b2;
+	float a1;
+	float a2;
+
+	float z1;
+	float z2;
+};
+
+//! Butterworth Q, for a maximally flat pass band
+#define BIQUAD_Q_BUTTERWORTH 0.70710678f
+
+bool biquad_set_lowpass(struct biquad *bq, float sample_rate, float cutoff, float q);
+bool biquad_set_notch(struct biquad *bq, float sample_rate, float center, float q);
+void biquad_set_passthrough(struct biquad *bq);
+void biquad_reset(struct biquad *bq, float value);
+float biquad_magnitude(const struct biquad *bq, float sample_rate, float freq);
+
+/**
+ * Filter one sample, in transposed direct form II
+ * @param[in] bq The filter
+ * @param[in] x The input sample
+ * @returns The filtered sample
+ */
+static inline float biquad_apply(struct biquad *bq, float x)
+{
+	float y = bq->b0 * x + bq->z1;
+
+	bq->z1 = bq->b1 * x - bq->a1 * y + bq->z2;
+	bq->z2 = bq->b2 * x - bq->a2 * y;
+
+	return y;
+}
+
+#endif /* BIQUAD_H */
+
+/**
+ * @}
+ * @}
+ */
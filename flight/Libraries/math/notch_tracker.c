@@ -0,0 +1,156 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       notch_tracker.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Tracks the dominant vibration frequency of a signal by FFT
+ *
+ * Samples are collected into a window. Once it is full the caller runs
+ * @ref notch_tracker_update, which takes a Hann windowed FFT, finds the
+ * largest peak in the tracked band, refines it by parabolic interpolation
+ * between bins and low passes the result. Pushing and updating are split
+ * so the caller decides when to spend the cycles on the FFT.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "misc_math.h"
+#include "notch_tracker.h"
+
+//! Weight of a new estimate in the tracked center frequency
+#define NOTCH_TRACKER_SMOOTHING 0.3f
+
+//! A peak must stand this far above the band average to be tracked
+#define NOTCH_TRACKER_PEAK_RATIO 3.0f
+
+/**
+ * Initialize a tracker
+ * @param[in] tracker The tracker
+ * @param[in] min_freq Lowest frequency to track [Hz]
+ * @param[in] max_freq Highest frequency to track [Hz]
+ * @param[in] initial Center frequency until a peak is found [Hz]
+ * @returns 0 if successful, -1 if the FFT could not be set up
+ */
+int32_t notch_tracker_init(struct notch_tracker *tracker, float min_freq,
+		float max_freq, float initial)
+{
+	if (arm_cfft_radix4_init_f32(&tracker->fft, NOTCH_TRACKER_FFT_SIZE, 0, 1) != ARM_MATH_SUCCESS)
+		return -1;
+
+	for (int i = 0; i < NOTCH_TRACKER_FFT_SIZE; i++) {
+		tracker->window[i] = 0.5f - 0.5f *
+			cosf(2 * PI * i / (NOTCH_TRACKER_FFT_SIZE - 1));
+	}
+
+	tracker->count = 0;
+	tracker->min_freq = min_freq;
+	tracker->max_freq = max_freq;
+	tracker->center = initial;
+
+	return 0;
+}
+
+/**
+ * Add a sample to the window
+ * @param[in] tracker The tracker
+ * @param[in] sample The new sample
+ * @returns true when the window is full and @ref notch_tracker_update
+ * should be called
+ */
+bool notch_tracker_push(struct notch_tracker *tracker, float sample)
+{
+	if (tracker->count < NOTCH_TRACKER_FFT_SIZE)
+		tracker->samples[tracker->count++] = sample;
+
+	return tracker->count == NOTCH_TRACKER_FFT_SIZE;
+}
+
+/**
+ * Analyze a full window and start collecting the next one
+ * @param[in] tracker The tracker
+ * @param[in] sample_rate The rate samples were pushed at [Hz]
+ * @returns The tracked center frequency [Hz]
+ */
+float notch_tracker_update(struct notch_tracker *tracker, float sample_rate)
+{
+	const int n = NOTCH_TRACKER_FFT_SIZE;
+	float *spectrum = tracker->spectrum;
+
+	if (tracker->count < n)
+		return tracker->center;
+
+	tracker->count = 0;
+
+	// Remove DC so that gravity and slow rotation do not leak into the band
+	float mean = 0;
+	for (int i = 0; i < n; i++)
+		mean += tracker->samples[i];
+	mean /= n;
+
+	for (int i = 0; i < n; i++) {
+		spectrum[2 * i] = (tracker->samples[i] - mean) * tracker->window[i];
+		spectrum[2 * i + 1] = 0;
+	}
+
+	arm_cfft_radix4_f32(&tracker->fft, spectrum);
+
+	// Only the first half of the bins are distinct for a real input
+	arm_cmplx_mag_f32(spectrum, spectrum, n / 2);
+
+	float bin_width = sample_rate / n;
+	int lo = MAX((int) ceilf(tracker->min_freq / bin_width), 1);
+	int hi = MIN((int) (tracker->max_freq / bin_width), n / 2 - 2);
+
+	if (lo > hi)
+		return tracker->center;
+
+	int peak = lo;
+	float sum = 0;
+	for (int i = lo; i <= hi; i++) {
+		sum += spectrum[i];
+		if (spectrum[i] > spectrum[peak])
+			peak = i;
+	}
+
+	// Broadband noise with no clear tone: keep the previous notch
+	if (spectrum[peak] * (hi - lo + 1) < NOTCH_TRACKER_PEAK_RATIO * sum)
+		return tracker->center;
+
+	// Fit a parabola through the peak and its neighbors
+	float left = spectrum[peak - 1];
+	float right = spectrum[peak + 1];
+	float den = left - 2 * spectrum[peak] + right;
+	float offset = (den < 0) ? 0.5f * (left - right) / den : 0;
+
+	float freq = (peak + offset) * bin_width;
+	freq = MAX(MIN(freq, tracker->max_freq), tracker->min_freq);
+
+	tracker->center += NOTCH_TRACKER_SMOOTHING * (freq - tracker->center);
+
+	return tracker->center;
+}
+
+/**
+ * @}
+ * @}
+ */
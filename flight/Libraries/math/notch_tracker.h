@@ -0,0 +1,62 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       notch_tracker.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Tracks the dominant vibration frequency of a signal by FFT
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef NOTCH_TRACKER_H
+#define NOTCH_TRACKER_H
+
+#include "arm_math.h"
+
+//! Window length; the CMSIS radix-4 FFT needs a power of four
+#define NOTCH_TRACKER_FFT_SIZE 64
+
+struct notch_tracker {
+	arm_cfft_radix4_instance_f32 fft;
+
+	float window[NOTCH_TRACKER_FFT_SIZE];
+	float samples[NOTCH_TRACKER_FFT_SIZE];
+	float spectrum[2 * NOTCH_TRACKER_FFT_SIZE];
+	uint16_t count;
+
+	float min_freq;
+	float max_freq;
+	float center;
+};
+
+int32_t notch_tracker_init(struct notch_tracker *tracker, float min_freq,
+		float max_freq, float initial);
+bool notch_tracker_push(struct notch_tracker *tracker, float sample);
+float notch_tracker_update(struct notch_tracker *tracker, float sample_rate);
+
+#endif /* NOTCH_TRACKER_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -51,10 +51,12 @@
 #include "mixersettings.h"
 #include "mixerstatus.h"
 #include "cameradesired.h"
+#include "controllatency.h"
 #include "manualcontrolcommand.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "control_pipeline.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE 2
@@ -67,6 +69,7 @@
 
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGHEST
 #define FAILSAFE_TIMEOUT_MS 100
+#define LATENCY_PERIOD_MS 1000
 #define MAX_MIX_ACTUATORS ACTUATORCOMMAND_CHANNEL_NUMELEM
 #define MULTIROTOR_MIXER_UPPER_BOUND 128
 
@@ -96,9 +99,10 @@ static float throt_curve(const float input, const float* curve, uint8_t num_poin
 static float collective_curve(const float input, const float* curve, uint8_t num_points);
 static bool set_channel(uint8_t mixer_channel, float value);
 static void actuator_update_rate_if_changed(bool force_update);
+static void update_latency(const struct control_pipeline_actuator *command);
 float process_mixer(const int index, const float curve1, const float curve2,
-		ActuatorDesiredData *desired);
-static float mix_channel(int ct, ActuatorDesiredData *desired,
+		const ActuatorDesiredData *desired);
+static float mix_channel(int ct, const ActuatorDesiredData *desired,
 		float curve1, float curve2);
 
 static MixerSettingsMixer1TypeOptions get_mixer_type(int idx);
@@ -151,6 +155,11 @@ int32_t ActuatorInitialize()
 		return -1;
 	}
 
+	if (ControlLatencyInitialize() == -1 \
+		|| control_pipeline_initialize() == -1) {
+		return -1;
+	}
+
 #if defined(MIXERSTATUS_DIAGNOSTICS)
 	// UAVO only used for inspecting the internal status of the mixer during debug
 	if (MixerStatusInitialize()  == -1) {
@@ -162,7 +171,7 @@ int32_t ActuatorInitialize()
 }
 MODULE_INITCALL(ActuatorInitialize, ActuatorStart);
 
-static float get_curve2_source(ActuatorDesiredData *desired, SystemSettingsAirframeTypeOptions airframe_type, MixerSettingsCurve2SourceOptions source)
+static float get_curve2_source(const ActuatorDesiredData *desired, SystemSettingsAirframeTypeOptions airframe_type, MixerSettingsCurve2SourceOptions source)
 {
 	float tmp;
 
@@ -229,7 +238,7 @@ static void actuator_task(void* parameters)
 	float dT = 0.0f;
 
 	ActuatorCommandData command;
-	ActuatorDesiredData desired;
+	ActuatorDesiredData desired_data;
 	MixerStatusData mixerStatus;
 	FlightStatusData flightStatus;
 	ManualControlCommandData manual_control_command;
@@ -269,8 +278,18 @@ static void actuator_task(void* parameters)
 
 		UAVObjEvent ev;
 
-		// Wait until the ActuatorDesired object is updated
-		rc = PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS);
+		// Wait until the ActuatorDesired object is updated, or in direct
+		// mode until stabilization hands over its output
+		const struct control_pipeline_actuator *pipelined = NULL;
+		if (control_pipeline_is_direct()) {
+			pipelined = control_pipeline_actuator_wait(FAILSAFE_TIMEOUT_MS);
+			rc = pipelined != NULL;
+
+			// Keep the queue empty for switching back to queued mode
+			PIOS_Queue_Receive(queue, &ev, 0);
+		} else {
+			rc = PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS);
+		}
 
 		/* If we timed out, go to top of loop, which sets failsafe
 		 * and waits again. */
@@ -284,7 +303,16 @@ static void actuator_task(void* parameters)
 			dT = (this_systime - last_systime) / 1000.0f;
 		last_systime = this_systime;
 
-		ActuatorDesiredGet(&desired);
+		// The pipeline slot is held for this task until the next
+		// control_pipeline_actuator_wait() or _latest(), so
+		// stabilization cannot refill it while this loop uses it
+		const ActuatorDesiredData *desired;
+		if (pipelined != NULL) {
+			desired = &pipelined->desired;
+		} else {
+			ActuatorDesiredGet(&desired_data);
+			desired = &desired_data;
+		}
 		ActuatorCommandGet(&command);
 
 		if (flightStatusUpdated) {
@@ -320,7 +348,7 @@ static void actuator_task(void* parameters)
 				throttle_source = manual_control_command.Throttle;
 			}
 		} else {
-			throttle_source = desired.Thrust;
+			throttle_source = desired->Thrust;
 		}
 
 		bool stabilize_now = throttle_source > 0.0f;
@@ -348,7 +376,7 @@ static void actuator_task(void* parameters)
 
 		//The source for the secondary curve is selectable
 		float curve2 = collective_curve(
-				get_curve2_source(&desired, airframe_type, mixerSettings.Curve2Source),
+				get_curve2_source(desired, airframe_type, mixerSettings.Curve2Source),
 				mixerSettings.ThrottleCurve2,
 				MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
 
@@ -360,7 +388,7 @@ static void actuator_task(void* parameters)
 		int num_motors = 0;
 
 		for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
-			status[ct] = mix_channel(ct, &desired, curve1, curve2);
+			status[ct] = mix_channel(ct, desired, curve1, curve2);
 
 			if (get_mixer_type(ct) == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
 				min_chan = fminf(min_chan, status[ct]);
@@ -475,6 +503,9 @@ static void actuator_task(void* parameters)
 		PIOS_Servo_Update();
 #endif
 
+		update_latency(pipelined != NULL ? pipelined :
+				control_pipeline_actuator_latest());
+
 		if (!success) {
 			command.NumFailedUpdates++;
 			ActuatorCommandSet(&command);
@@ -487,11 +518,68 @@ static void actuator_task(void* parameters)
 	}
 }
 
+/**
+ * @brief Accumulate the latency of the command just applied to the outputs
+ * and publish ControlLatency once a period
+ * @param[in] command the pipeline slot the outputs were computed from
+ */
+static void update_latency(const struct control_pipeline_actuator *command)
+{
+	static uint32_t last_timestamp;
+	static uint32_t last_publish;
+	static uint32_t updates;
+	static uint16_t samples;
+	static float stab_sum, stab_max;
+	static float act_sum, act_max;
+
+	updates++;
+
+	// ActuatorDesired can also be set from elsewhere, e.g. by the GCS,
+	// so only count commands made from a new gyro sample
+	if (control_pipeline_has_gyro() && command->timestamp != last_timestamp) {
+		last_timestamp = command->timestamp;
+
+		float latency = PIOS_DELAY_DiffuS(command->timestamp);
+
+		stab_sum += command->stabilization_latency;
+		stab_max = MAX(stab_max, command->stabilization_latency);
+		act_sum += latency;
+		act_max = MAX(act_max, latency);
+		samples++;
+	}
+
+	uint32_t now = PIOS_Thread_Systime();
+	if (now - last_publish < LATENCY_PERIOD_MS)
+		return;
+	last_publish = now;
+
+	ControlLatencyData latency;
+
+	if (samples > 0) {
+		latency.GyroToStabilization[CONTROLLATENCY_GYROTOSTABILIZATION_AVERAGE] = stab_sum / samples;
+		latency.GyroToActuator[CONTROLLATENCY_GYROTOACTUATOR_AVERAGE] = act_sum / samples;
+	} else {
+		latency.GyroToStabilization[CONTROLLATENCY_GYROTOSTABILIZATION_AVERAGE] = 0;
+		latency.GyroToActuator[CONTROLLATENCY_GYROTOACTUATOR_AVERAGE] = 0;
+	}
+	latency.GyroToStabilization[CONTROLLATENCY_GYROTOSTABILIZATION_MAX] = stab_max;
+	latency.GyroToActuator[CONTROLLATENCY_GYROTOACTUATOR_MAX] = act_max;
+	latency.Updates = updates;
+	latency.Pipeline = control_pipeline_is_direct() ?
+			CONTROLLATENCY_PIPELINE_DIRECT : CONTROLLATENCY_PIPELINE_QUEUED;
+
+	ControlLatencySet(&latency);
+
+	samples = 0;
+	stab_sum = stab_max = 0;
+	act_sum = act_max = 0;
+}
+
 /**
  *Process mixing for one actuator
  */
 float process_mixer(const int index, const float curve1, const float curve2,
-		ActuatorDesiredData *desired)
+		const ActuatorDesiredData *desired)
 {
 	// Taking the pointer to the array preserves type information so smart compilers
 	// can detect accesses past the end.
@@ -759,7 +847,7 @@ static void actuator_update_rate_if_changed(bool force_update)
 	}
 }
 
-static float mix_channel(int ct, ActuatorDesiredData *desired,
+static float mix_channel(int ct, const ActuatorDesiredData *desired,
 		float curve1, float curve2)
 {
 	MixerSettingsMixer1TypeOptions type = get_mixer_type(ct);
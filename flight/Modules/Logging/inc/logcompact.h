@@ -0,0 +1,105 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup Logging Logging Module
+ * @{
+ *
+ * @file       logcompact.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Compact log encoding with per object deltas
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGCOMPACT_H
+#define LOGCOMPACT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * The stream follows the usual text header (whose UAVO hash says how to
+ * interpret object ids) and a "##" line, and starts with the magic and a
+ * version byte.  Multi byte fields are little endian, crc is the UAVTalk
+ * CRC-8 over the whole record before it.
+ *
+ * SCHEMA  0x80 index objid:u32 instid:u16 flags:u8 length:u16 crc
+ *         Assigns a delta index to an object instance.
+ * KEY     0x81 index time:u32 payload[length] crc
+ *         Full copy of a tracked instance at an absolute time in ms.
+ * RAW     0x82 objid:u32 instid:u16 flags:u8 time:u32 length:u16 payload crc
+ *         Untracked sample, for settings and whatever does not fit.
+ * DELTA   index(<0x80) dt:varint changed[ceil(words/8)] delta:varint... crc
+ *         The payload as 32 bit words, zero padded; for each word set in
+ *         the bitmap (lsb first) the zigzag difference from the last sample.
+ *         dt is the time since the record before, of any kind.
+ *
+ * A decoder that loses sync scans for a SCHEMA, KEY or RAW record with a
+ * good crc and ignores deltas of each index until its next key frame.
+ */
+#define LOGCOMPACT_MAGIC          "dRLC"
+#define LOGCOMPACT_VERSION        1
+
+#define LOGCOMPACT_REC_SCHEMA     0x80
+#define LOGCOMPACT_REC_KEY        0x81
+#define LOGCOMPACT_REC_RAW        0x82
+
+#define LOGCOMPACT_FLAG_SINGLE    0x01	//!< Single instance, no instid in UAVTalk
+
+#define LOGCOMPACT_MAX_TRACKED    64
+#define LOGCOMPACT_MAX_TRACKED_LEN 128
+#define LOGCOMPACT_HISTORY_BYTES  1536
+#define LOGCOMPACT_KEY_INTERVAL_MS 1000
+
+#define LOGCOMPACT_MAX_WORDS      (LOGCOMPACT_MAX_TRACKED_LEN / 4)
+#define LOGCOMPACT_MAX_RECORD     (1 + 5 + (LOGCOMPACT_MAX_WORDS + 7) / 8 + 5 * LOGCOMPACT_MAX_WORDS)
+
+typedef int32_t (*logcompact_output_t)(uint8_t *data, int32_t length);
+
+struct logcompact_track {
+	uint32_t obj_id;
+	uint16_t inst_id;
+	uint8_t length;
+	bool valid;		//!< history holds the last sample
+	uint32_t last_key;
+	uint16_t history;	//!< Offset of the last sample
+};
+
+struct logcompact {
+	logcompact_output_t output;
+	uint32_t last_time;
+	uint8_t num_tracked;
+	uint16_t history_used;
+
+	struct logcompact_track tracked[LOGCOMPACT_MAX_TRACKED];
+	uint8_t history[LOGCOMPACT_HISTORY_BYTES];
+	uint8_t record[LOGCOMPACT_MAX_RECORD];
+};
+
+void logcompact_init(struct logcompact *lc, logcompact_output_t output);
+int32_t logcompact_start(struct logcompact *lc);
+int32_t logcompact_write(struct logcompact *lc, uint32_t obj_id, uint16_t inst_id,
+		bool single, const uint8_t *data, uint16_t length, uint32_t time, bool track);
+
+#endif /* LOGCOMPACT_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,264 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup Logging Logging Module
+ * @{
+ *
+ * @file       logcompact.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Compact log encoding with per object deltas
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logcompact.h"
+#include "pios_crc.h"
+
+#include <string.h>
+
+static inline uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+	p[0] = v & 0xff;
+	p[1] = v >> 8;
+	return p + 2;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = v >> 24;
+	return p + 4;
+}
+
+static inline uint8_t *put_varint(uint8_t *p, uint32_t v)
+{
+	while (v >= 0x80) {
+		*p++ = (v & 0x7f) | 0x80;
+		v >>= 7;
+	}
+	*p++ = v;
+	return p;
+}
+
+/* Word i of a payload, with the bytes past the end read as zero */
+static uint32_t get_word(const uint8_t *data, uint16_t length, int i)
+{
+	uint32_t v = 0;
+
+	for (int b = 3; b >= 0; b--) {
+		int pos = 4 * i + b;
+		v = (v << 8) | (pos < length ? data[pos] : 0);
+	}
+
+	return v;
+}
+
+/**
+ * @brief Set up an encoder that writes through output
+ */
+void logcompact_init(struct logcompact *lc, logcompact_output_t output)
+{
+	memset(lc, 0, sizeof(*lc));
+	lc->output = output;
+}
+
+/**
+ * @brief Forget everything tracked and begin a new stream
+ * @returns 0 on success, -1 if the output failed
+ */
+int32_t logcompact_start(struct logcompact *lc)
+{
+	logcompact_init(lc, lc->output);
+
+	uint8_t start[sizeof(LOGCOMPACT_MAGIC)];
+	memcpy(start, LOGCOMPACT_MAGIC, sizeof(start) - 1);
+	start[sizeof(start) - 1] = LOGCOMPACT_VERSION;
+
+	return lc->output(start, sizeof(start)) < 0 ? -1 : 0;
+}
+
+/* Header, payload and crc go out separately so the payload needs no copy */
+static int32_t write_record(struct logcompact *lc, uint8_t *header, int32_t header_len,
+		const uint8_t *payload, uint16_t length)
+{
+	uint8_t crc = PIOS_CRC_updateCRC(0, header, header_len);
+
+	if (lc->output(header, header_len) < 0) {
+		return -1;
+	}
+
+	if (length) {
+		crc = PIOS_CRC_updateCRC(crc, payload, length);
+		if (lc->output((uint8_t *) payload, length) < 0) {
+			return -1;
+		}
+	}
+
+	return lc->output(&crc, 1) < 0 ? -1 : 0;
+}
+
+static int32_t write_raw(struct logcompact *lc, uint32_t obj_id, uint16_t inst_id,
+		bool single, const uint8_t *data, uint16_t length, uint32_t time)
+{
+	uint8_t *p = lc->record;
+
+	*p++ = LOGCOMPACT_REC_RAW;
+	p = put_u32(p, obj_id);
+	p = put_u16(p, inst_id);
+	*p++ = single ? LOGCOMPACT_FLAG_SINGLE : 0;
+	p = put_u32(p, time);
+	p = put_u16(p, length);
+
+	int32_t ret = write_record(lc, lc->record, p - lc->record, data, length);
+	if (ret == 0) {
+		lc->last_time = time;
+	}
+
+	return ret;
+}
+
+/* Find the instance, or start tracking it if there is room */
+static struct logcompact_track *get_track(struct logcompact *lc, uint32_t obj_id,
+		uint16_t inst_id, bool single, uint16_t length, int *index)
+{
+	for (int i = 0; i < lc->num_tracked; i++) {
+		struct logcompact_track *t = &lc->tracked[i];
+
+		if (t->obj_id == obj_id && t->inst_id == inst_id) {
+			*index = i;
+			return t->length == length ? t : NULL;
+		}
+	}
+
+	if (lc->num_tracked >= LOGCOMPACT_MAX_TRACKED ||
+			length > LOGCOMPACT_MAX_TRACKED_LEN ||
+			lc->history_used + length > LOGCOMPACT_HISTORY_BYTES) {
+		return NULL;
+	}
+
+	*index = lc->num_tracked;
+	struct logcompact_track *t = &lc->tracked[lc->num_tracked++];
+	t->obj_id = obj_id;
+	t->inst_id = inst_id;
+	t->length = length;
+	t->valid = false;
+	t->history = lc->history_used;
+	lc->history_used += length;
+
+	uint8_t *p = lc->record;
+	*p++ = LOGCOMPACT_REC_SCHEMA;
+	*p++ = *index;
+	p = put_u32(p, obj_id);
+	p = put_u16(p, inst_id);
+	*p++ = single ? LOGCOMPACT_FLAG_SINGLE : 0;
+	p = put_u16(p, length);
+
+	if (write_record(lc, lc->record, p - lc->record, NULL, 0) < 0) {
+		/* Decoders won't know the index, so never use it */
+		t->length = 0;
+		return NULL;
+	}
+
+	return t;
+}
+
+/**
+ * @brief Log one sample of an object instance
+ * @param[in] data the instance packed like UAVTalk does
+ * @param[in] time in ms, not going backwards
+ * @param[in] track whether more samples will follow, so that deltas pay off
+ * @returns 0 on success, -1 if the output failed
+ */
+int32_t logcompact_write(struct logcompact *lc, uint32_t obj_id, uint16_t inst_id,
+		bool single, const uint8_t *data, uint16_t length, uint32_t time, bool track)
+{
+	int index;
+	struct logcompact_track *t = NULL;
+
+	if (track) {
+		t = get_track(lc, obj_id, inst_id, single, length, &index);
+	}
+
+	if (!t) {
+		return write_raw(lc, obj_id, inst_id, single, data, length, time);
+	}
+
+	uint8_t *prev = &lc->history[t->history];
+	uint8_t *p = lc->record;
+	int words = (length + 3) / 4;
+	int bitmap_len = (words + 7) / 8;
+
+	bool key = !t->valid || time < lc->last_time ||
+		time - t->last_key >= LOGCOMPACT_KEY_INTERVAL_MS;
+
+	if (!key) {
+		*p++ = index;
+		p = put_varint(p, time - lc->last_time);
+
+		uint8_t *bitmap = p;
+		memset(bitmap, 0, bitmap_len);
+		p += bitmap_len;
+
+		for (int i = 0; i < words; i++) {
+			uint32_t cur = get_word(data, length, i);
+			uint32_t last = get_word(prev, length, i);
+
+			if (cur != last) {
+				int32_t d = cur - last;
+				bitmap[i / 8] |= 1 << (i % 8);
+				p = put_varint(p, ((uint32_t) d << 1) ^ (uint32_t) (d >> 31));
+			}
+		}
+
+		/* Never bigger than the key frame */
+		key = (p - lc->record) >= 2 + 4 + length;
+	}
+
+	int32_t ret;
+
+	if (key) {
+		p = lc->record;
+		*p++ = LOGCOMPACT_REC_KEY;
+		*p++ = index;
+		p = put_u32(p, time);
+
+		ret = write_record(lc, lc->record, p - lc->record, data, length);
+		t->last_key = time;
+	} else {
+		ret = write_record(lc, lc->record, p - lc->record, NULL, 0);
+	}
+
+	/* Whatever got out, the decoder has to resync on a key frame */
+	t->valid = ret == 0;
+	memcpy(prev, data, length);
+
+	/* Later deltas count from the last record the decoder can see */
+	if (ret == 0) {
+		lc->last_time = time;
+	}
+
+	return ret;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -41,6 +41,8 @@
 #include "misc_math.h"
 #include "timeutils.h"
 #include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+#include "logcompact.h"
 
 #include "pios_streamfs.h"
 #include <pios_board_info.h>
@@ -96,11 +98,16 @@ static void register_default_profile();
 static void logSettings(UAVObjHandle obj);
 static void writeHeader();
 static void updateSettings();
+static bool allocCompact();
+static void logObject(UAVObjHandle obj, uint16_t instId, bool track);
 
 // Local variables
 static uintptr_t logging_com_id;
 static uint32_t written_bytes;
 static bool destination_spi_flash;
+static bool log_compact;
+static struct logcompact *compact;
+static uint8_t *compact_payload;
 
 #if defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC)
 // External variables
@@ -309,6 +316,10 @@ static void loggingTask(void *parameters)
 			}
 #endif /* defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC) */
 
+			// Fall back to UAVTalk if there is no memory for the encoder
+			log_compact = settings.LogFormat == LOGGINGSETTINGS_LOGFORMAT_COMPACT &&
+				allocCompact();
+
 			// Write information at start of the log file
 			writeHeader();
 
@@ -332,7 +343,7 @@ static void loggingTask(void *parameters)
 				// Log the objects registred to the shared queue
 				for (int i=0; i<LOGGING_QUEUE_SIZE; i++) {
 					if (PIOS_Queue_Receive(logging_queue, &ev, 0) == true) {
-						UAVTalkSendObjectTimestamped(uavTalkCon, ev.obj, ev.instId, false, 0);
+						logObject(ev.obj, ev.instId, true);
 					}
 					else {
 						break;
@@ -418,10 +429,55 @@ static void loggingTask(void *parameters)
 static void logSettings(UAVObjHandle obj)
 {
 	if (UAVObjIsSettings(obj)) {
-		UAVTalkSendObjectTimestamped(uavTalkCon, obj, 0, false, 0);
+		logObject(obj, 0, false);
 	}
 }
 
+/**
+ * Write one sample of an object in the format chosen for this log
+ * \param[in] obj Object to log
+ * \param[in] instId Instance to log
+ * \param[in] track Whether more samples follow, so compact logs keep a delta base
+ */
+static void logObject(UAVObjHandle obj, uint16_t instId, bool track)
+{
+	if (!log_compact) {
+		UAVTalkSendObjectTimestamped(uavTalkCon, obj, instId, false, 0);
+		return;
+	}
+
+	if (UAVObjPack(obj, instId, compact_payload) < 0)
+		return;
+
+	logcompact_write(compact, UAVObjGetID(obj), instId, UAVObjIsSingleInstance(obj),
+			compact_payload, UAVObjGetNumBytes(obj), PIOS_Thread_Systime(), track);
+}
+
+/**
+ * Allocate the compact encoder the first time it is needed
+ * \return true if it is available
+ */
+static bool allocCompact()
+{
+	if (compact)
+		return true;
+
+	compact_payload = PIOS_malloc(UAVOBJECTS_LARGEST);
+	compact = PIOS_malloc(sizeof(*compact));
+
+	if (!compact || !compact_payload) {
+		PIOS_free(compact);
+		PIOS_free(compact_payload);
+		compact = NULL;
+		compact_payload = NULL;
+		return false;
+	}
+
+	logcompact_init(compact, &send_data);
+
+	return true;
+}
+
 /**
  * Forward data from UAVTalk out the serial port
  * \param[in] data Data buffer to send
@@ -643,6 +699,13 @@ static void writeHeader()
 	}
 	tmp_str[pos++] = '\n';
 	send_data((uint8_t*)tmp_str, pos);
+
+	if (log_compact) {
+		// Readers expect binary data to follow a "##" line
+		send_data((uint8_t *)"##\n", 3);
+
+		logcompact_start(compact);
+	}
 }
 
 static void updateSettings()
@@ -275,6 +275,81 @@ void write_pixel_lm(int x, int y, int mmode, int lmode)
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 }
 
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+// Word type used by the span fills to touch the byte planes 32 bits at a time
+typedef uint32_t __attribute__((__may_alias__)) osd_word_t;
+
+/**
+ * calc_span_masks: compute the edge masks of a span from x0 to x1 on one row.
+ * When both ends fall in the same byte, both masks are the island mask.
+ *
+ * @param       x0      x0 coordinate
+ * @param       x1      x1 coordinate
+ * @param       mask_l  mask for the first byte
+ * @param       mask_r  mask for the last byte
+ */
+static inline void calc_span_masks(int x0, int x1, uint8_t *mask_l, uint8_t *mask_r)
+{
+	int bit0 = CALC_BIT_IN_WORD(x0);
+	int bit1 = CALC_BIT_IN_WORD(x1);
+
+	if (CALC_BUFF_ADDR(x0, 0) == CALC_BUFF_ADDR(x1, 0)) {
+		*mask_l = COMPUTE_HLINE_ISLAND_MASK(bit0, bit1);
+		*mask_r = *mask_l;
+	} else {
+		*mask_l = COMPUTE_HLINE_EDGE_L_MASK(bit0);
+		*mask_r = COMPUTE_HLINE_EDGE_R_MASK(bit1);
+	}
+}
+
+/**
+ * write_span: apply a mode to the bytes addr0 to addr1 of a buffer, using
+ * the edge masks on the first and last byte. The full bytes in between are
+ * written a 32-bit word at a time.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       addr0   address of the first byte
+ * @param       addr1   address of the last byte
+ * @param       mask_l  mask for the first byte
+ * @param       mask_r  mask for the last byte
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+static inline void write_span(uint8_t *buff, int addr0, int addr1, uint8_t mask_l, uint8_t mask_r, int mode)
+{
+	WRITE_WORD_MODE(buff, addr0, mask_l, mode);
+	if (addr0 == addr1) {
+		return;
+	}
+	WRITE_WORD_MODE(buff, addr1, mask_r, mode);
+
+	uint8_t *p   = buff + addr0 + 1;
+	uint8_t *end = buff + addr1;
+
+	if (mode == 2) {
+		while (p < end && ((uintptr_t)p & 3)) {
+			*p++ ^= 0xff;
+		}
+		for (; end - p >= 4; p += 4) {
+			*(osd_word_t *)p ^= 0xffffffff;
+		}
+		while (p < end) {
+			*p++ ^= 0xff;
+		}
+	} else if (mode == 0 || mode == 1) {
+		uint8_t fill = mode ? 0xff : 0x00;
+		while (p < end && ((uintptr_t)p & 3)) {
+			*p++ = fill;
+		}
+		for (; end - p >= 4; p += 4) {
+			*(osd_word_t *)p = fill * 0x01010101u;
+		}
+		while (p < end) {
+			*p++ = fill;
+		}
+	}
+}
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
 /**
  * write_hline: optimised horizontal line writing algorithm
  *
@@ -296,30 +371,9 @@ void write_hline(uint8_t *buff, int x0, int x1, int y, int mode)
 	if (x0 == x1) {
 		return;
 	}
-	/* This is an optimised algorithm for writing horizontal lines.
-	 * We begin by finding the addresses of the x0 and x1 points. */
-	int addr0     = CALC_BUFF_ADDR(x0, y);
-	int addr1     = CALC_BUFF_ADDR(x1, y);
-	int addr0_bit = CALC_BIT_IN_WORD(x0);
-	int addr1_bit = CALC_BIT_IN_WORD(x1);
-	int mask, mask_l, mask_r, i;
-	/* If the addresses are equal, we only need to write one word
-	 * which is an island. */
-	if (addr0 == addr1) {
-		mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
-		WRITE_WORD_MODE(buff, addr0, mask, mode);
-	} else {
-		/* Otherwise we need to write the edges and then the middle. */
-		mask_l = COMPUTE_HLINE_EDGE_L_MASK(addr0_bit);
-		mask_r = COMPUTE_HLINE_EDGE_R_MASK(addr1_bit);
-		WRITE_WORD_MODE(buff, addr0, mask_l, mode);
-		WRITE_WORD_MODE(buff, addr1, mask_r, mode);
-		// Now write 0xffff words from start+1 to end-1.
-		for (i = addr0 + 1; i <= addr1 - 1; i++) {
-			uint8_t m = 0xff;
-			WRITE_WORD_MODE(buff, i, m, mode);
-		}
-	}
+	uint8_t mask_l, mask_r;
+	calc_span_masks(x0, x1, &mask_l, &mask_r);
+	write_span(buff, CALC_BUFF_ADDR(x0, y), CALC_BUFF_ADDR(x1, y), mask_l, mask_r, mode);
 }
 #else
 void write_hline(int x0, int x1, int y, uint8_t value)
@@ -373,10 +427,22 @@ void write_hline(int x0, int x1, int y, uint8_t value)
 void write_hline_lm(int x0, int x1, int y, int lmode, int mmode)
 {
 #if defined(PIOS_VIDEO_SPLITBUFFER)
-	// TODO: an optimisation would compute the masks and apply to
-	// both buffers simultaneously.
-	write_hline(draw_buffer_level, x0, x1, y, lmode);
-	write_hline(draw_buffer_mask, x0, x1, y, mmode);
+	CHECK_COORD_Y(y);
+	CLIP_COORD_X(x0);
+	CLIP_COORD_X(x1);
+	if (x0 > x1) {
+		SWAP(x0, x1);
+	}
+	if (x0 == x1) {
+		return;
+	}
+	// Compute the span once and apply it to both buffers
+	uint8_t mask_l, mask_r;
+	int addr0 = CALC_BUFF_ADDR(x0, y);
+	int addr1 = CALC_BUFF_ADDR(x1, y);
+	calc_span_masks(x0, x1, &mask_l, &mask_r);
+	write_span(draw_buffer_level, addr0, addr1, mask_l, mask_r, lmode);
+	write_span(draw_buffer_mask, addr0, addr1, mask_l, mask_r, mmode);
 #else
 	uint8_t value = PACK_BITS(mmode, lmode);
 	write_hline(x0, x1, y, value);
@@ -540,8 +606,6 @@ void write_vline_outlined(int x, int y0, int y1, int endcap0, int endcap1, int m
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height, int mode)
 {
-	int yy, addr0_old, addr1_old;
-
 	CHECK_COORDS(x, y);
 	CHECK_COORDS(x + width, y + height);
 	if (width <= 0 || height <= 0) {
@@ -549,46 +613,14 @@ void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height,
 	}
 	// Calculate as if the rectangle was only a horizontal line. We then
 	// step these addresses through each row until we iterate `height` times.
-	int addr0     = CALC_BUFF_ADDR(x, y);
-	int addr1     = CALC_BUFF_ADDR(x + width, y);
-	int addr0_bit = CALC_BIT_IN_WORD(x);
-	int addr1_bit = CALC_BIT_IN_WORD(x + width);
-	int mask, mask_l, mask_r, i;
-	// If the addresses are equal, we need to write one word vertically.
-	if (addr0 == addr1) {
-		mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
-		while (height--) {
-			WRITE_WORD_MODE(buff, addr0, mask, mode);
-			addr0 += BUFFER_WIDTH;
-		}
-	} else {
-		// Otherwise we need to write the edges and then the middle repeatedly.
-		mask_l    = COMPUTE_HLINE_EDGE_L_MASK(addr0_bit);
-		mask_r    = COMPUTE_HLINE_EDGE_R_MASK(addr1_bit);
-		// Write edges first.
-		yy        = 0;
-		addr0_old = addr0;
-		addr1_old = addr1;
-		while (yy < height) {
-			WRITE_WORD_MODE(buff, addr0, mask_l, mode);
-			WRITE_WORD_MODE(buff, addr1, mask_r, mode);
-			addr0 += BUFFER_WIDTH;
-			addr1 += BUFFER_WIDTH;
-			yy++;
-		}
-		// Now write 0xffff words from start+1 to end-1 for each row.
-		yy    = 0;
-		addr0 = addr0_old;
-		addr1 = addr1_old;
-		while (yy < height) {
-			for (i = addr0 + 1; i <= addr1 - 1; i++) {
-				uint8_t m = 0xff;
-				WRITE_WORD_MODE(buff, i, m, mode);
-			}
-			addr0 += BUFFER_WIDTH;
-			addr1 += BUFFER_WIDTH;
-			yy++;
-		}
+	uint8_t mask_l, mask_r;
+	int addr0 = CALC_BUFF_ADDR(x, y);
+	int addr1 = CALC_BUFF_ADDR(x + width, y);
+	calc_span_masks(x, x + width, &mask_l, &mask_r);
+	while (height--) {
+		write_span(buff, addr0, addr1, mask_l, mask_r, mode);
+		addr0 += BUFFER_WIDTH;
+		addr1 += BUFFER_WIDTH;
 	}
 }
 #else
@@ -660,8 +692,22 @@ void write_filled_rectangle(int x, int y, int width, int height, uint8_t value)
 void write_filled_rectangle_lm(int x, int y, int width, int height, int lmode, int mmode)
 {
 #if defined(PIOS_VIDEO_SPLITBUFFER)
-	write_filled_rectangle(draw_buffer_mask, x, y, width, height, mmode);
-	write_filled_rectangle(draw_buffer_level, x, y, width, height, lmode);
+	CHECK_COORDS(x, y);
+	CHECK_COORDS(x + width, y + height);
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+	// Same as write_filled_rectangle, but both buffers are written row by row
+	uint8_t mask_l, mask_r;
+	int addr0 = CALC_BUFF_ADDR(x, y);
+	int addr1 = CALC_BUFF_ADDR(x + width, y);
+	calc_span_masks(x, x + width, &mask_l, &mask_r);
+	while (height--) {
+		write_span(draw_buffer_mask, addr0, addr1, mask_l, mask_r, mmode);
+		write_span(draw_buffer_level, addr0, addr1, mask_l, mask_r, lmode);
+		addr0 += BUFFER_WIDTH;
+		addr1 += BUFFER_WIDTH;
+	}
 #else
 	uint8_t value = PACK_BITS(mmode, lmode);
 	write_filled_rectangle(x, y, width, height, value);
@@ -1196,6 +1242,37 @@ void write_word_misaligned_MASKED(uint8_t *buff, uint16_t word, uint16_t mask, u
 }
 
 
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+/**
+ * write_glyph_row: Draw one row of a glyph on both draw buffers.
+ *
+ * The row is shifted into place once as a 32-bit word, which covers the
+ * (at most three) bytes it lands in, and each byte of both buffers is then
+ * updated with a single read-modify-write.
+ *
+ * @param       addr    address of the first byte
+ * @param       xoff    x offset (0-7)
+ * @param       mask    pixels to draw, left aligned in 16 bits
+ * @param       levels  pixel levels, left aligned (set = black)
+ */
+static inline void write_glyph_row(int addr, unsigned int xoff, uint16_t mask, uint16_t levels)
+{
+	uint32_t m = ((uint32_t)mask << 16) >> xoff;
+	uint32_t k = ((uint32_t)(mask & levels) << 16) >> xoff;
+	uint8_t *pm = draw_buffer_mask + addr;
+	uint8_t *pl = draw_buffer_level + addr;
+
+	for (int i = 0; i < 3 && m; i++) {
+		uint8_t mb = m >> 24;
+		uint8_t kb = k >> 24;
+		pm[i] |= mb;
+		pl[i] = (pl[i] | mb) & ~kb;
+		m <<= 8;
+		k <<= 8;
+	}
+}
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
 /**
  * write_char: Draw a character on the current draw buffer.
  *
@@ -1238,12 +1315,7 @@ void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info)
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 				mask = data & 0xFFFF;
 				levels   = (data >> 16) & 0xFFFF;
-				// mask
-				write_word_misaligned_OR(draw_buffer_mask, mask, addr, wbit);
-				// level
-				write_word_misaligned_OR(draw_buffer_level, mask, addr, wbit);
-				mask = (mask & levels);
-				write_word_misaligned_NAND(draw_buffer_level, mask, addr, wbit);
+				write_glyph_row(addr, wbit, mask, levels);
 #else
 				data16 = (data & 0xFFFF0000) >> 16;
 				mask = data16 | (data16 << 1);
@@ -1265,12 +1337,7 @@ void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info)
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 				levels = data & 0xFF00;
 				mask = (data & 0x00FF) << 8;
-				// mask
-				write_word_misaligned_OR(draw_buffer_mask, mask, addr, wbit);
-				// level
-				write_word_misaligned_OR(draw_buffer_level, mask, addr, wbit);
-				mask = (mask & levels);
-				write_word_misaligned_NAND(draw_buffer_level, mask, addr, wbit);
+				write_glyph_row(addr, wbit, mask, levels);
 #else
 				mask = data | (data << 1);
 				write_word_misaligned_MASKED(draw_buffer, data, mask, addr, wbit);
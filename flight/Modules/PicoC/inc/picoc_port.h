@@ -62,6 +62,8 @@ void PlatformFree(void *ptr);
 size_t PlatformHeapSize();
 void PlatformDebug(const char *format, ...);
 int picoc(const char *source, size_t stack_size);
+int picoc_cyclic(const char *source, size_t stack_size, uint32_t period_ms, bool (*keep_running)(void),
+		void (*loop_started)(bool compiled, int line));
 
 /* get all picoc definitions */
 #include "picoc.h"
@@ -69,6 +71,14 @@ int picoc(const char *source, size_t stack_size);
 /* add missing things */
 extern struct LibraryFunction CLibrary[];
 
+/* compiled functions */
+#ifndef NO_FP
+struct CompiledProgram;
+struct CompiledProgram *PicocCompile(Picoc *pc, const char *FuncName, int *Line);
+void PicocRunCompiled(struct CompiledProgram *Program);
+void PicocFreeCompiled(struct CompiledProgram *Program);
+#endif
+
 #ifdef NO_CTYPE
 #define isdigit(c) ((c) >= '0' && (c) <= '9')
 #endif
@@ -0,0 +1,3083 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules TauLabs Modules
+ * @{
+ * @addtogroup PicoC Interpreter Module
+ * @{
+ *
+ * @file       picoc_compile.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      c-interpreter module for autonomous user programmed tasks
+ *             translates the cyclic loop() function once into a tree of
+ *             evaluation functions, so it is not re-parsed every cycle
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * The compiler walks the tokens of a function body once, like the
+ * interpreter does, and builds a tree of nodes. Every node carries the
+ * C function that evaluates it, so running loop() is a walk over that
+ * tree instead of a walk over the tokens.
+ *
+ * Values behave like they do in the interpreter: integer expressions are
+ * computed on long and truncated to int, floating point is double, pointer
+ * arithmetic and the run time error messages are the same. Natives from
+ * the platform and C library are called with the same parameter layout.
+ *
+ * Anything the compiler does not handle (goto, local struct definitions,
+ * macros with parameters, calls returning structs, ...) makes it give up
+ * and the caller keeps running loop() through the interpreter. The same
+ * happens if the tree would take more than half of the free stack space.
+ *
+ * The interpreter is followed where it differs from C: '&&', '||' and
+ * '?:' evaluate all of their operands, and integer division by zero or
+ * indexing a NULL pointer fault the same way. The interpreter leaves out
+ * some calls in the right operand of '&&' and '||', depending on the
+ * operators around them, so such a call makes the compiler give up.
+ *
+ * The only difference left is that run time errors point at the start of
+ * the statement.
+ */
+
+// conditional compilation of the module
+#include "pios.h"
+#ifdef PIOS_INCLUDE_PICOC
+
+#include "openpilot.h"
+#include "picoc_port.h"
+#include <setjmp.h>
+#include "interpreter.h"
+
+#ifndef NO_FP
+
+extern jmp_buf PicocExitBuf;
+
+// Private constants
+#define COMPILE_CHUNK_SIZE		512		/* the compiled tree is carved from chunks this big */
+#define COMPILE_MACRO_DEPTH		16		/* macros expanding to macros, more is probably a loop */
+#define COMPILE_STACK_SHARE		2		/* the compiled tree takes at most half of the free stack space */
+
+/* what a compiled expression evaluates to */
+enum CompiledKind
+{
+	KindUnsupported,
+	KindVoid,
+	KindInt,
+	KindFP,
+	KindPointer,
+	KindAggregate
+};
+
+/* how a compiled statement finished */
+enum CompiledFlow
+{
+	FlowNext,
+	FlowBreak,
+	FlowContinue,
+	FlowReturn
+};
+
+union CompiledValue
+{
+	long Integer;
+	double FP;
+	void *Pointer;
+};
+
+struct CompiledExpr;
+struct CompiledStmt;
+
+typedef long CompiledIntEval(struct CompiledExpr *, char *);
+typedef double CompiledFPEval(struct CompiledExpr *, char *);
+typedef void *CompiledPointerEval(struct CompiledExpr *, char *);
+typedef enum CompiledFlow CompiledExec(struct CompiledStmt *, char *);
+
+/**
+ * A compiled expression. Integers evaluate to a long like
+ * ExpressionCoerceInteger() gives it, aggregates evaluate to their address.
+ * Expressions that can be assigned to also have an Address function.
+ */
+struct CompiledExpr
+{
+	union
+	{
+		CompiledIntEval *Int;
+		CompiledFPEval *FP;
+		CompiledPointerEval *Pointer;
+	} Eval;
+	CompiledPointerEval *Address;
+	struct ValueType *Typ;
+	struct CompiledExpr *A;
+	struct CompiledExpr *B;
+	union CompiledValue Imm;		/* constant, frame offset, element size... */
+	void *Extra;					/* error position, call or third operand */
+	unsigned char Op;				/* the operator of compound assignments */
+	unsigned char IsLValue;
+	unsigned char IsConst;
+};
+
+/* a compiled statement, statements of a block are linked with Next */
+struct CompiledStmt
+{
+	CompiledExec *Exec;
+	struct CompiledStmt *Next;
+	struct CompiledExpr *Expr;
+	struct CompiledStmt *Step;
+	struct CompiledStmt *Body;
+	struct CompiledStmt *Else;
+	struct CompiledCase *Cases;
+	int NumCases;
+	int Visited;				/* static initialisers */
+};
+
+struct CompiledCase
+{
+	int Value;
+	int IsDefault;
+	struct CompiledStmt *Start;
+};
+
+/* a compiled script function, its locals live in a frame on the picoc stack */
+struct CompiledFunction
+{
+	struct CompiledFunction *Next;
+	struct FuncDef *Def;
+	const char *Name;
+	struct CompiledStmt *Body;
+	struct ParseState *Where;
+	int FrameSize;
+	int *ParamOffset;
+	Picoc *pc;
+};
+
+/* the arguments and return value of a call */
+struct CompiledCall
+{
+	struct FuncDef *Def;
+	struct CompiledFunction *Target;	/* script functions */
+	struct CompiledExpr **Args;
+	struct Value **Param;				/* natives get the arguments as values */
+	struct Value *ReturnValue;
+	struct ParseState *Where;
+	int NumArgs;
+};
+
+struct CompileChunk
+{
+	struct CompileChunk *Next;
+	int Used;
+	int Size;
+};
+
+/* a static local the compiler had to create */
+struct CompileStatic
+{
+	struct CompileStatic *Next;
+	char *Name;
+};
+
+struct CompiledProgram
+{
+	Picoc *pc;
+	struct CompileChunk *Chunks;
+	struct CompiledFunction *Functions;
+	struct CompiledFunction *Entry;
+	struct CompileStatic *Statics;
+	const char *Reason;
+	int ReasonLine;
+	int StackReserve;
+};
+
+/* a local variable visible at the current point of compilation */
+struct CompileLocal
+{
+	struct CompileLocal *Next;
+	const char *Ident;
+	struct ValueType *Typ;
+	void *Static;				/* data of a static local, or NULL */
+	int Offset;					/* in the frame */
+	int Depth;					/* block nesting it was declared in */
+};
+
+/* the state of compiling one function */
+struct CompileState
+{
+	Picoc *pc;
+	struct CompiledProgram *Program;
+	struct CompiledFunction *Func;
+	struct ParseState Parser;
+	struct ParseState StatementStart;
+	struct ParseState *Where;	/* StatementStart for run time errors, made on demand */
+	struct CompileLocal *Locals;
+	int Depth;
+	int Loops;
+	int Breakable;
+	int MacroDepth;
+	int SkipCalls;				/* in the right operand of '&&' or '||' */
+};
+
+// Private functions
+static struct CompiledFunction *CompileFunction(struct CompiledProgram *Program, struct Value *FuncValue, const char *Name);
+static struct CompiledExpr *CompileExpression(struct CompileState *S);
+static struct CompiledExpr *CompileAssignment(struct CompileState *S);
+static struct CompiledExpr *CompileUnary(struct CompileState *S);
+static struct CompiledStmt *CompileStatement(struct CompileState *S);
+
+#define EVAL_INT(E, Frame) ((E)->Eval.Int((E), (Frame)))
+#define EVAL_FP(E, Frame) ((E)->Eval.FP((E), (Frame)))
+#define EVAL_POINTER(E, Frame) ((E)->Eval.Pointer((E), (Frame)))
+#define EVAL_ADDRESS(E, Frame) ((E)->Address((E), (Frame)))
+#define IS_UNSIGNED_BASE(b) ((b) >= TypeUnsignedInt && (b) <= TypeUnsignedLong)
+
+static enum CompiledKind CompiledKindOf(struct ValueType *Typ)
+{
+	if (IS_INTEGER_NUMERIC_TYPE(Typ))
+		return KindInt;
+
+	switch (Typ->Base)
+	{
+	case TypeVoid:
+		return KindVoid;
+	case TypeFP:
+		return KindFP;
+	case TypePointer:
+		return KindPointer;
+	case TypeArray:
+	case TypeStruct:
+	case TypeUnion:
+		return KindAggregate;
+	default:
+		return KindUnsupported;
+	}
+}
+
+/**
+ * integer storage
+ */
+static long LoadIntAt(const void *Addr, enum BaseType Base)
+{
+	switch (Base)
+	{
+	case TypeInt:			return *(const int *)Addr;
+	case TypeShort:			return *(const short *)Addr;
+	case TypeChar:			return *(const char *)Addr;
+	case TypeLong:			return *(const long *)Addr;
+	case TypeUnsignedInt:	return *(const unsigned int *)Addr;
+	case TypeUnsignedShort:	return *(const unsigned short *)Addr;
+	case TypeUnsignedChar:	return *(const unsigned char *)Addr;
+	case TypeUnsignedLong:	return (long)*(const unsigned long *)Addr;
+	default:				return 0;
+	}
+}
+
+static void StoreIntAt(void *Addr, enum BaseType Base, long Value)
+{
+	switch (Base)
+	{
+	case TypeInt:			*(int *)Addr = (int)Value; break;
+	case TypeShort:			*(short *)Addr = (short)Value; break;
+	case TypeChar:			*(char *)Addr = (char)Value; break;
+	case TypeLong:			*(long *)Addr = Value; break;
+	case TypeUnsignedInt:	*(unsigned int *)Addr = (unsigned int)Value; break;
+	case TypeUnsignedShort:	*(unsigned short *)Addr = (unsigned short)Value; break;
+	case TypeUnsignedChar:	*(unsigned char *)Addr = (unsigned char)Value; break;
+	case TypeUnsignedLong:	*(unsigned long *)Addr = (unsigned long)Value; break;
+	default:				break;
+	}
+}
+
+/* the value an integer has after it went through a variable of this type */
+static long TruncateInt(enum BaseType Base, long Value)
+{
+	long Result = 0;
+
+	StoreIntAt(&Result, Base, Value);
+	return LoadIntAt(&Result, Base);
+}
+
+/**
+ * constants, variables and addresses
+ */
+static long ConstInt(struct CompiledExpr *E, char *Frame)
+{
+	return E->Imm.Integer;
+}
+
+static double ConstFP(struct CompiledExpr *E, char *Frame)
+{
+	return E->Imm.FP;
+}
+
+static void *ConstPointer(struct CompiledExpr *E, char *Frame)
+{
+	return E->Imm.Pointer;
+}
+
+static void *LocalAddress(struct CompiledExpr *E, char *Frame)
+{
+	return Frame + E->Imm.Integer;
+}
+
+static void *GlobalAddress(struct CompiledExpr *E, char *Frame)
+{
+	return E->Imm.Pointer;
+}
+
+static void *ArrayElementAddress(struct CompiledExpr *E, char *Frame)
+{
+	char *Base = EVAL_ADDRESS(E->A, Frame);
+	int Index = EVAL_INT(E->B, Frame);
+
+	return Base + Index * E->Imm.Integer;
+}
+
+static void *PointerElementAddress(struct CompiledExpr *E, char *Frame)
+{
+	char *Base = EVAL_POINTER(E->A, Frame);
+	int Index = EVAL_INT(E->B, Frame);
+
+	return Base + Index * E->Imm.Integer;
+}
+
+static void *MemberAddress(struct CompiledExpr *E, char *Frame)
+{
+	return (char *)EVAL_ADDRESS(E->A, Frame) + E->Imm.Integer;
+}
+
+static void *ArrowAddress(struct CompiledExpr *E, char *Frame)
+{
+	char *Base = EVAL_POINTER(E->A, Frame);
+
+	return Base + E->Imm.Integer;
+}
+
+static void *DerefAddress(struct CompiledExpr *E, char *Frame)
+{
+	void *Pointer = EVAL_POINTER(E->A, Frame);
+
+	if (Pointer == NULL)
+		ProgramFail(E->Extra, "NULL pointer dereference");
+
+	return Pointer;
+}
+
+static void *AddressOf(struct CompiledExpr *E, char *Frame)
+{
+	return EVAL_ADDRESS(E->A, Frame);
+}
+
+/* integer loads of locals, globals and everything else with an address */
+#define COMPILED_INT_LOAD(Name, CType) \
+	static long Name##Local(struct CompiledExpr *E, char *Frame) \
+	{ \
+		return (long)*(CType *)(Frame + E->Imm.Integer); \
+	} \
+	static long Name##Global(struct CompiledExpr *E, char *Frame) \
+	{ \
+		return (long)*(CType *)E->Imm.Pointer; \
+	} \
+	static long Name(struct CompiledExpr *E, char *Frame) \
+	{ \
+		return (long)*(CType *)EVAL_ADDRESS(E, Frame); \
+	}
+
+COMPILED_INT_LOAD(LoadInt, int)
+COMPILED_INT_LOAD(LoadShort, short)
+COMPILED_INT_LOAD(LoadChar, char)
+COMPILED_INT_LOAD(LoadLong, long)
+COMPILED_INT_LOAD(LoadUnsignedInt, unsigned int)
+COMPILED_INT_LOAD(LoadUnsignedShort, unsigned short)
+COMPILED_INT_LOAD(LoadUnsignedChar, unsigned char)
+COMPILED_INT_LOAD(LoadUnsignedLong, unsigned long)
+
+/* in the order of enum BaseType, from TypeInt */
+static CompiledIntEval * const IntLoads[][3] =
+{
+	{ LoadIntLocal, LoadIntGlobal, LoadInt },
+	{ LoadShortLocal, LoadShortGlobal, LoadShort },
+	{ LoadCharLocal, LoadCharGlobal, LoadChar },
+	{ LoadLongLocal, LoadLongGlobal, LoadLong },
+	{ LoadUnsignedIntLocal, LoadUnsignedIntGlobal, LoadUnsignedInt },
+	{ LoadUnsignedShortLocal, LoadUnsignedShortGlobal, LoadUnsignedShort },
+	{ LoadUnsignedCharLocal, LoadUnsignedCharGlobal, LoadUnsignedChar },
+	{ LoadUnsignedLongLocal, LoadUnsignedLongGlobal, LoadUnsignedLong },
+};
+
+static double LoadFPLocal(struct CompiledExpr *E, char *Frame)
+{
+	return *(double *)(Frame + E->Imm.Integer);
+}
+
+static double LoadFPGlobal(struct CompiledExpr *E, char *Frame)
+{
+	return *(double *)E->Imm.Pointer;
+}
+
+static double LoadFP(struct CompiledExpr *E, char *Frame)
+{
+	return *(double *)EVAL_ADDRESS(E, Frame);
+}
+
+static void *LoadPointerLocal(struct CompiledExpr *E, char *Frame)
+{
+	return *(void **)(Frame + E->Imm.Integer);
+}
+
+static void *LoadPointerGlobal(struct CompiledExpr *E, char *Frame)
+{
+	return *(void **)E->Imm.Pointer;
+}
+
+static void *LoadPointer(struct CompiledExpr *E, char *Frame)
+{
+	return *(void **)EVAL_ADDRESS(E, Frame);
+}
+
+/**
+ * conversions
+ */
+static double IntToFP(struct CompiledExpr *E, char *Frame)
+{
+	return (double)EVAL_INT(E->A, Frame);
+}
+
+static double UnsignedToFP(struct CompiledExpr *E, char *Frame)
+{
+	return (double)(unsigned long)EVAL_INT(E->A, Frame);
+}
+
+static long FPToInt(struct CompiledExpr *E, char *Frame)
+{
+	return (long)EVAL_FP(E->A, Frame);
+}
+
+static long FPToUnsigned(struct CompiledExpr *E, char *Frame)
+{
+	return (long)(unsigned long)EVAL_FP(E->A, Frame);
+}
+
+static long CastInt(struct CompiledExpr *E, char *Frame)
+{
+	return TruncateInt(E->Typ->Base, EVAL_INT(E->A, Frame));
+}
+
+static long PointerToInt(struct CompiledExpr *E, char *Frame)
+{
+	return (long)EVAL_POINTER(E->A, Frame);
+}
+
+static void *IntToPointer(struct CompiledExpr *E, char *Frame)
+{
+	return (void *)(unsigned long)EVAL_INT(E->A, Frame);
+}
+
+static void *NumberToNullPointer(struct CompiledExpr *E, char *Frame)
+{
+	if (EVAL_INT(E->A, Frame) != 0)
+		AssignFail(E->Extra, "%t from %t", E->Typ, E->A->Typ, 0, 0, NULL, 0);
+
+	return NULL;
+}
+
+/**
+ * arithmetic, integers are computed on long and the result is an int
+ */
+#define COMPILED_INT_OP(Name, Op) \
+	static long Name(struct CompiledExpr *E, char *Frame) \
+	{ \
+		long Left = EVAL_INT(E->A, Frame); \
+		return (int)(Left Op EVAL_INT(E->B, Frame)); \
+	}
+
+COMPILED_INT_OP(IntAdd, +)
+COMPILED_INT_OP(IntSubtract, -)
+COMPILED_INT_OP(IntMultiply, *)
+COMPILED_INT_OP(IntShiftLeft, <<)
+COMPILED_INT_OP(IntShiftRight, >>)
+COMPILED_INT_OP(IntAnd, &)
+COMPILED_INT_OP(IntOr, |)
+COMPILED_INT_OP(IntExor, ^)
+COMPILED_INT_OP(IntEqual, ==)
+COMPILED_INT_OP(IntNotEqual, !=)
+COMPILED_INT_OP(IntLessThan, <)
+COMPILED_INT_OP(IntGreaterThan, >)
+COMPILED_INT_OP(IntLessEqual, <=)
+COMPILED_INT_OP(IntGreaterEqual, >=)
+
+static long IntDivide(struct CompiledExpr *E, char *Frame)
+{
+	long Left = EVAL_INT(E->A, Frame);
+	long Right = EVAL_INT(E->B, Frame);
+
+	return (int)(Left / Right);
+}
+
+static long IntModulus(struct CompiledExpr *E, char *Frame)
+{
+	long Left = EVAL_INT(E->A, Frame);
+	long Right = EVAL_INT(E->B, Frame);
+
+	return (int)(Left % Right);
+}
+
+/* both operands are evaluated, like the interpreter does */
+static long IntLogicalAnd(struct CompiledExpr *E, char *Frame)
+{
+	long Left = EVAL_INT(E->A, Frame);
+	long Right = EVAL_INT(E->B, Frame);
+
+	return Left && Right;
+}
+
+static long IntLogicalOr(struct CompiledExpr *E, char *Frame)
+{
+	long Left = EVAL_INT(E->A, Frame);
+	long Right = EVAL_INT(E->B, Frame);
+
+	return Left || Right;
+}
+
+static long IntPlus(struct CompiledExpr *E, char *Frame)
+{
+	return (int)EVAL_INT(E->A, Frame);
+}
+
+static long IntNegate(struct CompiledExpr *E, char *Frame)
+{
+	return (int)-EVAL_INT(E->A, Frame);
+}
+
+static long IntNot(struct CompiledExpr *E, char *Frame)
+{
+	return !EVAL_INT(E->A, Frame);
+}
+
+static long IntComplement(struct CompiledExpr *E, char *Frame)
+{
+	return (int)~EVAL_INT(E->A, Frame);
+}
+
+#define COMPILED_FP_OP(Name, Op) \
+	static double Name(struct CompiledExpr *E, char *Frame) \
+	{ \
+		double Left = EVAL_FP(E->A, Frame); \
+		return Left Op EVAL_FP(E->B, Frame); \
+	}
+
+COMPILED_FP_OP(FPAdd, +)
+COMPILED_FP_OP(FPSubtract, -)
+COMPILED_FP_OP(FPMultiply, *)
+COMPILED_FP_OP(FPDivide, /)
+
+#define COMPILED_FP_COMPARE(Name, Op) \
+	static long Name(struct CompiledExpr *E, char *Frame) \
+	{ \
+		double Left = EVAL_FP(E->A, Frame); \
+		return Left Op EVAL_FP(E->B, Frame); \
+	}
+
+COMPILED_FP_COMPARE(FPEqual, ==)
+COMPILED_FP_COMPARE(FPNotEqual, !=)
+COMPILED_FP_COMPARE(FPLessThan, <)
+COMPILED_FP_COMPARE(FPGreaterThan, >)
+COMPILED_FP_COMPARE(FPLessEqual, <=)
+COMPILED_FP_COMPARE(FPGreaterEqual, >=)
+
+static double FPNegate(struct CompiledExpr *E, char *Frame)
+{
+	return -EVAL_FP(E->A, Frame);
+}
+
+static double FPNot(struct CompiledExpr *E, char *Frame)
+{
+	return !EVAL_FP(E->A, Frame);
+}
+
+static void *PointerAdd(struct CompiledExpr *E, char *Frame)
+{
+	char *Pointer = EVAL_POINTER(E->A, Frame);
+	long Offset = EVAL_INT(E->B, Frame);
+
+	if (Pointer == NULL)
+		ProgramFail(E->Extra, "invalid use of a NULL pointer");
+
+	return Pointer + Offset * E->Imm.Integer;
+}
+
+static long PointerIsNull(struct CompiledExpr *E, char *Frame)
+{
+	void *Pointer = EVAL_POINTER(E->A, Frame);
+
+	if (E->B != NULL && EVAL_INT(E->B, Frame) != 0)
+		ProgramFail(E->Extra, "invalid operation");
+
+	return Pointer == NULL;
+}
+
+static long PointerNotNull(struct CompiledExpr *E, char *Frame)
+{
+	void *Pointer = EVAL_POINTER(E->A, Frame);
+
+	if (E->B != NULL && EVAL_INT(E->B, Frame) != 0)
+		ProgramFail(E->Extra, "invalid operation");
+
+	return Pointer != NULL;
+}
+
+static long PointerEqual(struct CompiledExpr *E, char *Frame)
+{
+	char *Left = EVAL_POINTER(E->A, Frame);
+	return Left == (char *)EVAL_POINTER(E->B, Frame);
+}
+
+static long PointerNotEqual(struct CompiledExpr *E, char *Frame)
+{
+	char *Left = EVAL_POINTER(E->A, Frame);
+	return Left != (char *)EVAL_POINTER(E->B, Frame);
+}
+
+static long PointerDifference(struct CompiledExpr *E, char *Frame)
+{
+	char *Left = EVAL_POINTER(E->A, Frame);
+	return (int)(Left - (char *)EVAL_POINTER(E->B, Frame));
+}
+
+/* the interpreter evaluates both branches of '?:' and then picks one */
+static long IntConditional(struct CompiledExpr *E, char *Frame)
+{
+	long Condition = EVAL_INT(E->A, Frame);
+	long Then = EVAL_INT(E->B, Frame);
+	long Else = EVAL_INT((struct CompiledExpr *)E->Extra, Frame);
+
+	return Condition ? Then : Else;
+}
+
+static double FPConditional(struct CompiledExpr *E, char *Frame)
+{
+	long Condition = EVAL_INT(E->A, Frame);
+	double Then = EVAL_FP(E->B, Frame);
+	double Else = EVAL_FP((struct CompiledExpr *)E->Extra, Frame);
+
+	return Condition ? Then : Else;
+}
+
+static void *PointerConditional(struct CompiledExpr *E, char *Frame)
+{
+	long Condition = EVAL_INT(E->A, Frame);
+	void *Then = EVAL_POINTER(E->B, Frame);
+	void *Else = EVAL_POINTER((struct CompiledExpr *)E->Extra, Frame);
+
+	return Condition ? Then : Else;
+}
+
+/**
+ * assignments, A is the destination and B the value
+ */
+static long IntApply(struct CompiledExpr *E, long Left, long Right)
+{
+	switch (E->Op)
+	{
+	case TokenAddAssign:			return Left + Right;
+	case TokenSubtractAssign:		return Left - Right;
+	case TokenMultiplyAssign:		return Left * Right;
+	case TokenDivideAssign:			return Left / Right;
+	case TokenModulusAssign:		return Left % Right;
+	case TokenShiftLeftAssign:		return Left << Right;
+	case TokenShiftRightAssign:		return Left >> Right;
+	case TokenArithmeticAndAssign:	return Left & Right;
+	case TokenArithmeticOrAssign:	return Left | Right;
+	case TokenArithmeticExorAssign:	return Left ^ Right;
+	default:						return Right;
+	}
+}
+
+static double FPApply(struct CompiledExpr *E, double Left, double Right)
+{
+	switch (E->Op)
+	{
+	case TokenAddAssign:			return Left + Right;
+	case TokenSubtractAssign:		return Left - Right;
+	case TokenMultiplyAssign:		return Left * Right;
+	case TokenDivideAssign:			return Left / Right;
+	default:						return Right;
+	}
+}
+
+static long AssignLocalInt(struct CompiledExpr *E, char *Frame)
+{
+	long Value = EVAL_INT(E->B, Frame);
+
+	*(int *)(Frame + E->A->Imm.Integer) = (int)Value;
+	return (int)Value;
+}
+
+static long AssignInt(struct CompiledExpr *E, char *Frame)
+{
+	void *Addr = EVAL_ADDRESS(E->A, Frame);
+	long Value = EVAL_INT(E->B, Frame);
+
+	StoreIntAt(Addr, E->A->Typ->Base, Value);
+	return (int)Value;
+}
+
+static long AssignOpInt(struct CompiledExpr *E, char *Frame)
+{
+	void *Addr = EVAL_ADDRESS(E->A, Frame);
+	long Value = EVAL_INT(E->B, Frame);
+
+	Value = IntApply(E, LoadIntAt(Addr, E->A->Typ->Base), Value);
+	StoreIntAt(Addr, E->A->Typ->Base, Value);
+	return (int)Value;
+}
+
+static long AssignOpIntFromFP(struct CompiledExpr *E, char *Frame)
+{
+	void *Addr = EVAL_ADDRESS(E->A, Frame);
+	double Value = EVAL_FP(E->B, Frame);
+	long Result = (long)FPApply(E, (double)LoadIntAt(Addr, E->A->Typ->Base), Value);
+
+	StoreIntAt(Addr, E->A->Typ->Base, Result);
+	return (int)Result;
+}
+
+static double AssignLocalFP(struct CompiledExpr *E, char *Frame)
+{
+	double Value = EVAL_FP(E->B, Frame);
+
+	*(double *)(Frame + E->A->Imm.Integer) = Value;
+	return Value;
+}
+
+static double AssignFP(struct CompiledExpr *E, char *Frame)
+{
+	double *Addr = EVAL_ADDRESS(E->A, Frame);
+	double Value = EVAL_FP(E->B, Frame);
+
+	*Addr = Value;
+	return Value;
+}
+
+static double AssignOpFP(struct CompiledExpr *E, char *Frame)
+{
+	double *Addr = EVAL_ADDRESS(E->A, Frame);
+	double Value = EVAL_FP(E->B, Frame);
+
+	*Addr = FPApply(E, *Addr, Value);
+	return *Addr;
+}
+
+static void *AssignPointer(struct CompiledExpr *E, char *Frame)
+{
+	void **Addr = EVAL_ADDRESS(E->A, Frame);
+	void *Value = EVAL_POINTER(E->B, Frame);
+
+	*Addr = Value;
+	return Value;
+}
+
+static void *AssignOpPointer(struct CompiledExpr *E, char *Frame)
+{
+	char **Addr = EVAL_ADDRESS(E->A, Frame);
+	long Offset = EVAL_INT(E->B, Frame);
+
+	if (*Addr == NULL)
+		ProgramFail(E->Extra, "invalid use of a NULL pointer");
+
+	*Addr += Offset * E->Imm.Integer;
+	return *Addr;
+}
+
+static void *AssignAggregate(struct CompiledExpr *E, char *Frame)
+{
+	void *Addr = EVAL_ADDRESS(E->A, Frame);
+
+	memcpy(Addr, EVAL_ADDRESS(E->B, Frame), E->Imm.Integer);
+	return Addr;
+}
+
+/* ++ and --, the step is in Imm */
+static long PreStepInt(struct CompiledExpr *E, char *Frame)
+{
+	void *Addr = EVAL_ADDRESS(E->A, Frame);
+	long Value = LoadIntAt(Addr, E->A->Typ->Base) + E->Imm.Integer;
+
+	StoreIntAt(Addr, E->A->Typ->Base, Value);
+	return (int)Value;
+}
+
+static long PostStepInt(struct CompiledExpr *E, char *Frame)
+{
+	void *Addr = EVAL_ADDRESS(E->A, Frame);
+	long Value = LoadIntAt(Addr, E->A->Typ->Base);
+
+	StoreIntAt(Addr, E->A->Typ->Base, Value + E->Imm.Integer);
+	return (int)Value;
+}
+
+static long PostStepLocalInt(struct CompiledExpr *E, char *Frame)
+{
+	int *Addr = (int *)(Frame + E->A->Imm.Integer);
+	int Value = *Addr;
+
+	*Addr = (int)(Value + E->Imm.Integer);
+	return Value;
+}
+
+static double StepFP(struct CompiledExpr *E, char *Frame)
+{
+	double *Addr = EVAL_ADDRESS(E->A, Frame);
+
+	*Addr += E->Imm.Integer;
+	return *Addr;
+}
+
+static void *PreStepPointer(struct CompiledExpr *E, char *Frame)
+{
+	char **Addr = EVAL_ADDRESS(E->A, Frame);
+
+	if (*Addr == NULL)
+		ProgramFail(E->Extra, "invalid use of a NULL pointer");
+
+	*Addr += E->Imm.Integer;
+	return *Addr;
+}
+
+static void *PostStepPointer(struct CompiledExpr *E, char *Frame)
+{
+	char **Addr = EVAL_ADDRESS(E->A, Frame);
+	char *Value = *Addr;
+
+	if (Value == NULL)
+		ProgramFail(E->Extra, "invalid use of a NULL pointer");
+
+	*Addr = Value + E->Imm.Integer;
+	return Value;
+}
+
+/**
+ * calls
+ */
+static void EvalValue(struct CompiledExpr *E, char *Frame, union CompiledValue *Result)
+{
+	switch (CompiledKindOf(E->Typ))
+	{
+	case KindInt:
+		Result->Integer = EVAL_INT(E, Frame);
+		break;
+	case KindFP:
+		Result->FP = EVAL_FP(E, Frame);
+		break;
+	default:
+		Result->Pointer = EVAL_POINTER(E, Frame);
+		break;
+	}
+}
+
+static void StoreValue(void *Addr, struct ValueType *Typ, union CompiledValue *Value)
+{
+	switch (CompiledKindOf(Typ))
+	{
+	case KindInt:
+		StoreIntAt(Addr, Typ->Base, Value->Integer);
+		break;
+	case KindFP:
+		*(double *)Addr = Value->FP;
+		break;
+	case KindPointer:
+		*(void **)Addr = Value->Pointer;
+		break;
+	default:
+		break;
+	}
+}
+
+static void CallNative(struct CompiledExpr *E, char *Frame)
+{
+	struct CompiledCall *Call = E->Extra;
+	union CompiledValue Args[PARAMETER_MAX];
+	int Count;
+
+	/* evaluate everything before the values are touched, the arguments may be calls too */
+	for (Count = 0; Count < Call->NumArgs; Count++)
+		EvalValue(Call->Args[Count], Frame, &Args[Count]);
+
+	for (Count = 0; Count < Call->NumArgs; Count++)
+		StoreValue(Call->Param[Count]->Val, Call->Param[Count]->Typ, &Args[Count]);
+
+	Call->Def->Intrinsic(Call->Where, Call->ReturnValue, Call->Param, Call->NumArgs);
+}
+
+static long CallNativeInt(struct CompiledExpr *E, char *Frame)
+{
+	struct CompiledCall *Call = E->Extra;
+
+	CallNative(E, Frame);
+	return LoadIntAt(Call->ReturnValue->Val, E->Typ->Base);
+}
+
+static double CallNativeFP(struct CompiledExpr *E, char *Frame)
+{
+	struct CompiledCall *Call = E->Extra;
+
+	CallNative(E, Frame);
+	return Call->ReturnValue->Val->FP;
+}
+
+static void *CallNativePointer(struct CompiledExpr *E, char *Frame)
+{
+	struct CompiledCall *Call = E->Extra;
+
+	CallNative(E, Frame);
+	return Call->ReturnValue->Val->Pointer;
+}
+
+static void *CallNativeVoid(struct CompiledExpr *E, char *Frame)
+{
+	CallNative(E, Frame);
+	return NULL;
+}
+
+/* runs a compiled function in a new frame, the return value is in its first slot */
+static void RunFunction(struct CompiledFunction *Func, struct ParseState *Where, union CompiledValue *Args, union CompiledValue *Result)
+{
+	Picoc *pc = Func->pc;
+	char *Frame;
+	int Count;
+
+	HeapPushStackFrame(pc);
+	Frame = HeapAllocStack(pc, Func->FrameSize);
+	if (Frame == NULL)
+		ProgramFail(Where, "out of memory");
+
+	for (Count = 0; Count < Func->Def->NumParams; Count++)
+		StoreValue(Frame + Func->ParamOffset[Count], Func->Def->ParamType[Count], &Args[Count]);
+
+	if (Func->Body->Exec(Func->Body, Frame) != FlowReturn && Func->Def->ReturnType != &pc->VoidType)
+		ProgramFail(Func->Where, "no value returned from a function returning %t", Func->Def->ReturnType);
+
+	*Result = *(union CompiledValue *)Frame;
+	HeapPopStackFrame(pc);
+}
+
+static void CallScript(struct CompiledExpr *E, char *Frame, union CompiledValue *Result)
+{
+	struct CompiledCall *Call = E->Extra;
+	union CompiledValue Args[PARAMETER_MAX];
+	int Count;
+
+	for (Count = 0; Count < Call->NumArgs; Count++)
+		EvalValue(Call->Args[Count], Frame, &Args[Count]);
+
+	RunFunction(Call->Target, Call->Where, Args, Result);
+}
+
+static long CallScriptInt(struct CompiledExpr *E, char *Frame)
+{
+	union CompiledValue Result;
+
+	CallScript(E, Frame, &Result);
+	return Result.Integer;
+}
+
+static double CallScriptFP(struct CompiledExpr *E, char *Frame)
+{
+	union CompiledValue Result;
+
+	CallScript(E, Frame, &Result);
+	return Result.FP;
+}
+
+static void *CallScriptPointer(struct CompiledExpr *E, char *Frame)
+{
+	union CompiledValue Result;
+
+	CallScript(E, Frame, &Result);
+	return Result.Pointer;
+}
+
+/**
+ * statements
+ */
+static enum CompiledFlow ExecIntExpr(struct CompiledStmt *Stmt, char *Frame)
+{
+	EVAL_INT(Stmt->Expr, Frame);
+	return FlowNext;
+}
+
+static enum CompiledFlow ExecFPExpr(struct CompiledStmt *Stmt, char *Frame)
+{
+	EVAL_FP(Stmt->Expr, Frame);
+	return FlowNext;
+}
+
+static enum CompiledFlow ExecPointerExpr(struct CompiledStmt *Stmt, char *Frame)
+{
+	EVAL_POINTER(Stmt->Expr, Frame);
+	return FlowNext;
+}
+
+static enum CompiledFlow ExecNothing(struct CompiledStmt *Stmt, char *Frame)
+{
+	return FlowNext;
+}
+
+static enum CompiledFlow ExecList(struct CompiledStmt *Stmt, char *Frame)
+{
+	enum CompiledFlow Flow;
+
+	for (Stmt = Stmt->Body; Stmt != NULL; Stmt = Stmt->Next)
+	{
+		Flow = Stmt->Exec(Stmt, Frame);
+		if (Flow != FlowNext)
+			return Flow;
+	}
+
+	return FlowNext;
+}
+
+static enum CompiledFlow ExecIf(struct CompiledStmt *Stmt, char *Frame)
+{
+	if (EVAL_INT(Stmt->Expr, Frame))
+		return Stmt->Body->Exec(Stmt->Body, Frame);
+
+	if (Stmt->Else != NULL)
+		return Stmt->Else->Exec(Stmt->Else, Frame);
+
+	return FlowNext;
+}
+
+static enum CompiledFlow ExecWhile(struct CompiledStmt *Stmt, char *Frame)
+{
+	enum CompiledFlow Flow;
+
+	while (EVAL_INT(Stmt->Expr, Frame))
+	{
+		Flow = Stmt->Body->Exec(Stmt->Body, Frame);
+		if (Flow == FlowBreak)
+			break;
+		if (Flow == FlowReturn)
+			return FlowReturn;
+	}
+
+	return FlowNext;
+}
+
+static enum CompiledFlow ExecDo(struct CompiledStmt *Stmt, char *Frame)
+{
+	enum CompiledFlow Flow;
+
+	do
+	{
+		Flow = Stmt->Body->Exec(Stmt->Body, Frame);
+		if (Flow == FlowBreak)
+			break;
+		if (Flow == FlowReturn)
+			return FlowReturn;
+	} while (EVAL_INT(Stmt->Expr, Frame));
+
+	return FlowNext;
+}
+
+/* Else is the initialiser, Expr the condition and Step the step */
+static enum CompiledFlow ExecFor(struct CompiledStmt *Stmt, char *Frame)
+{
+	enum CompiledFlow Flow;
+
+	if (Stmt->Else != NULL && Stmt->Else->Exec(Stmt->Else, Frame) == FlowReturn)
+		return FlowReturn;
+
+	while (Stmt->Expr == NULL || EVAL_INT(Stmt->Expr, Frame))
+	{
+		Flow = Stmt->Body->Exec(Stmt->Body, Frame);
+		if (Flow == FlowBreak)
+			break;
+		if (Flow == FlowReturn)
+			return FlowReturn;
+
+		if (Stmt->Step != NULL)
+			Stmt->Step->Exec(Stmt->Step, Frame);
+	}
+
+	return FlowNext;
+}
+
+/* the first label in the source that matches wins, like in the interpreter */
+static enum CompiledFlow ExecSwitch(struct CompiledStmt *Stmt, char *Frame)
+{
+	int Value = EVAL_INT(Stmt->Expr, Frame);
+	struct CompiledStmt *Start = NULL;
+	enum CompiledFlow Flow;
+	int Count;
+
+	for (Count = 0; Count < Stmt->NumCases; Count++)
+	{
+		if (Stmt->Cases[Count].IsDefault || Stmt->Cases[Count].Value == Value)
+		{
+			Start = Stmt->Cases[Count].Start;
+			break;
+		}
+	}
+
+	for (; Start != NULL; Start = Start->Next)
+	{
+		Flow = Start->Exec(Start, Frame);
+		if (Flow == FlowBreak)
+			break;
+		if (Flow != FlowNext)
+			return Flow;
+	}
+
+	return FlowNext;
+}
+
+static enum CompiledFlow ExecBreak(struct CompiledStmt *Stmt, char *Frame)
+{
+	return FlowBreak;
+}
+
+static enum CompiledFlow ExecContinue(struct CompiledStmt *Stmt, char *Frame)
+{
+	return FlowContinue;
+}
+
+static enum CompiledFlow ExecReturn(struct CompiledStmt *Stmt, char *Frame)
+{
+	if (Stmt->Expr != NULL)
+	{
+		union CompiledValue Value;
+
+		EvalValue(Stmt->Expr, Frame, &Value);
+		if (CompiledKindOf(Stmt->Expr->Typ) == KindInt)
+			Value.Integer = TruncateInt(Stmt->Expr->Typ->Base, Value.Integer);
+
+		*(union CompiledValue *)Frame = Value;
+	}
+
+	return FlowReturn;
+}
+
+/* a static local is initialised on the first visit, later visits only evaluate the initialiser in Else */
+static enum CompiledFlow ExecStaticInit(struct CompiledStmt *Stmt, char *Frame)
+{
+	if (!Stmt->Visited)
+	{
+		Stmt->Visited = TRUE;
+		return Stmt->Body->Exec(Stmt->Body, Frame);
+	}
+
+	if (Stmt->Else != NULL)
+		return Stmt->Else->Exec(Stmt->Else, Frame);
+
+	return FlowNext;
+}
+
+/**
+ * compiler support
+ */
+static void CompileBail(struct CompileState *S, const char *Reason)
+{
+	S->Program->Reason = Reason;
+	S->Program->ReasonLine = S->Parser.Line;
+	longjmp(PicocExitBuf, 1);
+}
+
+static void *CompileAlloc(struct CompileState *S, int Size)
+{
+	struct CompiledProgram *Program = S->Program;
+	struct CompileChunk *Chunk = Program->Chunks;
+	int Header = MEM_ALIGN(sizeof(struct CompileChunk));
+	void *Mem;
+
+	Size = MEM_ALIGN(Size);
+	if (Chunk == NULL || Chunk->Used + Size > Chunk->Size)
+	{
+		int ChunkSize = (Size > COMPILE_CHUNK_SIZE) ? Size : COMPILE_CHUNK_SIZE;
+
+		/* the stack grows towards the heap, leave it room to run the script */
+		if ((char *)S->pc->HeapBottom - (char *)S->pc->HeapStackTop - (Header + ChunkSize) < Program->StackReserve)
+			CompileBail(S, "out of memory");
+
+		Chunk = HeapAllocMem(S->pc, Header + ChunkSize);
+		if (Chunk == NULL)
+			CompileBail(S, "out of memory");
+
+		Chunk->Next = Program->Chunks;
+		Chunk->Used = 0;
+		Chunk->Size = ChunkSize;
+		Program->Chunks = Chunk;
+	}
+
+	Mem = (char *)Chunk + Header + Chunk->Used;
+	Chunk->Used += Size;
+	memset(Mem, 0, Size);
+	return Mem;
+}
+
+/* the position of the current statement, run time errors are reported there */
+static struct ParseState *CompileWhere(struct CompileState *S)
+{
+	if (S->Where == NULL)
+	{
+		S->Where = CompileAlloc(S, sizeof(struct ParseState));
+		ParserCopy(S->Where, &S->StatementStart);
+	}
+
+	return S->Where;
+}
+
+static enum LexToken CompilePeek(struct CompileState *S, struct Value **Value)
+{
+	return LexGetToken(&S->Parser, Value, FALSE);
+}
+
+static enum LexToken CompileNext(struct CompileState *S, struct Value **Value)
+{
+	return LexGetToken(&S->Parser, Value, TRUE);
+}
+
+static void CompileExpect(struct CompileState *S, enum LexToken Token)
+{
+	if (CompileNext(S, NULL) != Token)
+		CompileBail(S, "unexpected token");
+}
+
+static struct CompiledExpr *NewExpr(struct CompileState *S, struct ValueType *Typ)
+{
+	struct CompiledExpr *E = CompileAlloc(S, sizeof(struct CompiledExpr));
+
+	E->Typ = Typ;
+	return E;
+}
+
+static struct CompiledStmt *NewStmt(struct CompileState *S, CompiledExec *Exec)
+{
+	struct CompiledStmt *Stmt = CompileAlloc(S, sizeof(struct CompiledStmt));
+
+	Stmt->Exec = Exec;
+	return Stmt;
+}
+
+static struct CompiledExpr *NewIntConst(struct CompileState *S, struct ValueType *Typ, long Value)
+{
+	struct CompiledExpr *E = NewExpr(S, Typ);
+
+	E->Eval.Int = ConstInt;
+	E->Imm.Integer = Value;
+	E->IsConst = TRUE;
+	return E;
+}
+
+static struct CompiledExpr *NewUnary(struct CompileState *S, struct ValueType *Typ, struct CompiledExpr *A)
+{
+	struct CompiledExpr *E = NewExpr(S, Typ);
+
+	E->A = A;
+	E->IsConst = A->IsConst;
+	return E;
+}
+
+static struct CompiledExpr *NewBinary(struct CompileState *S, struct ValueType *Typ, struct CompiledExpr *A, struct CompiledExpr *B)
+{
+	struct CompiledExpr *E = NewExpr(S, Typ);
+
+	E->A = A;
+	E->B = B;
+	E->IsConst = A->IsConst && B->IsConst;
+	return E;
+}
+
+/* replaces an expression of constants by its value */
+static struct CompiledExpr *CompileFold(struct CompiledExpr *E)
+{
+	if (!E->IsConst || E->A == NULL)
+		return E;
+
+	switch (CompiledKindOf(E->Typ))
+	{
+	case KindInt:
+		E->Imm.Integer = EVAL_INT(E, NULL);
+		E->Eval.Int = ConstInt;
+		break;
+	case KindFP:
+		E->Imm.FP = EVAL_FP(E, NULL);
+		E->Eval.FP = ConstFP;
+		break;
+	default:
+		return E;
+	}
+
+	E->A = NULL;
+	E->B = NULL;
+	E->Extra = NULL;
+	return E;
+}
+
+/* an expression used as an integer, like ExpressionCoerceInteger() */
+static struct CompiledExpr *CompileToInt(struct CompileState *S, struct CompiledExpr *E)
+{
+	struct CompiledExpr *Result;
+
+	switch (CompiledKindOf(E->Typ))
+	{
+	case KindInt:
+		return E;
+	case KindFP:
+		Result = NewUnary(S, &S->pc->LongType, E);
+		Result->Eval.Int = FPToInt;
+		return CompileFold(Result);
+	default:
+		CompileBail(S, "integer value expected");
+		return NULL;
+	}
+}
+
+/* an integer in floating point arithmetic, always converted signed */
+static struct CompiledExpr *CompileToFP(struct CompileState *S, struct CompiledExpr *E)
+{
+	struct CompiledExpr *Result;
+
+	switch (CompiledKindOf(E->Typ))
+	{
+	case KindFP:
+		return E;
+	case KindInt:
+		Result = NewUnary(S, &S->pc->FPType, E);
+		Result->Eval.FP = IntToFP;
+		return CompileFold(Result);
+	default:
+		CompileBail(S, "numeric value expected");
+		return NULL;
+	}
+}
+
+/* a condition for if, while and friends, like ExpressionParseInt() */
+static struct CompiledExpr *CompileCondition(struct CompileState *S)
+{
+	return CompileToInt(S, CompileExpression(S));
+}
+
+/* a copy of an expression that is typed differently but has the same bits */
+static struct CompiledExpr *CompileRetype(struct CompileState *S, struct CompiledExpr *E, struct ValueType *Typ)
+{
+	struct CompiledExpr *Result = NewExpr(S, Typ);
+
+	*Result = *E;
+	Result->Typ = Typ;
+	Result->IsLValue = FALSE;
+	return Result;
+}
+
+/**
+ * converts a value for storing it in a variable of type Typ,
+ * this follows ExpressionAssign()
+ */
+static struct CompiledExpr *CompileConvert(struct CompileState *S, struct ValueType *Typ, struct CompiledExpr *E, int AllowPointerCoercion)
+{
+	Picoc *pc = S->pc;
+	enum CompiledKind From = CompiledKindOf(E->Typ);
+	struct CompiledExpr *Result;
+
+	switch (CompiledKindOf(Typ))
+	{
+	case KindInt:
+		if (From == KindInt)
+			return E;
+
+		if (From == KindFP)
+		{
+			Result = NewUnary(S, Typ, E);
+			Result->Eval.Int = IS_UNSIGNED_BASE(Typ->Base) ? FPToUnsigned : FPToInt;
+			return CompileFold(Result);
+		}
+
+		if (From == KindPointer && AllowPointerCoercion)
+		{
+			Result = NewUnary(S, Typ, E);
+			Result->Eval.Int = PointerToInt;
+			return Result;
+		}
+		break;
+
+	case KindFP:
+		if (From == KindFP)
+			return E;
+
+		if (From == KindInt)
+		{
+			Result = NewUnary(S, Typ, E);
+			Result->Eval.FP = IS_UNSIGNED_BASE(E->Typ->Base) ? UnsignedToFP : IntToFP;
+			return CompileFold(Result);
+		}
+		break;
+
+	case KindPointer:
+		if (From == KindPointer)
+		{
+			if (E->Typ == Typ || E->Typ == pc->VoidPtrType || Typ == pc->VoidPtrType || AllowPointerCoercion)
+				return CompileRetype(S, E, Typ);
+
+			/* pointer to an array of blah */
+			if (E->Typ->FromType->Base == TypeArray && E->Typ->FromType->FromType == Typ->FromType)
+				return CompileRetype(S, E, Typ);
+		}
+		else if (From == KindAggregate)
+		{
+			if (E->Typ->Base == TypeArray && (E->Typ->FromType == Typ->FromType || Typ == pc->VoidPtrType))
+			{
+				Result = NewUnary(S, Typ, E);
+				Result->Eval.Pointer = AddressOf;
+				Result->IsConst = FALSE;
+				return Result;
+			}
+		}
+		else if (From == KindInt || From == KindFP)
+		{
+			E = CompileToInt(S, E);
+			if (E->IsConst && (E->Imm.Integer == 0 || AllowPointerCoercion))
+			{
+				Result = NewExpr(S, Typ);
+				Result->Eval.Pointer = ConstPointer;
+				Result->Imm.Pointer = (void *)(unsigned long)E->Imm.Integer;
+				return Result;
+			}
+
+			Result = NewUnary(S, Typ, E);
+			Result->IsConst = FALSE;
+			if (AllowPointerCoercion)
+				Result->Eval.Pointer = IntToPointer;
+			else
+			{
+				Result->Eval.Pointer = NumberToNullPointer;
+				Result->Extra = CompileWhere(S);
+			}
+			return Result;
+		}
+		break;
+
+	case KindAggregate:
+		if ((Typ->Base == TypeStruct || Typ->Base == TypeUnion) && E->Typ == Typ)
+			return E;
+		break;
+
+	default:
+		break;
+	}
+
+	CompileBail(S, "assignment not supported");
+	return NULL;
+}
+
+/**
+ * stores a converted value in Dest
+ */
+static struct CompiledExpr *CompileStore(struct CompileState *S, struct CompiledExpr *Dest, struct CompiledExpr *Value)
+{
+	struct CompiledExpr *E = NewBinary(S, Dest->Typ, Dest, Value);
+
+	E->IsConst = FALSE;
+	switch (CompiledKindOf(Dest->Typ))
+	{
+	case KindInt:
+		E->Typ = &S->pc->IntType;
+		if (Dest->Address == LocalAddress && Dest->Typ->Base == TypeInt)
+			E->Eval.Int = AssignLocalInt;
+		else
+			E->Eval.Int = AssignInt;
+		break;
+	case KindFP:
+		E->Eval.FP = (Dest->Address == LocalAddress) ? AssignLocalFP : AssignFP;
+		break;
+	case KindPointer:
+		E->Eval.Pointer = AssignPointer;
+		break;
+	default:
+		E->Eval.Pointer = AssignAggregate;
+		E->Address = AssignAggregate;
+		E->Imm.Integer = TypeSize(Dest->Typ, Dest->Typ->ArraySize, FALSE);
+		break;
+	}
+
+	return E;
+}
+
+/* a variable at a fixed place, in the frame or in memory */
+static struct CompiledExpr *CompileVariable(struct CompileState *S, struct ValueType *Typ, int Offset, void *Addr, int IsLValue)
+{
+	struct CompiledExpr *E = NewExpr(S, Typ);
+	int Where = (Addr == NULL) ? 0 : 1;
+
+	if (Addr == NULL)
+	{
+		E->Address = LocalAddress;
+		E->Imm.Integer = Offset;
+	}
+	else
+	{
+		E->Address = GlobalAddress;
+		E->Imm.Pointer = Addr;
+	}
+
+	E->IsLValue = IsLValue;
+	switch (CompiledKindOf(Typ))
+	{
+	case KindInt:
+		E->Eval.Int = IntLoads[Typ->Base - TypeInt][Where];
+		break;
+	case KindFP:
+		E->Eval.FP = Where ? LoadFPGlobal : LoadFPLocal;
+		break;
+	case KindPointer:
+		E->Eval.Pointer = Where ? LoadPointerGlobal : LoadPointerLocal;
+		break;
+	case KindAggregate:
+		E->Eval.Pointer = E->Address;
+		break;
+	default:
+		CompileBail(S, "variable type not supported");
+	}
+
+	return E;
+}
+
+/* a value found through an address computed at run time */
+static struct CompiledExpr *CompileMemory(struct CompileState *S, struct CompiledExpr *E)
+{
+	switch (CompiledKindOf(E->Typ))
+	{
+	case KindInt:
+		E->Eval.Int = IntLoads[E->Typ->Base - TypeInt][2];
+		break;
+	case KindFP:
+		E->Eval.FP = LoadFP;
+		break;
+	case KindPointer:
+		E->Eval.Pointer = LoadPointer;
+		break;
+	case KindAggregate:
+		E->Eval.Pointer = E->Address;
+		break;
+	default:
+		CompileBail(S, "variable type not supported");
+	}
+
+	return E;
+}
+
+/* moves a member or element of a variable at a fixed place to a fixed place too */
+static struct CompiledExpr *CompileOffset(struct CompileState *S, struct CompiledExpr *Base, struct ValueType *Typ, int Offset, int IsLValue)
+{
+	struct CompiledExpr *E;
+
+	if (Base->Address == LocalAddress)
+		return CompileVariable(S, Typ, Base->Imm.Integer + Offset, NULL, IsLValue);
+
+	if (Base->Address == GlobalAddress)
+		return CompileVariable(S, Typ, 0, (char *)Base->Imm.Pointer + Offset, IsLValue);
+
+	E = NewUnary(S, Typ, Base);
+	E->IsConst = FALSE;
+	E->Address = MemberAddress;
+	E->Imm.Integer = Offset;
+	E->IsLValue = IsLValue;
+	return CompileMemory(S, E);
+}
+
+static struct CompileLocal *CompileFindLocal(struct CompileState *S, const char *Ident)
+{
+	struct CompileLocal *Local;
+
+	for (Local = S->Locals; Local != NULL; Local = Local->Next)
+	{
+		if (Local->Ident == Ident)
+			return Local;
+	}
+
+	return NULL;
+}
+
+/* reserves aligned space in the frame */
+static int CompileFrameAlloc(struct CompileState *S, int Size)
+{
+	int Offset = S->Func->FrameSize;
+
+	S->Func->FrameSize += MEM_ALIGN(Size);
+	return Offset;
+}
+
+/**
+ * expressions
+ */
+static struct CompiledExpr *CompileCall(struct CompileState *S, const char *FuncName)
+{
+	Picoc *pc = S->pc;
+	struct CompiledExpr *Args[PARAMETER_MAX];
+	struct CompiledExpr *E;
+	struct CompiledCall *Call;
+	struct Value *FuncValue;
+	struct FuncDef *Def;
+	enum LexToken Token;
+	int ArgCount = 0;
+	int Count;
+
+	CompileExpect(S, TokenOpenBracket);
+
+	/* the interpreter leaves out some of these calls, depending on the operators around them */
+	if (S->SkipCalls)
+		CompileBail(S, "call in the operand of '&&' or '||'");
+
+	if (CompileFindLocal(S, FuncName) != NULL)
+		CompileBail(S, "not a function");
+
+	if (!TableGet(&pc->GlobalTable, FuncName, &FuncValue, NULL, NULL, NULL) || FuncValue->Typ->Base != TypeFunction)
+		CompileBail(S, "not a function");
+
+	Def = &FuncValue->Val->FuncDef;
+
+	if (CompilePeek(S, NULL) == TokenCloseBracket)
+		CompileNext(S, NULL);
+	else
+	{
+		do
+		{
+			if (ArgCount >= PARAMETER_MAX)
+				CompileBail(S, "too many arguments");
+
+			Args[ArgCount++] = CompileAssignment(S);
+			Token = CompileNext(S, NULL);
+			if (Token != TokenComma && Token != TokenCloseBracket)
+				CompileBail(S, "comma expected");
+		} while (Token != TokenCloseBracket);
+	}
+
+	if (ArgCount < Def->NumParams || (ArgCount > Def->NumParams && !Def->VarArgs))
+		CompileBail(S, "wrong number of arguments");
+
+	Call = CompileAlloc(S, sizeof(struct CompiledCall));
+	Call->Def = Def;
+	Call->NumArgs = ArgCount;
+	Call->Where = CompileWhere(S);
+	Call->Args = CompileAlloc(S, sizeof(struct CompiledExpr *) * (ArgCount + 1));
+
+	/* fixed parameters are converted like ExpressionAssign() does it, variable ones are passed as they are */
+	for (Count = 0; Count < ArgCount; Count++)
+	{
+		if (Count < Def->NumParams)
+			Call->Args[Count] = CompileConvert(S, Def->ParamType[Count], Args[Count], FALSE);
+		else if (Args[Count]->Typ->Base == TypeArray)
+			Call->Args[Count] = CompileConvert(S, TypeGetMatching(pc, &S->Parser, Args[Count]->Typ->FromType, TypePointer, 0, pc->StrEmpty, TRUE), Args[Count], FALSE);
+		else if (CompiledKindOf(Args[Count]->Typ) == KindInt || CompiledKindOf(Args[Count]->Typ) == KindFP || CompiledKindOf(Args[Count]->Typ) == KindPointer)
+			Call->Args[Count] = Args[Count];
+		else
+			CompileBail(S, "argument type not supported");
+	}
+
+	E = NewExpr(S, Def->ReturnType);
+	E->Extra = Call;
+
+	if (Def->Intrinsic == NULL)
+	{
+		if (Def->Body.Pos == NULL || Def->VarArgs)
+			CompileBail(S, "function not supported");
+
+		Call->Target = CompileFunction(S->Program, FuncValue, FuncName);
+		switch (CompiledKindOf(Def->ReturnType))
+		{
+		case KindInt:		E->Eval.Int = CallScriptInt; break;
+		case KindFP:		E->Eval.FP = CallScriptFP; break;
+		case KindPointer:
+		case KindVoid:		E->Eval.Pointer = CallScriptPointer; break;
+		default:			CompileBail(S, "return type not supported");
+		}
+
+		return E;
+	}
+
+	/* natives get their parameters the way the interpreter puts them on the stack, one after the other */
+	{
+		int Size = 0;
+		char *Pos;
+
+		for (Count = 0; Count < ArgCount; Count++)
+		{
+			struct ValueType *Typ = Call->Args[Count]->Typ;
+			Size += MEM_ALIGN(sizeof(struct Value) + TypeSize(Typ, Typ->ArraySize, FALSE));
+		}
+
+		Call->Param = CompileAlloc(S, sizeof(struct Value *) * (ArgCount + 1));
+		Pos = CompileAlloc(S, Size + 1);
+		for (Count = 0; Count < ArgCount; Count++)
+		{
+			struct ValueType *Typ = Call->Args[Count]->Typ;
+			struct Value *Param = (struct Value *)Pos;
+
+			Param->Typ = Typ;
+			Param->Val = (union AnyValue *)(Pos + MEM_ALIGN(sizeof(struct Value)));
+			Param->ValOnStack = TRUE;
+			Call->Param[Count] = Param;
+			Pos += MEM_ALIGN(sizeof(struct Value) + TypeSize(Typ, Typ->ArraySize, FALSE));
+		}
+	}
+
+	Call->ReturnValue = CompileAlloc(S, MEM_ALIGN(sizeof(struct Value)) + TypeSize(Def->ReturnType, Def->ReturnType->ArraySize, FALSE) + 1);
+	Call->ReturnValue->Typ = Def->ReturnType;
+	Call->ReturnValue->Val = (union AnyValue *)((char *)Call->ReturnValue + MEM_ALIGN(sizeof(struct Value)));
+	switch (CompiledKindOf(Def->ReturnType))
+	{
+	case KindInt:		E->Eval.Int = CallNativeInt; break;
+	case KindFP:		E->Eval.FP = CallNativeFP; break;
+	case KindPointer:	E->Eval.Pointer = CallNativePointer; break;
+	case KindVoid:		E->Eval.Pointer = CallNativeVoid; break;
+	default:			CompileBail(S, "return type not supported");
+	}
+
+	return E;
+}
+
+static struct CompiledExpr *CompileIdentifier(struct CompileState *S, const char *Ident)
+{
+	Picoc *pc = S->pc;
+	struct CompileLocal *Local;
+	struct Value *Value;
+	struct CompiledExpr *E;
+
+	if (CompilePeek(S, NULL) == TokenOpenBracket)
+		return CompileCall(S, Ident);
+
+	Local = CompileFindLocal(S, Ident);
+	if (Local != NULL)
+		return CompileVariable(S, Local->Typ, Local->Offset, Local->Static, TRUE);
+
+	if (!TableGet(&pc->GlobalTable, Ident, &Value, NULL, NULL, NULL))
+		CompileBail(S, "undefined identifier");
+
+	if (Value->Typ->Base == TypeMacro)
+	{
+		struct ParseState Saved = S->Parser;
+		int SkipCalls = S->SkipCalls;
+
+		if (Value->Val->MacroDef.NumParams != 0 || ++S->MacroDepth > COMPILE_MACRO_DEPTH)
+			CompileBail(S, "macro not supported");
+
+		/* a macro body is parsed on its own, it makes all of its calls */
+		ParserCopy(&S->Parser, &Value->Val->MacroDef.Body);
+		S->Parser.Mode = RunModeRun;
+		S->SkipCalls = 0;
+		E = CompileExpression(S);
+		if (CompilePeek(S, NULL) != TokenEndOfFunction)
+			CompileBail(S, "macro not supported");
+
+		S->Parser = Saved;
+		S->SkipCalls = SkipCalls;
+		S->MacroDepth--;
+		return E;
+	}
+
+	return CompileVariable(S, Value->Typ, 0, Value->Val, Value->IsLValue);
+}
+
+static struct CompiledExpr *CompilePrimary(struct CompileState *S)
+{
+	Picoc *pc = S->pc;
+	struct Value *LexValue;
+	struct CompiledExpr *E;
+
+	switch (CompileNext(S, &LexValue))
+	{
+	case TokenIdentifier:
+		return CompileIdentifier(S, LexValue->Val->Identifier);
+
+	case TokenIntegerConstant:
+		return NewIntConst(S, &pc->LongType, LexValue->Val->LongInteger);
+
+	case TokenCharacterConstant:
+		return NewIntConst(S, &pc->CharType, LexValue->Val->Character);
+
+	case TokenFPConstant:
+		E = NewExpr(S, &pc->FPType);
+		E->Eval.FP = ConstFP;
+		E->Imm.FP = LexValue->Val->FP;
+		E->IsConst = TRUE;
+		return E;
+
+	case TokenStringConstant:
+		E = NewExpr(S, pc->CharPtrType);
+		E->Eval.Pointer = ConstPointer;
+		E->Imm.Pointer = LexValue->Val->Pointer;
+		return E;
+
+	case TokenOpenBracket:
+		E = CompileExpression(S);
+		CompileExpect(S, TokenCloseBracket);
+		return E;
+
+	default:
+		CompileBail(S, "expression expected");
+		return NULL;
+	}
+}
+
+static struct CompiledExpr *CompileIndex(struct CompileState *S, struct CompiledExpr *Base)
+{
+	struct CompiledExpr *Index = CompileToInt(S, CompileExpression(S));
+	struct CompiledExpr *E;
+	int Size;
+
+	CompileExpect(S, TokenRightSquareBracket);
+
+	if (Base->Typ->Base == TypeArray)
+	{
+		Size = TypeSize(Base->Typ, 1, TRUE);
+		if (Index->IsConst)
+			return CompileOffset(S, Base, Base->Typ->FromType, (int)Index->Imm.Integer * Size, Base->IsLValue);
+
+		E = NewBinary(S, Base->Typ->FromType, Base, Index);
+		E->Address = ArrayElementAddress;
+	}
+	else if (Base->Typ->Base == TypePointer)
+	{
+		Size = TypeSize(Base->Typ->FromType, 0, TRUE);
+		E = NewBinary(S, Base->Typ->FromType, Base, Index);
+		E->Address = PointerElementAddress;
+	}
+	else
+	{
+		CompileBail(S, "not an array");
+		return NULL;
+	}
+
+	E->IsConst = FALSE;
+	E->Imm.Integer = Size;
+	E->IsLValue = Base->IsLValue;
+	return CompileMemory(S, E);
+}
+
+static struct CompiledExpr *CompileMember(struct CompileState *S, struct CompiledExpr *Base, enum LexToken Token)
+{
+	struct ValueType *StructType = Base->Typ;
+	struct Value *Ident;
+	struct Value *Member;
+	struct CompiledExpr *E;
+
+	if (Token == TokenArrow)
+	{
+		if (Base->Typ->Base != TypePointer)
+			CompileBail(S, "not a pointer");
+
+		StructType = Base->Typ->FromType;
+	}
+
+	if (CompileNext(S, &Ident) != TokenIdentifier || (StructType->Base != TypeStruct && StructType->Base != TypeUnion))
+		CompileBail(S, "not a struct or union");
+
+	if (!TableGet(StructType->Members, Ident->Val->Identifier, &Member, NULL, NULL, NULL))
+		CompileBail(S, "no such member");
+
+	if (Token == TokenDot)
+		return CompileOffset(S, Base, Member->Typ, Member->Val->Integer, TRUE);
+
+	E = NewUnary(S, Member->Typ, Base);
+	E->IsConst = FALSE;
+	E->Address = ArrowAddress;
+	E->Imm.Integer = Member->Val->Integer;
+	E->IsLValue = TRUE;
+	return CompileMemory(S, E);
+}
+
+/* ++ and -- on an lvalue */
+static struct CompiledExpr *CompileStep(struct CompileState *S, struct CompiledExpr *Dest, enum LexToken Token, int Postfix)
+{
+	struct CompiledExpr *E;
+	int Step = (Token == TokenIncrement) ? 1 : -1;
+
+	if (!Dest->IsLValue || Dest->Address == NULL)
+		CompileBail(S, "can't assign to this");
+
+	E = NewUnary(S, Dest->Typ, Dest);
+	E->IsConst = FALSE;
+	E->Imm.Integer = Step;
+	switch (CompiledKindOf(Dest->Typ))
+	{
+	case KindInt:
+		E->Typ = &S->pc->IntType;
+		if (Postfix && Dest->Address == LocalAddress && Dest->Typ->Base == TypeInt)
+			E->Eval.Int = PostStepLocalInt;
+		else
+			E->Eval.Int = Postfix ? PostStepInt : PreStepInt;
+		break;
+	case KindFP:
+		E->Eval.FP = StepFP;
+		break;
+	case KindPointer:
+		E->Imm.Integer = Step * TypeSize(Dest->Typ->FromType, 0, TRUE);
+		E->Eval.Pointer = Postfix ? PostStepPointer : PreStepPointer;
+		E->Extra = CompileWhere(S);
+		break;
+	default:
+		CompileBail(S, "invalid operation");
+	}
+
+	return E;
+}
+
+static struct CompiledExpr *CompilePostfix(struct CompileState *S)
+{
+	struct CompiledExpr *E = CompilePrimary(S);
+	enum LexToken Token;
+
+	for (;;)
+	{
+		Token = CompilePeek(S, NULL);
+		switch (Token)
+		{
+		case TokenLeftSquareBracket:
+			CompileNext(S, NULL);
+			E = CompileIndex(S, E);
+			break;
+		case TokenDot:
+		case TokenArrow:
+			CompileNext(S, NULL);
+			E = CompileMember(S, E, Token);
+			break;
+		case TokenIncrement:
+		case TokenDecrement:
+			CompileNext(S, NULL);
+			E = CompileStep(S, E, Token, TRUE);
+			break;
+		default:
+			return E;
+		}
+	}
+}
+
+/* a cast, the type has been parsed already */
+static struct CompiledExpr *CompileCast(struct CompileState *S, struct ValueType *Typ, struct CompiledExpr *E)
+{
+	struct CompiledExpr *Result;
+
+	switch (CompiledKindOf(Typ))
+	{
+	case KindInt:
+		E = CompileConvert(S, &S->pc->LongType, E, TRUE);
+		if (Typ->Base == TypeLong || Typ->Base == TypeUnsignedLong)
+			return CompileRetype(S, E, Typ);
+
+		Result = NewUnary(S, Typ, E);
+		Result->Eval.Int = CastInt;
+		return CompileFold(Result);
+	case KindFP:
+	case KindPointer:
+		E = CompileConvert(S, Typ, E, TRUE);
+		if (E->Typ != Typ)
+			E = CompileRetype(S, E, Typ);
+		E->IsLValue = FALSE;
+		return E;
+	default:
+		CompileBail(S, "cast not supported");
+		return NULL;
+	}
+}
+
+/* true if the tokens ahead start a type */
+static int CompileIsType(struct CompileState *S, enum LexToken Token, struct Value *LexValue)
+{
+	struct Value *Value;
+
+	if (Token >= TokenIntType && Token <= TokenUnsignedType)
+		return TRUE;
+
+	if (Token == TokenIdentifier && CompileFindLocal(S, LexValue->Val->Identifier) == NULL &&
+			TableGet(&S->pc->GlobalTable, LexValue->Val->Identifier, &Value, NULL, NULL, NULL))
+		return Value->Typ->Base == Type_Type;
+
+	return FALSE;
+}
+
+/* a type inside an expression, struct definitions would end up as globals so leave those */
+static struct ValueType *CompileTypeName(struct CompileState *S)
+{
+	struct ParseState Ahead = S->Parser;
+	struct ValueType *Typ;
+	char *Ident;
+	enum LexToken Token;
+
+	Token = LexGetToken(&Ahead, NULL, TRUE);
+	if (Token == TokenEnumType)
+		CompileBail(S, "enum not supported");
+
+	if (Token == TokenStructType || Token == TokenUnionType)
+	{
+		if (LexGetToken(&Ahead, NULL, TRUE) == TokenLeftBrace || LexGetToken(&Ahead, NULL, FALSE) == TokenLeftBrace)
+			CompileBail(S, "struct definition not supported");
+	}
+
+	TypeParse(&S->Parser, &Typ, &Ident, NULL);
+	if (Ident != S->pc->StrEmpty)
+		CompileBail(S, "type expected");
+
+	return Typ;
+}
+
+static struct CompiledExpr *CompileUnary(struct CompileState *S)
+{
+	Picoc *pc = S->pc;
+	struct Value *LexValue;
+	struct CompiledExpr *E;
+	struct CompiledExpr *Result;
+	struct ValueType *Typ;
+	enum LexToken Token = CompilePeek(S, &LexValue);
+
+	switch (Token)
+	{
+	case TokenOpenBracket:
+	{
+		struct ParseState Ahead = S->Parser;
+		struct Value *AheadValue;
+
+		LexGetToken(&Ahead, NULL, TRUE);
+		Token = LexGetToken(&Ahead, &AheadValue, FALSE);
+		if (!CompileIsType(S, Token, AheadValue))
+			return CompilePostfix(S);
+
+		CompileNext(S, NULL);
+		Typ = CompileTypeName(S);
+		CompileExpect(S, TokenCloseBracket);
+		return CompileCast(S, Typ, CompileUnary(S));
+	}
+
+	case TokenSizeof:
+	{
+		struct ParseState Ahead;
+		struct Value *AheadValue;
+
+		CompileNext(S, NULL);
+		Ahead = S->Parser;
+		Token = LexGetToken(&Ahead, NULL, TRUE);
+		if (Token == TokenOpenBracket)
+			Token = LexGetToken(&Ahead, &AheadValue, FALSE);
+
+		if (Token != TokenOpenBracket && CompileIsType(S, Token, AheadValue))
+		{
+			CompileNext(S, NULL);
+			Typ = CompileTypeName(S);
+			CompileExpect(S, TokenCloseBracket);
+		}
+		else
+			Typ = CompileUnary(S)->Typ;
+
+		return NewIntConst(S, &pc->IntType, TypeSize(Typ, Typ->ArraySize, TRUE));
+	}
+
+	case TokenPlus:
+	case TokenMinus:
+	case TokenUnaryNot:
+	case TokenUnaryExor:
+		CompileNext(S, NULL);
+		E = CompileUnary(S);
+		if (CompiledKindOf(E->Typ) == KindFP && Token != TokenUnaryExor)
+		{
+			if (Token == TokenPlus)
+				return CompileRetype(S, E, &pc->FPType);
+
+			Result = NewUnary(S, &pc->FPType, E);
+			Result->Eval.FP = (Token == TokenMinus) ? FPNegate : FPNot;
+			return CompileFold(Result);
+		}
+
+		if (CompiledKindOf(E->Typ) != KindInt)
+			CompileBail(S, "invalid operation");
+
+		Result = NewUnary(S, &pc->IntType, E);
+		switch (Token)
+		{
+		case TokenPlus:		Result->Eval.Int = IntPlus; break;
+		case TokenMinus:	Result->Eval.Int = IntNegate; break;
+		case TokenUnaryNot:	Result->Eval.Int = IntNot; break;
+		default:			Result->Eval.Int = IntComplement; break;
+		}
+		return CompileFold(Result);
+
+	case TokenIncrement:
+	case TokenDecrement:
+		CompileNext(S, NULL);
+		return CompileStep(S, CompileUnary(S), Token, FALSE);
+
+	case TokenAsterisk:
+		CompileNext(S, NULL);
+		E = CompileUnary(S);
+		if (E->Typ->Base != TypePointer)
+			CompileBail(S, "not a pointer");
+
+		Result = NewUnary(S, E->Typ->FromType, E);
+		Result->IsConst = FALSE;
+		Result->Address = DerefAddress;
+		Result->Extra = CompileWhere(S);
+		Result->IsLValue = TRUE;
+		return CompileMemory(S, Result);
+
+	case TokenAmpersand:
+		CompileNext(S, NULL);
+		E = CompileUnary(S);
+		if (!E->IsLValue || E->Address == NULL)
+			CompileBail(S, "can't get the address of this");
+
+		Result = NewUnary(S, TypeGetMatching(pc, &S->Parser, E->Typ, TypePointer, 0, pc->StrEmpty, TRUE), E);
+		Result->IsConst = FALSE;
+		Result->Eval.Pointer = AddressOf;
+		return Result;
+
+	default:
+		return CompilePostfix(S);
+	}
+}
+
+/* binding of the infix operators, higher binds tighter */
+static int CompilePrecedence(enum LexToken Token)
+{
+	switch (Token)
+	{
+	case TokenLogicalOr:		return 4;
+	case TokenLogicalAnd:		return 5;
+	case TokenArithmeticOr:		return 6;
+	case TokenArithmeticExor:	return 7;
+	case TokenAmpersand:		return 8;
+	case TokenEqual:
+	case TokenNotEqual:			return 9;
+	case TokenLessThan:
+	case TokenGreaterThan:
+	case TokenLessEqual:
+	case TokenGreaterEqual:		return 10;
+	case TokenShiftLeft:
+	case TokenShiftRight:		return 11;
+	case TokenPlus:
+	case TokenMinus:			return 12;
+	case TokenAsterisk:
+	case TokenSlash:
+	case TokenModulus:			return 13;
+	default:					return 0;
+	}
+}
+
+/* an infix operator on two compiled operands, following ExpressionInfixOperator() */
+static struct CompiledExpr *CompileInfix(struct CompileState *S, enum LexToken Op, struct CompiledExpr *A, struct CompiledExpr *B)
+{
+	Picoc *pc = S->pc;
+	enum CompiledKind KindA = CompiledKindOf(A->Typ);
+	enum CompiledKind KindB = CompiledKindOf(B->Typ);
+	struct CompiledExpr *E;
+
+	if ((KindA == KindFP && (KindB == KindFP || KindB == KindInt)) || (KindA == KindInt && KindB == KindFP))
+	{
+		E = NewBinary(S, &pc->IntType, CompileToFP(S, A), CompileToFP(S, B));
+		switch (Op)
+		{
+		case TokenEqual:			E->Eval.Int = FPEqual; break;
+		case TokenNotEqual:			E->Eval.Int = FPNotEqual; break;
+		case TokenLessThan:			E->Eval.Int = FPLessThan; break;
+		case TokenGreaterThan:		E->Eval.Int = FPGreaterThan; break;
+		case TokenLessEqual:		E->Eval.Int = FPLessEqual; break;
+		case TokenGreaterEqual:		E->Eval.Int = FPGreaterEqual; break;
+		case TokenPlus:				E->Typ = &pc->FPType; E->Eval.FP = FPAdd; break;
+		case TokenMinus:			E->Typ = &pc->FPType; E->Eval.FP = FPSubtract; break;
+		case TokenAsterisk:			E->Typ = &pc->FPType; E->Eval.FP = FPMultiply; break;
+		case TokenSlash:			E->Typ = &pc->FPType; E->Eval.FP = FPDivide; break;
+		default:					CompileBail(S, "invalid operation");
+		}
+		return CompileFold(E);
+	}
+
+	if (KindA == KindInt && KindB == KindInt)
+	{
+		E = NewBinary(S, &pc->IntType, A, B);
+		switch (Op)
+		{
+		case TokenLogicalOr:		E->Eval.Int = IntLogicalOr; break;
+		case TokenLogicalAnd:		E->Eval.Int = IntLogicalAnd; break;
+		case TokenArithmeticOr:		E->Eval.Int = IntOr; break;
+		case TokenArithmeticExor:	E->Eval.Int = IntExor; break;
+		case TokenAmpersand:		E->Eval.Int = IntAnd; break;
+		case TokenEqual:			E->Eval.Int = IntEqual; break;
+		case TokenNotEqual:			E->Eval.Int = IntNotEqual; break;
+		case TokenLessThan:			E->Eval.Int = IntLessThan; break;
+		case TokenGreaterThan:		E->Eval.Int = IntGreaterThan; break;
+		case TokenLessEqual:		E->Eval.Int = IntLessEqual; break;
+		case TokenGreaterEqual:		E->Eval.Int = IntGreaterEqual; break;
+		case TokenShiftLeft:		E->Eval.Int = IntShiftLeft; break;
+		case TokenShiftRight:		E->Eval.Int = IntShiftRight; break;
+		case TokenPlus:				E->Eval.Int = IntAdd; break;
+		case TokenMinus:			E->Eval.Int = IntSubtract; break;
+		case TokenAsterisk:			E->Eval.Int = IntMultiply; break;
+		case TokenSlash:
+		case TokenModulus:
+			E->Eval.Int = (Op == TokenSlash) ? IntDivide : IntModulus;
+			/* a constant zero is divided by at run time, like the interpreter does */
+			if (B->IsConst && B->Imm.Integer == 0)
+				E->IsConst = FALSE;
+			break;
+		default:
+			CompileBail(S, "invalid operation");
+		}
+		return CompileFold(E);
+	}
+
+	if (KindA == KindPointer && (KindB == KindInt || KindB == KindFP))
+	{
+		B = CompileToInt(S, B);
+		E = NewBinary(S, &pc->IntType, A, B);
+		E->IsConst = FALSE;
+		E->Extra = CompileWhere(S);
+		switch (Op)
+		{
+		case TokenEqual:
+		case TokenNotEqual:
+			if (B->IsConst && B->Imm.Integer != 0)
+				CompileBail(S, "invalid operation");
+			if (B->IsConst)
+				E->B = NULL;
+			E->Eval.Int = (Op == TokenEqual) ? PointerIsNull : PointerNotNull;
+			break;
+		case TokenPlus:
+		case TokenMinus:
+			if (Op == TokenMinus)
+			{
+				E->B = NewUnary(S, &pc->LongType, B);
+				E->B->Eval.Int = IntNegate;
+				E->B = CompileFold(E->B);
+			}
+			E->Typ = A->Typ;
+			E->Eval.Pointer = PointerAdd;
+			E->Imm.Integer = TypeSize(A->Typ->FromType, 0, TRUE);
+			break;
+		default:
+			CompileBail(S, "invalid operation");
+		}
+		return E;
+	}
+
+	if (KindA == KindPointer && KindB == KindPointer)
+	{
+		E = NewBinary(S, &pc->IntType, A, B);
+		E->IsConst = FALSE;
+		switch (Op)
+		{
+		case TokenEqual:		E->Eval.Int = PointerEqual; break;
+		case TokenNotEqual:		E->Eval.Int = PointerNotEqual; break;
+		case TokenMinus:		E->Eval.Int = PointerDifference; break;
+		default:				CompileBail(S, "invalid operation");
+		}
+		return E;
+	}
+
+	CompileBail(S, "invalid operation");
+	return NULL;
+}
+
+static struct CompiledExpr *CompileBinary(struct CompileState *S, int MinPrecedence)
+{
+	struct CompiledExpr *E = CompileUnary(S);
+	enum LexToken Op;
+	int Precedence;
+
+	for (;;)
+	{
+		Op = CompilePeek(S, NULL);
+		Precedence = CompilePrecedence(Op);
+		if (Precedence == 0 || Precedence < MinPrecedence)
+			return E;
+
+		CompileNext(S, NULL);
+		if (Op == TokenLogicalOr || Op == TokenLogicalAnd)
+		{
+			struct CompiledExpr *Right;
+
+			S->SkipCalls++;
+			Right = CompileBinary(S, Precedence + 1);
+			S->SkipCalls--;
+			E = CompileInfix(S, Op, E, Right);
+		}
+		else
+			E = CompileInfix(S, Op, E, CompileBinary(S, Precedence + 1));
+	}
+}
+
+/* the interpreter groups 'a ? b : c ? d : e' as '(a ? b : c) ? d : e' */
+static struct CompiledExpr *CompileConditional(struct CompileState *S)
+{
+	struct CompiledExpr *E = CompileBinary(S, 1);
+	struct CompiledExpr *Condition;
+	struct CompiledExpr *Then;
+	struct CompiledExpr *Else;
+	enum CompiledKind Kind;
+
+	while (CompilePeek(S, NULL) == TokenQuestionMark)
+	{
+		CompileNext(S, NULL);
+		Condition = CompileToInt(S, E);
+		Then = CompileAssignment(S);
+		CompileExpect(S, TokenColon);
+		Else = CompileBinary(S, 1);
+
+		Kind = CompiledKindOf(Then->Typ);
+		if (Kind != CompiledKindOf(Else->Typ))
+			CompileBail(S, "mixed conditional");
+
+		E = NewBinary(S, (Then->Typ == Else->Typ) ? Then->Typ : &S->pc->IntType, Condition, Then);
+		E->IsConst = FALSE;
+		E->Extra = Else;
+		switch (Kind)
+		{
+		case KindInt:		E->Eval.Int = IntConditional; break;
+		case KindFP:		E->Eval.FP = FPConditional; break;
+		case KindPointer:	E->Typ = Then->Typ; E->Eval.Pointer = PointerConditional; break;
+		default:			CompileBail(S, "conditional not supported");
+		}
+	}
+
+	return E;
+}
+
+/* an assignment operator, following ExpressionInfixOperator() */
+static struct CompiledExpr *CompileAssign(struct CompileState *S, enum LexToken Op, struct CompiledExpr *Dest, struct CompiledExpr *Value)
+{
+	Picoc *pc = S->pc;
+	enum CompiledKind KindDest = CompiledKindOf(Dest->Typ);
+	enum CompiledKind KindValue = CompiledKindOf(Value->Typ);
+	struct CompiledExpr *E;
+
+	if (!Dest->IsLValue || Dest->Address == NULL)
+		CompileBail(S, "can't assign to this");
+
+	if ((KindDest == KindFP && (KindValue == KindFP || KindValue == KindInt)) || (KindDest == KindInt && KindValue == KindFP))
+	{
+		if (Op != TokenAssign && Op != TokenAddAssign && Op != TokenSubtractAssign && Op != TokenMultiplyAssign && Op != TokenDivideAssign)
+			CompileBail(S, "invalid operation");
+
+		Value = CompileToFP(S, Value);
+		if (KindDest == KindFP && Op == TokenAssign)
+			return CompileStore(S, Dest, Value);
+
+		E = NewBinary(S, Dest->Typ, Dest, Value);
+		E->IsConst = FALSE;
+		E->Op = Op;
+		if (KindDest == KindFP)
+			E->Eval.FP = AssignOpFP;
+		else
+		{
+			E->Typ = &pc->IntType;
+			E->Eval.Int = AssignOpIntFromFP;
+		}
+		return E;
+	}
+
+	if (KindDest == KindInt && KindValue == KindInt)
+	{
+		if (Op == TokenAssign)
+			return CompileStore(S, Dest, Value);
+
+		E = NewBinary(S, &pc->IntType, Dest, Value);
+		E->IsConst = FALSE;
+		E->Op = Op;
+		E->Eval.Int = AssignOpInt;
+		return E;
+	}
+
+	if (KindDest == KindPointer && (KindValue == KindInt || KindValue == KindFP))
+	{
+		Value = CompileToInt(S, Value);
+		if (Op == TokenAssign)
+		{
+			if (Value->IsConst && Value->Imm.Integer != 0)
+				CompileBail(S, "invalid operation");
+
+			return CompileStore(S, Dest, CompileConvert(S, Dest->Typ, Value, FALSE));
+		}
+
+		if (Op != TokenAddAssign && Op != TokenSubtractAssign)
+			CompileBail(S, "invalid operation");
+
+		if (Op == TokenSubtractAssign)
+		{
+			Value = NewUnary(S, &pc->LongType, Value);
+			Value->Eval.Int = IntNegate;
+			Value = CompileFold(Value);
+		}
+
+		E = NewBinary(S, Dest->Typ, Dest, Value);
+		E->IsConst = FALSE;
+		E->Eval.Pointer = AssignOpPointer;
+		E->Imm.Integer = TypeSize(Dest->Typ->FromType, 0, TRUE);
+		E->Extra = CompileWhere(S);
+		return E;
+	}
+
+	if (Op != TokenAssign)
+		CompileBail(S, "invalid operation");
+
+	return CompileStore(S, Dest, CompileConvert(S, Dest->Typ, Value, FALSE));
+}
+
+static struct CompiledExpr *CompileAssignment(struct CompileState *S)
+{
+	struct CompiledExpr *E = CompileConditional(S);
+	enum LexToken Op = CompilePeek(S, NULL);
+
+	if (Op < TokenAssign || Op > TokenArithmeticExorAssign)
+		return E;
+
+	CompileNext(S, NULL);
+	return CompileAssign(S, Op, E, CompileAssignment(S));
+}
+
+/* picoc has no comma operator, a comma ends the expression */
+static struct CompiledExpr *CompileExpression(struct CompileState *S)
+{
+	return CompileAssignment(S);
+}
+
+/**
+ * statements
+ */
+static struct CompiledStmt *CompileExprStmt(struct CompileState *S, struct CompiledExpr *E)
+{
+	struct CompiledStmt *Stmt;
+
+	switch (CompiledKindOf(E->Typ))
+	{
+	case KindInt:
+		Stmt = NewStmt(S, ExecIntExpr);
+		break;
+	case KindFP:
+		Stmt = NewStmt(S, ExecFPExpr);
+		break;
+	case KindPointer:
+	case KindAggregate:
+	case KindVoid:
+		Stmt = NewStmt(S, ExecPointerExpr);
+		break;
+	default:
+		CompileBail(S, "statement not supported");
+		return NULL;
+	}
+
+	Stmt->Expr = E;
+	return Stmt;
+}
+
+/* hides the locals of a block that ends */
+static void CompileScopeEnd(struct CompileState *S)
+{
+	while (S->Locals != NULL && S->Locals->Depth >= S->Depth)
+		S->Locals = S->Locals->Next;
+
+	S->Depth--;
+}
+
+/* statements up to the closing brace, the opening one has been read */
+static struct CompiledStmt *CompileBlock(struct CompileState *S)
+{
+	struct CompiledStmt *Block = NewStmt(S, ExecList);
+	struct CompiledStmt **Tail = &Block->Body;
+
+	S->Depth++;
+	while (CompilePeek(S, NULL) != TokenRightBrace)
+	{
+		*Tail = CompileStatement(S);
+		while (*Tail != NULL)
+			Tail = &(*Tail)->Next;
+	}
+	CompileNext(S, NULL);
+	CompileScopeEnd(S);
+
+	return Block;
+}
+
+static struct CompiledStmt *CompileSwitch(struct CompileState *S)
+{
+	struct CompiledStmt *Stmt = NewStmt(S, ExecSwitch);
+	struct CompiledStmt **Tail = &Stmt->Body;
+	struct CompiledCase Cases[PARAMETER_MAX * 2];
+	int Pending = 0;
+	int Count;
+	enum LexToken Token;
+
+	CompileExpect(S, TokenOpenBracket);
+	Stmt->Expr = CompileCondition(S);
+	CompileExpect(S, TokenCloseBracket);
+	CompileExpect(S, TokenLeftBrace);
+
+	S->Depth++;
+	S->Breakable++;
+	while ((Token = CompilePeek(S, NULL)) != TokenRightBrace)
+	{
+		if (Token == TokenCase || Token == TokenDefault)
+		{
+			if (Stmt->NumCases >= (int)(sizeof(Cases) / sizeof(Cases[0])))
+				CompileBail(S, "too many cases");
+
+			CompileNext(S, NULL);
+			Cases[Stmt->NumCases].IsDefault = (Token == TokenDefault);
+			Cases[Stmt->NumCases].Start = NULL;
+			if (Token == TokenCase)
+			{
+				struct CompiledExpr *Value = CompileToInt(S, CompileExpression(S));
+
+				if (!Value->IsConst)
+					CompileBail(S, "case value not constant");
+
+				Cases[Stmt->NumCases].Value = (int)Value->Imm.Integer;
+			}
+			CompileExpect(S, TokenColon);
+			Stmt->NumCases++;
+			Pending++;
+			continue;
+		}
+
+		*Tail = CompileStatement(S);
+		if (*Tail != NULL)
+		{
+			/* labels right before this statement start here */
+			for (Count = Stmt->NumCases - Pending; Count < Stmt->NumCases; Count++)
+				Cases[Count].Start = *Tail;
+
+			Pending = 0;
+			while (*Tail != NULL)
+				Tail = &(*Tail)->Next;
+		}
+	}
+	CompileNext(S, NULL);
+	S->Breakable--;
+	CompileScopeEnd(S);
+
+	Stmt->Cases = CompileAlloc(S, sizeof(struct CompiledCase) * (Stmt->NumCases + 1));
+	memcpy(Stmt->Cases, Cases, sizeof(struct CompiledCase) * Stmt->NumCases);
+	return Stmt;
+}
+
+/* the braces of an array initialiser, the opening one has been read */
+static struct CompiledStmt *CompileArrayInit(struct CompileState *S, struct CompiledExpr *Array)
+{
+	struct CompiledStmt *Block = NewStmt(S, ExecList);
+	struct CompiledStmt **Tail = &Block->Body;
+	struct ValueType *ElementType = Array->Typ->FromType;
+	int Size = TypeSize(Array->Typ, 1, TRUE);
+	int Count = 0;
+	enum LexToken Token;
+
+	if (ElementType->Base == TypeArray || CompiledKindOf(ElementType) == KindAggregate)
+		CompileBail(S, "initialiser not supported");
+
+	do
+	{
+		struct CompiledExpr *Element;
+
+		if (Count >= Array->Typ->ArraySize)
+			CompileBail(S, "too many array elements");
+
+		Element = CompileOffset(S, Array, ElementType, Count * Size, TRUE);
+		*Tail = CompileExprStmt(S, CompileStore(S, Element, CompileConvert(S, ElementType, CompileAssignment(S), FALSE)));
+		Tail = &(*Tail)->Next;
+		Count++;
+
+		Token = CompileNext(S, NULL);
+		if (Token != TokenComma && Token != TokenRightBrace)
+			CompileBail(S, "comma expected");
+	} while (Token == TokenComma && CompilePeek(S, NULL) != TokenRightBrace);
+
+	if (Token == TokenComma)
+		CompileNext(S, NULL);
+
+	return Block;
+}
+
+/* a static local lives in the global table under a name that's unique for the function */
+static void *CompileStaticLocal(struct CompileState *S, char *Ident, struct ValueType *Typ, int *FirstVisit)
+{
+	Picoc *pc = S->pc;
+	char MangledName[LINEBUFFER_MAX];
+	char *RegisteredName;
+	struct Value *Value;
+	struct CompileStatic *Static;
+
+	snprintf(MangledName, sizeof(MangledName), "/%s/%s/%s", S->Parser.FileName, S->Func->Name, Ident);
+	RegisteredName = TableStrRegister(pc, MangledName);
+
+	*FirstVisit = FALSE;
+	if (!TableGet(&pc->GlobalTable, RegisteredName, &Value, NULL, NULL, NULL))
+	{
+		Value = VariableAllocValueFromType(pc, &S->Parser, Typ, TRUE, NULL, TRUE);
+		TableSet(pc, &pc->GlobalTable, RegisteredName, Value, S->Parser.FileName, S->Parser.Line, S->Parser.CharacterPos);
+
+		/* remembered so the interpreter finds it undefined again if compiling fails */
+		Static = CompileAlloc(S, sizeof(struct CompileStatic));
+		Static->Name = RegisteredName;
+		Static->Next = S->Program->Statics;
+		S->Program->Statics = Static;
+		*FirstVisit = TRUE;
+	}
+
+	if (Value->Typ != Typ)
+		CompileBail(S, "static redefined");
+
+	return Value->Val;
+}
+
+static struct CompiledStmt *CompileDeclaration(struct CompileState *S)
+{
+	Picoc *pc = S->pc;
+	struct CompiledStmt *Block = NewStmt(S, ExecList);
+	struct CompiledStmt **Tail = &Block->Body;
+	struct ParseState Ahead = S->Parser;
+	struct ValueType *BasicType;
+	struct ValueType *Typ;
+	char *Ident;
+	int IsStatic = FALSE;
+	enum LexToken Token;
+
+	/* type definitions inside a function would become globals at compile time */
+	Token = LexGetToken(&Ahead, NULL, TRUE);
+	if (Token == TokenStaticType)
+		Token = LexGetToken(&Ahead, NULL, TRUE);
+	if (Token == TokenEnumType)
+		CompileBail(S, "enum not supported");
+	if ((Token == TokenStructType || Token == TokenUnionType) &&
+			(LexGetToken(&Ahead, NULL, TRUE) == TokenLeftBrace || LexGetToken(&Ahead, NULL, FALSE) == TokenLeftBrace))
+		CompileBail(S, "struct definition not supported");
+
+	TypeParseFront(&S->Parser, &BasicType, &IsStatic);
+	do
+	{
+		struct CompileLocal *Local;
+		struct CompiledExpr *Variable;
+		struct CompiledStmt *Init = NULL;
+		int FirstVisit = TRUE;
+
+		TypeParseIdentPart(&S->Parser, BasicType, &Typ, &Ident);
+		if (Ident == pc->StrEmpty || CompilePeek(S, NULL) == TokenOpenBracket)
+			CompileBail(S, "declaration not supported");
+
+		if (CompiledKindOf(Typ) == KindUnsupported || CompiledKindOf(Typ) == KindVoid || TypeIsForwardDeclared(&S->Parser, Typ) ||
+				(Typ->Base == TypeArray && TypeSize(Typ, Typ->ArraySize, TRUE) == 0))
+			CompileBail(S, "variable type not supported");
+
+		if (CompileFindLocal(S, Ident) != NULL)
+			CompileBail(S, "already defined");
+
+		Local = CompileAlloc(S, sizeof(struct CompileLocal));
+		Local->Ident = Ident;
+		Local->Typ = Typ;
+		Local->Depth = S->Depth;
+		if (IsStatic)
+			Local->Static = CompileStaticLocal(S, Ident, Typ, &FirstVisit);
+		else
+			Local->Offset = CompileFrameAlloc(S, TypeSize(Typ, Typ->ArraySize, TRUE));
+		Local->Next = S->Locals;
+		S->Locals = Local;
+
+		Variable = CompileVariable(S, Typ, Local->Offset, Local->Static, TRUE);
+		if (CompilePeek(S, NULL) == TokenAssign)
+		{
+			CompileNext(S, NULL);
+			if (CompilePeek(S, NULL) == TokenLeftBrace)
+			{
+				if (Typ->Base != TypeArray)
+					CompileBail(S, "initialiser not supported");
+
+				CompileNext(S, NULL);
+				Init = CompileArrayInit(S, Variable);
+			}
+			else if (Typ->Base == TypeArray)
+				CompileBail(S, "initialiser not supported");
+			else
+			{
+				struct CompiledExpr *Value = CompileAssignment(S);
+
+				Init = CompileExprStmt(S, CompileStore(S, Variable, CompileConvert(S, Typ, Value, FALSE)));
+				if (IsStatic)
+				{
+					struct CompiledStmt *Once = NewStmt(S, ExecStaticInit);
+
+					Once->Body = Init;
+					Once->Else = CompileExprStmt(S, Value);
+					Once->Visited = !FirstVisit;
+					Init = Once;
+				}
+			}
+
+			/* the values of an array initialiser are only evaluated once */
+			if (IsStatic && Init->Exec != ExecStaticInit)
+			{
+				struct CompiledStmt *Once = NewStmt(S, ExecStaticInit);
+
+				Once->Body = Init;
+				Once->Visited = !FirstVisit;
+				Init = Once;
+			}
+
+			*Tail = Init;
+			Tail = &Init->Next;
+		}
+
+		Token = CompileNext(S, NULL);
+	} while (Token == TokenComma);
+
+	if (Token != TokenSemicolon)
+		CompileBail(S, "';' expected");
+
+	return Block;
+}
+
+static struct CompiledStmt *CompileFor(struct CompileState *S)
+{
+	struct CompiledStmt *Stmt = NewStmt(S, ExecFor);
+
+	CompileExpect(S, TokenOpenBracket);
+	S->Depth++;
+
+	if (CompilePeek(S, NULL) == TokenSemicolon)
+		CompileNext(S, NULL);
+	else
+		Stmt->Else = CompileStatement(S);
+
+	if (CompilePeek(S, NULL) != TokenSemicolon)
+		Stmt->Expr = CompileCondition(S);
+	CompileExpect(S, TokenSemicolon);
+
+	if (CompilePeek(S, NULL) != TokenCloseBracket)
+		Stmt->Step = CompileExprStmt(S, CompileExpression(S));
+	CompileExpect(S, TokenCloseBracket);
+
+	S->Loops++;
+	S->Breakable++;
+	Stmt->Body = CompileStatement(S);
+	S->Loops--;
+	S->Breakable--;
+
+	CompileScopeEnd(S);
+	return Stmt;
+}
+
+static struct CompiledStmt *CompileStatement(struct CompileState *S)
+{
+	Picoc *pc = S->pc;
+	struct CompiledStmt *Stmt;
+	struct Value *LexValue;
+	enum LexToken Token;
+
+	S->StatementStart = S->Parser;
+	S->Where = NULL;
+
+	Token = CompilePeek(S, &LexValue);
+	if (CompileIsType(S, Token, LexValue))
+		return CompileDeclaration(S);
+
+	switch (Token)
+	{
+	case TokenSemicolon:
+		CompileNext(S, NULL);
+		return NewStmt(S, ExecNothing);
+
+	case TokenLeftBrace:
+		CompileNext(S, NULL);
+		return CompileBlock(S);
+
+	case TokenIf:
+		CompileNext(S, NULL);
+		Stmt = NewStmt(S, ExecIf);
+		CompileExpect(S, TokenOpenBracket);
+		Stmt->Expr = CompileCondition(S);
+		CompileExpect(S, TokenCloseBracket);
+		Stmt->Body = CompileStatement(S);
+		if (CompilePeek(S, NULL) == TokenElse)
+		{
+			CompileNext(S, NULL);
+			Stmt->Else = CompileStatement(S);
+		}
+		return Stmt;
+
+	case TokenWhile:
+		CompileNext(S, NULL);
+		Stmt = NewStmt(S, ExecWhile);
+		CompileExpect(S, TokenOpenBracket);
+		Stmt->Expr = CompileCondition(S);
+		CompileExpect(S, TokenCloseBracket);
+		S->Loops++;
+		S->Breakable++;
+		Stmt->Body = CompileStatement(S);
+		S->Loops--;
+		S->Breakable--;
+		return Stmt;
+
+	case TokenDo:
+		CompileNext(S, NULL);
+		Stmt = NewStmt(S, ExecDo);
+		S->Loops++;
+		S->Breakable++;
+		Stmt->Body = CompileStatement(S);
+		S->Loops--;
+		S->Breakable--;
+		CompileExpect(S, TokenWhile);
+		CompileExpect(S, TokenOpenBracket);
+		Stmt->Expr = CompileCondition(S);
+		CompileExpect(S, TokenCloseBracket);
+		CompileExpect(S, TokenSemicolon);
+		return Stmt;
+
+	case TokenFor:
+		CompileNext(S, NULL);
+		return CompileFor(S);
+
+	case TokenSwitch:
+		CompileNext(S, NULL);
+		return CompileSwitch(S);
+
+	case TokenBreak:
+	case TokenContinue:
+		CompileNext(S, NULL);
+		if ((Token == TokenBreak) ? !S->Breakable : !S->Loops)
+			CompileBail(S, "break or continue outside a loop");
+		CompileExpect(S, TokenSemicolon);
+		return NewStmt(S, (Token == TokenBreak) ? ExecBreak : ExecContinue);
+
+	case TokenReturn:
+		CompileNext(S, NULL);
+		Stmt = NewStmt(S, ExecReturn);
+		if (S->Func->Def->ReturnType == &pc->VoidType)
+		{
+			if (CompilePeek(S, NULL) != TokenSemicolon)
+				CompileBail(S, "value returned from a void function");
+		}
+		else
+		{
+			if (CompilePeek(S, NULL) == TokenSemicolon)
+				CompileBail(S, "value required in return");
+
+			Stmt->Expr = CompileConvert(S, S->Func->Def->ReturnType, CompileExpression(S), FALSE);
+			if (CompiledKindOf(Stmt->Expr->Typ) == KindAggregate)
+				CompileBail(S, "return type not supported");
+			if (CompiledKindOf(Stmt->Expr->Typ) == KindInt && Stmt->Expr->Typ != S->Func->Def->ReturnType)
+				Stmt->Expr = CompileRetype(S, Stmt->Expr, S->Func->Def->ReturnType);
+		}
+		CompileExpect(S, TokenSemicolon);
+		return Stmt;
+
+	case TokenIdentifier:
+	case TokenIntegerConstant:
+	case TokenFPConstant:
+	case TokenStringConstant:
+	case TokenCharacterConstant:
+	case TokenAsterisk:
+	case TokenAmpersand:
+	case TokenIncrement:
+	case TokenDecrement:
+	case TokenOpenBracket:
+	case TokenMinus:
+	case TokenPlus:
+	case TokenUnaryNot:
+	case TokenUnaryExor:
+	case TokenSizeof:
+		if (Token == TokenIdentifier)
+		{
+			struct ParseState Ahead = S->Parser;
+
+			LexGetToken(&Ahead, NULL, TRUE);
+			if (LexGetToken(&Ahead, NULL, FALSE) == TokenColon)
+				CompileBail(S, "labels not supported");
+		}
+		Stmt = CompileExprStmt(S, CompileExpression(S));
+		CompileExpect(S, TokenSemicolon);
+		return Stmt;
+
+	default:
+		CompileBail(S, "statement not supported");
+		return NULL;
+	}
+}
+
+/**
+ * compiles a script function, or finds it if it has been compiled already.
+ * Functions are registered before their body is compiled, so recursion works.
+ */
+static struct CompiledFunction *CompileFunction(struct CompiledProgram *Program, struct Value *FuncValue, const char *Name)
+{
+	struct FuncDef *Def = &FuncValue->Val->FuncDef;
+	struct CompiledFunction *Func;
+	struct CompileState State;
+	struct CompileState *S = &State;
+	struct CompiledStmt *Body;
+	int Count;
+
+	for (Func = Program->Functions; Func != NULL; Func = Func->Next)
+	{
+		if (Func->Def == Def)
+			return Func;
+	}
+
+	memset(S, 0, sizeof(*S));
+	S->pc = Program->pc;
+	S->Program = Program;
+	ParserCopy(&S->Parser, &Def->Body);
+	S->Parser.Mode = RunModeRun;
+	S->StatementStart = S->Parser;
+
+	if (Def->Intrinsic != NULL || Def->Body.Pos == NULL || Def->VarArgs || Def->NumParams > PARAMETER_MAX)
+		CompileBail(S, "function not supported");
+
+	Func = CompileAlloc(S, sizeof(struct CompiledFunction));
+	Func->Def = Def;
+	Func->Name = Name;
+	Func->pc = S->pc;
+	Func->Where = CompileWhere(S);
+	Func->FrameSize = MEM_ALIGN(sizeof(union CompiledValue));
+	Func->ParamOffset = CompileAlloc(S, sizeof(int) * (Def->NumParams + 1));
+	Func->Next = Program->Functions;
+	Program->Functions = Func;
+	S->Func = Func;
+
+	/* the parameters are locals of the outermost block */
+	for (Count = 0; Count < Def->NumParams; Count++)
+	{
+		struct CompileLocal *Local;
+		struct ValueType *Typ = Def->ParamType[Count];
+
+		if (CompiledKindOf(Typ) != KindInt && CompiledKindOf(Typ) != KindFP && CompiledKindOf(Typ) != KindPointer)
+			CompileBail(S, "parameter type not supported");
+
+		Local = CompileAlloc(S, sizeof(struct CompileLocal));
+		Local->Ident = Def->ParamName[Count];
+		Local->Typ = Typ;
+		Local->Offset = CompileFrameAlloc(S, TypeSize(Typ, Typ->ArraySize, TRUE));
+		Local->Depth = 1;
+		Local->Next = S->Locals;
+		S->Locals = Local;
+		Func->ParamOffset[Count] = Local->Offset;
+	}
+
+	CompileExpect(S, TokenLeftBrace);
+	Body = CompileBlock(S);
+	Func->Body = Body;
+
+	return Func;
+}
+
+/* removes what compiling left behind, the program itself goes last */
+static void CompileCleanup(struct CompiledProgram *Program, int Failed)
+{
+	Picoc *pc = Program->pc;
+	struct CompileChunk *Chunk = Program->Chunks;
+	struct CompileStatic *Static;
+
+	if (Failed)
+	{
+		for (Static = Program->Statics; Static != NULL; Static = Static->Next)
+		{
+			struct Value *Value = TableDelete(pc, &pc->GlobalTable, Static->Name);
+			if (Value != NULL)
+				VariableFree(pc, Value);
+		}
+	}
+
+	while (Chunk != NULL)
+	{
+		struct CompileChunk *Next = Chunk->Next;
+		HeapFreeMem(pc, Chunk);
+		Chunk = Next;
+	}
+
+	HeapFreeMem(pc, Program);
+}
+
+static void CompileDiscardOutput(unsigned char OutCh, union OutputStreamInfo *Stream)
+{
+}
+
+/**
+ * compiles a script function without parameters, like loop().
+ * Errors while compiling are not errors of the script, so they are kept
+ * away from the exit point and the console.
+ * returns NULL if the function has to be interpreted, Line is then set to
+ * the script line the compiler gave up at
+ */
+struct CompiledProgram *PicocCompile(Picoc *pc, const char *FuncName, int *Line)
+{
+	struct CompiledProgram *Program;
+	struct Value *FuncValue;
+	CharWriter *Putch = pc->CStdOutBase.Putch;
+	int ExitValue = pc->PicocExitValue;
+	jmp_buf ExitBuf;
+	int Failed;
+
+	*Line = 0;
+	if (!TableGet(&pc->GlobalTable, TableStrRegister(pc, FuncName), &FuncValue, NULL, NULL, NULL) ||
+			FuncValue->Typ->Base != TypeFunction || FuncValue->Val->FuncDef.NumParams != 0)
+		return NULL;
+
+	Program = HeapAllocMem(pc, sizeof(struct CompiledProgram));
+	if (Program == NULL)
+		return NULL;
+
+	memset(Program, 0, sizeof(*Program));
+	Program->pc = pc;
+	Program->StackReserve = ((char *)pc->HeapBottom - (char *)pc->HeapStackTop) / COMPILE_STACK_SHARE;
+
+	memcpy(ExitBuf, PicocExitBuf, sizeof(jmp_buf));
+	pc->CStdOutBase.Putch = &CompileDiscardOutput;
+
+	Failed = setjmp(PicocExitBuf);
+	if (!Failed)
+		Program->Entry = CompileFunction(Program, FuncValue, TableStrRegister(pc, FuncName));
+
+	memcpy(PicocExitBuf, ExitBuf, sizeof(jmp_buf));
+	pc->CStdOutBase.Putch = Putch;
+	pc->PicocExitValue = ExitValue;
+
+	if (Failed)
+	{
+		PlatformDebug("%s() is interpreted, line %d: %s\n", FuncName, Program->ReasonLine,
+			(Program->Reason != NULL) ? Program->Reason : "error");
+		*Line = Program->ReasonLine;
+		CompileCleanup(Program, TRUE);
+		return NULL;
+	}
+
+	return Program;
+}
+
+/**
+ * runs the compiled function once
+ */
+void PicocRunCompiled(struct CompiledProgram *Program)
+{
+	union CompiledValue Result;
+
+	RunFunction(Program->Entry, Program->Entry->Where, NULL, &Result);
+}
+
+void PicocFreeCompiled(struct CompiledProgram *Program)
+{
+	if (Program != NULL)
+		CompileCleanup(Program, FALSE);
+}
+
+#endif /* NO_FP */
+
+#endif /* PIOS_INCLUDE_PICOC */
+
+/**
+ * @}
+ * @}
+ */
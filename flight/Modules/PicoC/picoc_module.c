@@ -59,6 +59,7 @@ extern struct flashfs_logfs_cfg flashfs_waypoints_cfg;
 #define TASK_STACKSIZE_MAX		(128*1024)
 #define PICOC_STACKSIZE_MIN		(10*1024)
 #define PICOC_STACKSIZE_MAX		(128*1024)
+#define PICOC_CYCLEPERIOD_MIN	5				/* ms, loop() must leave time to the other tasks */
 #define PICOC_SOURCE_FILE_TYPE	0X00704300		/* mark picoc sources with this ID */
 #define PICOC_SECTOR_SIZE		48				/* size of filesystem object (less than slot_size - sizeof(slot_header) */
 #define SOH	0x01	/* (^A) start of heading */
@@ -79,6 +80,9 @@ static PicoCStatusData picocstatus;
 // Private functions
 static void picocTask(void *parameters);
 static void updateSettings();
+static bool startupCondition(const PicoCSettingsData *settings, const FlightStatusData *flightstatus);
+static bool keepRunningCyclic();
+static void loopStartedCyclic(bool compiled, int line);
 int32_t usart_cmd(char *buffer, uint32_t buffer_size);
 int32_t get_sector(uint16_t sector, char *buffer, uint32_t buffer_size);
 int32_t set_sector(uint16_t sector, char *buffer, uint32_t buffer_size);
@@ -245,19 +249,7 @@ static void picocTask(void *parameters) {
 
 		// check startup condition
 		if ((picocstatus.Command == PICOCSTATUS_COMMAND_IDLE) && (picocstatus.CommandError == 0)) {
-			switch (picocsettings.Startup) {
-			case PICOCSETTINGS_STARTUP_DISABLED:
-				startup = false;
-				break;
-			case PICOCSETTINGS_STARTUP_ONBOOT:
-				startup = true;
-				break;
-			case PICOCSETTINGS_STARTUP_WHENARMED:
-				startup = (flightstatus.Armed == FLIGHTSTATUS_ARMED_ARMED);
-				break;
-			default:
-				startup = false;
-			}
+			startup = startupCondition(&picocsettings, &flightstatus);
 		} else {
 			startup = false;
 		}
@@ -281,6 +273,15 @@ static void picocTask(void *parameters) {
 				picocstatus.ExitValue = picoc(sourcebuffer, picocsettings.PicoCStackSize);
 				started = true;
 				break;
+			case PICOCSETTINGS_SOURCE_FILECYCLIC:
+				// terminate source for security.
+				sourcebuffer[sourcebuffer_size - 1] = 0;
+				// parse once and call loop() until the startup condition goes away.
+				picocstatus.ExitValue = picoc_cyclic(sourcebuffer, picocsettings.PicoCStackSize,
+						(picocsettings.CyclePeriod > PICOC_CYCLEPERIOD_MIN) ? picocsettings.CyclePeriod : PICOC_CYCLEPERIOD_MIN,
+						keepRunningCyclic, loopStartedCyclic);
+				started = true;
+				break;
 			default:
 				picocstatus.ExitValue = 0;
 			}
@@ -294,6 +295,48 @@ static void picocTask(void *parameters) {
 	}
 }
 
+/**
+ * check if the script should be running with the current settings
+ */
+static bool startupCondition(const PicoCSettingsData *settings, const FlightStatusData *flightstatus)
+{
+	switch (settings->Startup) {
+	case PICOCSETTINGS_STARTUP_ONBOOT:
+		return true;
+	case PICOCSETTINGS_STARTUP_WHENARMED:
+		return (flightstatus->Armed == FLIGHTSTATUS_ARMED_ARMED);
+	case PICOCSETTINGS_STARTUP_DISABLED:
+	default:
+		return false;
+	}
+}
+
+/**
+ * called by the cyclic interpreter before each call of loop()
+ */
+static bool keepRunningCyclic()
+{
+	PicoCSettingsData settings;
+	FlightStatusData flightstatus;
+
+	PicoCSettingsGet(&settings);
+	FlightStatusGet(&flightstatus);
+
+	return (settings.Source == PICOCSETTINGS_SOURCE_FILECYCLIC) &&
+		startupCondition(&settings, &flightstatus);
+}
+
+/**
+ * called by the cyclic interpreter once it knows how loop() is run
+ */
+static void loopStartedCyclic(bool compiled, int line)
+{
+	picocstatus.LoopExecution = compiled ? PICOCSTATUS_LOOPEXECUTION_COMPILED : PICOCSTATUS_LOOPEXECUTION_INTERPRETED;
+	picocstatus.LoopInterpretedLine = line;
+	PicoCStatusLoopExecutionSet(&picocstatus.LoopExecution);
+	PicoCStatusLoopInterpretedLineSet(&picocstatus.LoopInterpretedLine);
+}
+
 /**
  * update picoc module settings
  */
@@ -91,6 +91,75 @@ int picoc(const char * source, size_t stack_size)
 	return pc.PicocExitValue;
 }
 
+/**
+ * picoc cyclic program
+ * parses and runs the source once, then calls the loop() function of the
+ * script every period_ms milliseconds for as long as keep_running() is true.
+ * The script is lexed only once. loop() is compiled into a tree of C
+ * functions when possible (see picoc_compile.c), otherwise the call to
+ * loop() is kept as a ready token stream and interpreted every cycle.
+ * loop_started() is told which of the two it is, and for an interpreted
+ * loop() the script line the compiler gave up at.
+ * returns the exit() value
+ */
+int picoc_cyclic(const char *source, size_t stack_size, uint32_t period_ms, bool (*keep_running)(void),
+		void (*loop_started)(bool compiled, int line))
+{
+	Picoc pc;
+	PicocInitialise(&pc, stack_size);
+
+	if (PicocPlatformSetExitPoint(&pc))
+	{	/* we get here, if an error occures or 'exit();' was called. */
+		PicocCleanup(&pc);
+		return pc.PicocExitValue;
+	}
+
+	/* keep the tokens, the function bodies are executed from them */
+	PicocParse(&pc, "nofile", source, strlen(source), true, false, false, false);
+
+	if (!VariableDefined(&pc, TableStrRegister(&pc, "loop")))
+		ProgramFailNoParser(&pc, "loop() is not defined");
+
+	uint32_t last_cycle = PIOS_Thread_Systime();
+	int line = 0;
+
+#ifndef NO_FP
+	/* loop() is translated once, if it uses anything the compiler can't do it is interpreted */
+	struct CompiledProgram *compiled = PicocCompile(&pc, "loop", &line);
+
+	if (compiled != NULL)
+	{
+		loop_started(true, 0);
+		while (keep_running())
+		{
+			PicocRunCompiled(compiled);
+			PIOS_Thread_Sleep_Until(&last_cycle, period_ms);
+		}
+
+		PicocFreeCompiled(compiled);
+		PicocCleanup(&pc);
+		return pc.PicocExitValue;
+	}
+#endif
+
+	const char *call_loop = "loop();";
+	void *call_tokens = LexAnalyse(&pc, "loop", call_loop, strlen(call_loop), NULL);
+	char *call_name = TableStrRegister(&pc, "loop");
+	struct ParseState parser;
+
+	loop_started(false, line);
+	while (keep_running())
+	{
+		LexInitParser(&parser, &pc, call_loop, call_tokens, call_name, true, false);
+		ParseStatement(&parser, true);
+		PIOS_Thread_Sleep_Until(&last_cycle, period_ms);
+	}
+
+	HeapFreeMem(&pc, call_tokens);
+	PicocCleanup(&pc);
+	return pc.PicocExitValue;
+}
+
 /**
  * PicoC platform depending system functions
  * normaly stored in platform_xxx.c
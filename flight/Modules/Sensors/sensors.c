@@ -53,11 +53,13 @@ extern uintptr_t external_i2c_adapter_id;
 #include "opticalflowsettings.h"
 #include "opticalflow.h"
 #include "sensorsettings.h"
+#include "sensorstats.h"
 #include "rangefinderdistance.h"
 #include "inssettings.h"
 #include "magnetometer.h"
 #include "magbias.h"
 #include "coordinate_conversions.h"
+#include "control_pipeline.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1000
@@ -66,6 +68,7 @@ extern uintptr_t external_i2c_adapter_id;
 #define REQUIRED_GOOD_CYCLES 50
 #define MAX_TIME_BETWEEN_VALID_BARO_DATAS_MS 100*1000  // we allow a pause time of 100 ms between two valid
                                                        // temperature/barometer dataa
+#define SENSOR_STATS_PERIOD_MS 1000
 
 // Private types
 enum mag_calibration_algo {
@@ -73,12 +76,21 @@ enum mag_calibration_algo {
 	MAG_CALIBRATION_NORMALIZE_LENGTH
 };
 
+//! Sum of the samples taken from a sensor queue since the last output
+struct sensor_accum {
+	float x;
+	float y;
+	float z;
+	float temperature;
+	uint16_t count;
+};
+
 // Private functions
 static void SensorsTask(void *parameters);
 static void settingsUpdatedCb(UAVObjEvent * objEv, void *ctx, void *obj, int len);
 
 static void update_accels(struct pios_sensor_accel_data *accel);
-static void update_gyros(struct pios_sensor_gyro_data *gyro);
+static void update_gyros(struct pios_sensor_gyro_data *gyro, uint32_t timestamp);
 static void update_mags(struct pios_sensor_mag_data *mag);
 static void update_baro(struct pios_sensor_baro_data *baro);
 
@@ -95,6 +107,9 @@ static void mag_calibration_fix_length(MagnetometerData *mag);
 
 static void updateTemperatureComp(float temperature, float *temp_bias);
 
+static void accum_add(struct sensor_accum *accum, float x, float y, float z, float temperature);
+static void update_sensor_stats(uint16_t samples, uint16_t backlog);
+
 // Private variables
 static struct pios_thread *sensorsTaskHandle;
 static INSSettingsData insSettings;
@@ -115,6 +130,10 @@ static float gyro_temp_bias[3] = {0,0,0};
 static float z_accel_offset = 0;
 static float Rsb[3][3] = {{0}}; //! Rotation matrix that transforms from the body frame to the sensor board frame
 static int8_t rotate = 0;
+static uint8_t gyro_decimation = 1;
+
+static struct sensor_accum gyro_accum;
+static SensorStatsData sensorStats;
 
 #if defined(SUPPORTS_EXTERNAL_MAG)
 // indicates whether the external mag works
@@ -146,7 +165,9 @@ static int32_t SensorsInitialize(void)
 		|| MagBiasInitialize() == -1 \
 		|| AttitudeSettingsInitialize() == -1 \
 		|| SensorSettingsInitialize() == -1 \
-		|| INSSettingsInitialize() == -1) {
+		|| SensorStatsInitialize() == -1 \
+		|| INSSettingsInitialize() == -1 \
+		|| control_pipeline_initialize() == -1) {
 
 		return -1;
 	}
@@ -253,22 +274,74 @@ static void SensorsTask(void *parameters)
 		//Block on gyro data but nothing else
 		struct pios_queue *queue;
 		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO);
-		if (queue == NULL || PIOS_Queue_Receive(queue, &gyros, SENSOR_PERIOD) == false) {
+		if (queue == NULL) {
+			good_runs = 0;
+			continue;
+		}
+
+		// Latency to the outputs is measured from when the newest sample
+		// of the window was read
+		uint32_t gyro_timestamp = 0;
+
+		// Drain whatever was already waiting, so that a backlog is
+		// averaged into this output instead of delaying the following ones
+		uint16_t backlog = 0;
+		while (PIOS_Queue_Receive(queue, &gyros, 0)) {
+			accum_add(&gyro_accum, gyros.x, gyros.y, gyros.z, gyros.temperature);
+			gyro_timestamp = gyros.timestamp;
+			backlog++;
+		}
+
+		// Then wait for the rest of the decimation window
+		bool gyro_timeout = false;
+		while (gyro_accum.count < gyro_decimation) {
+			if (PIOS_Queue_Receive(queue, &gyros, SENSOR_PERIOD) == false) {
+				gyro_timeout = true;
+				break;
+			}
+			accum_add(&gyro_accum, gyros.x, gyros.y, gyros.z, gyros.temperature);
+			gyro_timestamp = gyros.timestamp;
+		}
+
+		if (gyro_timeout) {
+			gyro_accum = (struct sensor_accum) { 0 };
 			good_runs = 0;
 			continue;
 		}
 
+		// Publish the average of the window, a boxcar FIR that also
+		// rejects what would alias down from above the output rate
+		uint16_t gyro_samples = gyro_accum.count;
+		gyros.x = gyro_accum.x / gyro_samples;
+		gyros.y = gyro_accum.y / gyro_samples;
+		gyros.z = gyro_accum.z / gyro_samples;
+		gyros.temperature = gyro_accum.temperature / gyro_samples;
+		gyro_accum = (struct sensor_accum) { 0 };
+
+		update_sensor_stats(gyro_samples, backlog);
+
+		// Accels come at the gyro rate or slower; average all that
+		// arrived since the last cycle
+		struct sensor_accum accel_accum = { 0 };
 		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
-		if (queue == NULL || PIOS_Queue_Receive(queue, &accels, 0) == false) {
+		while (queue != NULL && PIOS_Queue_Receive(queue, &accels, 0)) {
+			accum_add(&accel_accum, accels.x, accels.y, accels.z, accels.temperature);
+		}
+
+		if (accel_accum.count == 0) {
 			//If no new accels data is ready, reuse the latest sample
 			AccelsSet(&accelsData);
-		}
-		else
+		} else {
+			accels.x = accel_accum.x / accel_accum.count;
+			accels.y = accel_accum.y / accel_accum.count;
+			accels.z = accel_accum.z / accel_accum.count;
+			accels.temperature = accel_accum.temperature / accel_accum.count;
 			update_accels(&accels);
+		}
 
 		// Update gyros after the accels since the rest of the code expects
 		// the accels to be available first
-		update_gyros(&gyros);
+		update_gyros(&gyros, gyro_timestamp);
 
 		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_MAG);
 		if (queue != NULL && PIOS_Queue_Receive(queue, &mags, 0) != false) {
@@ -330,6 +403,54 @@ static void SensorsTask(void *parameters)
 	}
 }
 
+/**
+ * @brief Add a sample to the sum for the current output
+ */
+static void accum_add(struct sensor_accum *accum, float x, float y, float z, float temperature)
+{
+	accum->x += x;
+	accum->y += y;
+	accum->z += z;
+	accum->temperature += temperature;
+	accum->count++;
+}
+
+/**
+ * @brief Account for one published gyro sample in @ref SensorStats
+ * @param[in] samples The number of raw samples that went into it
+ * @param[in] backlog How many of those were already waiting in the queue
+ */
+static void update_sensor_stats(uint16_t samples, uint16_t backlog)
+{
+	static uint32_t last_update_time;
+	static uint32_t period_samples;
+	static uint32_t period_cycles;
+
+	sensorStats.GyroSamples += samples;
+	sensorStats.Cycles++;
+
+	// A whole window was waiting, so the task has fallen behind the sensor
+	if (backlog >= gyro_decimation)
+		sensorStats.Overruns++;
+
+	if (backlog > sensorStats.MaxBacklog)
+		sensorStats.MaxBacklog = MIN(backlog, UINT8_MAX);
+
+	period_samples += samples;
+	period_cycles++;
+
+	uint32_t now = PIOS_Thread_Systime();
+	if (now - last_update_time >= SENSOR_STATS_PERIOD_MS) {
+		sensorStats.SamplesPerCycle = (float) period_samples / period_cycles;
+		SensorStatsSet(&sensorStats);
+
+		sensorStats.MaxBacklog = 0;
+		period_samples = 0;
+		period_cycles = 0;
+		last_update_time = now;
+	}
+}
+
 /**
  * @brief Apply calibration and rotation to the raw accel data
  * @param[in] accels The raw accel data
@@ -364,8 +485,9 @@ static void update_accels(struct pios_sensor_accel_data *accels)
 /**
  * @brief Apply calibration and rotation to the raw gyro data
  * @param[in] gyros The raw gyro data
+ * @param[in] timestamp PIOS_DELAY_GetRaw() when it was read
  */
-static void update_gyros(struct pios_sensor_gyro_data *gyros)
+static void update_gyros(struct pios_sensor_gyro_data *gyros, uint32_t timestamp)
 {
 	// Scale the gyros
 	float gyros_out[3] = {
@@ -417,6 +539,16 @@ static void update_gyros(struct pios_sensor_gyro_data *gyros)
 		}
 	}
 
+	// Hand the sample to stabilization before the UAVO, which only
+	// queued mode waits for
+	struct control_pipeline_gyro *sample = control_pipeline_gyro_claim();
+	sample->x = gyrosData.x;
+	sample->y = gyrosData.y;
+	sample->z = gyrosData.z;
+	sample->temperature = gyrosData.temperature;
+	sample->timestamp = timestamp;
+	control_pipeline_gyro_publish();
+
 	GyrosSet(&gyrosData);
 }
 
@@ -706,6 +838,7 @@ static void settingsUpdatedCb(UAVObjEvent * objEv, void *ctx, void *obj, int len
 	gyro_coeff_z[2] =  sensorSettings.ZGyroTempCoeff[2];
 	gyro_coeff_z[3] =  sensorSettings.ZGyroTempCoeff[3];
 	z_accel_offset  =  sensorSettings.ZAccelOffset;
+	gyro_decimation =  MAX(sensorSettings.GyroDecimation, 1);
 
 	// Zero out any adaptive tracking
 	MagBiasData magBias;
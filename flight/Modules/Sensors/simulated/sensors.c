@@ -40,7 +40,9 @@
 #include "pios_thread.h"
 
 #include "accels.h"
+#include "actuatorcommand.h"
 #include "actuatordesired.h"
+#include "actuatorsettings.h"
 #include "airspeedactual.h"
 #include "attitudeactual.h"
 #include "attitudesimulated.h"
@@ -77,6 +79,9 @@ static void simulateModelAgnostic();
 static void simulateModelQuadcopter();
 static void simulateModelAirplane();
 static void simulateModelCar();
+#if defined(PIOS_INCLUDE_SIM)
+static void simulateModelPhysics();
+#endif /* PIOS_INCLUDE_SIM */
 
 static void magOffsetEstimation(MagnetometerData *mag);
 
@@ -84,7 +89,10 @@ static float accel_bias[3];
 
 static float rand_gauss();
 
-enum sensor_sim_type {CONSTANT, MODEL_AGNOSTIC, MODEL_QUADCOPTER, MODEL_AIRPLANE, MODEL_CAR} sensor_sim_type;
+enum sensor_sim_type {CONSTANT, MODEL_AGNOSTIC, MODEL_QUADCOPTER, MODEL_AIRPLANE, MODEL_CAR, MODEL_PHYSICS} sensor_sim_type;
+
+//! Whether a physical model was selected on the command line
+static bool physics_model;
 
 /**
  * Initialise the module.  Called before the start function
@@ -108,6 +116,10 @@ int32_t SensorsInitialize(void)
 	MagnetometerInitialize();
 	MagBiasInitialize();
 
+#if defined(PIOS_INCLUDE_SIM)
+	physics_model = (PIOS_SIM_Init() == 0);
+#endif /* PIOS_INCLUDE_SIM */
+
 	return 0;
 }
 
@@ -164,6 +176,9 @@ static void SensorsTask(void *parameters)
 			default:
 				sensor_sim_type = MODEL_AGNOSTIC;
 		}
+
+		if (physics_model)
+			sensor_sim_type = MODEL_PHYSICS;
 		
 		static int i;
 		i++;
@@ -189,6 +204,12 @@ static void SensorsTask(void *parameters)
 				break;
 			case MODEL_CAR:
 				simulateModelCar();
+				break;
+			case MODEL_PHYSICS:
+#if defined(PIOS_INCLUDE_SIM)
+				simulateModelPhysics();
+#endif /* PIOS_INCLUDE_SIM */
+				break;
 		}
 
 		PIOS_Thread_Sleep(2);
@@ -1082,6 +1103,144 @@ static void simulateModelCar()
 	AttitudeSimulatedSet(&attitudeSimulated);
 }
 
+#if defined(PIOS_INCLUDE_SIM)
+/**
+ * This method flies the physical model of PIOS_SIM
+ *
+ * The motors are driven by the actuator outputs, scaled from the channel
+ * range to 0 to 1, and the model is advanced by exactly the task period so
+ * that a run does not depend on how the host schedules it.  The model adds
+ * its own sensor noise.
+ */
+static void simulateModelPhysics()
+{
+	const float dT = SENSOR_PERIOD / 1000.0f;
+	const float GPS_PERIOD = 0.1;
+	const float MAG_PERIOD = 1.0 / 75.0;
+	const float BARO_PERIOD = 1.0 / 20.0;
+
+	// Simulated time since each sensor was last updated
+	static float gps_time, mag_time, baro_time;
+
+	ActuatorCommandData actuatorCommand;
+	ActuatorCommandGet(&actuatorCommand);
+
+	uint16_t channelMin[ACTUATORSETTINGS_CHANNELMIN_NUMELEM];
+	uint16_t channelMax[ACTUATORSETTINGS_CHANNELMAX_NUMELEM];
+	ActuatorSettingsChannelMinGet(channelMin);
+	ActuatorSettingsChannelMaxGet(channelMax);
+
+	float command[ACTUATORCOMMAND_CHANNEL_NUMELEM];
+	for (int i = 0; i < ACTUATORCOMMAND_CHANNEL_NUMELEM; i++) {
+		float range = channelMax[i] - channelMin[i];
+		command[i] = (range != 0) ? (actuatorCommand.Channel[i] - channelMin[i]) / range : 0;
+	}
+
+	PIOS_SIM_SetActuator(command, NELEMENTS(command));
+	PIOS_SIM_Step(dT);
+
+	float q[4], pos[3], vel[3];
+	PIOS_SIM_GetAttitude(q);
+	PIOS_SIM_GetPosition(pos);
+	PIOS_SIM_GetVelocity(vel);
+
+	float gyro[3];
+	PIOS_SIM_GetGyros(gyro);
+
+	GyrosData gyrosData; // Skip get as we set all the fields
+	gyrosData.x = gyro[0];
+	gyrosData.y = gyro[1];
+	gyrosData.z = gyro[2];
+	gyrosData.temperature = 20;
+	GyrosSet(&gyrosData);
+
+	float accel[3];
+	PIOS_SIM_GetAccels(accel);
+
+	AccelsData accelsData; // Skip get as we set all the fields
+	accelsData.x = accel[0];
+	accelsData.y = accel[1];
+	accelsData.z = accel[2];
+	accelsData.temperature = 20;
+	AccelsSet(&accelsData);
+
+	mag_time += dT;
+	if (mag_time >= MAG_PERIOD) {
+		float field[3];
+		PIOS_SIM_GetMag(field);
+
+		MagnetometerData mag;
+		mag.x = field[0];
+		mag.y = field[1];
+		mag.z = field[2];
+
+		// Run the offset compensation algorithm from the firmware
+		magOffsetEstimation(&mag);
+
+		MagnetometerSet(&mag);
+		mag_time -= MAG_PERIOD;
+	}
+
+	baro_time += dT;
+	if (baro_time >= BARO_PERIOD) {
+		BaroAltitudeData baroAltitude;
+		BaroAltitudeGet(&baroAltitude);
+		PIOS_SIM_GetBaro(&baroAltitude.Altitude);
+		BaroAltitudeSet(&baroAltitude);
+		baro_time -= BARO_PERIOD;
+	}
+
+	gps_time += dT;
+	if (gps_time >= GPS_PERIOD) {
+		HomeLocationData homeLocation;
+		HomeLocationGet(&homeLocation);
+
+		// Use double precision here as simulating what GPS produces
+		double T[3];
+		T[0] = homeLocation.Altitude+6.378137E6f * DEG2RAD;
+		T[1] = cosf(homeLocation.Latitude / 10e6 * DEG2RAD)*(homeLocation.Altitude+6.378137E6) * DEG2RAD;
+		T[2] = -1.0;
+
+		GPSPositionData gpsPosition;
+		GPSPositionGet(&gpsPosition);
+		gpsPosition.Latitude = homeLocation.Latitude + (pos[0] / T[0] * 10.0e6);
+		gpsPosition.Longitude = homeLocation.Longitude + (pos[1] / T[1] * 10.0e6);
+		gpsPosition.Altitude = homeLocation.Altitude + (pos[2] / T[2]);
+		gpsPosition.Groundspeed = sqrtf(vel[0] * vel[0] + vel[1] * vel[1]);
+		gpsPosition.Heading = 180 / M_PI * atan2f(vel[1], vel[0]);
+		gpsPosition.Satellites = 7;
+		gpsPosition.PDOP = 1;
+		gpsPosition.Accuracy = 3.0;
+		gpsPosition.Status = GPSPOSITION_STATUS_FIX3D;
+		GPSPositionSet(&gpsPosition);
+
+		GPSVelocityData gpsVelocity;
+		GPSVelocityGet(&gpsVelocity);
+		gpsVelocity.North = vel[0];
+		gpsVelocity.East = vel[1];
+		gpsVelocity.Down = vel[2];
+		gpsVelocity.Accuracy = 0.75;
+		GPSVelocitySet(&gpsVelocity);
+
+		gps_time -= GPS_PERIOD;
+	}
+
+	AttitudeSimulatedData attitudeSimulated;
+	AttitudeSimulatedGet(&attitudeSimulated);
+	attitudeSimulated.q1 = q[0];
+	attitudeSimulated.q2 = q[1];
+	attitudeSimulated.q3 = q[2];
+	attitudeSimulated.q4 = q[3];
+	Quaternion2RPY(q,&attitudeSimulated.Roll);
+	attitudeSimulated.Position[0] = pos[0];
+	attitudeSimulated.Position[1] = pos[1];
+	attitudeSimulated.Position[2] = pos[2];
+	attitudeSimulated.Velocity[0] = vel[0];
+	attitudeSimulated.Velocity[1] = vel[1];
+	attitudeSimulated.Velocity[2] = vel[2];
+	AttitudeSimulatedSet(&attitudeSimulated);
+}
+#endif /* PIOS_INCLUDE_SIM */
 
 static float rand_gauss (void) {
 	float v1,v2,s;
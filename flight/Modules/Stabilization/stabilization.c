@@ -65,6 +65,14 @@
 #include "physical_constants.h"
 #include "pid.h"
 #include "misc_math.h"
+#include "biquad.h"
+#include "control_pipeline.h"
+
+// The dynamic notch needs the CMSIS DSP library and an FPU
+#if defined(ARM_MATH_CM4) || defined(ARM_MATH_SIM)
+#define STABILIZATION_DYNAMIC_NOTCH
+#include "notch_tracker.h"
+#endif
 
 // Includes for various stabilization algorithms
 #include "virtualflybar.h"
@@ -120,6 +128,14 @@ float vbar_decay = 0.991f;
 float gyro_alpha = 0.6;
 struct pid pids[PID_MAX];
 
+static struct biquad gyro_notch[MAX_AXES];
+static struct biquad gyro_lowpass[MAX_AXES];
+#if defined(STABILIZATION_DYNAMIC_NOTCH)
+static struct notch_tracker *notch_tracker;
+static bool notch_tracking;
+static uint8_t notch_tracker_axis;
+#endif
+
 volatile bool gyro_filter_updated = false;
 
 static bool actuatorDesiredUpdated = true;
@@ -128,6 +144,7 @@ static bool systemSettingsUpdated = true;
 
 // Private functions
 static void stabilizationTask(void* parameters);
+static void configure_gyro_filters(float sample_rate);
 static void zero_pids(void);
 static void calculate_pids(void);
 static void SettingsUpdatedCb(UAVObjEvent * objEv, void *ctx, void *obj, int len);
@@ -180,7 +197,8 @@ int32_t StabilizationInitialize()
 		|| ActuatorDesiredInitialize() == -1 \
 		|| SubTrimInitialize() == -1 \
 		|| SubTrimSettingsInitialize() == -1 \
-		|| ManualControlCommandInitialize() == -1) {
+		|| ManualControlCommandInitialize() == -1 \
+		|| control_pipeline_initialize() == -1) {
 		return -1;
 	}
 
@@ -240,13 +258,29 @@ static void stabilizationTask(void* parameters)
 
 		PIOS_WDG_UpdateFlag(PIOS_WDG_STABILIZATION);
 
-		// Wait until the AttitudeRaw object is updated, if a timeout then go to failsafe
-		if (PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS) != true)
+		// Wait until the Gyros object is updated, or in direct mode
+		// until the sensors hand over the sample.  If a timeout then go
+		// to failsafe
+		const struct control_pipeline_gyro *gyro_sample = NULL;
+		bool direct = control_pipeline_is_direct() && control_pipeline_has_gyro();
+		if (direct) {
+			gyro_sample = control_pipeline_gyro_wait(FAILSAFE_TIMEOUT_MS);
+
+			// Keep the queue empty for switching back to queued mode
+			PIOS_Queue_Receive(queue, &ev, 0);
+		} else if (PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS) == true) {
+			gyro_sample = control_pipeline_gyro_latest();
+		}
+
+		if (gyro_sample == NULL)
 		{
 			AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_WARNING);
 			continue;
 		}
 
+		uint32_t gyro_timestamp = gyro_sample->timestamp;
+		float stabilization_latency = PIOS_DELAY_DiffuS(gyro_timestamp);
+
 		float dT = PIOS_DELAY_DiffuS(timeval) * 1.0e-6f;
 		timeval = PIOS_DELAY_GetRaw();
 
@@ -263,7 +297,8 @@ static void stabilizationTask(void* parameters)
 		}
 
 		if (gyro_filter_updated) {
-			if (settings.GyroCutoff < 1.0f) {
+			if (settings.GyroCutoff < 1.0f ||
+					settings.GyroFilterType == STABILIZATIONSETTINGS_GYROFILTERTYPE_BIQUAD) {
 				gyro_alpha = 0;
 			} else {
 				gyro_alpha = expf(-2.0f * (float)(M_PI) *
@@ -277,6 +312,8 @@ static void stabilizationTask(void* parameters)
 				vbar_decay = expf(-dT_filtered / settings.VbarTau);
 			}
 
+			configure_gyro_filters(1.0f / dT_filtered);
+
 			gyro_filter_updated = false;
 		}
 
@@ -297,7 +334,14 @@ static void stabilizationTask(void* parameters)
 
 		StabilizationDesiredGet(&stabDesired);
 		AttitudeActualGet(&attitudeActual);
-		GyrosGet(&gyrosData);
+		if (direct) {
+			gyrosData.x = gyro_sample->x;
+			gyrosData.y = gyro_sample->y;
+			gyrosData.z = gyro_sample->z;
+			gyrosData.temperature = gyro_sample->temperature;
+		} else {
+			GyrosGet(&gyrosData);
+		}
 
 		actuatorDesired.Thrust = stabDesired.Thrust;
 
@@ -369,10 +413,27 @@ static void stabilizationTask(void* parameters)
 		// Wrap yaw error to [-180,180]
 		local_attitude_error[2] = circular_modulus_deg(local_attitude_error[2]);
 
+		const float gyro_raw[MAX_AXES] = { gyrosData.x, gyrosData.y, gyrosData.z };
+
+#if defined(STABILIZATION_DYNAMIC_NOTCH)
+		// One axis per FFT window, so a window costs one FFT
+		if (notch_tracking && notch_tracker_push(notch_tracker, gyro_raw[notch_tracker_axis])) {
+			float sample_rate = 1.0f / dT_filtered;
+			float center = notch_tracker_update(notch_tracker, sample_rate);
+
+			for (int i = 0; i < MAX_AXES; i++)
+				biquad_set_notch(&gyro_notch[i], sample_rate, center, settings.GyroNotchQ);
+
+			notch_tracker_axis = (notch_tracker_axis + 1) % MAX_AXES;
+		}
+#endif
+
 		static float gyro_filtered[3];
-		gyro_filtered[0] = gyro_filtered[0] * gyro_alpha + gyrosData.x * (1 - gyro_alpha);
-		gyro_filtered[1] = gyro_filtered[1] * gyro_alpha + gyrosData.y * (1 - gyro_alpha);
-		gyro_filtered[2] = gyro_filtered[2] * gyro_alpha + gyrosData.z * (1 - gyro_alpha);
+		for (int i = 0; i < MAX_AXES; i++) {
+			float gyro = biquad_apply(&gyro_lowpass[i],
+					biquad_apply(&gyro_notch[i], gyro_raw[i]));
+			gyro_filtered[i] = gyro_filtered[i] * gyro_alpha + gyro * (1 - gyro_alpha);
+		}
 
 		// A flag to track which stabilization mode each axis is in
 		static uint8_t previous_mode[MAX_AXES] = {255,255,255};
@@ -818,6 +879,14 @@ static void stabilizationTask(void* parameters)
 		// Save dT
 		actuatorDesired.UpdateTime = dT * 1000;
 
+		// Hand the output to the actuator before the UAVO, which only
+		// queued mode waits for
+		struct control_pipeline_actuator *command = control_pipeline_actuator_claim();
+		command->desired = actuatorDesired;
+		command->timestamp = gyro_timestamp;
+		command->stabilization_latency = stabilization_latency;
+		control_pipeline_actuator_publish();
+
 		ActuatorDesiredSet(&actuatorDesired);
 		// So we only fetch it above if it is modified by another module (wacky)
 		actuatorDesiredUpdated = false;
@@ -934,6 +1003,50 @@ static void calculate_pids()
 
 }
 
+/**
+ * Set up the biquad low pass and notch on the gyros from the settings
+ * @param[in] sample_rate The rate of the stabilization loop [Hz]
+ */
+static void configure_gyro_filters(float sample_rate)
+{
+	float notch_center = settings.GyroNotchFrequency;
+
+#if defined(STABILIZATION_DYNAMIC_NOTCH)
+	notch_tracking = false;
+
+	if (settings.GyroNotchMode == STABILIZATIONSETTINGS_GYRONOTCHMODE_DYNAMIC) {
+		// Only allocated once dynamic tracking is first enabled
+		if (notch_tracker == NULL)
+			notch_tracker = PIOS_malloc(sizeof(*notch_tracker));
+
+		if (notch_tracker != NULL &&
+				notch_tracker_init(notch_tracker, settings.GyroNotchMinFrequency,
+					0.45f * sample_rate, notch_center) == 0) {
+			notch_tracking = true;
+			notch_tracker_axis = 0;
+		}
+	}
+#endif
+
+	for (int i = 0; i < MAX_AXES; i++) {
+		if (settings.GyroFilterType == STABILIZATIONSETTINGS_GYROFILTERTYPE_BIQUAD &&
+				settings.GyroCutoff >= 1.0f) {
+			biquad_set_lowpass(&gyro_lowpass[i], sample_rate, settings.GyroCutoff,
+					BIQUAD_Q_BUTTERWORTH);
+		} else {
+			biquad_set_passthrough(&gyro_lowpass[i]);
+		}
+
+		// Without tracking support a dynamic notch stays at its start frequency
+		if (settings.GyroNotchMode != STABILIZATIONSETTINGS_GYRONOTCHMODE_DISABLED) {
+			biquad_set_notch(&gyro_notch[i], sample_rate, notch_center,
+					settings.GyroNotchQ);
+		} else {
+			biquad_set_passthrough(&gyro_notch[i]);
+		}
+	}
+}
+
 static void SettingsUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj, int len)
 {
 	(void) ctx; (void) obj; (void) len;
@@ -970,6 +1083,8 @@ static void SettingsUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj, int len)
 		lowThrottleZeroIntegral = settings.LowThrottleZeroIntegral == STABILIZATIONSETTINGS_LOWTHROTTLEZEROINTEGRAL_TRUE;
 
 		gyro_filter_updated = true;
+
+		control_pipeline_set_direct(settings.ControlPipeline == STABILIZATIONSETTINGS_CONTROLPIPELINE_DIRECT);
 	}
 }
 
@@ -580,6 +580,16 @@ static void updateStats()
 	stats.HeapRemaining = PIOS_heap_get_free_size();
 	stats.FastHeapRemaining = PIOS_fastheap_get_free_size();
 
+	// Break the heap use down by what it is for
+	for (int i = 0; i < SYSTEMSTATS_HEAPTAGUSED_NUMELEM; i++) {
+		struct pios_heap_tag_stats tag_stats;
+
+		if (PIOS_heap_get_tag_stats(i, &tag_stats)) {
+			stats.HeapTagUsed[i] = tag_stats.used;
+			stats.HeapTagHighWater[i] = tag_stats.high_water;
+		}
+	}
+
 	// Get Irq stack status
 	stats.IRQStackRemaining = GetFreeIrqStackSize();
 
@@ -2,12 +2,16 @@
 #ifndef PIOS_SIM_H
 #define PIOS_SIM_H
 
+int PIOS_SIM_Configure(const char *spec);
 int PIOS_SIM_Init();
 int PIOS_SIM_Step(float dT);
 void PIOS_SIM_SetActuator(float * actuator_int, int nchannels);
 void PIOS_SIM_GetAccels(float *);
 void PIOS_SIM_GetGyros(float *);
 void PIOS_SIM_GetAttitude(float *);
+void PIOS_SIM_GetVelocity(float *);
 void PIOS_SIM_GetPosition(float *);
+void PIOS_SIM_GetMag(float *);
+void PIOS_SIM_GetBaro(float *);
 
 #endif /* PIOS_SIM_H */
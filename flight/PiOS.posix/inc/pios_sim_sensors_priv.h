@@ -0,0 +1,48 @@
+/**
+ ******************************************************************************
+ * @file       pios_sim_sensors_priv.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Sensors fed by a simulator bridge over UDP
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_SIM_SENSORS_PRIV_H
+#define PIOS_SIM_SENSORS_PRIV_H
+
+#include <pios.h>
+
+struct pios_sim_sensors_cfg {
+	const char *ip;
+	uint16_t port;
+};
+
+/**
+ * @brief Listen for sensor frames and register queues for every sensor
+ * they can carry
+ * @return 0 on success
+ */
+extern int32_t PIOS_SIM_SENSORS_Init(const struct pios_sim_sensors_cfg *cfg);
+
+#endif /* PIOS_SIM_SENSORS_PRIV_H */
+
+/**
+ * @}
+ */
@@ -1,6 +1,7 @@
 
 #include "pios_sim_priv.h"
 
+extern int sim_model_configure(const char *spec);
 extern int sim_model_init();
 extern int sim_model_terminate();
 extern int sim_model_step(float dT, struct pios_sim_state * state);
@@ -0,0 +1,115 @@
+/**
+ ******************************************************************************
+ * @file       sim_physics.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Rigid body multirotor model for the simulation
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SIM_PHYSICS_H
+#define SIM_PHYSICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SIM_PHYSICS_MAX_MOTORS 8
+
+/**
+ * Motor layouts, numbered clockwise from above like the GCS mixer presets,
+ * with motor 1 spinning clockwise
+ */
+enum sim_physics_frame {
+	SIM_PHYSICS_FRAME_QUADX,
+	SIM_PHYSICS_FRAME_QUADP,
+	SIM_PHYSICS_FRAME_HEXA,
+	SIM_PHYSICS_FRAME_OCTO,
+};
+
+/**
+ * Everything that can be changed at runtime.  Units are SI unless noted;
+ * the body frame is x forward, y right and z down and the earth frame NED.
+ */
+struct sim_physics_params {
+	enum sim_physics_frame frame;
+	float arm;		//!< Motor distance from the center, m
+	float mass;		//!< kg
+	float inertia[3];	//!< About the body axes, kg m^2
+	float max_thrust;	//!< Per motor at full command, N
+	float motor_tau;	//!< Time constant of the motor speed, s
+	float torque_ratio;	//!< Reaction torque per thrust, m
+	float drag[3];		//!< Along the body axes, N/(m/s)
+	float rate_drag;	//!< N m/(rad/s)
+	float wind[3];		//!< Mean wind, m/s NED
+	float turbulence;	//!< RMS gust speed, m/s
+	float turbulence_tau;	//!< Gust correlation time, s
+	float gyro_noise;	//!< deg/s RMS
+	float gyro_bias_walk;	//!< deg/s per sqrt(s)
+	float accel_noise;	//!< m/s^2 RMS
+	float mag_noise;	//!< mGauss RMS
+	float baro_noise;	//!< m RMS
+	float mag_field[3];	//!< Earth field, mGauss NED
+	float step;		//!< Integrator step, s
+};
+
+struct sim_physics_state {
+	float position[3];	//!< m NED
+	float velocity[3];	//!< m/s NED
+	float q[4];		//!< Body to earth
+	float rates[3];		//!< rad/s body
+	float motor[SIM_PHYSICS_MAX_MOTORS];	//!< Speed, 0 to 1
+};
+
+struct sim_physics {
+	struct sim_physics_params params;
+	struct sim_physics_state state;
+
+	/* Derived from the parameters by sim_physics_init */
+	uint8_t num_motors;
+	float motor_pos[SIM_PHYSICS_MAX_MOTORS][2];
+	float motor_yaw[SIM_PHYSICS_MAX_MOTORS];
+	float gust_decay;
+	float gust_drive;
+
+	float command[SIM_PHYSICS_MAX_MOTORS];
+	float gust[3];
+	float gyro_bias[3];
+	float residual;		//!< Time not integrated yet, s
+	double time;		//!< Simulated time, s
+	bool on_ground;
+	uint32_t rng;
+};
+
+void sim_physics_defaults(struct sim_physics_params *params);
+int sim_physics_parse(struct sim_physics_params *params, const char *spec);
+
+void sim_physics_init(struct sim_physics *sim, const struct sim_physics_params *params,
+		uint32_t seed);
+void sim_physics_set_command(struct sim_physics *sim, const float *command, int n);
+void sim_physics_advance(struct sim_physics *sim, float dT);
+
+void sim_physics_sensors(struct sim_physics *sim, float gyro[3], float accel[3],
+		float mag[3], float *baro_altitude);
+
+#endif /* SIM_PHYSICS_H */
+
+/**
+ * @}
+ */
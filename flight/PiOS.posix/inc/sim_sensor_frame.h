@@ -0,0 +1,99 @@
+/**
+ ******************************************************************************
+ * @file       sim_sensor_frame.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Binary sensor frames a simulator bridge sends the simulation
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SIM_SENSOR_FRAME_H
+#define SIM_SENSOR_FRAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * One UDP datagram carries a header followed by up to
+ * SIM_SENSOR_FRAME_MAX_SAMPLES samples, oldest first.  All fields are
+ * little endian, like every host the simulation runs on.  The sequence
+ * number counts datagrams so that losses can be told apart from a bridge
+ * that simply batches more samples.
+ */
+
+#define SIM_SENSOR_FRAME_MAGIC       0x46535264	/* "dRSF" */
+#define SIM_SENSOR_FRAME_VERSION     1
+#define SIM_SENSOR_FRAME_MAX_SAMPLES 16
+
+#define SIM_SENSOR_VALID_GYRO  (1 << 0)
+#define SIM_SENSOR_VALID_ACCEL (1 << 1)
+#define SIM_SENSOR_VALID_MAG   (1 << 2)
+#define SIM_SENSOR_VALID_BARO  (1 << 3)
+
+struct sim_sensor_frame_header {
+	uint32_t magic;
+	uint8_t version;
+	uint8_t count;		//!< Samples following the header
+	uint16_t reserved;
+	uint32_t sequence;
+} __attribute__((packed));
+
+struct sim_sensor_sample {
+	uint32_t time_us;	//!< Simulation time the sample was taken at
+	uint8_t valid;		//!< SIM_SENSOR_VALID_ bits of the fields to use
+	uint8_t reserved[3];
+	float gyro[3];		//!< deg/s
+	float accel[3];		//!< m/s^2
+	float mag[3];		//!< mGauss
+	float baro_altitude;	//!< m above sea level
+	float temperature;	//!< deg C
+} __attribute__((packed));
+
+#define SIM_SENSOR_FRAME_MAX_LENGTH (sizeof(struct sim_sensor_frame_header) + \
+		SIM_SENSOR_FRAME_MAX_SAMPLES * sizeof(struct sim_sensor_sample))
+
+/**
+ * @brief Releases samples at the pace of their timestamps
+ *
+ * The offset between the local clock and the simulation time is taken from
+ * the first sample.  When a sample is later or earlier than that by more than
+ * SIM_SENSOR_PACER_RESYNC_US, e.g. because the simulator was paused or
+ * restarted, the offset is taken again rather than bursting or stalling.
+ */
+struct sim_sensor_pacer {
+	bool synced;
+	uint32_t offset;	//!< Local time minus simulation time, us
+	uint32_t resyncs;
+};
+
+#define SIM_SENSOR_PACER_RESYNC_US 50000
+
+int sim_sensor_frame_parse(const uint8_t *buf, int len, uint32_t *sequence,
+		const struct sim_sensor_sample **samples);
+
+void sim_sensor_pacer_reset(struct sim_sensor_pacer *pacer);
+bool sim_sensor_pacer_due(struct sim_sensor_pacer *pacer, uint32_t sample_us,
+		uint32_t now_us);
+
+#endif /* SIM_SENSOR_FRAME_H */
+
+/**
+ * @}
+ */
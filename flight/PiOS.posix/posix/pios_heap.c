@@ -1,7 +1,7 @@
 /**
  ******************************************************************************
  * @file       pios_heap.c
- * @author     dRonin, http://dRonin.org/, Copyright (C) 2015
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2015-2016
  * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2014
  * @addtogroup PIOS PIOS Core hardware abstraction layer
  * @{
@@ -29,13 +29,32 @@
 #include "pios.h"		/* PIOS_INCLUDE_* */
 
 #include "pios_heap.h"		/* External API declaration */
+#include "pios_heap_pool.h"
+#include "pios_thread.h"
 #include <stdbool.h>		/* bool */
 
+#if !defined(PIOS_INCLUDE_CHIBIOS)
+#error "pios_heap requires PIOS_INCLUDE_CHIBIOS"
+#endif
+
+/*
+ * Same allocator as the firmware over a fixed arena, so that fragmentation
+ * and the per tag numbers seen in the simulation mean something.
+ */
+#define PIOS_HEAP_SIM_SIZE (4 * 1024 * 1024)
+
+static uintptr_t heap_arena[PIOS_HEAP_SIM_SIZE / sizeof(uintptr_t)];
+static struct pios_heap_pool heap_pool;
+static struct pios_heap_tag_stats tag_stats[PIOS_HEAP_TAG_NUM];
+static bool heap_initialized;
+
 #define DEBUG_MALLOC_FAILURES 0
 static volatile bool malloc_failed_flag = false;
-static void malloc_failed_hook(void)
+static void malloc_failed_hook(enum pios_heap_tag tag)
 {
 	malloc_failed_flag = true;
+	if (tag < PIOS_HEAP_TAG_NUM)
+		tag_stats[tag].failures++;
 #if DEBUG_MALLOC_FAILURES
 	static volatile bool wait_here = true;
 	while(wait_here);
@@ -48,20 +67,39 @@ bool PIOS_heap_malloc_failed_p(void)
 	return malloc_failed_flag;
 }
 
-void * PIOS_malloc(size_t size)
+/* Call with the scheduler suspended */
+static struct pios_heap_pool *get_pool(void)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	void *buf = chHeapAlloc(NULL, size);
-#else
-#error "pios_heap requires PIOS_INCLUDE_CHIBIOS"
-#endif
+	if (!heap_initialized) {
+		pios_heap_pool_init(&heap_pool, heap_arena, sizeof(heap_arena), tag_stats);
+		heap_initialized = true;
+	}
+
+	return &heap_pool;
+}
+
+void * PIOS_malloc_tagged(size_t size, enum pios_heap_tag tag)
+{
+	PIOS_Thread_Scheduler_Suspend();
+	void *buf = pios_heap_pool_alloc(get_pool(), size, tag);
+	PIOS_Thread_Scheduler_Resume();
 
 	if (buf == NULL)
-		malloc_failed_hook();
+		malloc_failed_hook(tag);
 
 	return buf;
 }
 
+void * PIOS_malloc_no_dma_tagged(size_t size, enum pios_heap_tag tag)
+{
+	return PIOS_malloc_tagged(size, tag);
+}
+
+void * PIOS_malloc(size_t size)
+{
+	return PIOS_malloc_tagged(size, PIOS_HEAP_TAG_OTHER);
+}
+
 void * PIOS_malloc_no_dma(size_t size)
 {
 	return PIOS_malloc(size);
@@ -69,11 +107,9 @@ void * PIOS_malloc_no_dma(size_t size)
 
 void PIOS_free(void * buf)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	chHeapFree(buf);
-#else
-#error "pios_heap requires PIOS_INCLUDE_CHIBIOS"
-#endif
+	PIOS_Thread_Scheduler_Suspend();
+	pios_heap_pool_free(get_pool(), buf);
+	PIOS_Thread_Scheduler_Resume();
 }
 
 void PIOS_heap_initialize_blocks(void)
@@ -82,7 +118,11 @@ void PIOS_heap_initialize_blocks(void)
 
 size_t PIOS_heap_get_free_size(void)
 {
-	return 4096;
+	PIOS_Thread_Scheduler_Suspend();
+	size_t free_bytes = pios_heap_pool_free_bytes(get_pool());
+	PIOS_Thread_Scheduler_Resume();
+
+	return free_bytes;
 }
 
 size_t PIOS_fastheap_get_free_size(void)
@@ -90,6 +130,18 @@ size_t PIOS_fastheap_get_free_size(void)
 	return 0;
 }
 
+bool PIOS_heap_get_tag_stats(enum pios_heap_tag tag, struct pios_heap_tag_stats *stats)
+{
+	if (tag >= PIOS_HEAP_TAG_NUM)
+		return false;
+
+	PIOS_Thread_Scheduler_Suspend();
+	*stats = tag_stats[tag];
+	PIOS_Thread_Scheduler_Resume();
+
+	return true;
+}
+
 /**
  * @}
  * @}
@@ -14,6 +14,17 @@ struct pios_sim_state pios_sim_state = {
 	.actuator = {0, 0, 0, 0, 0, 0, 0, 0}
 };
 
+/**
+ * Select and parameterize the model in the external library
+ * @returns 0 for success, -1 if the library does not understand spec
+ */
+int PIOS_SIM_Configure(const char *spec)
+{
+	if (sim_model_configure(spec) != 0)
+		return -1;
+	return 0;
+}
+
 /**
  * Initialize the model in the external library
  * @returns 0 for success, -1 if fails to initialize external library
@@ -100,10 +111,36 @@ void PIOS_SIM_GetPosition(float * position)
 		position[i] = pios_sim_state.position[i];
 }
 
+/**
+ * Get the magnetometer data from the simulation model
+ * @param[out] mag pointer to store the magnetometer data in
+ */
+void PIOS_SIM_GetMag(float * mag)
+{
+	for (int i = 0; i < NELEMENTS(pios_sim_state.mag); i++)
+		mag[i] = pios_sim_state.mag[i];
+}
+
+/**
+ * Get the baro altitude from the simulation model
+ * @param[out] baro pointer to store the altitude in
+ */
+void PIOS_SIM_GetBaro(float * baro)
+{
+	for (int i = 0; i < NELEMENTS(pios_sim_state.baro); i++)
+		baro[i] = pios_sim_state.baro[i];
+}
+
 /*
  * Provide weakly linked versions of model simulator
  */
 
+int sim_model_configure(const char *spec) __attribute__((weak));
+int sim_model_configure(const char *spec)
+{
+	return -1;
+}
+
 int sim_model_init(void) __attribute__((weak));
 int sim_model_init(void)
 {
@@ -0,0 +1,310 @@
+/**
+ ******************************************************************************
+ * @file       pios_sim_sensors.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Sensors fed by a simulator bridge over UDP
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_SIM_SENSORS)
+
+#include <pios_sim_sensors_priv.h>
+#include "pios_queue.h"
+#include "pios_sensors.h"
+#include "pios_thread.h"
+#include "sim_sensor_frame.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+//! Samples held back until their time comes, a few batches worth
+#define SIM_SENSORS_BACKLOG 128
+
+#define SIM_SENSORS_GYRO_QUEUE_LEN  32
+#define SIM_SENSORS_ACCEL_QUEUE_LEN 32
+#define SIM_SENSORS_MAG_QUEUE_LEN   4
+#define SIM_SENSORS_BARO_QUEUE_LEN  4
+
+struct pios_sim_sensors_dev {
+	const struct pios_sim_sensors_cfg *cfg;
+	int socket;
+
+	struct pios_queue *gyro_queue;
+	struct pios_queue *accel_queue;
+	struct pios_queue *mag_queue;
+	struct pios_queue *baro_queue;
+
+	struct sim_sensor_sample backlog[SIM_SENSORS_BACKLOG];
+	uint16_t head;
+	uint16_t tail;
+
+	struct sim_sensor_pacer pacer;
+
+	uint8_t rx_buffer[SIM_SENSOR_FRAME_MAX_LENGTH];
+
+	bool sequence_known;
+	uint32_t next_sequence;
+
+	uint32_t frames;
+	uint32_t frames_lost;
+	uint32_t frames_invalid;
+	uint32_t backlog_overruns;
+	uint32_t queue_overruns;
+};
+
+static struct pios_thread *sim_sensors_task_handle;
+
+static int set_nonblock(int sock) {
+#if defined(_WIN32) || defined(WIN32) || defined(__MINGW32__)
+	unsigned long flag = 1;
+	if (!ioctlsocket(sock, FIONBIO, &flag)) {
+		return 0;
+	}
+#else
+	int flags;
+	if ((flags = fcntl(sock, F_GETFL, 0)) != -1) {
+		if (fcntl(sock, F_SETFL, flags | O_NONBLOCK) != -1) {
+			return 0;
+		}
+	}
+#endif
+
+	return -1;
+}
+
+/**
+ * Wall clock in microseconds.  PIOS_DELAY on this target counts CPU time,
+ * which does not advance while the simulation sleeps.  Steps of the wall
+ * clock are absorbed by the pacer resyncing.
+ */
+static uint32_t now_us(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+
+	return (uint32_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void store_frame(struct pios_sim_sensors_dev *dev,
+		const uint8_t *buf, int len)
+{
+	uint32_t sequence;
+	const struct sim_sensor_sample *samples;
+
+	int count = sim_sensor_frame_parse(buf, len, &sequence, &samples);
+
+	if (count < 0) {
+		dev->frames_invalid++;
+		return;
+	}
+
+	/* A bridge restart shows up as a jump back, which is not a loss */
+	if (dev->sequence_known && (int32_t) (sequence - dev->next_sequence) > 0) {
+		dev->frames_lost += sequence - dev->next_sequence;
+	}
+
+	dev->sequence_known = true;
+	dev->next_sequence = sequence + 1;
+	dev->frames++;
+
+	for (int i = 0; i < count; i++) {
+		uint16_t next_head = (dev->head + 1) % SIM_SENSORS_BACKLOG;
+
+		if (next_head == dev->tail) {
+			/* The sender runs ahead of real time, keep the oldest */
+			dev->backlog_overruns++;
+			return;
+		}
+
+		memcpy(&dev->backlog[dev->head], &samples[i], sizeof(samples[i]));
+		dev->head = next_head;
+	}
+}
+
+static void send_sample(struct pios_sim_sensors_dev *dev,
+		const struct sim_sensor_sample *sample)
+{
+	bool sent = true;
+
+	/* Sensors reads the queues without blocking on them for long, so a full
+	 * queue means it fell behind and the sample is dropped */
+	if (sample->valid & SIM_SENSOR_VALID_ACCEL) {
+		struct pios_sensor_accel_data accel = {
+			.x = sample->accel[0],
+			.y = sample->accel[1],
+			.z = sample->accel[2],
+			.temperature = sample->temperature,
+		};
+		sent &= PIOS_Queue_Send(dev->accel_queue, &accel, 0);
+	}
+
+	if (sample->valid & SIM_SENSOR_VALID_GYRO) {
+		struct pios_sensor_gyro_data gyro = {
+			.x = sample->gyro[0],
+			.y = sample->gyro[1],
+			.z = sample->gyro[2],
+			.temperature = sample->temperature,
+			.timestamp = PIOS_DELAY_GetRaw(),
+		};
+		sent &= PIOS_Queue_Send(dev->gyro_queue, &gyro, 0);
+	}
+
+	if (sample->valid & SIM_SENSOR_VALID_MAG) {
+		struct pios_sensor_mag_data mag = {
+			.x = sample->mag[0],
+			.y = sample->mag[1],
+			.z = sample->mag[2],
+		};
+		sent &= PIOS_Queue_Send(dev->mag_queue, &mag, 0);
+	}
+
+	if (sample->valid & SIM_SENSOR_VALID_BARO) {
+		/* Standard atmosphere, in kPa like the baro drivers */
+		struct pios_sensor_baro_data baro = {
+			.temperature = sample->temperature,
+			.pressure = 101.325f * powf(1.0f - 2.25577e-5f * sample->baro_altitude, 5.25588f),
+			.altitude = sample->baro_altitude,
+		};
+		sent &= PIOS_Queue_Send(dev->baro_queue, &baro, 0);
+	}
+
+	if (!sent) {
+		dev->queue_overruns++;
+	}
+}
+
+static void PIOS_SIM_SENSORS_Task(void *parameters)
+{
+	struct pios_sim_sensors_dev *dev = parameters;
+
+	while (1) {
+		/* Take in everything the bridge sent since the last pass */
+		while (1) {
+			/* Polling the fd has to be executed in thread suspended mode
+			 * to get a correct errno value. */
+			PIOS_Thread_Scheduler_Suspend();
+
+			int received = recv(dev->socket, dev->rx_buffer,
+					sizeof(dev->rx_buffer), 0);
+			int error = errno;
+
+			PIOS_Thread_Scheduler_Resume();
+
+			if (received < 0) {
+				if (error != EAGAIN && error != EWOULDBLOCK && error != EINTR) {
+					perror("Sensor frame receive failed");
+				}
+				break;
+			}
+
+			store_frame(dev, dev->rx_buffer, received);
+		}
+
+		/* Then release the samples whose time has come */
+		uint32_t now = now_us();
+
+		while (dev->tail != dev->head &&
+				sim_sensor_pacer_due(&dev->pacer, dev->backlog[dev->tail].time_us, now)) {
+			send_sample(dev, &dev->backlog[dev->tail]);
+			dev->tail = (dev->tail + 1) % SIM_SENSORS_BACKLOG;
+		}
+
+		PIOS_Thread_Sleep(1);
+	}
+}
+
+int32_t PIOS_SIM_SENSORS_Init(const struct pios_sim_sensors_cfg *cfg)
+{
+	struct pios_sim_sensors_dev *dev = PIOS_malloc(sizeof(*dev));
+
+	if (!dev) {
+		return -1;
+	}
+
+	memset(dev, 0, sizeof(*dev));
+	dev->cfg = cfg;
+	sim_sensor_pacer_reset(&dev->pacer);
+
+	dev->gyro_queue = PIOS_Queue_Create(SIM_SENSORS_GYRO_QUEUE_LEN, sizeof(struct pios_sensor_gyro_data));
+	dev->accel_queue = PIOS_Queue_Create(SIM_SENSORS_ACCEL_QUEUE_LEN, sizeof(struct pios_sensor_accel_data));
+	dev->mag_queue = PIOS_Queue_Create(SIM_SENSORS_MAG_QUEUE_LEN, sizeof(struct pios_sensor_mag_data));
+	dev->baro_queue = PIOS_Queue_Create(SIM_SENSORS_BARO_QUEUE_LEN, sizeof(struct pios_sensor_baro_data));
+
+	if (!dev->gyro_queue || !dev->accel_queue || !dev->mag_queue || !dev->baro_queue) {
+		return -1;
+	}
+
+	dev->socket = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	/* Room for a burst of frames while the scheduler is busy elsewhere */
+	int bufsize = 256 * SIM_SENSOR_FRAME_MAX_LENGTH;
+	setsockopt(dev->socket, SOL_SOCKET, SO_RCVBUF, (char *) &bufsize, sizeof(bufsize));
+
+	struct sockaddr_in server;
+	memset(&server, 0, sizeof(server));
+	server.sin_family = AF_INET;
+	server.sin_addr.s_addr = inet_addr(cfg->ip);
+	server.sin_port = htons(cfg->port);
+
+	if (bind(dev->socket, (struct sockaddr *) &server, sizeof(server)) == -1) {
+		perror("Binding sensor socket failed");
+		exit(EXIT_FAILURE);
+	}
+
+	set_nonblock(dev->socket);
+
+	PIOS_SENSORS_Register(PIOS_SENSOR_GYRO, dev->gyro_queue);
+	PIOS_SENSORS_Register(PIOS_SENSOR_ACCEL, dev->accel_queue);
+	PIOS_SENSORS_Register(PIOS_SENSOR_MAG, dev->mag_queue);
+	PIOS_SENSORS_Register(PIOS_SENSOR_BARO, dev->baro_queue);
+
+	/* Same full scale as the gyros of real boards */
+	PIOS_SENSORS_SetMaxGyro(2000);
+
+	sim_sensors_task_handle = PIOS_Thread_Create(PIOS_SIM_SENSORS_Task,
+			"pios_sim_sensors", PIOS_THREAD_STACK_SIZE_MIN, dev, PIOS_THREAD_PRIO_HIGHEST);
+
+	printf("Sensor frames on udp %s:%d\n", cfg->ip, cfg->port);
+
+	return 0;
+}
+
+#endif /* PIOS_INCLUDE_SIM_SENSORS */
+
+/**
+ * @}
+ */
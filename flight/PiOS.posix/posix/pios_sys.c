@@ -46,9 +46,10 @@
 static bool debug_fpe=false;
 
 static void Usage(char *cmdName) {
-	printf( "usage: %s [-f]\n"
+	printf( "usage: %s [-f] [-m model]\n"
 		"\n"
-		"\t-f\tEnables floating point exception trapping mode\n",
+		"\t-f\tEnables floating point exception trapping mode\n"
+		"\t-m\tFlies a physical model, e.g. quadx or hexa:mass=1.5,turb=2\n",
 		cmdName);
 
 	exit(1);
@@ -57,11 +58,18 @@ static void Usage(char *cmdName) {
 void PIOS_SYS_Args(int argc, char *argv[]) {
 	int opt;
 
-	while ((opt = getopt(argc, argv, "f")) != -1) {
+	while ((opt = getopt(argc, argv, "fm:")) != -1) {
 		switch (opt) {
 			case 'f':
 				debug_fpe=true;
 				break;
+#if defined(PIOS_INCLUDE_SIM)
+			case 'm':
+				if (PIOS_SIM_Configure(optarg)) {
+					Usage(argv[0]);
+				}
+				break;
+#endif
 			default:
 				Usage(argv[0]);
 				break;
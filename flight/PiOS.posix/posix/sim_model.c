@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * @file       sim_model.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Physical model behind the PIOS_SIM interface
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_SIM)
+
+#include "sim_model.h"
+#include "sim_physics.h"
+
+static struct sim_physics_params params;
+static struct sim_physics sim;
+static bool configured;
+
+/**
+ * Select the model, see sim_physics_parse for the format
+ * @returns 0 for success, -1 if spec is not understood
+ */
+int sim_model_configure(const char *spec)
+{
+	if (!configured)
+		sim_physics_defaults(&params);
+
+	if (sim_physics_parse(&params, spec) != 0)
+		return -1;
+
+	configured = true;
+
+	return 0;
+}
+
+/**
+ * Start the model from rest on the ground
+ * @returns 0 for success, -1 if no model was selected
+ */
+int sim_model_init(void)
+{
+	if (!configured)
+		return -1;
+
+	/* Fixed seed, so runs with the same inputs repeat exactly */
+	sim_physics_init(&sim, &params, 1);
+
+	return 0;
+}
+
+int sim_model_terminate(void)
+{
+	return 0;
+}
+
+/**
+ * Advance the model by dT with the actuators in state and fill in what the
+ * sensors read afterwards
+ */
+int sim_model_step(float dT, struct pios_sim_state *state)
+{
+	if (!configured)
+		return -1;
+
+	sim_physics_set_command(&sim, state->actuator, NELEMENTS(state->actuator));
+	sim_physics_advance(&sim, dT);
+	sim_physics_sensors(&sim, state->gyros, state->accels, state->mag, &state->baro[0]);
+
+	for (int i = 0; i < 4; i++)
+		state->q[i] = sim.state.q[i];
+
+	for (int i = 0; i < 3; i++) {
+		state->velocity[i] = sim.state.velocity[i];
+		state->position[i] = sim.state.position[i];
+	}
+
+	return 0;
+}
+
+#endif /* PIOS_INCLUDE_SIM */
+
+/**
+ * @}
+ */
@@ -0,0 +1,480 @@
+/**
+ ******************************************************************************
+ * @file       sim_physics.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Rigid body multirotor model for the simulation
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ *
+ * Motors follow their commands with a first order lag and produce thrust
+ * and reaction torque proportional to the square of their speed.  The body
+ * feels linear drag against the air, which moves with the wind plus Gauss
+ * Markov gusts, and rotational damping.  Everything is integrated with
+ * fixed steps of classic Runge Kutta, so a run only depends on the
+ * parameters, the commands and the seed and not on how it is scheduled.
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "sim_physics.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "coordinate_conversions.h"
+#include "physical_constants.h"
+
+//! The state is all floats, so the integrator can treat it as a vector
+#define STATE_LEN (sizeof(struct sim_physics_state) / sizeof(float))
+
+static const struct {
+	const char *name;
+	enum sim_physics_frame frame;
+	uint8_t num_motors;
+	float first_angle;	//!< deg clockwise from the nose
+} frames[] = {
+	{ "quadx", SIM_PHYSICS_FRAME_QUADX, 4, -45 },
+	{ "quadp", SIM_PHYSICS_FRAME_QUADP, 4, 0 },
+	{ "hexa", SIM_PHYSICS_FRAME_HEXA, 6, 0 },
+	{ "octo", SIM_PHYSICS_FRAME_OCTO, 8, 0 },
+};
+
+static const struct {
+	const char *name;
+	size_t offset;
+} params_by_name[] = {
+	{ "arm", offsetof(struct sim_physics_params, arm) },
+	{ "mass", offsetof(struct sim_physics_params, mass) },
+	{ "ixx", offsetof(struct sim_physics_params, inertia[0]) },
+	{ "iyy", offsetof(struct sim_physics_params, inertia[1]) },
+	{ "izz", offsetof(struct sim_physics_params, inertia[2]) },
+	{ "thrust", offsetof(struct sim_physics_params, max_thrust) },
+	{ "tau", offsetof(struct sim_physics_params, motor_tau) },
+	{ "torque", offsetof(struct sim_physics_params, torque_ratio) },
+	{ "dragx", offsetof(struct sim_physics_params, drag[0]) },
+	{ "dragy", offsetof(struct sim_physics_params, drag[1]) },
+	{ "dragz", offsetof(struct sim_physics_params, drag[2]) },
+	{ "ratedrag", offsetof(struct sim_physics_params, rate_drag) },
+	{ "windn", offsetof(struct sim_physics_params, wind[0]) },
+	{ "winde", offsetof(struct sim_physics_params, wind[1]) },
+	{ "windd", offsetof(struct sim_physics_params, wind[2]) },
+	{ "turb", offsetof(struct sim_physics_params, turbulence) },
+	{ "turbtau", offsetof(struct sim_physics_params, turbulence_tau) },
+	{ "gyronoise", offsetof(struct sim_physics_params, gyro_noise) },
+	{ "gyrowalk", offsetof(struct sim_physics_params, gyro_bias_walk) },
+	{ "accelnoise", offsetof(struct sim_physics_params, accel_noise) },
+	{ "magnoise", offsetof(struct sim_physics_params, mag_noise) },
+	{ "baronoise", offsetof(struct sim_physics_params, baro_noise) },
+	{ "step", offsetof(struct sim_physics_params, step) },
+};
+
+#define NELEM(x) (sizeof(x) / sizeof((x)[0]))
+
+/**
+ * @brief Parameters of a 250 class quad with a thrust to weight of four
+ */
+void sim_physics_defaults(struct sim_physics_params *params)
+{
+	*params = (struct sim_physics_params) {
+		.frame = SIM_PHYSICS_FRAME_QUADX,
+		.arm = 0.12f,
+		.mass = 0.8f,
+		.inertia = { 0.004f, 0.004f, 0.007f },
+		.max_thrust = 8.0f,
+		.motor_tau = 0.03f,
+		.torque_ratio = 0.016f,
+		.drag = { 0.25f, 0.25f, 0.5f },
+		.rate_drag = 0.002f,
+		.wind = { 0, 0, 0 },
+		.turbulence = 0,
+		.turbulence_tau = 2.0f,
+		.gyro_noise = 0.5f,
+		.gyro_bias_walk = 0.01f,
+		.accel_noise = 0.2f,
+		.mag_noise = 2.0f,
+		.baro_noise = 0.2f,
+		.mag_field = { 100, 0, 400 },
+		.step = 0.001f,
+	};
+}
+
+static bool params_valid(const struct sim_physics_params *params)
+{
+	return params->arm > 0 && params->mass > 0 &&
+		params->inertia[0] > 0 && params->inertia[1] > 0 && params->inertia[2] > 0 &&
+		params->max_thrust >= 0 && params->motor_tau > 0 &&
+		params->turbulence >= 0 && params->turbulence_tau > 0 &&
+		params->step > 0 && params->step <= 0.01f;
+}
+
+/**
+ * @brief Change parameters from a description like
+ * "hexa:mass=1.5,thrust=10,turb=2"
+ *
+ * The frame is optional, as is the list after it.  Parameters that are not
+ * named keep their values.
+ * @return 0 on success, -1 if the description was not understood, in which
+ * case params is unchanged
+ */
+int sim_physics_parse(struct sim_physics_params *params, const char *spec)
+{
+	struct sim_physics_params parsed = *params;
+	char buf[256];
+
+	if (strlen(spec) >= sizeof(buf)) {
+		return -1;
+	}
+	strcpy(buf, spec);
+
+	char *list = buf;
+	char *colon = strchr(buf, ':');
+
+	if (colon || !strchr(buf, '=')) {
+		if (colon) {
+			*colon = '\0';
+			list = colon + 1;
+		} else {
+			list = buf + strlen(buf);
+		}
+
+		unsigned int i;
+		for (i = 0; i < NELEM(frames); i++) {
+			if (!strcmp(buf, frames[i].name)) {
+				parsed.frame = frames[i].frame;
+				break;
+			}
+		}
+
+		if (i == NELEM(frames)) {
+			return -1;
+		}
+	}
+
+	while (*list) {
+		char *next = strchr(list, ',');
+		if (next) {
+			*next++ = '\0';
+		} else {
+			next = list + strlen(list);
+		}
+
+		char *equals = strchr(list, '=');
+		if (!equals) {
+			return -1;
+		}
+		*equals = '\0';
+
+		char *end;
+		float value = strtof(equals + 1, &end);
+		if (end == equals + 1 || *end) {
+			return -1;
+		}
+
+		unsigned int i;
+		for (i = 0; i < NELEM(params_by_name); i++) {
+			if (!strcmp(list, params_by_name[i].name)) {
+				*(float *) ((uint8_t *) &parsed + params_by_name[i].offset) = value;
+				break;
+			}
+		}
+
+		if (i == NELEM(params_by_name)) {
+			return -1;
+		}
+
+		list = next;
+	}
+
+	if (!params_valid(&parsed)) {
+		return -1;
+	}
+
+	*params = parsed;
+
+	return 0;
+}
+
+//! Gaussian noise of unit variance from a generator private to the model
+static float rand_gauss(struct sim_physics *sim)
+{
+	float u[2];
+
+	for (int i = 0; i < 2; i++) {
+		/* xorshift32 */
+		sim->rng ^= sim->rng << 13;
+		sim->rng ^= sim->rng >> 17;
+		sim->rng ^= sim->rng << 5;
+		u[i] = (sim->rng >> 8) * (1.0f / 16777216.0f);
+	}
+
+	return sqrtf(-2.0f * logf(1.0f - u[0])) * cosf(2.0f * (float) M_PI * u[1]);
+}
+
+void sim_physics_init(struct sim_physics *sim, const struct sim_physics_params *params,
+		uint32_t seed)
+{
+	memset(sim, 0, sizeof(*sim));
+
+	sim->params = *params;
+	sim->state.q[0] = 1;
+	sim->on_ground = true;
+	sim->rng = seed ? seed : 1;
+
+	for (unsigned int i = 0; i < NELEM(frames); i++) {
+		if (frames[i].frame != params->frame) {
+			continue;
+		}
+
+		sim->num_motors = frames[i].num_motors;
+
+		for (int m = 0; m < sim->num_motors; m++) {
+			float angle = (frames[i].first_angle + 360.0f * m / sim->num_motors) * DEG2RAD;
+
+			sim->motor_pos[m][0] = params->arm * cosf(angle);
+			sim->motor_pos[m][1] = params->arm * sinf(angle);
+
+			/* Clockwise props twist the frame counter clockwise */
+			sim->motor_yaw[m] = (m % 2) ? 1 : -1;
+		}
+	}
+
+	sim->gust_decay = expf(-params->step / params->turbulence_tau);
+	sim->gust_drive = params->turbulence * sqrtf(1 - sim->gust_decay * sim->gust_decay);
+}
+
+/**
+ * @brief Set the motor commands, from 0 for stopped to 1 for full thrust
+ */
+void sim_physics_set_command(struct sim_physics *sim, const float *command, int n)
+{
+	for (int i = 0; i < sim->num_motors; i++) {
+		float c = (i < n) ? command[i] : 0;
+
+		if (!(c > 0)) {
+			c = 0;
+		} else if (c > 1) {
+			c = 1;
+		}
+
+		sim->command[i] = c;
+	}
+}
+
+/**
+ * Time derivative of the state
+ * @param[out] force specific force on the body, i.e. what an accelerometer
+ * would measure in flight, if not NULL
+ */
+static void derivative(const struct sim_physics *sim, const struct sim_physics_state *s,
+		struct sim_physics_state *d, float force[3])
+{
+	const struct sim_physics_params *p = &sim->params;
+
+	float q[4] = { s->q[0], s->q[1], s->q[2], s->q[3] };
+	float Rbe[3][3];
+	Quaternion2R(q, Rbe);
+
+	float thrust_total = 0;
+	float torque[3] = { 0, 0, 0 };
+
+	memset(d->motor, 0, sizeof(d->motor));
+
+	for (int i = 0; i < sim->num_motors; i++) {
+		float thrust = p->max_thrust * s->motor[i] * s->motor[i];
+
+		thrust_total += thrust;
+		torque[0] -= sim->motor_pos[i][1] * thrust;
+		torque[1] += sim->motor_pos[i][0] * thrust;
+		torque[2] += sim->motor_yaw[i] * p->torque_ratio * thrust;
+
+		d->motor[i] = (sim->command[i] - s->motor[i]) / p->motor_tau;
+	}
+
+	// Drag is against the air, which moves with the wind
+	float air_ned[3], air[3];
+	for (int i = 0; i < 3; i++) {
+		air_ned[i] = s->velocity[i] - p->wind[i] - sim->gust[i];
+	}
+	rot_mult(Rbe, air_ned, air, false);
+
+	float f_body[3] = {
+		-p->drag[0] * air[0],
+		-p->drag[1] * air[1],
+		-thrust_total - p->drag[2] * air[2],
+	};
+	float f_ned[3];
+	rot_mult(Rbe, f_body, f_ned, true);
+
+	for (int i = 0; i < 3; i++) {
+		d->position[i] = s->velocity[i];
+		d->velocity[i] = f_ned[i] / p->mass;
+	}
+	d->velocity[2] += GRAVITY;
+
+	const float wx = s->rates[0], wy = s->rates[1], wz = s->rates[2];
+
+	d->q[0] = 0.5f * (-q[1] * wx - q[2] * wy - q[3] * wz);
+	d->q[1] = 0.5f * (q[0] * wx - q[3] * wy + q[2] * wz);
+	d->q[2] = 0.5f * (q[3] * wx + q[0] * wy - q[1] * wz);
+	d->q[3] = 0.5f * (-q[2] * wx + q[1] * wy + q[0] * wz);
+
+	// Euler's equations for the principal axes
+	const float *I = p->inertia;
+	d->rates[0] = (torque[0] - p->rate_drag * wx - (I[2] - I[1]) * wy * wz) / I[0];
+	d->rates[1] = (torque[1] - p->rate_drag * wy - (I[0] - I[2]) * wz * wx) / I[1];
+	d->rates[2] = (torque[2] - p->rate_drag * wz - (I[1] - I[0]) * wx * wy) / I[2];
+
+	if (force) {
+		for (int i = 0; i < 3; i++) {
+			force[i] = f_body[i] / p->mass;
+		}
+	}
+}
+
+static void state_add(struct sim_physics_state *out, const struct sim_physics_state *a,
+		float h, const struct sim_physics_state *b)
+{
+	float *o = (float *) out;
+	const float *x = (const float *) a;
+	const float *y = (const float *) b;
+
+	for (unsigned int i = 0; i < STATE_LEN; i++) {
+		o[i] = x[i] + h * y[i];
+	}
+}
+
+//! The ground holds the vehicle up until thrust lifts it off
+static void ground_contact(struct sim_physics *sim)
+{
+	struct sim_physics_state *s = &sim->state;
+
+	if (s->position[2] < 0) {
+		sim->on_ground = false;
+		return;
+	}
+
+	s->position[2] = 0;
+
+	if (s->velocity[2] >= 0) {
+		memset(s->velocity, 0, sizeof(s->velocity));
+		memset(s->rates, 0, sizeof(s->rates));
+		sim->on_ground = true;
+	}
+}
+
+static void rk4_step(struct sim_physics *sim)
+{
+	const struct sim_physics_params *p = &sim->params;
+	const float h = p->step;
+
+	// Disturbances are held over the step
+	for (int i = 0; i < 3; i++) {
+		sim->gust[i] = sim->gust[i] * sim->gust_decay + sim->gust_drive * rand_gauss(sim);
+		sim->gyro_bias[i] += p->gyro_bias_walk * sqrtf(h) * rand_gauss(sim);
+	}
+
+	struct sim_physics_state k1, k2, k3, k4, tmp;
+
+	derivative(sim, &sim->state, &k1, NULL);
+	state_add(&tmp, &sim->state, h / 2, &k1);
+	derivative(sim, &tmp, &k2, NULL);
+	state_add(&tmp, &sim->state, h / 2, &k2);
+	derivative(sim, &tmp, &k3, NULL);
+	state_add(&tmp, &sim->state, h, &k3);
+	derivative(sim, &tmp, &k4, NULL);
+
+	float *s = (float *) &sim->state;
+	const float *d1 = (const float *) &k1, *d2 = (const float *) &k2;
+	const float *d3 = (const float *) &k3, *d4 = (const float *) &k4;
+
+	for (unsigned int i = 0; i < STATE_LEN; i++) {
+		s[i] += h / 6 * (d1[i] + 2 * d2[i] + 2 * d3[i] + d4[i]);
+	}
+
+	float *q = sim->state.q;
+	float qmag = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	for (int i = 0; i < 4; i++) {
+		q[i] /= qmag;
+	}
+
+	ground_contact(sim);
+
+	sim->time += h;
+}
+
+/**
+ * @brief Run the model forward
+ *
+ * Only whole integrator steps are taken and what is left of dT is carried
+ * over to the next call.  Time is rounded to the nearest step, so that dT
+ * which are multiples of the step never lose one to rounding.
+ */
+void sim_physics_advance(struct sim_physics *sim, float dT)
+{
+	sim->residual += dT;
+
+	while (sim->residual > sim->params.step / 2) {
+		rk4_step(sim);
+		sim->residual -= sim->params.step;
+	}
+}
+
+/**
+ * @brief What the sensors read in the current state
+ * @param[out] gyro deg/s
+ * @param[out] accel m/s^2
+ * @param[out] mag mGauss
+ * @param[out] baro_altitude m
+ */
+void sim_physics_sensors(struct sim_physics *sim, float gyro[3], float accel[3],
+		float mag[3], float *baro_altitude)
+{
+	const struct sim_physics_params *p = &sim->params;
+	struct sim_physics_state *s = &sim->state;
+
+	float Rbe[3][3];
+	Quaternion2R(s->q, Rbe);
+
+	float force[3];
+
+	if (sim->on_ground) {
+		// Resting on the ground, which carries what thrust does not
+		const float up[3] = { 0, 0, -GRAVITY };
+		rot_mult(Rbe, up, force, false);
+	} else {
+		struct sim_physics_state d;
+		derivative(sim, s, &d, force);
+	}
+
+	float field[3];
+	rot_mult(Rbe, p->mag_field, field, false);
+
+	for (int i = 0; i < 3; i++) {
+		gyro[i] = s->rates[i] * RAD2DEG + sim->gyro_bias[i] + p->gyro_noise * rand_gauss(sim);
+		accel[i] = force[i] + p->accel_noise * rand_gauss(sim);
+		mag[i] = field[i] + p->mag_noise * rand_gauss(sim);
+	}
+
+	*baro_altitude = -s->position[2] + p->baro_noise * rand_gauss(sim);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * @file       sim_sensor_frame.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Parsing and pacing of simulator sensor frames
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "sim_sensor_frame.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Check a received datagram
+ * @param[in] buf the datagram
+ * @param[in] len its length
+ * @param[out] sequence the sequence number of the frame
+ * @param[out] samples where the samples start within buf
+ * @return the number of samples, or -1 if this is not a valid frame
+ */
+int sim_sensor_frame_parse(const uint8_t *buf, int len, uint32_t *sequence,
+		const struct sim_sensor_sample **samples)
+{
+	const struct sim_sensor_frame_header *header =
+		(const struct sim_sensor_frame_header *) buf;
+
+	if (len < (int) sizeof(*header)) {
+		return -1;
+	}
+
+	if (header->magic != SIM_SENSOR_FRAME_MAGIC ||
+			header->version != SIM_SENSOR_FRAME_VERSION ||
+			header->count > SIM_SENSOR_FRAME_MAX_SAMPLES) {
+		return -1;
+	}
+
+	if (len != (int) (sizeof(*header) +
+				header->count * sizeof(struct sim_sensor_sample))) {
+		return -1;
+	}
+
+	*sequence = header->sequence;
+	*samples = (const struct sim_sensor_sample *) (buf + sizeof(*header));
+
+	return header->count;
+}
+
+void sim_sensor_pacer_reset(struct sim_sensor_pacer *pacer)
+{
+	pacer->synced = false;
+	pacer->offset = 0;
+	pacer->resyncs = 0;
+}
+
+/**
+ * @brief Whether a sample should be released yet
+ * @param[in] sample_us simulation time of the sample
+ * @param[in] now_us the local time
+ * @return true if the sample is due
+ */
+bool sim_sensor_pacer_due(struct sim_sensor_pacer *pacer, uint32_t sample_us,
+		uint32_t now_us)
+{
+	if (!pacer->synced) {
+		pacer->offset = now_us - sample_us;
+		pacer->synced = true;
+		return true;
+	}
+
+	/* Both clocks wrap, so only their difference is meaningful */
+	int32_t ahead = (int32_t) (sample_us + pacer->offset - now_us);
+
+	if (ahead > SIM_SENSOR_PACER_RESYNC_US ||
+			ahead < -SIM_SENSOR_PACER_RESYNC_US) {
+		pacer->offset = now_us - sample_us;
+		pacer->resyncs++;
+		return true;
+	}
+
+	return ahead <= 0;
+}
+
+/**
+ * @}
+ */
@@ -347,6 +347,66 @@ int32_t PIOS_FLASH_erase_range(uintptr_t partition_id, uint32_t start_offset, ui
 	return 0;
 }
 
+/**
+ * @brief Begin erasing one chip sector in this partition without waiting for it
+ * @param[in] partition_id opaque handle for a specific partition
+ * @param[in] start_offset offset (in bytes) from beginning of partition of the start of the sector
+ * @return 0 if the erase was started or error code
+ * @retval -1 to -19 error code from underlying flash chip driver
+ * @retval -20 if partition_id is not a valid partition identifier
+ * @retval -21 if chip driver can only erase synchronously
+ * @retval -22 if failed to find beginning of partition within the partition table
+ * @retval -23 if start_offset is not the start of a sector in the partition
+ * @note use PIOS_FLASH_busy to find out when it is done.  Other operations on
+ * the chip wait for the erase to complete.
+ */
+int32_t PIOS_FLASH_erase_sector_start(uintptr_t partition_id, uint32_t start_offset)
+{
+	struct pios_flash_partition *partition = (struct pios_flash_partition *)partition_id;
+
+	if (!PIOS_FLASH_validate_partition(partition))
+		return -20;
+
+	if (!partition->chip_desc->driver->erase_sector_start)
+		return -21;
+
+	struct pios_flash_sector_desc sector_desc;
+	if (!pios_flash_get_partition_first_sector(partition, &sector_desc))
+		return -22;
+
+	do {
+		if (sector_desc.partition_offset == start_offset) {
+			return partition->chip_desc->driver->erase_sector_start(*partition->chip_desc->chip_id,
+										sector_desc.sector,
+										sector_desc.chip_offset);
+		}
+	} while (pios_flash_get_partition_next_sector(partition, &sector_desc));
+
+	return -23;
+}
+
+/**
+ * @brief Check whether the chip underlying this partition is still busy with a
+ * previously started erase
+ * @param[in] partition_id opaque handle for a specific partition
+ * @return 0 if idle, 1 if busy or error code
+ * @retval -1 to -19 error code from underlying flash chip driver
+ * @retval -20 if partition_id is not a valid partition identifier
+ */
+int32_t PIOS_FLASH_busy(uintptr_t partition_id)
+{
+	struct pios_flash_partition *partition = (struct pios_flash_partition *)partition_id;
+
+	if (!PIOS_FLASH_validate_partition(partition))
+		return -20;
+
+	/* Drivers that cannot start an erase in the background are never left busy */
+	if (!partition->chip_desc->driver->busy)
+		return 0;
+
+	return partition->chip_desc->driver->busy(*partition->chip_desc->chip_id);
+}
+
 /**
  * @brief Erase all of the flash sectors within this partition
  * @param[in] partition_id opaque handle for a specific partition
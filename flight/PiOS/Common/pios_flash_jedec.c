@@ -71,6 +71,7 @@ struct jedec_flash_dev {
 
 	const struct pios_flash_jedec_cfg *cfg;
 	struct pios_semaphore *transaction_lock;
+	bool erasing;		//!< An erase was started and may still run
 	enum pios_jedec_dev_magic magic;
 };
 
@@ -84,6 +85,7 @@ static int32_t PIOS_Flash_Jedec_ClaimBus(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_ReleaseBus(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_WriteEnable(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_Busy(struct jedec_flash_dev *flash_dev);
+static void PIOS_Flash_Jedec_WaitErase(struct jedec_flash_dev *flash_dev);
 
 /**
  * @brief Allocate a new device
@@ -96,6 +98,7 @@ static struct jedec_flash_dev *PIOS_Flash_Jedec_alloc(void)
 	if (!flash_dev) return (NULL);
 
 	flash_dev->magic = PIOS_JEDEC_DEV_MAGIC;
+	flash_dev->erasing = false;
 
 	return(flash_dev);
 }
@@ -181,6 +184,24 @@ static int32_t PIOS_Flash_Jedec_Busy(struct jedec_flash_dev *flash_dev)
 	return status & JEDEC_STATUS_BUSY;
 }
 
+/**
+ * @brief Wait for an erase started by EraseSectorStart, since the chip
+ * ignores or garbles everything else meanwhile
+ */
+static void PIOS_Flash_Jedec_WaitErase(struct jedec_flash_dev *flash_dev)
+{
+	if (!flash_dev->erasing)
+		return;
+
+	while (PIOS_Flash_Jedec_Busy(flash_dev) != 0) {
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+		PIOS_Thread_Sleep(1);
+#endif
+	}
+
+	flash_dev->erasing = false;
+}
+
 /**
  * @brief Execute the write enable instruction and returns the status
  * @returns 0 if successful, -1 if unable to claim bus
@@ -296,21 +317,23 @@ static int32_t PIOS_Flash_Jedec_EndTransaction(uintptr_t chip_id)
 }
 
 /**
- * @brief Erase a sector on the flash chip
+ * @brief Begin erasing a sector on the flash chip and return without waiting
  * @param[in] chip_id the opaque handle for the chip that this operation should be applied to
  * @param[in] chip_sector Sector number of flash to erase
  * @param[in] chip_offset Address within flash to erase
  * @returns 0 if successful
  * @retval -1 if unable to claim bus
- * @retval
+ * @retval -2 if the command could not be sent
  */
-static int32_t PIOS_Flash_Jedec_EraseSector(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset)
+static int32_t PIOS_Flash_Jedec_EraseSectorStart(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset)
 {
 	struct jedec_flash_dev *flash_dev = (struct jedec_flash_dev *)chip_id;
 
 	if (PIOS_Flash_Jedec_Validate(flash_dev) != 0)
 		return -1;
 
+	PIOS_Flash_Jedec_WaitErase(flash_dev);
+
 	uint8_t ret;
 	uint8_t out[] = {
 		flash_dev->cfg->sector_erase,
@@ -332,12 +355,49 @@ static int32_t PIOS_Flash_Jedec_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	PIOS_Flash_Jedec_ReleaseBus(flash_dev);
 
-	// Keep polling when bus is busy too
-	while (PIOS_Flash_Jedec_Busy(flash_dev) != 0) {
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-		PIOS_Thread_Sleep(1);
-#endif
-	}
+	flash_dev->erasing = true;
+
+	return 0;
+}
+
+/**
+ * @brief Erase a sector on the flash chip
+ * @param[in] chip_id the opaque handle for the chip that this operation should be applied to
+ * @param[in] chip_sector Sector number of flash to erase
+ * @param[in] chip_offset Address within flash to erase
+ * @returns 0 if successful
+ * @retval -1 if unable to claim bus
+ * @retval
+ */
+static int32_t PIOS_Flash_Jedec_EraseSector(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset)
+{
+	int32_t ret = PIOS_Flash_Jedec_EraseSectorStart(chip_id, chip_sector, chip_offset);
+	if (ret != 0)
+		return ret;
+
+	PIOS_Flash_Jedec_WaitErase((struct jedec_flash_dev *)chip_id);
+
+	return 0;
+}
+
+/**
+ * @brief Check whether an erase started by EraseSectorStart is still running
+ * @return 0 if idle, 1 if busy, -1 if the device is invalid
+ */
+static int32_t PIOS_Flash_Jedec_EraseBusy(uintptr_t chip_id)
+{
+	struct jedec_flash_dev *flash_dev = (struct jedec_flash_dev *)chip_id;
+
+	if (PIOS_Flash_Jedec_Validate(flash_dev) != 0)
+		return -1;
+
+	if (!flash_dev->erasing)
+		return 0;
+
+	if (PIOS_Flash_Jedec_Busy(flash_dev) != 0)
+		return 1;
+
+	flash_dev->erasing = false;
 
 	return 0;
 }
@@ -372,6 +432,8 @@ static int32_t PIOS_Flash_Jedec_WriteData(uintptr_t chip_id, uint32_t chip_offse
 	if (len > 0x100)
 		return -2;
 
+	PIOS_Flash_Jedec_WaitErase(flash_dev);
+
 	/* Ensure number of bytes fits after starting address before end of page */
 	if (((chip_offset & 0xff) + len) > 0x100)
 		return -3;
@@ -432,6 +494,8 @@ static int32_t PIOS_Flash_Jedec_ReadData(uintptr_t chip_id, uint32_t chip_offset
 	if (PIOS_Flash_Jedec_Validate(flash_dev) != 0)
 		return -1;
 
+	PIOS_Flash_Jedec_WaitErase(flash_dev);
+
 	if (PIOS_Flash_Jedec_ClaimBus(flash_dev) == -1)
 		return -1;
 
@@ -466,6 +530,8 @@ const struct pios_flash_driver pios_jedec_flash_driver = {
 	.erase_sector      = PIOS_Flash_Jedec_EraseSector,
 	.write_data        = PIOS_Flash_Jedec_WriteData,
 	.read_data         = PIOS_Flash_Jedec_ReadData,
+	.erase_sector_start = PIOS_Flash_Jedec_EraseSectorStart,
+	.busy              = PIOS_Flash_Jedec_EraseBusy,
 };
 
 #endif	/* PIOS_INCLUDE_FLASH_JEDEC */
@@ -33,11 +33,37 @@
 #include <stdint.h>		/* uintptr_t */
 #include <stdbool.h>		/* bool */
 
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+
+#include "pios_thread.h"
+
+/*
+ * The firmware frees at runtime, so it gets the size class allocator.
+ * Bootloaders never free, and the F1 boards cannot spare the flash and
+ * per block headers; both keep the smaller bump allocator.
+ */
+#if !defined(STM32F10X_MD)
+#define PIOS_HEAP_POOL
+#include "pios_heap_pool.h"
+#endif	/* STM32F10X_MD */
+
+#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+
 #define DEBUG_MALLOC_FAILURES 0
 static volatile bool malloc_failed_flag = false;
-static void malloc_failed_hook(void)
+
+#if defined(PIOS_HEAP_POOL)
+/* Shared by the standard and fast heaps */
+static struct pios_heap_tag_stats tag_stats[PIOS_HEAP_TAG_NUM];
+#endif	/* PIOS_HEAP_POOL */
+
+static void malloc_failed_hook(enum pios_heap_tag tag)
 {
 	malloc_failed_flag = true;
+#if defined(PIOS_HEAP_POOL)
+	if (tag < PIOS_HEAP_TAG_NUM)
+		tag_stats[tag].failures++;
+#endif	/* PIOS_HEAP_POOL */
 #if DEBUG_MALLOC_FAILURES
 	static volatile bool wait_here = true;
 	while(wait_here);
@@ -50,11 +76,70 @@ bool PIOS_heap_malloc_failed_p(void)
 	return malloc_failed_flag;
 }
 
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+#if defined(PIOS_HEAP_POOL)
 
-#include "pios_thread.h"
+struct pios_heap {
+	const uintptr_t start_addr;
+	const uintptr_t end_addr;
+	bool initialized;
+	struct pios_heap_pool pool;
+};
 
-#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+#define PIOS_HEAP_INITIALIZER(start, end) { \
+	.start_addr = (const uintptr_t)(start), \
+	.end_addr   = (const uintptr_t)(end), \
+}
+
+/* Call with the scheduler suspended */
+static struct pios_heap_pool *heap_pool(struct pios_heap *heap)
+{
+	if (!heap->initialized) {
+		pios_heap_pool_init(&heap->pool, (void *)heap->start_addr,
+				heap->end_addr - heap->start_addr, tag_stats);
+		heap->initialized = true;
+	}
+
+	return &heap->pool;
+}
+
+static bool is_ptr_in_heap_p(const struct pios_heap *heap, void *buf)
+{
+	return heap->initialized && pios_heap_pool_contains(&heap->pool, buf);
+}
+
+static void * heap_malloc(struct pios_heap *heap, size_t size, enum pios_heap_tag tag)
+{
+	PIOS_Thread_Scheduler_Suspend();
+	void *buf = pios_heap_pool_alloc(heap_pool(heap), size, tag);
+	PIOS_Thread_Scheduler_Resume();
+
+	return buf;
+}
+
+static void heap_free(struct pios_heap *heap, void *buf)
+{
+	PIOS_Thread_Scheduler_Suspend();
+	pios_heap_pool_free(heap_pool(heap), buf);
+	PIOS_Thread_Scheduler_Resume();
+}
+
+static size_t heap_get_free_bytes(struct pios_heap *heap)
+{
+	PIOS_Thread_Scheduler_Suspend();
+	size_t free_bytes = pios_heap_pool_free_bytes(heap_pool(heap));
+	PIOS_Thread_Scheduler_Resume();
+
+	return free_bytes;
+}
+
+static void heap_extend(struct pios_heap *heap, size_t bytes)
+{
+	PIOS_Thread_Scheduler_Suspend();
+	pios_heap_pool_extend(heap_pool(heap), bytes);
+	PIOS_Thread_Scheduler_Resume();
+}
+
+#else	/* PIOS_HEAP_POOL */
 
 struct pios_heap {
 	const uintptr_t start_addr;
@@ -62,6 +147,12 @@ struct pios_heap {
 	uintptr_t free_addr;
 };
 
+#define PIOS_HEAP_INITIALIZER(start, end) { \
+	.start_addr = (const uintptr_t)(start), \
+	.end_addr   = (const uintptr_t)(end), \
+	.free_addr  = (uintptr_t)(start), \
+}
+
 static bool is_ptr_in_heap_p(const struct pios_heap *heap, void *buf)
 {
 	uintptr_t buf_addr = (uintptr_t)buf;
@@ -69,7 +160,7 @@ static bool is_ptr_in_heap_p(const struct pios_heap *heap, void *buf)
 	return ((buf_addr >= heap->start_addr) && (buf_addr <= heap->end_addr));
 }
 
-static void * simple_malloc(struct pios_heap *heap, size_t size)
+static void * heap_malloc(struct pios_heap *heap, size_t size, enum pios_heap_tag tag)
 {
 	if (heap == NULL)
 		return NULL;
@@ -77,28 +168,20 @@ static void * simple_malloc(struct pios_heap *heap, size_t size)
 	void * buf = NULL;
 	uint32_t align_pad = (sizeof(uintptr_t) - (size & (sizeof(uintptr_t) - 1))) % sizeof(uintptr_t);
 
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-	PIOS_Thread_Scheduler_Suspend();
-#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
-
 	if (heap->free_addr + size <= heap->end_addr) {
 		buf = (void *)heap->free_addr;
 		heap->free_addr += size + align_pad;
 	}
 
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-	PIOS_Thread_Scheduler_Resume();
-#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
-
 	return buf;
 }
 
-static void simple_free(struct pios_heap *heap, void *buf)
+static void heap_free(struct pios_heap *heap, void *buf)
 {
 	/* This allocator doesn't support free */
 }
 
-static size_t simple_get_free_bytes(struct pios_heap *heap)
+static size_t heap_get_free_bytes(struct pios_heap *heap)
 {
 	if (heap->free_addr > heap->end_addr)
 		return 0;
@@ -106,11 +189,13 @@ static size_t simple_get_free_bytes(struct pios_heap *heap)
 	return heap->end_addr - heap->free_addr;
 }
 
-static void simple_extend_heap(struct pios_heap *heap, size_t bytes)
+static void heap_extend(struct pios_heap *heap, size_t bytes)
 {
 	heap->end_addr += bytes;
 }
 
+#endif	/* PIOS_HEAP_POOL */
+
 /*
  * Standard heap.  All memory in this heap is DMA-safe.
  * Note: Uses underlying FreeRTOS heap when available
@@ -118,24 +203,24 @@ static void simple_extend_heap(struct pios_heap *heap, size_t bytes)
 extern const void * _eheap;	/* defined in linker script */
 extern const void * _sheap;	/* defined in linker script */
 
-static struct pios_heap pios_standard_heap = {
-	.start_addr = (const uintptr_t)&_sheap,
-	.end_addr   = (const uintptr_t)&_eheap,
-	.free_addr  = (uintptr_t)&_sheap,
-};
-
+static struct pios_heap pios_standard_heap = PIOS_HEAP_INITIALIZER(&_sheap, &_eheap);
 
-void * pvPortMalloc(size_t size) __attribute__((alias ("PIOS_malloc"), weak));
-void * PIOS_malloc(size_t size)
+void * PIOS_malloc_tagged(size_t size, enum pios_heap_tag tag)
 {
-	void *buf = simple_malloc(&pios_standard_heap, size);
+	void *buf = heap_malloc(&pios_standard_heap, size, tag);
 
 	if (buf == NULL)
-		malloc_failed_hook();
+		malloc_failed_hook(tag);
 
 	return buf;
 }
 
+void * pvPortMalloc(size_t size) __attribute__((alias ("PIOS_malloc"), weak));
+void * PIOS_malloc(size_t size)
+{
+	return PIOS_malloc_tagged(size, PIOS_HEAP_TAG_OTHER);
+}
+
 /*
  * Fast heap.  Memory in this heap is NOT DMA-safe.
  * Note: This should not be used to allocate RAM for task stacks since a task may pass
@@ -146,20 +231,14 @@ void * PIOS_malloc(size_t size)
 
 extern const void * _efastheap;	/* defined in linker script */
 extern const void * _sfastheap;	/* defined in linker script */
-static struct pios_heap pios_nodma_heap = {
-	.start_addr = (const uintptr_t)&_sfastheap,
-	.end_addr   = (const uintptr_t)&_efastheap,
-	.free_addr  = (uintptr_t)&_sfastheap,
-};
-void * PIOS_malloc_no_dma(size_t size)
-{
-	void * buf = simple_malloc(&pios_nodma_heap, size);
+static struct pios_heap pios_nodma_heap = PIOS_HEAP_INITIALIZER(&_sfastheap, &_efastheap);
 
-	if (buf == NULL)
-		buf = PIOS_malloc(size);
+void * PIOS_malloc_no_dma_tagged(size_t size, enum pios_heap_tag tag)
+{
+	void * buf = heap_malloc(&pios_nodma_heap, size, tag);
 
 	if (buf == NULL)
-		malloc_failed_hook();
+		buf = PIOS_malloc_tagged(size, tag);
 
 	return buf;
 }
@@ -167,57 +246,41 @@ void * PIOS_malloc_no_dma(size_t size)
 #else	/* PIOS_INCLUDE_FASTHEAP */
 
 /* This platform only has a standard heap.  Fall back directly to that */
-void * PIOS_malloc_no_dma(size_t size)
+void * PIOS_malloc_no_dma_tagged(size_t size, enum pios_heap_tag tag)
 {
-	return PIOS_malloc(size);
+	return PIOS_malloc_tagged(size, tag);
 }
 
 #endif	/* PIOS_INCLUDE_FASTHEAP */
 
+void * PIOS_malloc_no_dma(size_t size)
+{
+	return PIOS_malloc_no_dma_tagged(size, PIOS_HEAP_TAG_OTHER);
+}
+
 void vPortFree(void * buf) __attribute__((alias ("PIOS_free")));
 void PIOS_free(void * buf)
 {
 #if defined(PIOS_INCLUDE_FASTHEAP)
 	if (is_ptr_in_heap_p(&pios_nodma_heap, buf))
-		return simple_free(&pios_nodma_heap, buf);
+		return heap_free(&pios_nodma_heap, buf);
 #endif	/* PIOS_INCLUDE_FASTHEAP */
 
 	if (is_ptr_in_heap_p(&pios_standard_heap, buf))
-		return simple_free(&pios_standard_heap, buf);
+		return heap_free(&pios_standard_heap, buf);
 }
 
 size_t xPortGetFreeHeapSize(void) __attribute__((alias ("PIOS_heap_get_free_size")));
 size_t PIOS_heap_get_free_size(void)
 {
-#if defined(PIOS_INCLUDE_FREERTOS)
-	PIOS_Thread_Scheduler_Suspend();
-#endif	/* PIOS_INCLUDE_FREERTOS */
-
-	size_t free_bytes = simple_get_free_bytes(&pios_standard_heap);
-
-#if defined(PIOS_INCLUDE_FREERTOS)
-	PIOS_Thread_Scheduler_Resume();
-#endif	/* PIOS_INCLUDE_FREERTOS */
-
-	return free_bytes;
+	return heap_get_free_bytes(&pios_standard_heap);
 }
 
-
 #if defined(PIOS_INCLUDE_FASTHEAP)
 
 size_t PIOS_fastheap_get_free_size(void)
 {
-#if defined(PIOS_INCLUDE_FREERTOS)
-	PIOS_Thread_Scheduler_Suspend();
-#endif	/* PIOS_INCLUDE_FREERTOS */
-
-	size_t free_bytes = simple_get_free_bytes(&pios_nodma_heap);
-
-#if defined(PIOS_INCLUDE_FREERTOS)
-	PIOS_Thread_Scheduler_Resume();
-#endif	/* PIOS_INCLUDE_FREERTOS */
-
-	return free_bytes;
+	return heap_get_free_bytes(&pios_nodma_heap);
 }
 
 #else
@@ -229,24 +292,36 @@ size_t PIOS_fastheap_get_free_size(void)
 
 #endif // PIOS_INCLUDE_FASTHEAP
 
+/**
+ * @brief Get how much memory one allocation tag holds across the heaps
+ * @returns false if this heap keeps no accounting
+ */
+bool PIOS_heap_get_tag_stats(enum pios_heap_tag tag, struct pios_heap_tag_stats *stats)
+{
+#if defined(PIOS_HEAP_POOL)
+	if (tag >= PIOS_HEAP_TAG_NUM)
+		return false;
+
+	PIOS_Thread_Scheduler_Suspend();
+	*stats = tag_stats[tag];
+	PIOS_Thread_Scheduler_Resume();
+
+	return true;
+#else
+	return false;
+#endif	/* PIOS_HEAP_POOL */
+}
+
 void vPortInitialiseBlocks(void) __attribute__((alias ("PIOS_heap_initialize_blocks")));
 void PIOS_heap_initialize_blocks(void)
 {
-	/* NOP for the simple allocator */
+	/* NOP, the heaps set themselves up on first use */
 }
 
 void xPortIncreaseHeapSize(size_t bytes) __attribute__((alias ("PIOS_heap_increase_size")));
 void PIOS_heap_increase_size(size_t bytes)
 {
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-	PIOS_Thread_Scheduler_Suspend();
-#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
-
-	simple_extend_heap(&pios_standard_heap, bytes);
-
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-	PIOS_Thread_Scheduler_Resume();
-#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+	heap_extend(&pios_standard_heap, bytes);
 }
 
 /* Provide an implementation of _sbrk for library functions.
@@ -0,0 +1,355 @@
+/**
+ ******************************************************************************
+ * @file       pios_heap_pool.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_HEAP Heap Allocation Abstraction
+ * @{
+ * @brief Size class allocator with free and per tag accounting
+ *
+ * Not thread safe by itself, the heap that owns a pool serializes access.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios_heap_pool.h"
+
+#include <string.h>		/* memset */
+
+#define BLOCK_USED 0xa5
+#define BLOCK_FREE 0x5a
+
+/* Every block starts with a header of one alignment unit */
+struct block_header {
+	uint16_t units;		/* Whole block in PIOS_HEAP_POOL_ALIGN units */
+	uint8_t tag;
+	uint8_t state;		/* BLOCK_USED or BLOCK_FREE */
+};
+
+#define HEADER_SIZE PIOS_HEAP_POOL_ALIGN
+#define MAX_BLOCK   (UINT16_MAX * PIOS_HEAP_POOL_ALIGN)
+
+/* A free block links to the next one where the payload was */
+struct pios_heap_pool_free {
+	union {
+		struct block_header header;
+		uintptr_t pad;
+	};
+	struct pios_heap_pool_free *next;
+};
+
+static inline size_t block_size(const struct pios_heap_pool_free *block)
+{
+	return block->header.units * PIOS_HEAP_POOL_ALIGN;
+}
+
+static inline uintptr_t block_end(const struct pios_heap_pool_free *block)
+{
+	return (uintptr_t) block + block_size(block);
+}
+
+static inline void set_free(struct pios_heap_pool_free *block, size_t size)
+{
+	block->header.units = size / PIOS_HEAP_POOL_ALIGN;
+	block->header.tag = 0;
+	block->header.state = BLOCK_FREE;
+}
+
+static inline unsigned int small_class(size_t size)
+{
+	return size / PIOS_HEAP_POOL_GRANULE - 1;
+}
+
+/**
+ * @brief Manage the memory from start to start + size
+ * @param[in] stats per tag accounting to update, which pools may share
+ */
+void pios_heap_pool_init(struct pios_heap_pool *pool, void *start, size_t size,
+		struct pios_heap_tag_stats *stats)
+{
+	uintptr_t start_addr = (uintptr_t) start;
+	uintptr_t end_addr = start_addr + size;
+
+	memset(pool, 0, sizeof(*pool));
+
+	start_addr = (start_addr + PIOS_HEAP_POOL_ALIGN - 1) & ~(PIOS_HEAP_POOL_ALIGN - 1);
+	end_addr &= ~(PIOS_HEAP_POOL_ALIGN - 1);
+
+	pool->start_addr = start_addr;
+	pool->end_addr = end_addr;
+	pool->free_addr = start_addr;
+	pool->free_bytes = end_addr - start_addr;
+	pool->stats = stats;
+}
+
+/**
+ * @brief Grow the region at its end, e.g. over memory that is no longer needed
+ * for the startup stack
+ */
+void pios_heap_pool_extend(struct pios_heap_pool *pool, size_t bytes)
+{
+	bytes &= ~(PIOS_HEAP_POOL_ALIGN - 1);
+
+	pool->end_addr += bytes;
+	pool->free_bytes += bytes;
+}
+
+/* First fit from the large free list, splitting what is left over */
+static struct pios_heap_pool_free *take_large(struct pios_heap_pool *pool, size_t size)
+{
+	struct pios_heap_pool_free **link = &pool->large;
+
+	for (struct pios_heap_pool_free *block = pool->large; block; block = block->next) {
+		size_t available = block_size(block);
+
+		if (available >= size) {
+			if (available - size >= PIOS_HEAP_POOL_GRANULE) {
+				struct pios_heap_pool_free *rest =
+					(struct pios_heap_pool_free *) ((uintptr_t) block + size);
+				set_free(rest, available - size);
+				rest->next = block->next;
+				*link = rest;
+				block->header.units = size / PIOS_HEAP_POOL_ALIGN;
+			} else {
+				*link = block->next;
+			}
+
+			return block;
+		}
+
+		link = &block->next;
+	}
+
+	return NULL;
+}
+
+/* Cut from the untouched top of the region */
+static struct pios_heap_pool_free *take_top(struct pios_heap_pool *pool, size_t size)
+{
+	if (pool->end_addr - pool->free_addr < size) {
+		return NULL;
+	}
+
+	struct pios_heap_pool_free *block = (struct pios_heap_pool_free *) pool->free_addr;
+	pool->free_addr += size;
+	block->header.units = size / PIOS_HEAP_POOL_ALIGN;
+
+	return block;
+}
+
+/* Insert by address, merging with the neighbours and giving back to the top */
+static void put_large(struct pios_heap_pool *pool, struct pios_heap_pool_free *block)
+{
+	struct pios_heap_pool_free *prev = NULL;
+	struct pios_heap_pool_free *next = pool->large;
+
+	while (next && (uintptr_t) next < (uintptr_t) block) {
+		prev = next;
+		next = next->next;
+	}
+
+	if (next && block_end(block) == (uintptr_t) next &&
+			block_size(block) + block_size(next) <= MAX_BLOCK) {
+		set_free(block, block_size(block) + block_size(next));
+		next = next->next;
+	}
+	block->next = next;
+
+	if (prev && block_end(prev) == (uintptr_t) block &&
+			block_size(prev) + block_size(block) <= MAX_BLOCK) {
+		set_free(prev, block_size(prev) + block_size(block));
+		prev->next = block->next;
+		block = prev;
+	} else if (prev) {
+		prev->next = block;
+	} else {
+		pool->large = block;
+	}
+
+	if (block_end(block) == pool->free_addr) {
+		/* Nothing lies above, so it is the last entry in the list */
+		struct pios_heap_pool_free **link = &pool->large;
+		while (*link != block) {
+			link = &(*link)->next;
+		}
+		*link = NULL;
+
+		pool->free_addr = (uintptr_t) block;
+	}
+}
+
+/*
+ * Hand every small free block to the merging list.  Done only when an
+ * allocation would otherwise fail, so that small blocks stay cheap the rest
+ * of the time but cannot hold memory hostage.
+ */
+static void consolidate(struct pios_heap_pool *pool)
+{
+	for (int c = 0; c < PIOS_HEAP_POOL_CLASSES; c++) {
+		while (pool->small[c]) {
+			struct pios_heap_pool_free *block = pool->small[c];
+			pool->small[c] = block->next;
+
+			put_large(pool, block);
+		}
+	}
+}
+
+/**
+ * @brief Allocate size bytes accounted to tag
+ * @return the memory, aligned to PIOS_HEAP_POOL_ALIGN, or NULL
+ */
+void *pios_heap_pool_alloc(struct pios_heap_pool *pool, size_t size, enum pios_heap_tag tag)
+{
+	struct pios_heap_pool_free *block = NULL;
+
+	size = (size + HEADER_SIZE + PIOS_HEAP_POOL_GRANULE - 1) & ~(PIOS_HEAP_POOL_GRANULE - 1);
+
+	if (tag >= PIOS_HEAP_TAG_NUM) {
+		tag = PIOS_HEAP_TAG_OTHER;
+	}
+
+	if (size <= MAX_BLOCK) {
+		if (size <= PIOS_HEAP_POOL_SMALL_MAX && pool->small[small_class(size)]) {
+			block = pool->small[small_class(size)];
+			pool->small[small_class(size)] = block->next;
+		}
+
+		if (!block) {
+			block = take_large(pool, size);
+		}
+
+		if (!block) {
+			block = take_top(pool, size);
+		}
+
+		/* Last resort, merge the small blocks and look again */
+		if (!block) {
+			consolidate(pool);
+
+			block = take_large(pool, size);
+			if (!block) {
+				block = take_top(pool, size);
+			}
+		}
+	}
+
+	if (!block) {
+		/* Failures are counted by the caller, which may try elsewhere */
+		return NULL;
+	}
+
+	block->header.tag = tag;
+	block->header.state = BLOCK_USED;
+
+	size = block_size(block);
+	pool->free_bytes -= size;
+
+	if (pool->stats) {
+		struct pios_heap_tag_stats *stats = &pool->stats[tag];
+
+		stats->used += size;
+		stats->blocks++;
+		if (stats->used > stats->high_water) {
+			stats->high_water = stats->used;
+		}
+	}
+
+	return (uint8_t *) block + HEADER_SIZE;
+}
+
+/**
+ * @brief Give back memory from pios_heap_pool_alloc
+ *
+ * Pointers that are not allocated blocks of this pool are ignored.
+ */
+void pios_heap_pool_free(struct pios_heap_pool *pool, void *buf)
+{
+	if (!pios_heap_pool_contains(pool, buf)) {
+		return;
+	}
+
+	struct pios_heap_pool_free *block =
+		(struct pios_heap_pool_free *) ((uint8_t *) buf - HEADER_SIZE);
+
+	if (block->header.state != BLOCK_USED) {
+		return;
+	}
+
+	size_t size = block_size(block);
+
+	if (pool->stats && block->header.tag < PIOS_HEAP_TAG_NUM) {
+		pool->stats[block->header.tag].used -= size;
+		pool->stats[block->header.tag].blocks--;
+	}
+
+	pool->free_bytes += size;
+	set_free(block, size);
+
+	if (block_end(block) == pool->free_addr && size <= PIOS_HEAP_POOL_SMALL_MAX) {
+		/* Small blocks rarely sit below the top, but give them back too */
+		pool->free_addr = (uintptr_t) block;
+	} else if (size <= PIOS_HEAP_POOL_SMALL_MAX) {
+		block->next = pool->small[small_class(size)];
+		pool->small[small_class(size)] = block;
+	} else {
+		put_large(pool, block);
+	}
+}
+
+bool pios_heap_pool_contains(const struct pios_heap_pool *pool, const void *buf)
+{
+	uintptr_t addr = (uintptr_t) buf;
+
+	return addr >= pool->start_addr + HEADER_SIZE && addr < pool->free_addr;
+}
+
+size_t pios_heap_pool_free_bytes(const struct pios_heap_pool *pool)
+{
+	return pool->free_bytes;
+}
+
+/**
+ * @brief The largest allocation, header included, that would succeed now
+ */
+size_t pios_heap_pool_largest_free(const struct pios_heap_pool *pool)
+{
+	size_t largest = pool->end_addr - pool->free_addr;
+
+	for (const struct pios_heap_pool_free *block = pool->large; block; block = block->next) {
+		if (block_size(block) > largest) {
+			largest = block_size(block);
+		}
+	}
+
+	for (int c = PIOS_HEAP_POOL_CLASSES - 1; c >= 0; c--) {
+		if (pool->small[c]) {
+			size_t size = (c + 1) * PIOS_HEAP_POOL_GRANULE;
+			if (size > largest) {
+				largest = size;
+			}
+			break;
+		}
+	}
+
+	return largest;
+}
+
+/**
+ * @}
+ * @}
+ */
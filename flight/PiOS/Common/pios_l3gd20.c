@@ -434,6 +434,7 @@ static void PIOS_L3GD20_Task(void *parameters)
 		// TODO: This reordering is specific to the FlyingF3 chip placement.  Whenever
 		// this code is used on another board add an orientation mapping to the configuration
 		struct pios_sensor_gyro_data normalized_data;
+		normalized_data.timestamp = PIOS_DELAY_GetRaw();
 		float scale = PIOS_L3GD20_GetScale();
 		normalized_data.y = data.gyro_x * scale;
 		normalized_data.x = data.gyro_y * scale;
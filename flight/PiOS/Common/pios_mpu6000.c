@@ -598,6 +598,7 @@ static void PIOS_MPU6000_Task(void *parameters)
 		// Currently we only support rotations on top so switch X/Y accordingly
 		struct pios_sensor_accel_data accel_data;
 		struct pios_sensor_gyro_data gyro_data;
+		gyro_data.timestamp = PIOS_DELAY_GetRaw();
 
 		switch (pios_mpu6000_dev->cfg->orientation) {
 		case PIOS_MPU60X0_TOP_0DEG:
@@ -690,6 +691,7 @@ static void PIOS_MPU6000_Task(void *parameters)
 #else
 
 		struct pios_sensor_gyro_data gyro_data;
+		gyro_data.timestamp = PIOS_DELAY_GetRaw();
 
 		switch (pios_mpu6000_dev->cfg->orientation) {
 		case PIOS_MPU60X0_TOP_0DEG:
@@ -631,6 +631,7 @@ static void PIOS_MPU6050_Task(void *parameters)
 		// Currently we only support rotations on top so switch X/Y accordingly
 		struct pios_sensor_accel_data accel_data;
 		struct pios_sensor_gyro_data gyro_data;
+		gyro_data.timestamp = PIOS_DELAY_GetRaw();
 
 		switch (pios_mpu6050_dev->cfg->orientation) {
 		case PIOS_MPU60X0_TOP_0DEG:
@@ -723,6 +724,7 @@ static void PIOS_MPU6050_Task(void *parameters)
 #else
 
 		struct pios_sensor_gyro_data gyro_data;
+		gyro_data.timestamp = PIOS_DELAY_GetRaw();
 
 		switch (pios_mpu6050_dev->cfg->orientation) {
 		case PIOS_MPU60X0_TOP_0DEG:
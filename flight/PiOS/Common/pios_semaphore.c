@@ -52,7 +52,7 @@
  */
 struct pios_semaphore *PIOS_Semaphore_Create(void)
 {
-	struct pios_semaphore *sema = PIOS_malloc(sizeof(struct pios_semaphore));
+	struct pios_semaphore *sema = PIOS_malloc_tagged(sizeof(struct pios_semaphore), PIOS_HEAP_TAG_SYNC);
 
 	if (sema == NULL)
 		return NULL;
@@ -169,7 +169,7 @@ bool PIOS_Semaphore_Give_FromISR(struct pios_semaphore *sema, bool *woken)
  */
 struct pios_semaphore *PIOS_Semaphore_Create(void)
 {
-	struct pios_semaphore *sema = PIOS_malloc(sizeof(struct pios_semaphore));
+	struct pios_semaphore *sema = PIOS_malloc_tagged(sizeof(struct pios_semaphore), PIOS_HEAP_TAG_SYNC);
 
 	if (sema == NULL)
 		return NULL;
@@ -272,7 +272,7 @@ bool PIOS_Semaphore_Give_FromISR(struct pios_semaphore *sema, bool *woken)
  */
 struct pios_semaphore *PIOS_Semaphore_Create(void)
 {
-	struct pios_semaphore *sema = PIOS_malloc_no_dma(sizeof(struct pios_semaphore));
+	struct pios_semaphore *sema = PIOS_malloc_no_dma_tagged(sizeof(struct pios_semaphore), PIOS_HEAP_TAG_SYNC);
 
 	if (sema == NULL)
 		return NULL;
@@ -33,6 +33,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>		/* NULL */
+#include <string.h>		/* memcpy */
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
@@ -48,6 +49,12 @@
  * sector has a footer to indicate the file id and the sector id.
  *
  * Arenas map onto sectors. 
+ *
+ * Writes are gathered into whole pages, so that each costs one page
+ * program.  While the active arena fills, the next one is erased in the
+ * background where the flash driver supports it, and pages are buffered
+ * in RAM until the chip is free again.  Moving on to the next arena then
+ * does not wait for an erase.
  */
 
 #include <pios_com.h>
@@ -93,6 +100,18 @@ struct streamfs_state {
 	int32_t active_file_arena;
 	int32_t active_file_arena_offset;
 
+	/* Pages waiting to be written, in a ring of buffer_size bytes */
+	uint8_t *page_buffer;
+	uint16_t num_pages;
+	uint16_t first_pending;
+	uint16_t pages_pending;
+	uint32_t page_fill;	/* Bytes in the page after the pending ones */
+	int32_t fill_arena;	/* Where that page goes */
+	int32_t fill_arena_offset;
+
+	/* Arena erased, or being erased, ahead of the active one; -1 if none */
+	int32_t erased_arena;
+
 	/* Information about file system contents */
 	int32_t min_file_id;
 	int32_t max_file_id;
@@ -186,9 +205,32 @@ static void streamfs_free(struct streamfs_state *streamfs)
 {
 	/* Invalidate the magic */
 	streamfs->magic = ~PIOS_FLASHFS_STREAMFS_DEV_MAGIC;
+	PIOS_free(streamfs->page_buffer);
+	PIOS_free(streamfs->com_buffer);
 	PIOS_free(streamfs);
 }
 
+/**
+ * Start erasing the arena after the active one, so that it is ready by the
+ * time the active one fills.  Without driver support the erase happens when
+ * the arena is reached instead.
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static void streamfs_erase_ahead(struct streamfs_state *streamfs)
+{
+	int32_t next_arena = (streamfs->active_file_arena + 1) % streamfs->partition_arenas;
+
+	if (next_arena == streamfs->erased_arena)
+		return;
+
+	streamfs->erased_arena = -1;
+
+	if (PIOS_FLASH_erase_sector_start(streamfs->partition_id,
+			streamfs_get_addr(streamfs, next_arena, 0)) == 0) {
+		streamfs->erased_arena = next_arena;
+	}
+}
+
 /**
  * Write footer to current sector and reset pointers for writing to
  * next sector
@@ -214,22 +256,29 @@ static int32_t streamfs_new_sector(struct streamfs_state *streamfs)
 	streamfs->active_file_arena_offset = 0;
 	streamfs->active_file_segment++;
 
-	// Test whether the sector has already been erased by checking the footer
-	start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
-			                          streamfs->cfg->arena_size - sizeof(footer));
-	if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
-		return -2;
-	}
+	if (streamfs->active_file_arena == streamfs->erased_arena) {
+		// Erased ahead; writes wait for the chip if it is not done yet
+		streamfs->erased_arena = -1;
+	} else {
+		// Test whether the sector has already been erased by checking the footer
+		start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
+						  streamfs->cfg->arena_size - sizeof(footer));
+		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+			return -2;
+		}
 
-	for (int i=0; i < sizeof(footer); i++) {
-		if (((uint8_t*)&footer)[i] != 0xFF) {
-			if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
-				return -3;
+		for (int i=0; i < sizeof(footer); i++) {
+			if (((uint8_t*)&footer)[i] != 0xFF) {
+				if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
+					return -3;
+				}
+				break;
 			}
-			break;
 		}
 	}
 
+	streamfs_erase_ahead(streamfs);
+
 	return 0;
 }
 
@@ -359,6 +408,95 @@ static int32_t streamfs_find_new_sector(struct streamfs_state *streamfs)
 	return (last_sector + 1) % num_arenas;
 }
 
+/**
+ * Length of the page starting at arena_offset, which is short only where the
+ * footer cuts into it
+ */
+static uint32_t streamfs_page_len(const struct streamfs_state *streamfs, uint32_t arena_offset)
+{
+	uint32_t data_size = streamfs->cfg->arena_size - sizeof(struct streamfs_footer);
+	uint32_t len = streamfs->cfg->write_size - (arena_offset % streamfs->cfg->write_size);
+
+	return MIN(len, data_size - arena_offset);
+}
+
+static uint8_t *streamfs_page(const struct streamfs_state *streamfs, uint16_t slot)
+{
+	return &streamfs->page_buffer[slot * streamfs->cfg->write_size];
+}
+
+/**
+ * Write data at the end of the file in flash, moving on to the next
+ * sector when this one is full.  The data must fit in the active sector.
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t streamfs_write_flash(struct streamfs_state *streamfs, const uint8_t *data, uint32_t len)
+{
+	uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
+						   streamfs->active_file_arena_offset);
+
+	if (PIOS_FLASH_write_data(streamfs->partition_id, start_address, data, len) != 0) {
+		return -1;
+	}
+
+	streamfs->active_file_arena_offset += len;
+
+	if (streamfs->active_file_arena_offset >= (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
+		if (streamfs_new_sector(streamfs) != 0) {
+			return -2;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Write out the full pages that are buffered
+ * @param[in] wait whether to wait for an erase in progress, otherwise the
+ * pages stay buffered until the chip is free
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t streamfs_write_pages(struct streamfs_state *streamfs, bool wait)
+{
+	while (streamfs->pages_pending > 0) {
+		if (!wait && PIOS_FLASH_busy(streamfs->partition_id) != 0) {
+			return 0;
+		}
+
+		uint32_t len = streamfs_page_len(streamfs, streamfs->active_file_arena_offset);
+		if (streamfs_write_flash(streamfs, streamfs_page(streamfs, streamfs->first_pending), len) != 0) {
+			return -1;
+		}
+
+		streamfs->first_pending = (streamfs->first_pending + 1) % streamfs->num_pages;
+		streamfs->pages_pending--;
+	}
+
+	return 0;
+}
+
+/**
+ * Write out everything buffered, including a partly filled page
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t streamfs_flush(struct streamfs_state *streamfs)
+{
+	if (streamfs_write_pages(streamfs, true) != 0) {
+		return -1;
+	}
+
+	if (streamfs->page_fill > 0) {
+		uint16_t slot = streamfs->first_pending;
+		if (streamfs_write_flash(streamfs, streamfs_page(streamfs, slot), streamfs->page_fill) != 0) {
+			return -2;
+		}
+
+		streamfs->page_fill = 0;
+	}
+
+	return 0;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
 static int32_t streamfs_append_to_file(struct streamfs_state *streamfs, uint8_t *data, uint32_t len)
 {
@@ -371,28 +509,36 @@ static int32_t streamfs_append_to_file(struct streamfs_state *streamfs, uint8_t
 	uint32_t total_written = 0;
 
 	while (len > 0) {
-		uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
-			                                                 streamfs->active_file_arena_offset);
-
-		// Make sure not to write into the space for the footer
-		uint32_t bytes_to_write = len;
-		if ((streamfs->active_file_arena_offset + bytes_to_write) > (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
-			bytes_to_write = streamfs->cfg->arena_size - sizeof(struct streamfs_footer) - streamfs->active_file_arena_offset;
+		// Only wait on the flash when there is nowhere left to buffer
+		if (streamfs->pages_pending == streamfs->num_pages) {
+			if (streamfs_write_pages(streamfs, true) != 0) {
+				return -3;
+			}
 		}
 
-		if (PIOS_FLASH_write_data(streamfs->partition_id, start_address, data, bytes_to_write) != 0) {
-			return -3;
-		}
+		uint16_t slot = (streamfs->first_pending + streamfs->pages_pending) % streamfs->num_pages;
+		uint32_t page_len = streamfs_page_len(streamfs, streamfs->fill_arena_offset);
+
+		uint32_t bytes_to_write = MIN(len, page_len - streamfs->page_fill);
+		memcpy(streamfs_page(streamfs, slot) + streamfs->page_fill, data, bytes_to_write);
 
 		// Increment pointers
-		streamfs->active_file_arena_offset += bytes_to_write;
+		streamfs->page_fill += bytes_to_write;
 		len -= bytes_to_write;
 		total_written += bytes_to_write;
 		data = &data[bytes_to_write];
 
+		if (streamfs->page_fill == page_len) {
+			streamfs->pages_pending++;
+			streamfs->page_fill = 0;
+			streamfs->fill_arena_offset += page_len;
+
+			if (streamfs->fill_arena_offset >= (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
+				streamfs->fill_arena = (streamfs->fill_arena + 1) % streamfs->partition_arenas;
+				streamfs->fill_arena_offset = 0;
+			}
 
-		if (streamfs->active_file_arena_offset >= (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
-			if (streamfs_new_sector(streamfs) != 0) {
+			if (streamfs_write_pages(streamfs, false) != 0) {
 				return -4;
 			}
 		}
@@ -545,6 +691,9 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 	/* sector_size must exceed write_size */
 	PIOS_Assert(cfg->arena_size > cfg->write_size);
 
+	/* Buffer at least the page being filled and one more */
+	PIOS_Assert(cfg->buffer_size >= 2 * cfg->write_size);
+
 	int8_t rc;
 
 	struct streamfs_state *streamfs;
@@ -561,6 +710,14 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 		return -1;
 	}
 
+	streamfs->num_pages = cfg->buffer_size / cfg->write_size;
+	streamfs->page_buffer = (uint8_t *)PIOS_malloc_no_dma(streamfs->num_pages * cfg->write_size);
+	if (!streamfs->page_buffer) {
+		PIOS_free(streamfs->com_buffer);
+		PIOS_free(streamfs);
+		return -1;
+	}
+
 	/* Bind configuration parameters to this filesystem instance */
 	streamfs->cfg            = cfg;	/* filesystem configuration */
 	streamfs->partition_id   = partition_id; /* underlying partition */
@@ -572,6 +729,7 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 	streamfs->active_file_id           = 0;
 	streamfs->active_file_arena        = 0;
 	streamfs->active_file_arena_offset = 0;
+	streamfs->erased_arena             = -1;
 
 	if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
 		rc = -1;
@@ -698,12 +856,22 @@ int32_t PIOS_STREAMFS_OpenWrite(uintptr_t fs_id)
 	streamfs->active_file_arena_offset = 0;
 	streamfs->file_open_writing = true;
 
-	// Erase this sector to prepare for streaming
-	if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
+	streamfs->first_pending = 0;
+	streamfs->pages_pending = 0;
+	streamfs->page_fill = 0;
+	streamfs->fill_arena = streamfs->active_file_arena;
+	streamfs->fill_arena_offset = 0;
+
+	// Erase this sector to prepare for streaming, unless the last file did
+	if (streamfs->active_file_arena == streamfs->erased_arena) {
+		streamfs->erased_arena = -1;
+	} else if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
 		rc = -5;
 		goto out_end_trans;
 	}
 
+	streamfs_erase_ahead(streamfs);
+
 	rc = 0;
 
 out_end_trans:
@@ -810,6 +978,11 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		goto out_exit;
 	}
 
+	if (streamfs_flush(streamfs) != 0) {
+		rc = -3;
+		goto out_end_trans;
+	}
+
 	if (streamfs->active_file_arena_offset != 0) {
 		// Close segment when something has been written. This avoids creating
 		// null files with an open/close operation
@@ -819,8 +992,6 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		}
 	}
 
-
-	// TODO: make sure to flush remaining data
 	streamfs->file_open_writing = false;
 
 	if (streamfs_scan_filesystem(streamfs) != 0) {
@@ -969,7 +1140,7 @@ static void PIOS_STREAMFS_TxStart(uintptr_t fs_id, uint16_t tx_bytes_avail)
 		if (bytes_to_write <= 0)
 			break;
 
-		if (streamfs_append_to_file (streamfs, streamfs->com_buffer, bytes_to_write) != 0) {
+		if (streamfs_append_to_file (streamfs, streamfs->com_buffer, bytes_to_write) < 0) {
 			goto out_end_trans;
 		}
 	}
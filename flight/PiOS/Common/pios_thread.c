@@ -58,7 +58,7 @@
  */
 struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
 {
-	struct pios_thread *thread = PIOS_malloc_no_dma(sizeof(struct pios_thread));
+	struct pios_thread *thread = PIOS_malloc_no_dma_tagged(sizeof(struct pios_thread), PIOS_HEAP_TAG_THREAD);
 
 	if (thread == NULL)
 		return NULL;
@@ -222,14 +222,17 @@ static uint32_t ceil_size(uint32_t size)
  * to 8 byte boundaries. This makes sure to allocate enough
  * memory and return an address that has the requested size
  * or more with these constraints.
+ * @param[out] block the start of the allocation, which is what
+ * must be passed to PIOS_free()
  */
-static uint8_t * align8_alloc(uint32_t size)
+static uint8_t * align8_alloc(uint32_t size, uint8_t **block)
 {
 	// round size up to at nearest multiple of 8 + 4 bytes to guarantee
 	// sufficient size within. This is because PIOS_malloc only guarantees
 	// uintptr_t alignment which is 4 bytes.
 	size = size + sizeof(uintptr_t);
-	uint8_t *wap = PIOS_malloc(size);
+	uint8_t *wap = PIOS_malloc_tagged(size, PIOS_HEAP_TAG_THREAD);
+	*block = wap;
 
 	// shift start point to nearest 8 byte boundary.
 	uint32_t pad = ((uint32_t) wap) % sizeof(stkalign_t);
@@ -253,7 +256,7 @@ static uint8_t * align8_alloc(uint32_t size)
  */
 struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
 {
-	struct pios_thread *thread = PIOS_malloc_no_dma(sizeof(struct pios_thread));
+	struct pios_thread *thread = PIOS_malloc_no_dma_tagged(sizeof(struct pios_thread), PIOS_HEAP_TAG_THREAD);
 	if (thread == NULL)
 		return NULL;
 
@@ -265,7 +268,8 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 
 	// Use special functions to ensure ChibiOS stack requirements
 	stack_bytes = ceil_size(stack_bytes);
-	uint8_t *wap = align8_alloc(stack_bytes);
+	uint8_t *stack;
+	uint8_t *wap = align8_alloc(stack_bytes, &stack);
 	if (wap == NULL)
 	{
 		PIOS_free(thread);
@@ -276,7 +280,7 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 	if (thread->threadp == NULL)
 	{
 		PIOS_free(thread);
-		PIOS_free(wap);
+		PIOS_free(stack);
 		return NULL;
 	}
 
@@ -40,6 +40,10 @@ struct pios_flash_driver {
 	int32_t (*erase_sector)(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset);
 	int32_t (*write_data)(uintptr_t chip_id, uint32_t chip_offset, const uint8_t *data, uint16_t len);
 	int32_t (*read_data)(uintptr_t chip_id, uint32_t chip_offset, uint8_t *data, uint16_t len);
+
+	/* Optional: begin an erase without waiting for it.  Other operations wait until it is done. */
+	int32_t (*erase_sector_start)(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset);
+	int32_t (*busy)(uintptr_t chip_id);
 };
 
 /**
@@ -30,11 +30,34 @@
 
 #include <stdlib.h>		/* size_t */
 #include <stdbool.h>		/* bool */
+#include <stdint.h>		/* uint32_t */
+
+/**
+ * What an allocation is for, so that memory use can be broken down
+ */
+enum pios_heap_tag {
+	PIOS_HEAP_TAG_OTHER,
+	PIOS_HEAP_TAG_UAVO,
+	PIOS_HEAP_TAG_QUEUE,
+	PIOS_HEAP_TAG_THREAD,
+	PIOS_HEAP_TAG_SYNC,
+
+	PIOS_HEAP_TAG_NUM
+};
+
+struct pios_heap_tag_stats {
+	uint32_t used;		//!< Bytes held now, block headers included
+	uint32_t high_water;	//!< Most bytes ever held at once
+	uint16_t blocks;	//!< Allocations held now
+	uint16_t failures;	//!< Allocations that could not be satisfied
+};
 
 extern bool PIOS_heap_malloc_failed_p(void);
 
 extern void * PIOS_malloc_no_dma(size_t size);
 extern void * PIOS_malloc(size_t size);
+extern void * PIOS_malloc_no_dma_tagged(size_t size, enum pios_heap_tag tag);
+extern void * PIOS_malloc_tagged(size_t size, enum pios_heap_tag tag);
 
 extern void PIOS_free(void * buf);
 
@@ -42,5 +65,6 @@ extern size_t PIOS_heap_get_free_size(void);
 extern size_t PIOS_fastheap_get_free_size(void);
 extern void PIOS_heap_initialize_blocks(void);
 extern void PIOS_heap_increase_size(size_t bytes);
+extern bool PIOS_heap_get_tag_stats(enum pios_heap_tag tag, struct pios_heap_tag_stats *stats);
 
 #endif	/* PIOS_HEAP_H */
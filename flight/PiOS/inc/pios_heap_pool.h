@@ -0,0 +1,80 @@
+/**
+ ******************************************************************************
+ * @file       pios_heap_pool.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_HEAP Heap Allocation Abstraction
+ * @{
+ * @brief Size class allocator with free and per tag accounting
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_HEAP_POOL_H
+#define PIOS_HEAP_POOL_H
+
+#include <stdbool.h>		/* bool */
+#include <stddef.h>		/* size_t */
+#include <stdint.h>		/* uintptr_t */
+
+#include "pios_heap.h"		/* enum pios_heap_tag */
+
+/*
+ * Blocks up to PIOS_HEAP_POOL_SMALL_MAX bytes, header included, come in
+ * size classes PIOS_HEAP_POOL_GRANULE apart.  Each class keeps a list of
+ * freed blocks which is reused exactly, so the many small allocations that
+ * come and go cost no search and leave no slivers.  Larger blocks are
+ * placed first fit in an address ordered free list that merges neighbours,
+ * and anything still missing is cut from the untouched top of the region.
+ * Before giving up, the small lists are merged into the large one.
+ */
+#define PIOS_HEAP_POOL_ALIGN     sizeof(uintptr_t)
+#define PIOS_HEAP_POOL_GRANULE   (2 * PIOS_HEAP_POOL_ALIGN)
+#define PIOS_HEAP_POOL_SMALL_MAX (32 * PIOS_HEAP_POOL_GRANULE)
+#define PIOS_HEAP_POOL_CLASSES   (PIOS_HEAP_POOL_SMALL_MAX / PIOS_HEAP_POOL_GRANULE)
+
+struct pios_heap_pool_free;
+
+struct pios_heap_pool {
+	uintptr_t start_addr;
+	uintptr_t end_addr;
+	uintptr_t free_addr;	//!< Start of the untouched top
+
+	struct pios_heap_pool_free *small[PIOS_HEAP_POOL_CLASSES];
+	struct pios_heap_pool_free *large;
+
+	size_t free_bytes;	//!< In the free lists and the top
+	struct pios_heap_tag_stats *stats;
+};
+
+void pios_heap_pool_init(struct pios_heap_pool *pool, void *start, size_t size,
+		struct pios_heap_tag_stats *stats);
+void pios_heap_pool_extend(struct pios_heap_pool *pool, size_t bytes);
+
+void *pios_heap_pool_alloc(struct pios_heap_pool *pool, size_t size, enum pios_heap_tag tag);
+void pios_heap_pool_free(struct pios_heap_pool *pool, void *buf);
+
+bool pios_heap_pool_contains(const struct pios_heap_pool *pool, const void *buf);
+size_t pios_heap_pool_free_bytes(const struct pios_heap_pool *pool);
+size_t pios_heap_pool_largest_free(const struct pios_heap_pool *pool);
+
+#endif /* PIOS_HEAP_POOL_H */
+
+/**
+ * @}
+ * @}
+ */
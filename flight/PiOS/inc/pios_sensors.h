@@ -41,6 +41,7 @@ struct pios_sensor_gyro_data {
 	float y; 
 	float z;
 	float temperature;
+	uint32_t timestamp;	//!< PIOS_DELAY_GetRaw() when the sample was read
 };
 
 //! Pios sensor structure for generic accel data
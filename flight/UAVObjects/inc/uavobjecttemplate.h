@@ -40,7 +40,6 @@
 #define $(NAMEUC)_H
 
 #include "pios_queue.h"
-#include "uavoversion.h"
 
 $(PARENT_INCLUDES)
 
@@ -36,7 +36,7 @@
 
 #include "openpilot.h"
 #include "pios_struct_helper.h"
-#include "pios_heap.h"		/* PIOS_malloc_no_dma */
+#include "pios_heap.h"		/* PIOS_malloc_no_dma_tagged */
 #include "pios_mutex.h"
 #include "pios_queue.h"
 #include "misc_math.h"
@@ -127,6 +127,12 @@ struct UAVOData {
 struct UAVOSingle {
 	struct UAVOData   uavo;
 
+	/*
+	 * Sequence counter for lock-free reads, odd while a write is in
+	 * progress. Only maintained for data (not settings) objects.
+	 */
+	volatile uint16_t seq;
+
 	uint8_t           instance0[];
 	/* 
 	 * Additional space will be malloc'd here to hold the
@@ -172,11 +178,18 @@ struct UAVOMulti {
 #define InstanceDataOffset(inst) ((void*)&(( (struct UAVOMultiInst*)inst )->instance))
 #define InstanceData(instance) (void*)instance
 
+/** Lock-free read attempts before falling back to the mutex **/
+#define SEQLOCK_READ_RETRIES 3
+
 // Private functions
 static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			UAVObjEventType event, void *obj_data, int len);
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId);
 static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId);
+static struct UAVOSingle *getSeqObject(UAVObjHandle obj_handle, uint16_t instId);
+static void seqWriteBegin(struct UAVOSingle *obj);
+static void seqWriteEnd(struct UAVOSingle *obj);
+static bool seqRead(struct UAVOSingle *obj, void *dataOut, uint32_t offset, uint32_t size);
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask,
 			uint16_t interval);
@@ -220,7 +233,7 @@ int32_t UAVObjInitialize()
 	events_unused_throttled = NULL;
 
 	// Allocate the stack used for callbacks.
-	cb_stack = PIOS_malloc_no_dma(UAVO_CB_STACK_SIZE);
+	cb_stack = PIOS_malloc_no_dma_tagged(UAVO_CB_STACK_SIZE, PIOS_HEAP_TAG_UAVO);
 
 	PIOS_Assert(cb_stack);
 
@@ -285,7 +298,7 @@ static struct UAVOData * UAVObjAllocSingle(uint32_t num_bytes)
 	uint32_t object_size = sizeof(struct UAVOSingle) + num_bytes;
 
 	/* Allocate the object from the heap */
-	struct UAVOSingle * uavo_single = (struct UAVOSingle *) PIOS_malloc_no_dma(object_size);
+	struct UAVOSingle * uavo_single = (struct UAVOSingle *) PIOS_malloc_no_dma_tagged(object_size, PIOS_HEAP_TAG_UAVO);
 	if (!uavo_single)
 		return (NULL);
 
@@ -296,6 +309,7 @@ static struct UAVOData * UAVObjAllocSingle(uint32_t num_bytes)
 	uavo_base->next_event     = NULL;
 
 	/* Clear the instance data carried in the UAVO */
+	uavo_single->seq = 0;
 	memset(&(uavo_single->instance0), 0, num_bytes);
 
 	/* Give back the generic UAVO part */
@@ -308,7 +322,7 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 	uint32_t object_size = sizeof(struct UAVOMulti) + num_bytes;
 
 	/* Allocate the object from the heap */
-	struct UAVOMulti * uavo_multi = (struct UAVOMulti *) PIOS_malloc_no_dma(object_size);
+	struct UAVOMulti * uavo_multi = (struct UAVOMulti *) PIOS_malloc_no_dma_tagged(object_size, PIOS_HEAP_TAG_UAVO);
 	if (!uavo_multi)
 		return (NULL);
 
@@ -656,7 +670,11 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 		len = obj->instance_size;
 	}
 
+	struct UAVOSingle *seq_obj = getSeqObject(obj_handle, instId);
+
+	seqWriteBegin(seq_obj);
 	memcpy(target, dataIn, len);
+	seqWriteEnd(seq_obj);
 
 	// Fire event
 	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED,
@@ -1186,7 +1204,11 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 	}
 
 	// Set data
+	struct UAVOSingle *seq_obj = getSeqObject(obj_handle, instId);
+
+	seqWriteBegin(seq_obj);
 	memcpy(target + offset, dataIn, size);
+	seqWriteEnd(seq_obj);
 
 	// Fire event
 	sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED,
@@ -1210,6 +1232,13 @@ int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
+	// Data objects can usually be read without the lock
+	struct UAVOSingle *seq_obj = getSeqObject(obj_handle, instId);
+
+	if (seq_obj && seqRead(seq_obj, dataOut, 0, seq_obj->uavo.instance_size)) {
+		return 0;
+	}
+
 	// Lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
@@ -1256,6 +1285,14 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 {
 	PIOS_Assert(obj_handle);
 
+	// Data objects can usually be read without the lock
+	struct UAVOSingle *seq_obj = getSeqObject(obj_handle, instId);
+
+	if (seq_obj && (size + offset) <= seq_obj->uavo.instance_size &&
+			seqRead(seq_obj, dataOut, offset, size)) {
+		return 0;
+	}
+
 	// Lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
@@ -1497,6 +1534,77 @@ int8_t UAVObjReadOnly(UAVObjHandle obj_handle)
 	return -1;
 }
 
+/**
+ * Get the object if the instance is guarded by a sequence counter, or NULL
+ * if it is only protected by the mutex. Settings are excluded because they
+ * are also written by UAVObjLoad, which does not take the mutex.
+ */
+static struct UAVOSingle *getSeqObject(UAVObjHandle obj_handle, uint16_t instId)
+{
+	struct UAVOBase *base = (struct UAVOBase *) obj_handle;
+
+	if (instId != 0 || base->flags.isMeta || !base->flags.isSingle ||
+			base->flags.isSettings) {
+		return NULL;
+	}
+
+	return (struct UAVOSingle *) obj_handle;
+}
+
+/**
+ * Mark the start of a write. Writers must hold the mutex, so there is
+ * only ever one at a time.
+ */
+static void seqWriteBegin(struct UAVOSingle *obj)
+{
+	if (obj) {
+		obj->seq++;
+		__sync_synchronize();
+	}
+}
+
+/**
+ * Mark the end of a write
+ */
+static void seqWriteEnd(struct UAVOSingle *obj)
+{
+	if (obj) {
+		__sync_synchronize();
+		obj->seq++;
+	}
+}
+
+/**
+ * Copy data out of a single instance data object without the mutex.
+ *
+ * The copy is retried if a write happened during it. A write in
+ * progress when we start means the writer was preempted by us; spinning
+ * would never let it finish, so give up and let the caller block on the
+ * mutex instead, which the writer holds.
+ *
+ * @return true if dataOut holds a consistent copy
+ */
+static bool seqRead(struct UAVOSingle *obj, void *dataOut, uint32_t offset, uint32_t size)
+{
+	for (int i = 0; i < SEQLOCK_READ_RETRIES; i++) {
+		uint16_t start = obj->seq;
+
+		if (start & 1) {
+			return false;
+		}
+
+		__sync_synchronize();
+		memcpy(dataOut, obj->instance0 + offset, size);
+		__sync_synchronize();
+
+		if (obj->seq == start) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * Connect an event queue to the object, if the queue is already connected then the event mask is only updated.
  * All events matching the event mask will be pushed to the event queue.
@@ -1873,7 +1981,7 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 	}
 
 	/* Create the actual instance */
-	instEntry = (struct UAVOMultiInst *) PIOS_malloc_no_dma(sizeof(struct UAVOMultiInst)+obj->instance_size);
+	instEntry = (struct UAVOMultiInst *) PIOS_malloc_no_dma_tagged(sizeof(struct UAVOMultiInst)+obj->instance_size, PIOS_HEAP_TAG_UAVO);
 	if (!instEntry)
 		return NULL;
 	memset(InstanceDataOffset(instEntry), 0, obj->instance_size);
@@ -2004,7 +2112,7 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 		LL_DELETE(*unused, event);
 	}
 	else {
-		event =	(struct ObjectEventEntry *) PIOS_malloc_no_dma(mallocSize);
+		event =	(struct ObjectEventEntry *) PIOS_malloc_no_dma_tagged(mallocSize, PIOS_HEAP_TAG_UAVO);
 		if (event == NULL) {
 			PIOS_Recursive_Mutex_Unlock(mutex);
 			return -1;
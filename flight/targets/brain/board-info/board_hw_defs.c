@@ -228,6 +228,7 @@ const struct streamfs_cfg streamfs_settings = {
 	.fs_magic      = 0x89abceef,
 	.arena_size    = 0x00001000, /* 4 KB */
 	.write_size    = 0x00000100, /* 256 bytes */
+	.buffer_size   = 0x00001000, /* 4 KB */
 };
 
 #if defined(PIOS_INCLUDE_FLASH_JEDEC)
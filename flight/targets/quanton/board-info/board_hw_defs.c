@@ -720,6 +720,7 @@ const struct streamfs_cfg streamfs_settings = {
        .fs_magic      = 0x89abceef,
        .arena_size    = 0x00001000, /* 64 KB */
        .write_size    = 0x00000100, /* 256 bytes */
+       .buffer_size   = 0x00001000, /* 4 KB */
 };
 
 #endif	/* PIOS_INCLUDE_FLASH */
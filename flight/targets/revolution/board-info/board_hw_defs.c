@@ -643,6 +643,7 @@ const struct streamfs_cfg streamfs_settings = {
 	.fs_magic      = 0x89abceef,
 	.arena_size    = 0x00010000, /* 64 KB */
 	.write_size    = 0x00000100, /* 256 bytes */
+	.buffer_size   = 0x00001000, /* 4 KB */
 };
 
 const struct pios_flash_partition * PIOS_BOARD_HW_DEFS_GetPartitionTable (uint32_t board_revision, uint32_t * num_partitions)
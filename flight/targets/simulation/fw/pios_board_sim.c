@@ -34,6 +34,7 @@
 #include <pios_com_priv.h>
 #include <pios_tcp_priv.h>
 #include <pios_udp_priv.h>
+#include <pios_sim_sensors_priv.h>
 #include <openpilot.h>
 #include <uavobjectsinit.h>
 
@@ -83,6 +84,13 @@ const struct pios_tcp_cfg pios_tcp_aux_cfg = {
 };
 #endif
 
+#if defined(PIOS_INCLUDE_SIM_SENSORS)
+const struct pios_sim_sensors_cfg pios_sim_sensors_cfg = {
+	.ip = "0.0.0.0",
+	.port = 9004,
+};
+#endif
+
 #define PIOS_COM_TELEM_RF_RX_BUF_LEN 384
 #define PIOS_COM_TELEM_RF_TX_BUF_LEN 384
 #define PIOS_COM_GPS_RX_BUF_LEN 96
@@ -232,6 +240,11 @@ void PIOS_Board_Init(void) {
 	pios_rcvr_group_map[MANUALCONTROLSETTINGS_CHANNELGROUPS_GCS] = pios_gcsrcvr_rcvr_id;
 #endif	/* PIOS_INCLUDE_GCSRCVR */
 
+#if defined(PIOS_INCLUDE_SIM_SENSORS)
+	if (PIOS_SIM_SENSORS_Init(&pios_sim_sensors_cfg)) {
+		PIOS_Assert(0);
+	}
+#else
 	// Register fake address.  Later if we really fake entire sensors then
 	// it will make sense to have real queues registered.  For now if these
 	// queues are used a crash is appropriate.
@@ -239,6 +252,7 @@ void PIOS_Board_Init(void) {
 	PIOS_SENSORS_Register(PIOS_SENSOR_GYRO, (struct pios_queue*)1);
 	PIOS_SENSORS_Register(PIOS_SENSOR_MAG, (struct pios_queue*)1);
 	PIOS_SENSORS_Register(PIOS_SENSOR_BARO, (struct pios_queue*)1);
+#endif /* PIOS_INCLUDE_SIM_SENSORS */
 
 	printf("Completed PIOS_Board_Init\n");
 }
@@ -45,6 +45,7 @@
 #define PIOS_INCLUDE_TCP
 #define PIOS_INCLUDE_UDP
 #define PIOS_INCLUDE_SERVO
+#define PIOS_INCLUDE_SIM
 #define PIOS_INCLUDE_RCVR
 #define PIOS_INCLUDE_GCSRCVR
 #define PIOS_INCLUDE_IAP
@@ -0,0 +1,281 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* sinf */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "biquad.h"
+
+// arm_math.h is not clean under -Wextra when compiled as C++
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#include "notch_tracker.h"
+#pragma GCC diagnostic pop
+
+}
+
+#define SAMPLE_RATE 1000.0f
+#define BENCHMARK_SAMPLES 1000000
+#define BENCHMARK_WINDOWS 20000
+
+// Deterministic noise in [-1, 1]
+static float noise(uint32_t *state)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return (int32_t) *state / 2147483648.0f;
+}
+
+static float tone(float freq, int i)
+{
+  return sinf(2 * (float) M_PI * freq * i / SAMPLE_RATE);
+}
+
+// Filters a sine and returns the output amplitude once settled
+static float measured_gain(struct biquad *bq, float freq)
+{
+  const int settle = 2000, measure = 2000;
+  float peak = 0;
+
+  biquad_reset(bq, 0);
+  for (int i = 0; i < settle + measure; i++) {
+    float y = biquad_apply(bq, tone(freq, i));
+    if (i >= settle)
+      peak = fmaxf(peak, fabsf(y));
+  }
+
+  return peak;
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class Biquad : public testing::Test {
+protected:
+  struct biquad bq;
+};
+
+TEST_F(Biquad, LowpassMagnitude) {
+  ASSERT_TRUE(biquad_set_lowpass(&bq, SAMPLE_RATE, 100, BIQUAD_Q_BUTTERWORTH));
+
+  EXPECT_NEAR(1.0f, biquad_magnitude(&bq, SAMPLE_RATE, 0.1f), 1e-4f);
+  EXPECT_NEAR(M_SQRT1_2, biquad_magnitude(&bq, SAMPLE_RATE, 100), 1e-3f);
+
+  // Second order: roughly 12 dB per octave past the cutoff
+  EXPECT_LT(biquad_magnitude(&bq, SAMPLE_RATE, 200), 0.25f);
+  EXPECT_LT(biquad_magnitude(&bq, SAMPLE_RATE, 400), 0.03f);
+}
+
+TEST_F(Biquad, NotchMagnitude) {
+  const float center = 200, q = 3;
+  ASSERT_TRUE(biquad_set_notch(&bq, SAMPLE_RATE, center, q));
+
+  EXPECT_LT(biquad_magnitude(&bq, SAMPLE_RATE, center), 1e-3f);
+  EXPECT_NEAR(1.0f, biquad_magnitude(&bq, SAMPLE_RATE, 0.1f), 1e-4f);
+  EXPECT_NEAR(1.0f, biquad_magnitude(&bq, SAMPLE_RATE, 499), 1e-3f);
+
+  // The -3 dB points are center / q apart
+  float lo = center, hi = center;
+  while (biquad_magnitude(&bq, SAMPLE_RATE, lo) < M_SQRT1_2)
+    lo -= 0.1f;
+  while (biquad_magnitude(&bq, SAMPLE_RATE, hi) < M_SQRT1_2)
+    hi += 0.1f;
+
+  EXPECT_NEAR(center / q, hi - lo, 0.5f);
+}
+
+TEST_F(Biquad, FilteringMatchesResponse) {
+  const float freqs[] = { 10, 60, 100, 150, 190, 230, 300, 450 };
+
+  biquad_set_lowpass(&bq, SAMPLE_RATE, 100, BIQUAD_Q_BUTTERWORTH);
+  for (float f : freqs)
+    EXPECT_NEAR(biquad_magnitude(&bq, SAMPLE_RATE, f), measured_gain(&bq, f), 0.01f) << f << " Hz";
+
+  biquad_set_notch(&bq, SAMPLE_RATE, 200, 3);
+  for (float f : freqs)
+    EXPECT_NEAR(biquad_magnitude(&bq, SAMPLE_RATE, f), measured_gain(&bq, f), 0.01f) << f << " Hz";
+}
+
+TEST_F(Biquad, InvalidIsPassthrough) {
+  EXPECT_FALSE(biquad_set_lowpass(&bq, SAMPLE_RATE, SAMPLE_RATE / 2, BIQUAD_Q_BUTTERWORTH));
+  biquad_reset(&bq, 0);
+  EXPECT_EQ(3.5f, biquad_apply(&bq, 3.5f));
+
+  EXPECT_FALSE(biquad_set_notch(&bq, SAMPLE_RATE, 0, 3));
+  EXPECT_EQ(-2.0f, biquad_apply(&bq, -2.0f));
+
+  EXPECT_FALSE(biquad_set_notch(&bq, SAMPLE_RATE, 100, 0));
+  EXPECT_EQ(1.0f, biquad_apply(&bq, 1.0f));
+}
+
+TEST_F(Biquad, ResetToSteadyState) {
+  biquad_set_lowpass(&bq, SAMPLE_RATE, 50, BIQUAD_Q_BUTTERWORTH);
+  biquad_reset(&bq, 42);
+
+  for (int i = 0; i < 100; i++)
+    ASSERT_NEAR(42.0f, biquad_apply(&bq, 42), 1e-3f);
+
+  biquad_set_notch(&bq, SAMPLE_RATE, 150, 2);
+  biquad_reset(&bq, -7);
+
+  for (int i = 0; i < 100; i++)
+    ASSERT_NEAR(-7.0f, biquad_apply(&bq, -7), 1e-3f);
+}
+
+class NotchTracker : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, notch_tracker_init(&tracker, 80, 450, 250));
+  }
+
+  // Feeds windows of a signal and returns the final center estimate
+  float track(float freq, float amplitude, float noise_amplitude, int windows) {
+    uint32_t seed = 1;
+    int i = 0;
+
+    for (int w = 0; w < windows; w++) {
+      while (!notch_tracker_push(&tracker, 20 + 30 * tone(3, i) +
+            amplitude * tone(freq, i) + noise_amplitude * noise(&seed)))
+        i++;
+      i++;
+
+      notch_tracker_update(&tracker, SAMPLE_RATE);
+    }
+
+    return tracker.center;
+  }
+
+  struct notch_tracker tracker;
+};
+
+TEST_F(NotchTracker, FindsTone) {
+  // Off bin centers on purpose; bins are 15.6 Hz wide
+  EXPECT_NEAR(137.0f, track(137, 5, 1, 20), 4.0f);
+  EXPECT_NEAR(305.0f, track(305, 5, 1, 20), 4.0f);
+}
+
+TEST_F(NotchTracker, IgnoresNoise) {
+  EXPECT_EQ(250.0f, track(0, 0, 5, 20));
+}
+
+TEST_F(NotchTracker, StaysInBand) {
+  // Stronger than anything in band, but below the lowest tracked frequency
+  float center = track(40, 20, 0.5f, 20);
+  EXPECT_GE(center, 80.0f);
+  EXPECT_LE(center, 450.0f);
+
+  notch_tracker_init(&tracker, 80, 300, 250);
+  EXPECT_LE(track(400, 5, 0.5f, 20), 300.0f);
+}
+
+TEST_F(NotchTracker, DynamicNotchRemovesVibration) {
+  const float vibration = 220, q = 3;
+  struct biquad notch;
+  uint32_t seed = 1;
+
+  biquad_set_notch(&notch, SAMPLE_RATE, tracker.center, q);
+  biquad_reset(&notch, 0);
+
+  float in_power = 0, out_power = 0;
+  const int total = 40 * NOTCH_TRACKER_FFT_SIZE;
+  const int measured = 8 * NOTCH_TRACKER_FFT_SIZE;
+
+  for (int i = 0; i < total; i++) {
+    float x = 8 * tone(vibration, i) + 0.2f * noise(&seed);
+
+    if (notch_tracker_push(&tracker, x)) {
+      float center = notch_tracker_update(&tracker, SAMPLE_RATE);
+      biquad_set_notch(&notch, SAMPLE_RATE, center, q);
+    }
+
+    float y = biquad_apply(&notch, x);
+
+    if (i >= total - measured) {
+      in_power += x * x;
+      out_power += y * y;
+    }
+  }
+
+  // At least 20 dB of the vibration is gone once tracking settles
+  EXPECT_LT(out_power, in_power / 100);
+}
+
+// Not a pass/fail test: reports the cost of filtering three gyro axes
+TEST_F(Biquad, BenchmarkFilter) {
+  struct biquad lp[3], notch[3];
+  float x[3] = { 0, 0, 0 }, sum = 0;
+  struct timespec start, end;
+
+  for (int j = 0; j < 3; j++) {
+    biquad_set_lowpass(&lp[j], SAMPLE_RATE, 90, BIQUAD_Q_BUTTERWORTH);
+    biquad_set_notch(&notch[j], SAMPLE_RATE, 200, 3);
+    biquad_reset(&lp[j], 0);
+    biquad_reset(&notch[j], 0);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < BENCHMARK_SAMPLES; i++) {
+    for (int j = 0; j < 3; j++) {
+      x[j] = biquad_apply(&notch[j], biquad_apply(&lp[j], (i & 0xff) - x[j] * 0.5f));
+      sum += x[j];
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  printf("Low pass + notch, 3 axes: %.1f ns per sample (%g)\n",
+      elapsed_ns(&start, &end) / BENCHMARK_SAMPLES, sum);
+}
+
+TEST_F(NotchTracker, BenchmarkUpdate) {
+  struct timespec start, end;
+  uint32_t seed = 1;
+  float sum = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int w = 0; w < BENCHMARK_WINDOWS; w++) {
+    while (!notch_tracker_push(&tracker, noise(&seed)));
+    sum += notch_tracker_update(&tracker, SAMPLE_RATE);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  printf("Tracker FFT of %d samples: %.2f us per window (%g)\n",
+      NOTCH_TRACKER_FFT_SIZE, elapsed_ns(&start, &end) / 1e3 / BENCHMARK_WINDOWS, sum);
+}
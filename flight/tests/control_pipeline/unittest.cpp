@@ -0,0 +1,209 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the gyro to actuator hand-off
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <pthread.h>		/* pthread_create */
+
+extern "C" {
+#include "control_pipeline.h"
+#include "pios_semaphore.h"
+
+/* Binary semaphores that never block; a failed take is a timeout */
+static struct pios_semaphore semaphores[2];
+static bool given[2];
+static int num_semaphores;
+
+struct pios_semaphore *PIOS_Semaphore_Create(void)
+{
+	return &semaphores[num_semaphores++];
+}
+
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+{
+	(void) timeout_ms;
+
+	return __sync_lock_test_and_set(&given[sema - semaphores], false);
+}
+
+bool PIOS_Semaphore_Give(struct pios_semaphore *sema)
+{
+	given[sema - semaphores] = true;
+	return true;
+}
+}
+
+static void publish_gyro(uint32_t seq)
+{
+	struct control_pipeline_gyro *sample = control_pipeline_gyro_claim();
+
+	sample->x = seq;
+	sample->y = seq;
+	sample->z = seq;
+	sample->temperature = seq;
+	sample->timestamp = seq;
+
+	control_pipeline_gyro_publish();
+}
+
+static bool gyro_consistent(const struct control_pipeline_gyro *sample)
+{
+	return sample->x == sample->timestamp && sample->y == sample->timestamp
+		&& sample->z == sample->timestamp
+		&& sample->temperature == sample->timestamp;
+}
+
+class ControlPipeline : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, control_pipeline_initialize());
+    control_pipeline_set_direct(false);
+  }
+};
+
+TEST_F(ControlPipeline, LatestIsLastPublished) {
+  for (uint32_t seq = 1; seq < 10; seq++) {
+    publish_gyro(seq);
+    EXPECT_EQ(seq, control_pipeline_gyro_latest()->timestamp);
+  }
+
+  EXPECT_TRUE(control_pipeline_has_gyro());
+};
+
+TEST_F(ControlPipeline, HeldSlotIsNeverFilled) {
+  publish_gyro(100);
+
+  const struct control_pipeline_gyro *held = control_pipeline_gyro_latest();
+
+  // However often the writer goes round, it leaves the reader's slot alone
+  for (uint32_t seq = 101; seq < 200; seq++) {
+    EXPECT_NE(held, control_pipeline_gyro_claim());
+    publish_gyro(seq);
+    EXPECT_EQ(100U, held->timestamp);
+  }
+
+  EXPECT_EQ(199U, control_pipeline_gyro_latest()->timestamp);
+};
+
+TEST_F(ControlPipeline, ActuatorCommandCarriesTimestamp) {
+  struct control_pipeline_actuator *command = control_pipeline_actuator_claim();
+  command->desired.Thrust = 0.5f;
+  command->timestamp = 1234;
+  control_pipeline_actuator_publish();
+
+  const struct control_pipeline_actuator *latest = control_pipeline_actuator_latest();
+  EXPECT_EQ(1234U, latest->timestamp);
+  EXPECT_EQ(0.5f, latest->desired.Thrust);
+
+  // The held command survives two more publishes, which a double buffer
+  // would have overwritten
+  for (int i = 0; i < 2; i++) {
+    command = control_pipeline_actuator_claim();
+    EXPECT_NE(latest, command);
+    command->timestamp = 0;
+    control_pipeline_actuator_publish();
+  }
+
+  EXPECT_EQ(1234U, latest->timestamp);
+};
+
+TEST_F(ControlPipeline, DirectModeWakesReader) {
+  // Nothing published in queued mode wakes the reader
+  publish_gyro(300);
+  EXPECT_EQ(NULL, control_pipeline_gyro_wait(0));
+
+  control_pipeline_set_direct(true);
+
+  publish_gyro(301);
+  const struct control_pipeline_gyro *sample = control_pipeline_gyro_wait(0);
+  ASSERT_TRUE(sample != NULL);
+  EXPECT_EQ(301U, sample->timestamp);
+
+  EXPECT_EQ(NULL, control_pipeline_gyro_wait(0));
+};
+
+#define STRESS_SAMPLES 2000000
+
+static volatile bool writer_done;
+
+static void *gyro_writer(void *arg)
+{
+  (void) arg;
+
+  for (uint32_t seq = 1000; seq < 1000 + STRESS_SAMPLES; seq++)
+    publish_gyro(seq);
+
+  writer_done = true;
+
+  return NULL;
+}
+
+TEST_F(ControlPipeline, ConcurrentWriterNeverTearsHeldSample) {
+  pthread_t writer;
+  uint32_t torn = 0, changed = 0, went_back = 0, reads = 0;
+  uint32_t last = 0;
+
+  publish_gyro(999);
+  writer_done = false;
+
+  ASSERT_EQ(0, pthread_create(&writer, NULL, gyro_writer, NULL));
+
+  while (!writer_done) {
+    const struct control_pipeline_gyro *sample = control_pipeline_gyro_latest();
+    uint32_t seq = sample->timestamp;
+
+    // Keep looking at the held sample while the writer runs on
+    for (int i = 0; i < 16; i++) {
+      if (!gyro_consistent(sample))
+        torn++;
+      if (sample->timestamp != seq)
+        changed++;
+    }
+
+    if (seq < last)
+      went_back++;
+    last = seq;
+    reads++;
+  }
+
+  pthread_join(writer, NULL);
+
+  printf("%u reads while %u samples were published\n", reads, STRESS_SAMPLES);
+
+  EXPECT_EQ(0U, torn);
+  EXPECT_EQ(0U, changed);
+  EXPECT_EQ(0U, went_back);
+  EXPECT_EQ(1000U + STRESS_SAMPLES - 1, control_pipeline_gyro_latest()->timestamp);
+};
@@ -0,0 +1,252 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the size class heap allocator
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memset */
+
+extern "C" {
+#include "pios_heap_pool.h"
+}
+
+#define ARENA_SIZE (64 * 1024)
+
+class HeapPool : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(stats, 0, sizeof(stats));
+    pios_heap_pool_init(&pool, arena, sizeof(arena), stats);
+  }
+
+  uint32_t total_used() {
+    uint32_t used = 0;
+    for (int i = 0; i < PIOS_HEAP_TAG_NUM; i++)
+      used += stats[i].used;
+    return used;
+  }
+
+  uintptr_t arena[ARENA_SIZE / sizeof(uintptr_t)];
+  struct pios_heap_pool pool;
+  struct pios_heap_tag_stats stats[PIOS_HEAP_TAG_NUM];
+};
+
+TEST_F(HeapPool, AlignedAndAccounted) {
+  for (size_t size = 0; size < 300; size++) {
+    void *p = pios_heap_pool_alloc(&pool, size, PIOS_HEAP_TAG_QUEUE);
+    ASSERT_NE((void *) NULL, p);
+    EXPECT_EQ(0U, (uintptr_t) p % PIOS_HEAP_POOL_ALIGN);
+  }
+
+  EXPECT_EQ(300, stats[PIOS_HEAP_TAG_QUEUE].blocks);
+  EXPECT_EQ(0U, stats[PIOS_HEAP_TAG_OTHER].used);
+  EXPECT_EQ(ARENA_SIZE - stats[PIOS_HEAP_TAG_QUEUE].used,
+      pios_heap_pool_free_bytes(&pool));
+  EXPECT_EQ(stats[PIOS_HEAP_TAG_QUEUE].used, stats[PIOS_HEAP_TAG_QUEUE].high_water);
+}
+
+TEST_F(HeapPool, SmallBlocksReused) {
+  void *a = pios_heap_pool_alloc(&pool, 20, PIOS_HEAP_TAG_SYNC);
+  void *b = pios_heap_pool_alloc(&pool, 20, PIOS_HEAP_TAG_SYNC);
+  void *c = pios_heap_pool_alloc(&pool, 100, PIOS_HEAP_TAG_SYNC);
+  ASSERT_NE((void *) NULL, c);
+
+  // a is buried, so it goes to its size class rather than the top
+  pios_heap_pool_free(&pool, a);
+  EXPECT_EQ(a, pios_heap_pool_alloc(&pool, 18, PIOS_HEAP_TAG_UAVO));
+
+  // Other classes do not take it
+  pios_heap_pool_free(&pool, b);
+  void *d = pios_heap_pool_alloc(&pool, 60, PIOS_HEAP_TAG_UAVO);
+  EXPECT_NE(b, d);
+  EXPECT_EQ(b, pios_heap_pool_alloc(&pool, 20, PIOS_HEAP_TAG_UAVO));
+}
+
+TEST_F(HeapPool, LargeBlocksMergeAndReturnToTop) {
+  void *a = pios_heap_pool_alloc(&pool, 1000, PIOS_HEAP_TAG_THREAD);
+  void *b = pios_heap_pool_alloc(&pool, 1000, PIOS_HEAP_TAG_THREAD);
+  void *c = pios_heap_pool_alloc(&pool, 1000, PIOS_HEAP_TAG_THREAD);
+  void *d = pios_heap_pool_alloc(&pool, 1000, PIOS_HEAP_TAG_THREAD);
+  ASSERT_NE((void *) NULL, d);
+
+  // a and b merge, so something bigger than either fits where they were
+  pios_heap_pool_free(&pool, b);
+  pios_heap_pool_free(&pool, a);
+  void *e = pios_heap_pool_alloc(&pool, 1800, PIOS_HEAP_TAG_THREAD);
+  EXPECT_EQ(a, e);
+
+  // Freeing from the top down gives everything back
+  pios_heap_pool_free(&pool, d);
+  pios_heap_pool_free(&pool, c);
+  pios_heap_pool_free(&pool, e);
+
+  EXPECT_EQ((size_t) ARENA_SIZE, pios_heap_pool_free_bytes(&pool));
+  EXPECT_EQ((size_t) ARENA_SIZE, pios_heap_pool_largest_free(&pool));
+  EXPECT_EQ(0U, stats[PIOS_HEAP_TAG_THREAD].used);
+  EXPECT_EQ(0, stats[PIOS_HEAP_TAG_THREAD].blocks);
+}
+
+TEST_F(HeapPool, BadFreesIgnored) {
+  void *a = pios_heap_pool_alloc(&pool, 40, PIOS_HEAP_TAG_OTHER);
+  void *b = pios_heap_pool_alloc(&pool, 40, PIOS_HEAP_TAG_OTHER);
+  ASSERT_NE((void *) NULL, b);
+  size_t free_bytes = pios_heap_pool_free_bytes(&pool);
+
+  int outside;
+  pios_heap_pool_free(&pool, &outside);
+  pios_heap_pool_free(&pool, NULL);
+  EXPECT_EQ(free_bytes, pios_heap_pool_free_bytes(&pool));
+
+  pios_heap_pool_free(&pool, a);
+  pios_heap_pool_free(&pool, a);
+  EXPECT_EQ(1, stats[PIOS_HEAP_TAG_OTHER].blocks);
+}
+
+TEST_F(HeapPool, TooBigFails) {
+  EXPECT_EQ((void *) NULL, pios_heap_pool_alloc(&pool, ARENA_SIZE, PIOS_HEAP_TAG_OTHER));
+  EXPECT_EQ((size_t) ARENA_SIZE, pios_heap_pool_free_bytes(&pool));
+
+  pios_heap_pool_extend(&pool, 1024);
+  EXPECT_EQ((size_t) ARENA_SIZE + 1024, pios_heap_pool_free_bytes(&pool));
+}
+
+/*
+ * Churn through a mix shaped like the firmware's, mostly small objects with
+ * some buffers and stacks, keeping up to half the arena in use.  A bump
+ * allocator runs out after about one pass over the arena.
+ */
+TEST_F(HeapPool, FragmentationStress) {
+  const int slots = 256;
+  const uint32_t live_limit = ARENA_SIZE / 2;
+  const int iterations = 200000;
+
+  struct {
+    uint8_t *p;
+    size_t size;
+    enum pios_heap_tag tag;
+  } live[slots];
+  memset(live, 0, sizeof(live));
+
+  uint32_t rng = 12345;
+  uint32_t requested = 0;
+  uintptr_t max_top = 0;
+  int allocations = 0;
+  int failures = 0;
+
+  for (int i = 0; i < iterations; i++) {
+    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+    int slot = rng % slots;
+
+    if (live[slot].p) {
+      // Nothing may have written over it
+      for (size_t j = 0; j < live[slot].size; j++) {
+        ASSERT_EQ((uint8_t) (slot + j), live[slot].p[j]);
+      }
+
+      pios_heap_pool_free(&pool, live[slot].p);
+      requested -= live[slot].size;
+      live[slot].p = NULL;
+      continue;
+    }
+
+    size_t size;
+    uint32_t kind = (rng >> 8) % 100;
+    if (kind < 80) {
+      size = 4 + (rng >> 12) % 120;
+    } else if (kind < 97) {
+      size = 200 + (rng >> 12) % 800;
+    } else {
+      size = 1024 + (rng >> 12) % 1024;
+    }
+
+    if (requested + size > live_limit) {
+      continue;
+    }
+
+    enum pios_heap_tag tag = (enum pios_heap_tag) ((rng >> 20) % PIOS_HEAP_TAG_NUM);
+    uint8_t *p = (uint8_t *) pios_heap_pool_alloc(&pool, size, tag);
+    allocations++;
+    if (!p) {
+      failures++;
+      continue;
+    }
+
+    for (size_t j = 0; j < size; j++) {
+      p[j] = slot + j;
+    }
+
+    live[slot].p = p;
+    live[slot].size = size;
+    live[slot].tag = tag;
+    requested += size;
+
+    if (pool.free_addr > max_top) {
+      max_top = pool.free_addr;
+    }
+
+    ASSERT_EQ(ARENA_SIZE - total_used(), pios_heap_pool_free_bytes(&pool));
+  }
+
+  printf("Top of heap reached %u of %u bytes, %d of %d allocations failed\n",
+      (unsigned) (max_top - pool.start_addr), ARENA_SIZE, failures, allocations);
+
+  // Random lifetimes at half full occasionally leave no hole big enough for
+  // a stack sized block, but only very rarely
+  EXPECT_LE(failures * 10000, allocations);
+
+  uint32_t high_water = 0;
+  for (int i = 0; i < PIOS_HEAP_TAG_NUM; i++) {
+    EXPECT_GE(stats[i].high_water, stats[i].used);
+    high_water += stats[i].high_water;
+  }
+  EXPECT_GT(high_water, 0U);
+
+  for (int i = 0; i < slots; i++) {
+    pios_heap_pool_free(&pool, live[i].p);
+  }
+
+  // Every byte comes back
+  EXPECT_EQ(0U, total_used());
+  EXPECT_EQ((size_t) ARENA_SIZE, pios_heap_pool_free_bytes(&pool));
+
+  // and once the small blocks are merged it is all in one piece again
+  void *all = pios_heap_pool_alloc(&pool, ARENA_SIZE - PIOS_HEAP_POOL_GRANULE, PIOS_HEAP_TAG_OTHER);
+  EXPECT_EQ((void *) pool.start_addr, (uint8_t *) all - PIOS_HEAP_POOL_ALIGN);
+  EXPECT_EQ((void *) NULL, pool.large);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,175 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <pthread.h>		/* pthread_create */
+
+extern "C" {
+
+#include "insgps.h"		/* API for the INSGPS filter */
+
+}
+
+#define NUM_STEPS   500
+#define NUM_THREADS 8
+
+// Runs the filter with a slow rotation scaled by rate, and returns the
+// resulting attitude and gyro bias. A NULL instance runs the filter the
+// flight code uses.
+static void run_filter(struct insgps_instance *ins, float rate, float q[4], float gyro_bias[3])
+{
+  const float zeros[3] = {0, 0, 0};
+  const float accels[3] = {0, 0, -9.81f};
+  const float mag[3] = {1, 0, 0};
+  const float gyros[3] = {0.1f * rate, -0.05f * rate, 0.2f * rate};
+
+  if (ins == NULL) {
+    INSGPSInit();
+
+    for (int i = 0; i < NUM_STEPS; i++) {
+      INSStatePrediction(gyros, accels, 0.002f);
+      INSCovariancePrediction(0.002f);
+      if ((i % 10) == 0)
+        INSCorrection(mag, zeros, zeros, 0, MAG_SENSORS | BARO_SENSOR);
+    }
+
+    INSGetState(NULL, NULL, q, gyro_bias, NULL);
+    return;
+  }
+
+  insgps_init(ins);
+
+  for (int i = 0; i < NUM_STEPS; i++) {
+    insgps_state_prediction(ins, gyros, accels, 0.002f);
+    insgps_covariance_prediction(ins, 0.002f);
+    if ((i % 10) == 0)
+      insgps_correction(ins, mag, zeros, zeros, 0, MAG_SENSORS | BARO_SENSOR);
+  }
+
+  insgps_get_state(ins, NULL, NULL, q, gyro_bias, NULL);
+}
+
+static struct insgps_instance *instance_alloc()
+{
+  return (struct insgps_instance *) malloc(INSGetInstanceSize());
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class InsgpsInstance : public testing::Test {
+};
+
+TEST_F(InsgpsInstance, InstancesAreIndependent) {
+  float q_ref[4], bias_ref[3];
+  run_filter(NULL, 1.0f, q_ref, bias_ref);
+
+  struct insgps_instance *a = instance_alloc();
+  struct insgps_instance *b = instance_alloc();
+  ASSERT_TRUE(a != NULL);
+  ASSERT_TRUE(b != NULL);
+
+  float q_a[4], bias_a[3];
+  float q_b[4], bias_b[3];
+
+  run_filter(a, 1.0f, q_a, bias_a);
+  run_filter(b, -1.0f, q_b, bias_b);
+
+  // Running a second filter must not disturb the first one
+  float q_a2[4];
+  insgps_get_state(a, NULL, NULL, q_a2, NULL, NULL);
+
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(q_ref[i], q_a[i]);
+    EXPECT_EQ(q_a[i], q_a2[i]);
+  }
+  for (int i = 0; i < 3; i++)
+    EXPECT_EQ(bias_ref[i], bias_a[i]);
+
+  // The opposite rotation leaves the second filter elsewhere
+  EXPECT_NE(q_a[1], q_b[1]);
+  EXPECT_NE(q_a[3], q_b[3]);
+
+  // The flight code's filter is untouched by the other two
+  float q_def[4];
+  INSGetState(NULL, NULL, q_def, NULL, NULL);
+  for (int i = 0; i < 4; i++)
+    EXPECT_EQ(q_ref[i], q_def[i]);
+
+  free(a);
+  free(b);
+}
+
+struct thread_result {
+  float rate;
+  float q[4];
+  float gyro_bias[3];
+};
+
+static void *filter_thread(void *ctx)
+{
+  struct thread_result *result = (struct thread_result *) ctx;
+  struct insgps_instance *ins = instance_alloc();
+
+  run_filter(ins, result->rate, result->q, result->gyro_bias);
+
+  free(ins);
+  return NULL;
+}
+
+TEST_F(InsgpsInstance, ConcurrentThreads) {
+  float q_ref[2][4], bias_ref[2][3];
+  run_filter(NULL, 1.0f, q_ref[0], bias_ref[0]);
+  run_filter(NULL, -1.0f, q_ref[1], bias_ref[1]);
+
+  pthread_t threads[NUM_THREADS];
+  struct thread_result results[NUM_THREADS];
+
+  for (int i = 0; i < NUM_THREADS; i++) {
+    results[i].rate = (i & 1) ? -1.0f : 1.0f;
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, filter_thread, &results[i]));
+  }
+
+  for (int i = 0; i < NUM_THREADS; i++)
+    pthread_join(threads[i], NULL);
+
+  for (int i = 0; i < NUM_THREADS; i++) {
+    for (int j = 0; j < 4; j++)
+      EXPECT_EQ(q_ref[i & 1][j], results[i].q[j]);
+    for (int j = 0; j < 3; j++)
+      EXPECT_EQ(bias_ref[i & 1][j], results[i].gyro_bias[j]);
+  }
+}
@@ -0,0 +1,6 @@
+/* Only what pios_crc.c and the log encoder need */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <pios_crc.h>
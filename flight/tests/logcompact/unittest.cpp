@@ -0,0 +1,518 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the compact log encoding
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memset */
+#include <math.h>		/* sinf */
+
+#include <vector>
+#include <map>
+
+extern "C" {
+#include "logcompact.h"
+#include "pios_crc.h"
+}
+
+static std::vector<uint8_t> stream;
+
+static int32_t capture(uint8_t *data, int32_t length)
+{
+  stream.insert(stream.end(), data, data + length);
+  return length;
+}
+
+static int32_t fail_output(uint8_t *, int32_t)
+{
+  return -1;
+}
+
+struct sample {
+  uint32_t obj_id;
+  uint16_t inst_id;
+  uint32_t time;
+  std::vector<uint8_t> data;
+
+  bool operator==(const sample &o) const {
+    return obj_id == o.obj_id && inst_id == o.inst_id && time == o.time && data == o.data;
+  }
+};
+
+/*
+ * Decoder written from the format description rather than the encoder, the
+ * way the GCS and python tools read it.
+ */
+class Decoder {
+public:
+  std::vector<sample> samples;
+  int resyncs;
+
+  Decoder() : resyncs(0) {}
+
+  bool decode(const std::vector<uint8_t> &in) {
+    if (in.size() < 5 || memcmp(&in[0], LOGCOMPACT_MAGIC, 4) || in[4] != LOGCOMPACT_VERSION)
+      return false;
+
+    size_t pos = 5;
+    bool synced = true;
+    uint32_t time = 0;
+
+    while (pos < in.size()) {
+      size_t next = record(in, pos, synced, time);
+      if (next) {
+        pos = next;
+        synced = true;
+      } else {
+        if (synced) {
+          resyncs++;
+          for (auto &t : tracks)
+            t.second.valid = false;
+        }
+        synced = false;
+        pos++;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  struct track {
+    uint32_t obj_id;
+    uint16_t inst_id;
+    uint16_t length;
+    bool valid;
+    std::vector<uint8_t> last;
+  };
+  std::map<int, track> tracks;
+
+  static uint32_t u16(const uint8_t *p) { return p[0] | p[1] << 8; }
+  static uint32_t u32(const uint8_t *p) { return u16(p) | u16(p + 2) << 16; }
+
+  static bool varint(const std::vector<uint8_t> &in, size_t &pos, uint32_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      if (pos >= in.size())
+        return false;
+      uint8_t b = in[pos++];
+      v |= (uint32_t) (b & 0x7f) << shift;
+      if (!(b & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  static bool crc_ok(const std::vector<uint8_t> &in, size_t pos, size_t len) {
+    return pos + len < in.size() &&
+      PIOS_CRC_updateCRC(0, &in[pos], len) == in[pos + len];
+  }
+
+  /* Returns where the next record starts, or 0 if this is not one */
+  size_t record(const std::vector<uint8_t> &in, size_t pos, bool synced, uint32_t &time) {
+    uint8_t type = in[pos];
+
+    if (type == LOGCOMPACT_REC_SCHEMA) {
+      if (!crc_ok(in, pos, 11))
+        return 0;
+      track t;
+      t.obj_id = u32(&in[pos + 2]);
+      t.inst_id = u16(&in[pos + 6]);
+      t.length = u16(&in[pos + 9]);
+      t.valid = false;
+      tracks[in[pos + 1]] = t;
+      return pos + 12;
+    }
+
+    if (type == LOGCOMPACT_REC_KEY) {
+      if (pos + 1 >= in.size() || !tracks.count(in[pos + 1]))
+        return 0;
+      track &t = tracks[in[pos + 1]];
+      if (!crc_ok(in, pos, 6 + t.length))
+        return 0;
+      time = u32(&in[pos + 2]);
+      t.last.assign(&in[pos + 6], &in[pos + 6] + t.length);
+      t.valid = true;
+      emit(t, time);
+      return pos + 7 + t.length;
+    }
+
+    if (type == LOGCOMPACT_REC_RAW) {
+      if (pos + 14 >= in.size())
+        return 0;
+      uint16_t length = u16(&in[pos + 12]);
+      if (!crc_ok(in, pos, 14 + length))
+        return 0;
+      sample s;
+      s.obj_id = u32(&in[pos + 1]);
+      s.inst_id = u16(&in[pos + 5]);
+      s.time = time = u32(&in[pos + 8]);
+      s.data.assign(&in[pos + 14], &in[pos + 14] + length);
+      samples.push_back(s);
+      return pos + 15 + length;
+    }
+
+    /* Deltas carry no crc, so they are only believed in sync */
+    if (type >= 0x80 || !synced || !tracks.count(type))
+      return 0;
+
+    track &t = tracks[type];
+    size_t start = pos;
+    uint32_t dt;
+    pos++;
+    if (!varint(in, pos, dt))
+      return 0;
+
+    int words = (t.length + 3) / 4;
+    int bitmap_len = (words + 7) / 8;
+    if (pos + bitmap_len > in.size())
+      return 0;
+    const uint8_t *bitmap = &in[pos];
+    pos += bitmap_len;
+
+    std::vector<uint8_t> cur = t.last;
+    cur.resize(words * 4);
+    for (int i = 0; i < words; i++) {
+      if (!(bitmap[i / 8] & (1 << (i % 8))))
+        continue;
+      uint32_t z;
+      if (!varint(in, pos, z))
+        return 0;
+      uint32_t w = u32(&cur[4 * i]) + ((z >> 1) ^ -(z & 1));
+      for (int b = 0; b < 4; b++)
+        cur[4 * i + b] = w >> (8 * b);
+    }
+    cur.resize(t.length);
+
+    if (!crc_ok(in, start, pos - start))
+      return 0;
+    pos++;
+
+    time += dt;
+    if (t.valid) {
+      t.last = cur;
+      emit(t, time);
+    }
+    return pos;
+  }
+
+  void emit(const track &t, uint32_t time) {
+    sample s;
+    s.obj_id = t.obj_id;
+    s.inst_id = t.inst_id;
+    s.time = time;
+    s.data = t.last;
+    samples.push_back(s);
+  }
+};
+
+class LogCompact : public testing::Test {
+protected:
+  virtual void SetUp() {
+    stream.clear();
+    logcompact_init(&lc, capture);
+    ASSERT_EQ(0, logcompact_start(&lc));
+  }
+
+  void write(const sample &s, bool track = true) {
+    ASSERT_EQ(0, logcompact_write(&lc, s.obj_id, s.inst_id, true,
+        s.data.data(), s.data.size(), s.time, track));
+    written.push_back(s);
+  }
+
+  struct logcompact lc;
+  std::vector<sample> written;
+};
+
+static sample make_sample(uint32_t obj_id, uint16_t inst_id, uint32_t time, size_t length)
+{
+  sample s;
+  s.obj_id = obj_id;
+  s.inst_id = inst_id;
+  s.time = time;
+  s.data.resize(length);
+  return s;
+}
+
+TEST_F(LogCompact, StartsWithMagic) {
+  ASSERT_EQ(5U, stream.size());
+  EXPECT_EQ(0, memcmp(&stream[0], "dRLC", 4));
+  EXPECT_EQ(LOGCOMPACT_VERSION, stream[4]);
+}
+
+TEST_F(LogCompact, RoundTrip) {
+  uint32_t rng = 1;
+
+  for (uint32_t t = 0; t < 5000; t += 10) {
+    // Odd length, so the last word is padded
+    sample a = make_sample(0x1234, 0, t, 23);
+    for (size_t i = 0; i < a.data.size(); i++)
+      a.data[i] = (t / 100 + i) & 0xff;
+    a.data[3] = t & 0xff;
+    write(a);
+
+    // Two instances of one object, one of them noisy
+    for (uint16_t inst = 0; inst < 2; inst++) {
+      sample b = make_sample(0xabcd0000, inst, t, 40);
+      for (size_t i = 0; i < b.data.size(); i++) {
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        b.data[i] = inst ? rng : i;
+      }
+      write(b);
+    }
+
+    if (t % 1000 == 0) {
+      write(make_sample(0x5555, 0, t, 200), false);
+    }
+  }
+
+  Decoder dec;
+  ASSERT_TRUE(dec.decode(stream));
+  EXPECT_EQ(0, dec.resyncs);
+  ASSERT_EQ(written.size(), dec.samples.size());
+  for (size_t i = 0; i < written.size(); i++) {
+    ASSERT_TRUE(written[i] == dec.samples[i]) << "sample " << i;
+  }
+}
+
+TEST_F(LogCompact, UntrackableGoesRaw) {
+  // Too long to keep a history of
+  write(make_sample(1, 0, 0, LOGCOMPACT_MAX_TRACKED_LEN + 1));
+  EXPECT_EQ(0, lc.num_tracked);
+  EXPECT_EQ(LOGCOMPACT_REC_RAW, stream[5]);
+
+  // Changing length, e.g. after an object is redefined
+  write(make_sample(2, 0, 0, 10));
+  write(make_sample(2, 0, 10, 12));
+  EXPECT_EQ(1, lc.num_tracked);
+
+  // Out of indices
+  for (int i = 0; i < LOGCOMPACT_MAX_TRACKED + 4; i++) {
+    write(make_sample(100 + i, 0, 20, 4));
+  }
+  EXPECT_EQ(LOGCOMPACT_MAX_TRACKED, lc.num_tracked);
+
+  Decoder dec;
+  ASSERT_TRUE(dec.decode(stream));
+  ASSERT_EQ(written.size(), dec.samples.size());
+  for (size_t i = 0; i < written.size(); i++) {
+    EXPECT_TRUE(written[i] == dec.samples[i]) << "sample " << i;
+  }
+}
+
+TEST_F(LogCompact, FailedOutputForcesKey) {
+  sample s = make_sample(7, 0, 0, 16);
+  write(s);
+  s.time = 10;
+  write(s);
+
+  // A delta that went nowhere must not be built on
+  lc.output = fail_output;
+  s.time = 20;
+  s.data[0] = 1;
+  EXPECT_EQ(-1, logcompact_write(&lc, s.obj_id, s.inst_id, true,
+      s.data.data(), s.data.size(), s.time, true));
+
+  lc.output = capture;
+  size_t before = stream.size();
+  s.time = 30;
+  write(s);
+  EXPECT_EQ(LOGCOMPACT_REC_KEY, stream[before]);
+
+  // and later deltas still land at the right time
+  s.time = 40;
+  s.data[1] = 2;
+  write(s);
+
+  Decoder dec;
+  ASSERT_TRUE(dec.decode(stream));
+  ASSERT_EQ(written.size(), dec.samples.size());
+  for (size_t i = 0; i < written.size(); i++) {
+    EXPECT_TRUE(written[i] == dec.samples[i]) << "sample " << i;
+  }
+}
+
+TEST_F(LogCompact, ResyncsAfterCorruption) {
+  uint32_t rng = 99;
+
+  for (uint32_t t = 0; t < 10000; t += 4) {
+    sample s = make_sample(0x42, 0, t, 16);
+    for (int i = 0; i < 4; i++) {
+      rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+      int32_t v = 1000 * sinf(t * 0.001f + i) + (int32_t) (rng % 16);
+      memcpy(&s.data[4 * i], &v, 4);
+    }
+    write(s);
+  }
+
+  // Damage a stretch well inside the first second
+  for (size_t i = 0; i < 8; i++)
+    stream[stream.size() / 20 + i] ^= 0x5a;
+
+  Decoder dec;
+  ASSERT_TRUE(dec.decode(stream));
+  EXPECT_GE(dec.resyncs, 1);
+
+  // What comes out is right, and little more than a key interval is lost
+  std::map<uint32_t, const sample *> by_time;
+  for (const sample &s : written)
+    by_time[s.time] = &s;
+
+  for (const sample &s : dec.samples) {
+    ASSERT_TRUE(by_time.count(s.time));
+    ASSERT_TRUE(*by_time[s.time] == s) << "time " << s.time;
+  }
+
+  EXPECT_GE(dec.samples.size() + (LOGCOMPACT_KEY_INTERVAL_MS + 100) / 4, written.size());
+  EXPECT_TRUE(dec.samples.back() == written.back());
+}
+
+/*
+ * Roughly what the default logging profile writes: sensors and attitude at
+ * the full rate, control and status objects that barely change, and GPS.
+ * Floats are noisy sensor readings quantized the way the drivers scale them.
+ */
+class LogCompactRatio : public LogCompact {
+protected:
+  void profile(uint32_t rate_hz, uint32_t seconds) {
+    uint32_t rng = 4321;
+    uint32_t period = 1000 / rate_hz;
+
+    for (uint32_t t = 0; t < seconds * 1000; t += period) {
+      float ft = t * 0.001f;
+
+      // Gyros: x y z temperature, 16 bit samples at 2000 deg/s full scale
+      float gyros[4];
+      for (int i = 0; i < 3; i++)
+        gyros[i] = roundf((20 * sinf(ft * (1 + i)) + noise(rng, 1.0f)) / 0.061f) * 0.061f;
+      gyros[3] = 35.5f;
+      add(1, t, gyros, sizeof(gyros));
+
+      // Accels: x y z temperature, 16 bit samples at 16 g full scale
+      float accels[4];
+      for (int i = 0; i < 3; i++)
+        accels[i] = roundf(((i == 2 ? -9.81f : 0) + noise(rng, 0.2f)) / 0.0048f) * 0.0048f;
+      accels[3] = 35.5f;
+      add(2, t, accels, sizeof(accels));
+
+      // AttitudeActual: quaternion, roll pitch yaw
+      float att[7];
+      for (int i = 0; i < 7; i++)
+        att[i] = (i < 4 ? 0.5f : 10.0f) * sinf(ft * 0.3f + i);
+      add(3, t, att, sizeof(att));
+
+      // StabilizationDesired: roll pitch yaw thrust, modes
+      float stab[6] = { 0, 0, 0, roundf(50 + 10 * sinf(ft)) * 0.01f, 0, 0 };
+      add(4, t, stab, 22);
+
+      // ActuatorCommand: eight int16 channels and a couple of status fields
+      int16_t act[12] = { 0 };
+      for (int i = 0; i < 4; i++)
+        act[i] = 1500 + 100 * sinf(ft * 2 + i) + (int16_t) noise(rng, 5);
+      add(5, t, act, sizeof(act));
+
+      // Status objects that only move now and then
+      uint8_t flight_status[4] = { 1, (uint8_t) (t > 5000), 0, 0 };
+      add(6, t, flight_status, sizeof(flight_status));
+
+      uint8_t alarms[40];
+      memset(alarms, 1, sizeof(alarms));
+      add(7, t, alarms, sizeof(alarms));
+
+      // ManualControlCommand: throttle roll pitch yaw collective, then channels
+      float mcc[5];
+      for (int i = 0; i < 5; i++)
+        mcc[i] = roundf(500 * sinf(ft * 0.5f + i)) / 500;
+      add(8, t, mcc, 20 + 36);
+
+      // Magnetometer and baro at their own rates
+      if (t % 20 == 0) {
+        float mag[3];
+        for (int i = 0; i < 3; i++)
+          mag[i] = roundf((200 + noise(rng, 3)) / 0.92f) * 0.92f;
+        add(9, t, mag, sizeof(mag));
+      }
+      if (t % 40 == 0) {
+        float baro[3] = { 12.0f + noise(rng, 0.1f), 31.0f, 1000.0f + noise(rng, 0.01f) };
+        add(10, t, baro, sizeof(baro));
+      }
+
+      // GPSPosition at 5 Hz
+      if (t % 200 == 0) {
+        int32_t gps[12] = { 0 };
+        gps[0] = 377490000 + t / 10;
+        gps[1] = -1224194000 + t / 20;
+        add(11, t, gps, 44);
+      }
+    }
+  }
+
+  float noise(uint32_t &rng, float scale) {
+    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+    return scale * (((int32_t) (rng % 2001) - 1000) / 1000.0f);
+  }
+
+  // Counts what the same sample costs as a timestamped UAVTalk frame
+  void add(uint32_t obj_id, uint32_t t, const void *data, size_t length) {
+    static uint8_t buf[256];
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf, data, length);
+    uavtalk_bytes += 10 + length + 1;
+
+    ASSERT_EQ(0, logcompact_write(&lc, obj_id, 0, true, buf, length, t, true));
+  }
+
+  double ratio() {
+    return (double) uavtalk_bytes / stream.size();
+  }
+
+  size_t uavtalk_bytes = 0;
+};
+
+TEST_F(LogCompactRatio, Default25Hz) {
+  profile(25, 60);
+  printf("25 Hz: %zu bytes of UAVTalk in %zu, %.2fx\n", uavtalk_bytes, stream.size(), ratio());
+  EXPECT_GT(ratio(), 2.0);
+}
+
+TEST_F(LogCompactRatio, Default100Hz) {
+  profile(100, 60);
+  printf("100 Hz: %zu bytes of UAVTalk in %zu, %.2fx\n", uavtalk_bytes, stream.size(), ratio());
+  EXPECT_GT(ratio(), 2.0);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,388 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "osd_utils.h"		/* API for the OSD drawing functions */
+
+extern uint8_t *draw_buffer_level;
+extern uint8_t *draw_buffer_mask;
+
+// Not exported by osd_utils.h
+void write_pixel(uint8_t *buff, int x, int y, int mode);
+void write_hline(uint8_t *buff, int x0, int x1, int y, int mode);
+void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height, int mode);
+void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info);
+
+}
+
+#define BENCHMARK_FRAMES 500
+
+static int get_pixel(const uint8_t *buff, int x, int y)
+{
+  return (buff[CALC_BUFF_ADDR(x, y)] & CALC_BIT_MASK(x)) ? 1 : 0;
+}
+
+// FNV-1a over one plane, used to compare against the golden images
+static uint32_t plane_hash(const uint8_t *buff)
+{
+  uint32_t hash = 2166136261u;
+
+  for (int i = 0; i < BUFFER_HEIGHT * BUFFER_WIDTH; i++) {
+    hash ^= buff[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+// Writes the composed frame as a PGM (black, white and transparent as grey)
+// when OSD_DUMP_DIR is set, so a changed golden image can be inspected
+static void dump_frame(const char *name)
+{
+  const char *dir = getenv("OSD_DUMP_DIR");
+  if (dir == NULL)
+    return;
+
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s.pgm", dir, name);
+  FILE *f = fopen(path, "wb");
+  if (f == NULL)
+    return;
+
+  fprintf(f, "P5\n%d %d\n255\n", GRAPHICS_WIDTH_REAL, GRAPHICS_HEIGHT_REAL);
+  for (int y = 0; y < GRAPHICS_HEIGHT_REAL; y++) {
+    for (int x = 0; x < GRAPHICS_WIDTH_REAL; x++) {
+      uint8_t v = 128;
+      if (get_pixel(draw_buffer_mask, x, y))
+        v = get_pixel(draw_buffer_level, x, y) ? 255 : 0;
+      fputc(v, f);
+    }
+  }
+  fclose(f);
+}
+
+static void draw_shapes()
+{
+  write_hline_lm(10, 300, 20, 1, 1);
+  write_hline_lm(13, 17, 24, 1, 1);
+  write_vline_lm(5, 30, 200, 1, 1);
+  write_filled_rectangle_lm(33, 40, 77, 23, 0, 1);
+  write_filled_rectangle_lm(121, 41, 5, 30, 1, 1);
+  write_rectangle_outlined(150, 40, 100, 50, 0, 1);
+  write_hline_outlined(20, 200, 110, 2, 2, 0, 1);
+  write_vline_outlined(280, 60, 220, 2, 2, 1, 1);
+  write_line_outlined(30, 230, 250, 130, 2, 2, 0, 1);
+  write_line_outlined_dashed(40, 250, 300, 240, 2, 2, 0, 1, 5);
+  write_circle_outlined(300, 180, 30, 0, 1, 0, 1);
+  write_circle_outlined(300, 180, 45, 6, 0, 1, 1);
+
+  const point_t arrow[] = { {0, -12}, {8, 8}, {0, 4}, {-8, 8} };
+  draw_polygon(80, 180, 30.0f, arrow, 4, 0, 1);
+  drawArrow(140, 200, 120, 10);
+  drawBox(180, 150, 240, 210);
+}
+
+static void draw_text()
+{
+  char line[64];
+
+  for (int font = 0; font < NUM_FONTS; font++) {
+    for (int offset = 0; offset < 8; offset++) {
+      snprintf(line, sizeof(line), "%d:%d ABC xyz 0123", font, offset);
+      write_string(line, 4 + offset, 4 + (font * 8 + offset) * 8, 0, 0,
+          TEXT_VA_TOP, TEXT_HA_LEFT, 0, font);
+    }
+  }
+
+  char centered[] = "Centered\nLines";
+  char right[] = "RIGHT";
+  char clipped[] = "clipped";
+
+  write_string(centered, GRAPHICS_X_MIDDLE, GRAPHICS_Y_MIDDLE, 1, 2,
+      TEXT_VA_MIDDLE, TEXT_HA_CENTER, 0, FONT12X18);
+  write_string(right, GRAPHICS_RIGHT, GRAPHICS_BOTTOM, 0, 0,
+      TEXT_VA_BOTTOM, TEXT_HA_RIGHT, 0, FONT_OUTLINED8X14);
+  // Partly off screen
+  write_string(clipped, -20, GRAPHICS_BOTTOM - 5, 0, 0,
+      TEXT_VA_TOP, TEXT_HA_LEFT, 0, FONT8X10);
+}
+
+// Roughly what render_user_page() draws for a typical flight page: an
+// artificial horizon, two ticker tapes, a compass strip and ~20 text items
+static void draw_hud(float roll, float pitch, int alt, int speed, int heading)
+{
+  char tmp[32];
+  float sin_roll = sinf(roll * (float)(M_PI / 180));
+  float cos_roll = cosf(roll * (float)(M_PI / 180));
+
+  for (int i = -3; i <= 3; i++) {
+    int cx = GRAPHICS_X_MIDDLE - i * 30 * sin_roll;
+    int cy = GRAPHICS_Y_MIDDLE + (pitch + i * 10) * 3 * cos_roll;
+    int dx = 60 * cos_roll;
+    int dy = 60 * sin_roll;
+
+    if (i < 0)
+      write_line_outlined_dashed(cx - dx, cy + dy, cx + dx, cy - dy, 2, 2, 0, 1, 5);
+    else
+      write_line_outlined(cx - dx, cy + dy, cx + dx, cy - dy, 2, 2, 0, 1);
+
+    snprintf(tmp, sizeof(tmp), "%d", i * 10);
+    write_string(tmp, cx - dx - 10, cy + dy, 0, 0, TEXT_VA_MIDDLE, TEXT_HA_CENTER, 0, FONT_OUTLINED8X8);
+  }
+
+  for (int side = 0; side < 2; side++) {
+    int x = side ? GRAPHICS_RIGHT - 50 : 50;
+    int v = side ? alt : speed;
+    for (int r = -5; r <= 5; r++) {
+      int ys = GRAPHICS_Y_MIDDLE + r * 15;
+      write_hline_outlined(x, side ? x + 8 : x - 8, ys, 2, 2, 0, 1);
+      snprintf(tmp, sizeof(tmp), "%d", v - r * 5);
+      write_string(tmp, side ? x + 12 : x - 12, ys, 1, 0, TEXT_VA_MIDDLE,
+          side ? TEXT_HA_LEFT : TEXT_HA_RIGHT, 0, FONT_OUTLINED8X8);
+    }
+    write_filled_rectangle_lm(side ? x + 10 : x - 44, GRAPHICS_Y_MIDDLE - 6, 34, 13, 0, 1);
+    snprintf(tmp, sizeof(tmp), "%03d", v);
+    write_string(tmp, side ? x + 12 : x - 12, GRAPHICS_Y_MIDDLE, 1, 0, TEXT_VA_MIDDLE,
+        side ? TEXT_HA_LEFT : TEXT_HA_RIGHT, 0, FONT8X10);
+  }
+
+  for (int r = -45; r <= 45; r += 5) {
+    int x = GRAPHICS_X_MIDDLE + r * 3;
+    write_vline_outlined(x, 20, (r % 15) ? 24 : 28, 2, 2, 0, 1);
+  }
+  snprintf(tmp, sizeof(tmp), "%03d", heading);
+  write_string(tmp, GRAPHICS_X_MIDDLE, 32, 0, 0, TEXT_VA_TOP, TEXT_HA_CENTER, 0, FONT8X10);
+
+  for (int i = 0; i < 16; i++) {
+    snprintf(tmp, sizeof(tmp), "ITEM%02d %5.1f", i, alt * 0.1f + i);
+    write_string(tmp, (i & 1) ? GRAPHICS_RIGHT - 5 : 5, GRAPHICS_BOTTOM - 20 - (i / 2) * 12,
+        0, 0, TEXT_VA_TOP, (i & 1) ? TEXT_HA_RIGHT : TEXT_HA_LEFT, 0, FONT_OUTLINED8X14);
+  }
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class OsdUtils : public testing::Test {
+protected:
+  virtual void SetUp() {
+    clearGraphics();
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(OsdUtils, PixelBothPlanes) {
+  write_pixel_lm(17, 3, 1, 0);
+  EXPECT_EQ(1, get_pixel(draw_buffer_mask, 17, 3));
+  EXPECT_EQ(0, get_pixel(draw_buffer_level, 17, 3));
+
+  write_pixel_lm(17, 3, 1, 1);
+  EXPECT_EQ(1, get_pixel(draw_buffer_mask, 17, 3));
+  EXPECT_EQ(1, get_pixel(draw_buffer_level, 17, 3));
+
+  write_pixel_lm(17, 3, 2, 2);
+  EXPECT_EQ(0, get_pixel(draw_buffer_mask, 17, 3));
+  EXPECT_EQ(0, get_pixel(draw_buffer_level, 17, 3));
+
+  // Off screen writes are dropped
+  write_pixel_lm(-1, 3, 1, 1);
+  write_pixel_lm(3, GRAPHICS_BOTTOM + 1, 1, 1);
+  EXPECT_EQ(plane_hash(draw_buffer_level), plane_hash(draw_buffer_mask));
+}
+
+TEST_F(OsdUtils, HorizontalLineSpan) {
+  write_hline_lm(13, 50, 7, 1, 1);
+
+  for (int x = 0; x < GRAPHICS_WIDTH_REAL; x++) {
+    int expected = (x >= 13 && x <= 50) ? 1 : 0;
+    EXPECT_EQ(expected, get_pixel(draw_buffer_mask, x, 7)) << "x = " << x;
+    EXPECT_EQ(expected, get_pixel(draw_buffer_level, x, 7)) << "x = " << x;
+    EXPECT_EQ(0, get_pixel(draw_buffer_mask, x, 6));
+    EXPECT_EQ(0, get_pixel(draw_buffer_mask, x, 8));
+  }
+
+  // Lines are clipped to the visible area
+  write_hline_lm(-40, 1000, 9, 1, 1);
+  EXPECT_EQ(1, get_pixel(draw_buffer_mask, 0, 9));
+  EXPECT_EQ(1, get_pixel(draw_buffer_mask, GRAPHICS_RIGHT, 9));
+  EXPECT_EQ(0, get_pixel(draw_buffer_mask, GRAPHICS_RIGHT + 1, 9));
+}
+
+TEST_F(OsdUtils, FilledRectangle) {
+  write_filled_rectangle_lm(30, 10, 40, 5, 0, 1);
+
+  int count = 0;
+  for (int y = 0; y < 20; y++)
+    for (int x = 0; x < 100; x++)
+      count += get_pixel(draw_buffer_mask, x, y);
+
+  EXPECT_EQ(1, get_pixel(draw_buffer_mask, 30, 10));
+  EXPECT_EQ(1, get_pixel(draw_buffer_mask, 69, 14));
+  EXPECT_EQ(0, get_pixel(draw_buffer_mask, 30, 15));
+  EXPECT_EQ(0, get_pixel(draw_buffer_mask, 29, 10));
+  EXPECT_EQ(41 * 5, count);
+
+  for (int i = 0; i < BUFFER_HEIGHT * BUFFER_WIDTH; i++)
+    ASSERT_EQ(0, draw_buffer_level[i]);
+}
+
+TEST_F(OsdUtils, ToggleSpans) {
+  // Cover every start and end alignment of the span fill
+  for (int x0 = 0; x0 < 40; x0++) {
+    int x1 = GRAPHICS_RIGHT - (x0 * 7) % 40;
+
+    write_filled_rectangle_lm(3, 10, 300, 2, 1, 1);
+    write_filled_rectangle(draw_buffer_level, x0, 10, x1 - x0, 2, 2);
+
+    for (int x = 0; x < GRAPHICS_WIDTH_REAL; x++) {
+      int set = (x >= 3 && x <= 303);
+      int toggled = (x >= x0 && x <= x1);
+      ASSERT_EQ(set ^ toggled, get_pixel(draw_buffer_level, x, 11)) << x0 << " " << x;
+    }
+
+    // Toggling twice restores the buffer
+    write_filled_rectangle(draw_buffer_level, x0, 10, x1 - x0, 2, 2);
+    write_filled_rectangle_lm(3, 10, 300, 2, 0, 0);
+    for (int i = 0; i < BUFFER_HEIGHT * BUFFER_WIDTH; i++)
+      ASSERT_EQ(0, draw_buffer_level[i] | draw_buffer_mask[i]);
+  }
+}
+
+TEST_F(OsdUtils, CharMatchesFont) {
+  const struct FontEntry *font = get_font_info(FONT8X10);
+  ASSERT_TRUE(font != NULL);
+
+  for (int x = 40; x < 48; x++) {
+    clearGraphics();
+    write_char('A', x, 20, font);
+
+    const uint16_t *glyph = &font->data[font->lookup['A'] * font->height];
+    for (int row = 0; row < font->height; row++) {
+      for (int col = 0; col < font->width; col++) {
+        int bit = 7 - col;
+        int mask = (glyph[row] >> bit) & 1;
+        // A set level bit in the font marks a black pixel
+        int white = !((glyph[row] >> (bit + 8)) & 1);
+        EXPECT_EQ(mask, get_pixel(draw_buffer_mask, x + col, 20 + row));
+        if (mask) {
+          EXPECT_EQ(white, get_pixel(draw_buffer_level, x + col, 20 + row));
+        }
+      }
+    }
+  }
+}
+
+// Golden images: the hashes below were recorded from the reference
+// implementation. Run with OSD_DUMP_DIR=<dir> to look at the frames.
+TEST_F(OsdUtils, GoldenShapes) {
+  draw_shapes();
+  dump_frame("shapes");
+
+  EXPECT_EQ(0xca9daba4u, plane_hash(draw_buffer_level));
+  EXPECT_EQ(0x4f5ba606u, plane_hash(draw_buffer_mask));
+}
+
+TEST_F(OsdUtils, GoldenText) {
+  draw_text();
+  dump_frame("text");
+
+  EXPECT_EQ(0x3e199881u, plane_hash(draw_buffer_level));
+  EXPECT_EQ(0xac479aeau, plane_hash(draw_buffer_mask));
+}
+
+TEST_F(OsdUtils, GoldenHud) {
+  draw_hud(20.0f, -7.0f, 123, 45, 271);
+  dump_frame("hud");
+
+  EXPECT_EQ(0xfa3f7f54u, plane_hash(draw_buffer_level));
+  EXPECT_EQ(0x4023f716u, plane_hash(draw_buffer_mask));
+}
+
+// Not a pass/fail test: reports the cost of a representative HUD frame
+TEST_F(OsdUtils, BenchmarkHud) {
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < BENCHMARK_FRAMES; i++) {
+    clearGraphics();
+    draw_hud(-30.0f + (i % 60), -10.0f + (i % 20), 100 + i % 50, 30 + i % 20, i % 360);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double us = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+  printf("HUD frame: %.1f us (%.0f frames/s)\n", us / BENCHMARK_FRAMES,
+      BENCHMARK_FRAMES * 1e6 / us);
+}
+
+TEST_F(OsdUtils, BenchmarkFills) {
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < BENCHMARK_FRAMES; i++) {
+    clearGraphics();
+    // Horizon-style fill of the lower half and a few panels
+    for (int y = GRAPHICS_Y_MIDDLE + (i % 20); y < GRAPHICS_BOTTOM; y++)
+      write_hline_lm(i % 7, GRAPHICS_RIGHT - (i % 5), y, 0, 1);
+    for (int r = 0; r < 8; r++)
+      write_filled_rectangle_lm(5 + r * 3, 10 + r * 12, 120 + r * 9, 10, 1, 1);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double us = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+  printf("Fill frame: %.1f us (%.0f frames/s)\n", us / BENCHMARK_FRAMES,
+      BENCHMARK_FRAMES * 1e6 / us);
+}
+
+TEST_F(OsdUtils, BenchmarkText) {
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < BENCHMARK_FRAMES; i++) {
+    clearGraphics();
+    draw_text();
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double us = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+  printf("Text page: %.1f us (%.0f frames/s)\n", us / BENCHMARK_FRAMES,
+      BENCHMARK_FRAMES * 1e6 / us);
+}
@@ -0,0 +1,54 @@
+/**
+ ******************************************************************************
+ * @file       unittest_init.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Video buffers and object stand-ins for the OSD drawing code
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <string.h>
+#include "pios_video.h"
+#include "homelocation.h"
+#include "gpsposition.h"
+
+static uint8_t buffer_level[BUFFER_HEIGHT * BUFFER_WIDTH];
+static uint8_t buffer_mask[BUFFER_HEIGHT * BUFFER_WIDTH];
+
+uint8_t *draw_buffer_level = buffer_level;
+uint8_t *draw_buffer_mask = buffer_mask;
+
+// PAL boundaries as set up by the video driver
+static const struct pios_video_type_boundary pios_video_type_boundary_pal = {
+	.graphics_right  = 359,
+	.graphics_bottom = 265,
+};
+
+const struct pios_video_type_boundary *pios_video_type_boundary_act = &pios_video_type_boundary_pal;
+
+void HomeLocationGet(HomeLocationData *data)
+{
+	memset(data, 0, sizeof(*data));
+}
+
+void GPSPositionGet(GPSPositionData *data)
+{
+	memset(data, 0, sizeof(*data));
+}
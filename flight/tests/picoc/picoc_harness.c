@@ -0,0 +1,211 @@
+/**
+ ******************************************************************************
+ * @file       picoc_harness.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Runs PicoC scripts for the unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+#include "openpilot.h"
+#include "pios_thread.h"
+#include "picoc_port.h"
+#include <setjmp.h>
+#include "interpreter.h"
+#include "picoc_harness.h"
+
+#define PICOC_TEST_MAX_VALUES	256
+
+extern jmp_buf PicocExitBuf;
+
+double picoc_test_values[PICOC_TEST_MAX_VALUES];
+int picoc_test_num_values;
+int picoc_test_sleeps;
+bool picoc_test_loop_compiled;
+int picoc_test_loop_line;
+
+static int cycles_left;
+
+/* the picoc heap is taken once and kept */
+#undef malloc
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	return 0;
+}
+
+void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms)
+{
+	*previous_ms += increment_ms;
+	picoc_test_sleeps++;
+}
+
+void PIOS_Thread_Sleep(uint32_t time_ms)
+{
+}
+
+/* void emit(double); records a value */
+static void TestEmit(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
+{
+	if (picoc_test_num_values < PICOC_TEST_MAX_VALUES)
+		picoc_test_values[picoc_test_num_values++] = Param[0]->Val->FP;
+}
+
+/* int cycle(); counts calls, to see a native returning a value */
+static void TestCycle(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
+{
+	ReturnValue->Val->Integer = cycles_left;
+}
+
+static struct LibraryFunction TestFunctions[] =
+{
+	{ TestEmit, "void emit(double);" },
+	{ TestCycle, "int cycle();" },
+	{ NULL, NULL }
+};
+
+void PlatformLibraryInit(Picoc *pc)
+{
+	IncludeRegister(pc, "test.h", NULL, &TestFunctions[0], NULL);
+}
+
+static bool keep_running(void)
+{
+	return cycles_left-- > 0;
+}
+
+static void loop_started(bool compiled, int line)
+{
+	picoc_test_loop_compiled = compiled;
+	picoc_test_loop_line = line;
+}
+
+static void call_loop(Picoc *pc, void *tokens, char *name)
+{
+	struct ParseState parser;
+
+	LexInitParser(&parser, pc, "loop();", tokens, name, true, false);
+	ParseStatement(&parser, true);
+}
+
+/**
+ * runs the script and its loop() cycles times
+ * returns the number of values emitted, or one of the PICOC_TEST_ errors
+ */
+int picoc_test_run(const char *source, enum picoc_test_mode mode, int cycles)
+{
+	Picoc pc;
+	struct CompiledProgram *compiled = NULL;
+	void *tokens;
+	char *name;
+	int line;
+
+	picoc_test_num_values = 0;
+	cycles_left = cycles;
+
+	if (mode == PICOC_TEST_RESTART) {
+		for (; cycles_left > 0; cycles_left--) {
+			PicocInitialise(&pc, PICOC_TEST_STACK_SIZE);
+			if (PicocPlatformSetExitPoint(&pc)) {
+				PicocCleanup(&pc);
+				return PICOC_TEST_ERROR;
+			}
+
+			PicocParse(&pc, "nofile", source, strlen(source), true, true, false, false);
+			PicocParse(&pc, "loop", "loop();", strlen("loop();"), true, true, false, false);
+			PicocCleanup(&pc);
+		}
+
+		return picoc_test_num_values;
+	}
+
+	PicocInitialise(&pc, PICOC_TEST_STACK_SIZE);
+	if (PicocPlatformSetExitPoint(&pc)) {
+		PicocCleanup(&pc);
+		return PICOC_TEST_ERROR;
+	}
+
+	PicocParse(&pc, "nofile", source, strlen(source), true, false, false, false);
+
+	if (mode == PICOC_TEST_COMPILED) {
+		compiled = PicocCompile(&pc, "loop", &line);
+		if (compiled == NULL) {
+			PicocCleanup(&pc);
+			return PICOC_TEST_NOT_COMPILED;
+		}
+
+		for (; cycles_left > 0; cycles_left--)
+			PicocRunCompiled(compiled);
+
+		PicocFreeCompiled(compiled);
+	} else {
+		tokens = LexAnalyse(&pc, "loop", "loop();", strlen("loop();"), NULL);
+		name = TableStrRegister(&pc, "loop");
+
+		for (; cycles_left > 0; cycles_left--)
+			call_loop(&pc, tokens, name);
+
+		HeapFreeMem(&pc, tokens);
+	}
+
+	PicocCleanup(&pc);
+	return picoc_test_num_values;
+}
+
+/**
+ * runs the script through picoc_cyclic() for the given number of cycles
+ * returns the exit value
+ */
+int picoc_test_cyclic(const char *source, uint32_t period_ms, int cycles)
+{
+	picoc_test_num_values = 0;
+	picoc_test_sleeps = 0;
+	picoc_test_loop_compiled = false;
+	picoc_test_loop_line = -1;
+	cycles_left = cycles;
+
+	return picoc_cyclic(source, PICOC_TEST_STACK_SIZE, period_ms, keep_running, loop_started);
+}
+
+/* true if loop() of the script can be compiled */
+bool picoc_test_compiles(const char *source)
+{
+	Picoc pc;
+	struct CompiledProgram *compiled;
+	int line;
+
+	PicocInitialise(&pc, PICOC_TEST_STACK_SIZE);
+	if (PicocPlatformSetExitPoint(&pc)) {
+		PicocCleanup(&pc);
+		return false;
+	}
+
+	PicocParse(&pc, "nofile", source, strlen(source), true, false, false, false);
+	compiled = PicocCompile(&pc, "loop", &line);
+	PicocFreeCompiled(compiled);
+	PicocCleanup(&pc);
+
+	return compiled != NULL;
+}
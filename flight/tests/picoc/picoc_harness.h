@@ -0,0 +1,59 @@
+/**
+ ******************************************************************************
+ * @file       picoc_harness.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Runs PicoC scripts for the unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PICOC_HARNESS_H
+#define PICOC_HARNESS_H
+
+#include <stdbool.h>
+
+/* how loop() is run every cycle */
+enum picoc_test_mode {
+	PICOC_TEST_RESTART,		/* the whole script is started again */
+	PICOC_TEST_TOKENS,		/* loop() is interpreted */
+	PICOC_TEST_COMPILED,	/* loop() is compiled once */
+};
+
+/* the interpreter and the compiled tree take about twice the memory with 64 bit pointers */
+#define PICOC_TEST_STACK_SIZE	65536
+#define PICOC_TEST_ERROR		-1
+#define PICOC_TEST_NOT_COMPILED	-2
+
+/* the values a script passed to emit() */
+extern double picoc_test_values[];
+extern int picoc_test_num_values;
+
+/* the number of times PIOS_Thread_Sleep_Until() was called */
+extern int picoc_test_sleeps;
+
+/* what picoc_cyclic() reported about loop() */
+extern bool picoc_test_loop_compiled;
+extern int picoc_test_loop_line;
+
+int picoc_test_run(const char *source, enum picoc_test_mode mode, int cycles);
+int picoc_test_cyclic(const char *source, uint32_t period_ms, int cycles);
+bool picoc_test_compiles(const char *source);
+
+#endif /* PICOC_HARNESS_H */
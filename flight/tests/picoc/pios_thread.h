@@ -0,0 +1,36 @@
+/**
+ ******************************************************************************
+ * @file       pios_thread.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Stub pios_thread.h for the PicoC test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_THREAD_H
+#define PIOS_THREAD_H
+
+#include <stdint.h>
+
+uint32_t PIOS_Thread_Systime(void);
+void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms);
+void PIOS_Thread_Sleep(uint32_t time_ms);
+
+#endif /* PIOS_THREAD_H */
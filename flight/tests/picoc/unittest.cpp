@@ -0,0 +1,284 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the PicoC loop() compiler
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+#include "picoc_harness.h"
+}
+
+/* loop() of every script is compiled and must behave like the interpreter */
+static const char *scripts[] = {
+	/* integers on long, truncated to int and to the variable */
+	"#include \"test.h\"\n"
+	"int i = 2147483600; char c = 100; unsigned char u = 250; short s = 32000; unsigned int w = 7;\n"
+	"void loop() {\n"
+	"  i += 20; c += 20; u += 3; s = s + 500; w = w - 10;\n"
+	"  emit(i); emit(c); emit(u); emit(s); emit(w);\n"
+	"  emit(7 / 2); emit(-7 % 3); emit(1 << 4); emit(0xf0 >> 2); emit(~5); emit(!0); emit(-c);\n"
+	"  emit(6 & 3); emit(6 | 3); emit(6 ^ 3); emit(i < 0); emit(c >= -100); emit(3 != 3);\n"
+	"  int x = 13; x *= 3; x /= 2; x %= 7; x <<= 3; x >>= 1; x &= 0x1c; x |= 1; x ^= 0xff; emit(x);\n"
+	"}\n",
+
+	/* floating point and the conversions to and from it */
+	"#include \"test.h\"\n"
+	"double d = 0.25; int n = 3; unsigned int big = 4000000000;\n"
+	"void loop() {\n"
+	"  d = d * 1.5 + n; n = d; emit(d); emit(n); emit(d / 3); emit(-d);\n"
+	"  double e = n; e += 0.5; e -= 1; e *= 2; e /= 4; emit(e);\n"
+	"  n += 2.7; emit(n); n -= 0.5; emit(n); emit(big); emit(d > 2); emit(d == d); emit(!d);\n"
+	"  double f = 1; f++; ++f; f--; emit(f); emit((int)2.9); emit((char)300); emit((double)7 / 2);\n"
+	"}\n",
+
+	/* pointers, arrays and structs */
+	"#include \"test.h\"\n"
+	"struct point { int x; double y; char tag[4]; };\n"
+	"struct point pts[3]; int data[5] = { 1, 2, 3, 4, 5 }; int count = 0;\n"
+	"void loop() {\n"
+	"  int *p = &data[1]; int *q = data; struct point *pt = &pts[count % 3];\n"
+	"  p[1] += count; *q = *p + 1; p++; --p; q = p + 2; q -= 1;\n"
+	"  emit(*q); emit(q - p); emit(p == q); emit(p != 0); emit(q[-1]);\n"
+	"  pt->x = count * 10; pt->y = pt->x / 4.0; pt->tag[count % 4] = 'a' + count;\n"
+	"  pts[2].x++; emit(pts[2].x); emit(pt->y); emit(pt->tag[0]); emit(sizeof(struct point)); emit(sizeof(data));\n"
+	"  struct point copy; copy = *pt; emit(copy.x); emit(copy.tag[count % 4]);\n"
+	"  char *str = \"picoc\"; emit(str[count % 5]);\n"
+	"  count++;\n"
+	"}\n",
+
+	/* control flow */
+	"#include \"test.h\"\n"
+	"int count = 0;\n"
+	"void loop() {\n"
+	"  int i; int sum = 0;\n"
+	"  for (i = 0; i < 10; i++) { if (i == 3) continue; if (i > 7) break; sum += i; }\n"
+	"  emit(sum); emit(i);\n"
+	"  while (sum > 5) sum -= 4; emit(sum);\n"
+	"  do { sum++; } while (sum < 3); emit(sum);\n"
+	"  for (int j = 0; j < 5; j++) {\n"
+	"    switch (j + count) {\n"
+	"    case 0: emit(100);\n"
+	"    case 2: emit(102); break;\n"
+	"    case 4: { emit(104); continue; }\n"
+	"    default: emit(j);\n"
+	"    }\n"
+	"  }\n"
+	"  if (count & 1) emit(1); else if (count & 2) emit(2); else emit(3);\n"
+	"  emit(count > 1 ? 1.5 : 2.5); emit(count && sum); emit(count || 0);\n"
+	"  count++;\n"
+	"}\n",
+
+	/* functions, natives and static locals */
+	"#include \"test.h\"\n"
+	"#define SCALE 3\n"
+	"#define LIMIT (SCALE * 2)\n"
+	"int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+	"double half(double v) { return v / 2; }\n"
+	"char clip(int v) { return v; }\n"
+	"void twice(int *v) { *v *= 2; }\n"
+	"int steps = 0;\n"
+	"void loop() {\n"
+	"  static int calls = 0; static int first = 5;\n"
+	"  calls++; first = first + calls; twice(&steps); steps++;\n"
+	"  emit(calls); emit(first); emit(steps); emit(fib(calls + 5)); emit(half(calls)); emit(half(7));\n"
+	"  emit(clip(200 + calls)); emit(cycle()); emit(SCALE * calls); emit(LIMIT);\n"
+	"  if (calls > 2) return;\n"
+	"  emit(-1);\n"
+	"}\n",
+
+	/* the interpreter evaluates all operands of '&&', '||' and '?:' */
+	"#include \"test.h\"\n"
+	"#define CALL (f(3) + 1)\n"
+	"struct s { int x; int y; }; struct s *q = 0;\n"
+	"int b = 0; int count = 0;\n"
+	"int f(int v) { emit(100 + v); return v; }\n"
+	"void loop() {\n"
+	"  emit(1 || (b = 5)); emit(b); emit(0 && (b = 7)); emit(b); emit(1 || b++); emit(b);\n"
+	"  emit(b++ && b++); emit(b); emit(b-- || b--); emit(b); emit(1 || CALL); emit(0 && CALL);\n"
+	"  int x = count ? (b = 2) : (b = 3); emit(x); emit(b); x = (count & 1) ? f(5) : f(6); emit(x);\n"
+	"  emit(count ? 2 : 0 ? 3 : 4); emit((count & 2) ? (b = 2) : 0 ? (b = 3) : (b = 4)); emit(b);\n"
+	"  int *pp = &q->y; emit(pp != 0);\n"
+	"  count++;\n"
+	"}\n",
+};
+
+static double time_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+class PicoCCompile : public testing::Test {
+};
+
+/* every script compiles and emits the same values as the interpreter */
+TEST_F(PicoCCompile, SameAsInterpreter) {
+	for (unsigned int i = 0; i < sizeof(scripts) / sizeof(scripts[0]); i++) {
+		SCOPED_TRACE(i);
+
+		int num_interpreted = picoc_test_run(scripts[i], PICOC_TEST_TOKENS, 6);
+		ASSERT_GT(num_interpreted, 0);
+
+		double interpreted[num_interpreted];
+		memcpy(interpreted, picoc_test_values, sizeof(interpreted));
+
+		ASSERT_EQ(num_interpreted, picoc_test_run(scripts[i], PICOC_TEST_COMPILED, 6));
+
+		for (int j = 0; j < num_interpreted; j++) {
+			EXPECT_EQ(interpreted[j], picoc_test_values[j]) << "value " << j;
+		}
+	}
+}
+
+/* what the compiler doesn't know is left to the interpreter */
+TEST_F(PicoCCompile, FallsBack) {
+	const char *uses_goto =
+		"#include \"test.h\"\n"
+		"int count = 0;\n"
+		"void loop() { count++; if (count > 1) goto done; emit(-1); done: emit(count); }\n";
+
+	EXPECT_FALSE(picoc_test_compiles(uses_goto));
+	EXPECT_EQ(PICOC_TEST_NOT_COMPILED, picoc_test_run(uses_goto, PICOC_TEST_COMPILED, 3));
+
+	/* picoc_cyclic() still runs it */
+	EXPECT_EQ(0, picoc_test_cyclic(uses_goto, 10, 3));
+	ASSERT_EQ(4, picoc_test_num_values);
+	EXPECT_EQ(-1, picoc_test_values[0]);
+	EXPECT_EQ(1, picoc_test_values[1]);
+	EXPECT_EQ(2, picoc_test_values[2]);
+	EXPECT_EQ(3, picoc_test_values[3]);
+
+	/* a failed compile doesn't leave its static locals behind */
+	const char *static_then_goto =
+		"#include \"test.h\"\n"
+		"void loop() { static int n = 10; n++; emit(n); goto end; end: ; }\n";
+
+	EXPECT_EQ(2, picoc_test_run(static_then_goto, PICOC_TEST_TOKENS, 2));
+	EXPECT_EQ(PICOC_TEST_NOT_COMPILED, picoc_test_run(static_then_goto, PICOC_TEST_COMPILED, 2));
+	EXPECT_EQ(0, picoc_test_cyclic(static_then_goto, 10, 2));
+	ASSERT_EQ(2, picoc_test_num_values);
+	EXPECT_EQ(11, picoc_test_values[0]);
+	EXPECT_EQ(12, picoc_test_values[1]);
+
+	/* the interpreter leaves out some calls in the right operand of '||' and '&&' */
+	const char *calls_in_or =
+		"#include \"test.h\"\n"
+		"int f(int v) { emit(v); return v; }\n"
+		"void loop() {\n"
+		"  emit(1 || f(2)); emit(0 || f(3));\n"
+		"}\n";
+
+	EXPECT_FALSE(picoc_test_compiles(calls_in_or));
+	EXPECT_EQ(0, picoc_test_cyclic(calls_in_or, 10, 1));
+	EXPECT_FALSE(picoc_test_loop_compiled);
+	EXPECT_EQ(4, picoc_test_loop_line);
+	ASSERT_EQ(3, picoc_test_num_values);
+	EXPECT_EQ(1, picoc_test_values[0]);
+	EXPECT_EQ(3, picoc_test_values[1]);
+	EXPECT_EQ(1, picoc_test_values[2]);
+}
+
+/* run time errors and exit() end the script like they do in the interpreter */
+TEST_F(PicoCCompile, Errors) {
+	const char *null_pointer =
+		"#include \"test.h\"\n"
+		"int *p = 0;\n"
+		"void loop() { emit(1); *p = 1; emit(2); }\n";
+
+	EXPECT_EQ(PICOC_TEST_ERROR, picoc_test_run(null_pointer, PICOC_TEST_TOKENS, 3));
+	EXPECT_EQ(PICOC_TEST_ERROR, picoc_test_run(null_pointer, PICOC_TEST_COMPILED, 3));
+	EXPECT_EQ(1, picoc_test_num_values);
+
+	const char *exits =
+		"#include \"test.h\"\n"
+		"int count = 0;\n"
+		"void loop() { count++; emit(count); if (count == 2) exit(7); }\n";
+
+	EXPECT_TRUE(picoc_test_compiles(exits));
+	EXPECT_EQ(7, picoc_test_cyclic(exits, 10, 5));
+	EXPECT_EQ(2, picoc_test_num_values);
+}
+
+/* the cyclic mode sleeps once per cycle */
+TEST_F(PicoCCompile, Cyclic) {
+	EXPECT_EQ(0, picoc_test_cyclic(scripts[4], 20, 4));
+	EXPECT_TRUE(picoc_test_loop_compiled);
+	EXPECT_EQ(0, picoc_test_loop_line);
+	EXPECT_EQ(4, picoc_test_sleeps);
+	EXPECT_EQ(1, picoc_test_values[0]);
+}
+
+/* scripts per second for a small control loop, printed for comparison */
+TEST_F(PicoCCompile, Benchmark) {
+	const char *control =
+		"#include \"test.h\"\n"
+		"double integral = 0; double last = 0; int count = 0;\n"
+		"double pid(double error) {\n"
+		"  integral += error * 0.01;\n"
+		"  if (integral > 10) integral = 10; else if (integral < -10) integral = -10;\n"
+		"  double out = error * 0.5 + integral * 0.1 + (error - last) * 2;\n"
+		"  last = error;\n"
+		"  return out;\n"
+		"}\n"
+		"void loop() {\n"
+		"  int i; double sum = 0;\n"
+		"  for (i = 0; i < 8; i++) sum += pid((count % 50) - 25 + i * 0.5);\n"
+		"  count++;\n"
+		"  if (count % 1000 == 0) emit(sum);\n"
+		"}\n";
+	const char *names[] = { "restart", "interpreted", "compiled" };
+	const enum picoc_test_mode modes[] = { PICOC_TEST_RESTART, PICOC_TEST_TOKENS, PICOC_TEST_COMPILED };
+	double rate[3];
+
+	for (int i = 0; i < 3; i++) {
+		int cycles = (modes[i] == PICOC_TEST_RESTART) ? 2000 : 20000;
+		double start = time_now();
+
+		ASSERT_LE(0, picoc_test_run(control, modes[i], cycles));
+		rate[i] = cycles / (time_now() - start);
+		printf("loop() %-12s %10.0f scripts/s\n", names[i], rate[i]);
+	}
+
+	EXPECT_GT(rate[2], rate[1]);
+	EXPECT_GT(rate[1], rate[0]);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,288 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the simulation physics model
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* sqrtf */
+#include <string.h>		/* memcmp */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+#include "sim_physics.h"
+#include "physical_constants.h"
+}
+
+#define BENCHMARK_SECONDS 60
+
+class SimPhysics : public testing::Test {
+protected:
+  virtual void SetUp() {
+    sim_physics_defaults(&params);
+
+    // Exact sensors unless a test wants noise
+    params.gyro_noise = 0;
+    params.gyro_bias_walk = 0;
+    params.accel_noise = 0;
+    params.mag_noise = 0;
+    params.baro_noise = 0;
+  }
+
+  // Command for each motor to hold the weight
+  float hover_command(int motors) {
+    return sqrtf(params.mass * GRAVITY / (motors * params.max_thrust));
+  }
+
+  void set_all(struct sim_physics *sim, float c) {
+    float command[SIM_PHYSICS_MAX_MOTORS];
+    for (int i = 0; i < SIM_PHYSICS_MAX_MOTORS; i++)
+      command[i] = c;
+    sim_physics_set_command(sim, command, SIM_PHYSICS_MAX_MOTORS);
+  }
+
+  struct sim_physics_params params;
+};
+
+TEST_F(SimPhysics, RestsOnGround) {
+  struct sim_physics sim;
+  sim_physics_init(&sim, &params, 1);
+
+  sim_physics_advance(&sim, 1.0f);
+
+  EXPECT_FLOAT_EQ(0, sim.state.position[2]);
+  EXPECT_TRUE(sim.on_ground);
+
+  float gyro[3], accel[3], mag[3], baro;
+  sim_physics_sensors(&sim, gyro, accel, mag, &baro);
+
+  // Level and still, the accels feel the ground holding it up
+  EXPECT_NEAR(0, accel[0], 1e-5);
+  EXPECT_NEAR(0, accel[1], 1e-5);
+  EXPECT_NEAR(-GRAVITY, accel[2], 1e-5);
+  EXPECT_NEAR(params.mag_field[0], mag[0], 1e-3);
+  EXPECT_NEAR(params.mag_field[2], mag[2], 1e-3);
+}
+
+TEST_F(SimPhysics, ClimbsAndHovers) {
+  struct sim_physics sim;
+  sim_physics_init(&sim, &params, 1);
+
+  // Climb for a second, then hold the weight
+  set_all(&sim, 1.2f * hover_command(4));
+  sim_physics_advance(&sim, 1.0f);
+  EXPECT_FALSE(sim.on_ground);
+  EXPECT_LT(sim.state.velocity[2], 0);
+
+  set_all(&sim, hover_command(4));
+  sim_physics_advance(&sim, 20.0f);
+
+  // Drag has taken the climb rate out and thrust balances gravity
+  EXPECT_LT(sim.state.position[2], -0.5f);
+  EXPECT_NEAR(0, sim.state.velocity[2], 1e-3);
+  EXPECT_NEAR(1, sim.state.q[0], 1e-6);
+
+  float gyro[3], accel[3], mag[3], baro;
+  sim_physics_sensors(&sim, gyro, accel, mag, &baro);
+  EXPECT_NEAR(-GRAVITY, accel[2], 1e-2);
+  EXPECT_NEAR(-sim.state.position[2], baro, 1e-5);
+}
+
+TEST_F(SimPhysics, TorqueSigns) {
+  const float h = hover_command(4);
+
+  struct sim_physics sim;
+  sim_physics_init(&sim, &params, 1);
+  set_all(&sim, 1.5f * h);
+  sim_physics_advance(&sim, 0.5f);
+  ASSERT_FALSE(sim.on_ground);
+
+  struct sim_physics start = sim;
+
+  // Quad X, clockwise from front left: roll right speeds up the left motors
+  float roll[4] = { 1.1f * h, 0.9f * h, 0.9f * h, 1.1f * h };
+  sim_physics_set_command(&sim, roll, 4);
+  sim_physics_advance(&sim, 0.05f);
+  EXPECT_GT(sim.state.rates[0], 0.1f);
+  EXPECT_NEAR(0, sim.state.rates[1], 1e-3);
+
+  // Nose up speeds up the front motors
+  sim = start;
+  float pitch[4] = { 1.1f * h, 1.1f * h, 0.9f * h, 0.9f * h };
+  sim_physics_set_command(&sim, pitch, 4);
+  sim_physics_advance(&sim, 0.05f);
+  EXPECT_GT(sim.state.rates[1], 0.1f);
+  EXPECT_NEAR(0, sim.state.rates[0], 1e-3);
+
+  // Yaw right speeds up the counter clockwise motors 2 and 4
+  sim = start;
+  float yaw[4] = { 0.9f * h, 1.1f * h, 0.9f * h, 1.1f * h };
+  sim_physics_set_command(&sim, yaw, 4);
+  sim_physics_advance(&sim, 0.05f);
+  EXPECT_GT(sim.state.rates[2], 0.01f);
+  EXPECT_NEAR(0, sim.state.rates[0], 1e-3);
+}
+
+TEST_F(SimPhysics, MotorLag) {
+  struct sim_physics sim;
+  sim_physics_init(&sim, &params, 1);
+
+  set_all(&sim, 1);
+  sim_physics_advance(&sim, params.motor_tau);
+
+  // One time constant gets 1 - 1/e of the way
+  EXPECT_NEAR(1 - expf(-1), sim.state.motor[0], 1e-3);
+}
+
+TEST_F(SimPhysics, StepIndependent) {
+  // A tumbling, drifting vehicle comes out the same with coarse and fine
+  // steps, down to single precision
+  const float steps[3] = { 0.008f, 0.002f, 0.0005f };
+  struct sim_physics runs[3];
+
+  for (int r = 0; r < 3; r++) {
+    params.step = steps[r];
+    sim_physics_init(&runs[r], &params, 1);
+    runs[r].on_ground = false;
+    runs[r].state.position[2] = -100;
+    runs[r].state.rates[0] = 3;
+    runs[r].state.rates[1] = -2;
+    runs[r].state.rates[2] = 5;
+    runs[r].state.velocity[0] = 10;
+
+    float c[4] = { 0.6f, 0.4f, 0.5f, 0.3f };
+    sim_physics_set_command(&runs[r], c, 4);
+    sim_physics_advance(&runs[r], 0.4f);
+  }
+
+  for (int r = 0; r < 2; r++) {
+    for (int i = 0; i < 4; i++)
+      EXPECT_NEAR(runs[2].state.q[i], runs[r].state.q[i], 1e-5);
+    for (int i = 0; i < 3; i++) {
+      EXPECT_NEAR(runs[2].state.rates[i], runs[r].state.rates[i], 1e-4);
+      EXPECT_NEAR(runs[2].state.position[i], runs[r].state.position[i], 1e-4);
+    }
+  }
+}
+
+TEST_F(SimPhysics, Deterministic) {
+  params.turbulence = 2;
+  params.gyro_noise = 1;
+
+  struct sim_physics a, b;
+  sim_physics_init(&a, &params, 42);
+  sim_physics_init(&b, &params, 42);
+
+  set_all(&a, 1.2f * hover_command(4));
+  set_all(&b, 1.2f * hover_command(4));
+
+  // Same total time in different slices comes out the same
+  for (int i = 0; i < 1000; i++)
+    sim_physics_advance(&a, 0.002f);
+  for (int i = 0; i < 500; i++)
+    sim_physics_advance(&b, 0.004f);
+
+  EXPECT_NEAR(a.state.position[0], b.state.position[0], 1e-5);
+  EXPECT_NEAR(a.state.position[2], b.state.position[2], 1e-5);
+  EXPECT_NE(0, a.state.position[0]);
+}
+
+TEST_F(SimPhysics, Parse) {
+  EXPECT_EQ(0, sim_physics_parse(&params, "hexa"));
+  EXPECT_EQ(SIM_PHYSICS_FRAME_HEXA, params.frame);
+
+  EXPECT_EQ(0, sim_physics_parse(&params, "octo:mass=2.5,turb=1.5"));
+  EXPECT_EQ(SIM_PHYSICS_FRAME_OCTO, params.frame);
+  EXPECT_FLOAT_EQ(2.5f, params.mass);
+  EXPECT_FLOAT_EQ(1.5f, params.turbulence);
+
+  // Parameters alone keep the frame
+  EXPECT_EQ(0, sim_physics_parse(&params, "windn=3,izz=0.01"));
+  EXPECT_EQ(SIM_PHYSICS_FRAME_OCTO, params.frame);
+  EXPECT_FLOAT_EQ(3, params.wind[0]);
+  EXPECT_FLOAT_EQ(0.01f, params.inertia[2]);
+
+  // Anything wrong leaves the parameters alone
+  struct sim_physics_params before = params;
+  EXPECT_EQ(-1, sim_physics_parse(&params, "tricopter"));
+  EXPECT_EQ(-1, sim_physics_parse(&params, "quadx:mass"));
+  EXPECT_EQ(-1, sim_physics_parse(&params, "quadx:mass=heavy"));
+  EXPECT_EQ(-1, sim_physics_parse(&params, "quadx:color=red"));
+  EXPECT_EQ(-1, sim_physics_parse(&params, "quadx:mass=-1"));
+  EXPECT_EQ(-1, sim_physics_parse(&params, "mass=1,step=0.1"));
+  EXPECT_EQ(0, memcmp(&before, &params, sizeof(params)));
+}
+
+TEST_F(SimPhysics, HexaHovers) {
+  ASSERT_EQ(0, sim_physics_parse(&params, "hexa"));
+
+  struct sim_physics sim;
+  sim_physics_init(&sim, &params, 1);
+  ASSERT_EQ(6, sim.num_motors);
+
+  set_all(&sim, 1.1f * hover_command(6));
+  sim_physics_advance(&sim, 2.0f);
+
+  // Balanced layout: climbs straight without turning
+  EXPECT_LT(sim.state.position[2], -0.1f);
+  EXPECT_NEAR(0, sim.state.rates[0], 1e-4);
+  EXPECT_NEAR(0, sim.state.rates[1], 1e-4);
+  EXPECT_NEAR(0, sim.state.rates[2], 1e-4);
+}
+
+TEST_F(SimPhysics, BenchmarkRealTime) {
+  params.turbulence = 1;
+  params.gyro_noise = 0.5f;
+
+  struct sim_physics sim;
+  sim_physics_init(&sim, &params, 1);
+  set_all(&sim, hover_command(4));
+
+  struct timespec start, end;
+  float gyro[3], accel[3], mag[3], baro;
+
+  // Stepped and sampled like the simulation target, at 500 Hz
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < BENCHMARK_SECONDS * 500; i++) {
+    sim_physics_advance(&sim, 0.002f);
+    sim_physics_sensors(&sim, gyro, accel, mag, &baro);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  printf("%d s of flight in %.3f s, %.0fx real time (%g)\n",
+      BENCHMARK_SECONDS, elapsed, BENCHMARK_SECONDS / elapsed, baro);
+
+  EXPECT_GT(BENCHMARK_SECONDS / elapsed, 100);
+}
@@ -0,0 +1,170 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the simulator sensor frames
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memset */
+
+extern "C" {
+#include "sim_sensor_frame.h"
+}
+
+class SimSensorFrame : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(buf, 0, sizeof(buf));
+  }
+
+  int build(uint32_t sequence, int count) {
+    struct sim_sensor_frame_header header = {};
+    header.magic = SIM_SENSOR_FRAME_MAGIC;
+    header.version = SIM_SENSOR_FRAME_VERSION;
+    header.count = count;
+    header.sequence = sequence;
+    memcpy(buf, &header, sizeof(header));
+
+    for (int i = 0; i < count; i++) {
+      struct sim_sensor_sample sample = {};
+      sample.time_us = 1000 * i;
+      sample.valid = SIM_SENSOR_VALID_GYRO;
+      sample.gyro[0] = i;
+      memcpy(buf + sizeof(header) + i * sizeof(sample), &sample, sizeof(sample));
+    }
+
+    return sizeof(header) + count * sizeof(struct sim_sensor_sample);
+  }
+
+  uint8_t buf[SIM_SENSOR_FRAME_MAX_LENGTH + 64];
+};
+
+TEST_F(SimSensorFrame, Layout) {
+  // The bridge packs these by hand
+  EXPECT_EQ(12U, sizeof(struct sim_sensor_frame_header));
+  EXPECT_EQ(52U, sizeof(struct sim_sensor_sample));
+}
+
+TEST_F(SimSensorFrame, ParseValid) {
+  uint32_t sequence = 0;
+  const struct sim_sensor_sample *samples = NULL;
+
+  int len = build(42, 4);
+
+  ASSERT_EQ(4, sim_sensor_frame_parse(buf, len, &sequence, &samples));
+  EXPECT_EQ(42U, sequence);
+  EXPECT_EQ(3000U, samples[3].time_us);
+  EXPECT_EQ(3.0f, samples[3].gyro[0]);
+}
+
+TEST_F(SimSensorFrame, ParseEmpty) {
+  uint32_t sequence;
+  const struct sim_sensor_sample *samples;
+
+  int len = build(7, 0);
+
+  EXPECT_EQ(0, sim_sensor_frame_parse(buf, len, &sequence, &samples));
+  EXPECT_EQ(7U, sequence);
+}
+
+TEST_F(SimSensorFrame, RejectMalformed) {
+  uint32_t sequence;
+  const struct sim_sensor_sample *samples;
+
+  int len = build(1, 2);
+
+  // Truncated header and truncated or padded samples
+  EXPECT_EQ(-1, sim_sensor_frame_parse(buf, 4, &sequence, &samples));
+  EXPECT_EQ(-1, sim_sensor_frame_parse(buf, len - 1, &sequence, &samples));
+  EXPECT_EQ(-1, sim_sensor_frame_parse(buf, len + 1, &sequence, &samples));
+
+  // Wrong magic
+  buf[0] ^= 0xff;
+  EXPECT_EQ(-1, sim_sensor_frame_parse(buf, len, &sequence, &samples));
+  buf[0] ^= 0xff;
+
+  // Unknown version
+  buf[4] = SIM_SENSOR_FRAME_VERSION + 1;
+  EXPECT_EQ(-1, sim_sensor_frame_parse(buf, len, &sequence, &samples));
+  buf[4] = SIM_SENSOR_FRAME_VERSION;
+
+  // Too many samples, even if the length agrees
+  len = build(1, SIM_SENSOR_FRAME_MAX_SAMPLES + 1);
+  EXPECT_EQ(-1, sim_sensor_frame_parse(buf, len, &sequence, &samples));
+}
+
+TEST_F(SimSensorFrame, PacerFollowsTimestamps) {
+  struct sim_sensor_pacer pacer;
+  sim_sensor_pacer_reset(&pacer);
+
+  // First sample is due right away and sets the offset
+  EXPECT_TRUE(sim_sensor_pacer_due(&pacer, 1000, 500000));
+
+  // Later samples wait for the local clock to catch up
+  EXPECT_FALSE(sim_sensor_pacer_due(&pacer, 2000, 500000));
+  EXPECT_FALSE(sim_sensor_pacer_due(&pacer, 2000, 500999));
+  EXPECT_TRUE(sim_sensor_pacer_due(&pacer, 2000, 501000));
+
+  // A little late is released without resyncing
+  EXPECT_TRUE(sim_sensor_pacer_due(&pacer, 3000, 510000));
+  EXPECT_EQ(0U, pacer.resyncs);
+}
+
+TEST_F(SimSensorFrame, PacerResyncs) {
+  struct sim_sensor_pacer pacer;
+  sim_sensor_pacer_reset(&pacer);
+
+  EXPECT_TRUE(sim_sensor_pacer_due(&pacer, 1000, 500000));
+
+  // Simulator restarted, time went backwards
+  EXPECT_TRUE(sim_sensor_pacer_due(&pacer, 0xf0000000, 501000));
+  EXPECT_EQ(1U, pacer.resyncs);
+
+  // Paced from the new origin
+  EXPECT_FALSE(sim_sensor_pacer_due(&pacer, 0xf0000000 + 1000, 501500));
+  EXPECT_TRUE(sim_sensor_pacer_due(&pacer, 0xf0000000 + 1000, 502000));
+
+  // Local stall: way behind is released at once, and pacing restarts there
+  EXPECT_TRUE(sim_sensor_pacer_due(&pacer, 0xf0000000 + 2000, 900000));
+  EXPECT_EQ(2U, pacer.resyncs);
+  EXPECT_FALSE(sim_sensor_pacer_due(&pacer, 0xf0000000 + 3000, 900000));
+}
+
+TEST_F(SimSensorFrame, PacerWraps) {
+  struct sim_sensor_pacer pacer;
+  sim_sensor_pacer_reset(&pacer);
+
+  EXPECT_TRUE(sim_sensor_pacer_due(&pacer, 0xfffffc18, 0xfffff000));
+  EXPECT_FALSE(sim_sensor_pacer_due(&pacer, 0x00000000, 0xfffff100));
+  EXPECT_TRUE(sim_sensor_pacer_due(&pacer, 0x00000000, 0xfffff3e8));
+  EXPECT_EQ(0U, pacer.resyncs);
+}
@@ -17,8 +17,24 @@ struct flash_posix_dev {
 	const struct pios_flash_posix_cfg * cfg;
 	bool transaction_in_progress;
 	FILE * flash_file;
+	uint64_t busy_until_us;
 };
 
+/* Typical timings of a 64 KB sector erase and a page program */
+#define FLASH_POSIX_ERASE_US 150000
+#define FLASH_POSIX_WRITE_US 700
+
+uint64_t pios_flash_posix_clock_us;
+bool pios_flash_posix_async_erase = true;
+
+/* Everything else waits for an erase in progress to finish */
+static void PIOS_Flash_Posix_WaitIdle(struct flash_posix_dev * flash_dev)
+{
+	if (pios_flash_posix_clock_us < flash_dev->busy_until_us) {
+		pios_flash_posix_clock_us = flash_dev->busy_until_us;
+	}
+}
+
 static struct flash_posix_dev * PIOS_Flash_Posix_Alloc(void)
 {
 	struct flash_posix_dev * flash_dev = PIOS_malloc(sizeof(struct flash_posix_dev));
@@ -42,6 +58,7 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix
 
 	flash_dev->cfg = cfg;
 	flash_dev->transaction_in_progress = false;
+	flash_dev->busy_until_us = 0;
 
 	flash_dev->flash_file = fopen ("theflash.bin", "r+");
 	if (flash_dev->flash_file == NULL) {
@@ -95,11 +112,10 @@ static int32_t PIOS_Flash_Posix_EndTransaction(uintptr_t chip_id)
 	return 0;
 }
 
-static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset)
+/* Erase now, leaving the chip busy for as long as the erase would take */
+static void PIOS_Flash_Posix_Erase(struct flash_posix_dev * flash_dev, uint32_t chip_offset)
 {
-	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
-
-	assert(flash_dev->transaction_in_progress);
+	PIOS_Flash_Posix_WaitIdle(flash_dev);
 
 	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
 		assert(0);
@@ -116,9 +132,43 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	assert (s == flash_dev->cfg->size_of_sector);
 
+	flash_dev->busy_until_us = pios_flash_posix_clock_us + FLASH_POSIX_ERASE_US;
+}
+
+static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	assert(flash_dev->transaction_in_progress);
+
+	PIOS_Flash_Posix_Erase(flash_dev, chip_offset);
+	PIOS_Flash_Posix_WaitIdle(flash_dev);
+
 	return 0;
 }
 
+static int32_t PIOS_Flash_Posix_EraseSectorStart(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	assert(flash_dev->transaction_in_progress);
+
+	if (!pios_flash_posix_async_erase) {
+		return -1;
+	}
+
+	PIOS_Flash_Posix_Erase(flash_dev, chip_offset);
+
+	return 0;
+}
+
+static int32_t PIOS_Flash_Posix_Busy(uintptr_t chip_id)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	return pios_flash_posix_clock_us < flash_dev->busy_until_us;
+}
+
 static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offset, const uint8_t * data, uint16_t len)
 {
 	/* Check inputs */
@@ -128,6 +178,9 @@ static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offse
 
 	assert(flash_dev->transaction_in_progress);
 
+	PIOS_Flash_Posix_WaitIdle(flash_dev);
+	pios_flash_posix_clock_us += FLASH_POSIX_WRITE_US;
+
 	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
 		assert(0);
 	}
@@ -149,6 +202,8 @@ static int32_t PIOS_Flash_Posix_ReadData(uintptr_t chip_id, uint32_t chip_offset
 
 	assert(flash_dev->transaction_in_progress);
 
+	PIOS_Flash_Posix_WaitIdle(flash_dev);
+
 	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
 		assert(0);
 	}
@@ -166,6 +221,8 @@ const struct pios_flash_driver pios_posix_flash_driver = {
 	.start_transaction = PIOS_Flash_Posix_StartTransaction,
 	.end_transaction   = PIOS_Flash_Posix_EndTransaction,
 	.erase_sector      = PIOS_Flash_Posix_EraseSector,
+	.erase_sector_start = PIOS_Flash_Posix_EraseSectorStart,
+	.busy              = PIOS_Flash_Posix_Busy,
 	.write_data        = PIOS_Flash_Posix_WriteData,
 	.read_data         = PIOS_Flash_Posix_ReadData,
 };
@@ -1,3 +1,4 @@
+#include <stdbool.h>
 #include <stdint.h>
 
 struct pios_flash_posix_cfg {
@@ -9,3 +10,9 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix
 void PIOS_Flash_Posix_Destroy(uintptr_t chip_id);
 
 extern const struct pios_flash_driver pios_posix_flash_driver;
+
+/* Simulated time in us; chip operations advance it like a JEDEC part would */
+extern uint64_t pios_flash_posix_clock_us;
+
+/* Whether erases can run in the background, cleared for a baseline */
+extern bool pios_flash_posix_async_erase;
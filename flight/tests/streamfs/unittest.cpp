@@ -150,6 +150,9 @@ protected:
   virtual void TearDown() {
     PIOS_STREAMFS_Destroy(fs_id);
     PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+
+    /* Remove the flash image made by the super fixture */
+    StreamfsTestRaw::TearDown();
   }
 
   void CompareArray(uint8_t *a, uint8_t *b, int32_t size) {
@@ -462,3 +465,111 @@ TEST_F(StreamfsComTest, ComRead) {
   EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
   CompareArray(data1, data_read, DATA_LEN);
 }
+
+/*
+ * Logging at a steady rate, as the logging module does, on a flash whose
+ * sector erase takes 150 ms and page program 0.7 ms of simulated time.
+ */
+#define TIMED_CHUNK 100
+#define TIMED_LEN (6 * 64 * 1024)
+
+class StreamfsTimingTest : public StreamfsTestCooked {
+protected:
+  virtual void SetUp() {
+    StreamfsTestCooked::SetUp();
+
+    /* Leave old logs everywhere, so that every arena needs an erase */
+    EXPECT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+    for (uint32_t i = 0; i < 20; i++) {
+      EXPECT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, data1, DATA_LEN));
+    }
+    EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+  }
+
+  virtual void TearDown() {
+    pios_flash_posix_async_erase = true;
+    StreamfsTestCooked::TearDown();
+  }
+
+  uint8_t Pattern(uint32_t i) {
+    return (i * 7) ^ (i >> 8);
+  }
+
+  /* Writes TIMED_LEN bytes, a chunk every period_us after opening, and
+   * returns the longest time one write kept the caller waiting */
+  uint64_t WritePaced(uint64_t period_us) {
+    uint8_t chunk[TIMED_CHUNK];
+    uint64_t max_latency = 0;
+
+    EXPECT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+    uint64_t opened = pios_flash_posix_clock_us;
+
+    for (uint32_t pos = 0; pos < TIMED_LEN; pos += TIMED_CHUNK) {
+      uint64_t due = opened + (pos / TIMED_CHUNK) * period_us;
+      if (pios_flash_posix_clock_us < due) {
+        pios_flash_posix_clock_us = due;
+      }
+
+      for (int i = 0; i < TIMED_CHUNK; i++) {
+        chunk[i] = Pattern(pos + i);
+      }
+
+      uint64_t start = pios_flash_posix_clock_us;
+      EXPECT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, chunk, TIMED_CHUNK));
+      if (pios_flash_posix_clock_us - start > max_latency) {
+        max_latency = pios_flash_posix_clock_us - start;
+      }
+    }
+
+    EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+    return max_latency;
+  }
+
+  void CheckWritten() {
+    uint8_t chunk[TIMED_CHUNK];
+
+    EXPECT_EQ(0, PIOS_STREAMFS_OpenRead(fs_id, PIOS_STREAMFS_MaxFileId(fs_id)));
+    for (uint32_t pos = 0; pos < TIMED_LEN; pos += TIMED_CHUNK) {
+      ASSERT_EQ(TIMED_CHUNK, PIOS_STREAMFS_Testing_Read(fs_id, chunk, TIMED_CHUNK));
+      for (int i = 0; i < TIMED_CHUNK; i++) {
+        ASSERT_EQ(Pattern(pos + i), chunk[i]);
+      }
+    }
+    EXPECT_EQ(0, PIOS_STREAMFS_Testing_Read(fs_id, chunk, TIMED_CHUNK));
+    EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+  }
+};
+
+TEST_F(StreamfsTimingTest, PacedLatency) {
+  // About 16 KB/s
+  uint64_t max_latency = WritePaced(6000);
+  printf("Longest write at 16 KB/s: %.1f ms\n", max_latency / 1000.0);
+  CheckWritten();
+
+  // Never waits for an erase, only writes out what was buffered during one
+  EXPECT_LT(max_latency, 15000U);
+}
+
+TEST_F(StreamfsTimingTest, PacedLatencySyncErase) {
+  pios_flash_posix_async_erase = false;
+
+  uint64_t max_latency = WritePaced(6000);
+  printf("Longest write at 16 KB/s, erasing in place: %.1f ms\n", max_latency / 1000.0);
+  CheckWritten();
+
+  EXPECT_GE(max_latency, 150000U);
+}
+
+TEST_F(StreamfsTimingTest, Throughput) {
+  uint64_t start = pios_flash_posix_clock_us;
+  WritePaced(0);
+  uint64_t elapsed = pios_flash_posix_clock_us - start;
+  CheckWritten();
+
+  printf("Sustained: %.1f KB/s\n", TIMED_LEN * 1000000.0 / 1024 / elapsed);
+
+  // One program per page rather than per write; the chip cannot program
+  // while it erases, so the erases still count
+  EXPECT_LT(elapsed, (TIMED_LEN / 256) * 700U + 8 * 150000U);
+}
@@ -0,0 +1,264 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <pthread.h>		/* pthread_create */
+#include <time.h>		/* clock_gettime */
+#include <algorithm>		/* std::sort */
+#include <vector>		/* std::vector */
+
+extern "C" {
+
+#include "openpilot.h"
+
+}
+
+#define DATA_OBJ_ID     0x1000
+#define SETTINGS_OBJ_ID 0x2000
+#define OBJ_WORDS       32
+#define NUM_READERS     3
+#define NUM_WRITES      200000
+
+#define LOOP_ITERATIONS 2000
+#define LOOP_PERIOD_US  500
+#define LOCK_HOLD_US    50
+#define SLOW_GET_US     10
+
+struct test_obj {
+  uint32_t words[OBJ_WORDS];
+};
+
+static UAVObjHandle data_obj;
+static UAVObjHandle settings_obj;
+
+static double now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVObjSeqlock : public testing::Test {
+protected:
+  static void SetUpTestCase() {
+    ASSERT_EQ(0, UAVObjInitialize());
+
+    data_obj = UAVObjRegister(DATA_OBJ_ID, 1, 0, sizeof(struct test_obj), NULL);
+    settings_obj = UAVObjRegister(SETTINGS_OBJ_ID, 1, 1, sizeof(struct test_obj), NULL);
+
+    ASSERT_TRUE(data_obj != NULL);
+    ASSERT_TRUE(settings_obj != NULL);
+  }
+
+  static void fill(struct test_obj *obj, uint32_t value) {
+    for (int i = 0; i < OBJ_WORDS; i++)
+      obj->words[i] = value;
+  }
+
+  static bool consistent(const struct test_obj *obj) {
+    for (int i = 1; i < OBJ_WORDS; i++)
+      if (obj->words[i] != obj->words[0])
+        return false;
+    return true;
+  }
+};
+
+TEST_F(UAVObjSeqlock, GetReturnsLastSet) {
+  struct test_obj in, out;
+
+  fill(&in, 0x12345678);
+  ASSERT_EQ(0, UAVObjSetData(data_obj, &in));
+  ASSERT_EQ(0, UAVObjGetData(data_obj, &out));
+  EXPECT_EQ(0, memcmp(&in, &out, sizeof(in)));
+
+  uint32_t word = 0;
+  in.words[5] = 0xcafe;
+  ASSERT_EQ(0, UAVObjSetDataField(data_obj, &in.words[5], 5 * sizeof(uint32_t), sizeof(uint32_t)));
+  ASSERT_EQ(0, UAVObjGetDataField(data_obj, &word, 5 * sizeof(uint32_t), sizeof(uint32_t)));
+  EXPECT_EQ(0xcafeu, word);
+
+  // Out of range fields are still rejected
+  EXPECT_EQ(-1, UAVObjGetDataField(data_obj, &word, sizeof(in), sizeof(uint32_t)));
+
+  // Only instance 0 exists
+  EXPECT_EQ(-1, UAVObjGetInstanceData(data_obj, 1, &out));
+}
+
+TEST_F(UAVObjSeqlock, UnpackIsVisible) {
+  struct test_obj in, out;
+
+  fill(&in, 0xabcdef01);
+  ASSERT_EQ(0, UAVObjUnpack(data_obj, 0, (const uint8_t *) &in));
+  ASSERT_EQ(0, UAVObjGetData(data_obj, &out));
+  EXPECT_EQ(0, memcmp(&in, &out, sizeof(in)));
+}
+
+struct reader_result {
+  UAVObjHandle obj;
+  volatile bool *done;
+  uint32_t reads;
+  uint32_t torn;
+};
+
+static void *reader_thread(void *ctx)
+{
+  struct reader_result *result = (struct reader_result *) ctx;
+  struct test_obj obj;
+
+  while (!*result->done) {
+    UAVObjGetData(result->obj, &obj);
+    result->reads++;
+
+    for (int i = 1; i < OBJ_WORDS; i++) {
+      if (obj.words[i] != obj.words[0]) {
+        result->torn++;
+        break;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+// Readers racing a writer must only ever see whole updates
+TEST_F(UAVObjSeqlock, NoTornReads) {
+  volatile bool done = false;
+  pthread_t threads[NUM_READERS];
+  struct reader_result results[NUM_READERS];
+
+  for (int i = 0; i < NUM_READERS; i++) {
+    results[i] = (struct reader_result) { data_obj, &done, 0, 0 };
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, reader_thread, &results[i]));
+  }
+
+  struct test_obj obj;
+  for (uint32_t n = 0; n < NUM_WRITES; n++) {
+    fill(&obj, n);
+    UAVObjSetData(data_obj, &obj);
+  }
+
+  done = true;
+
+  for (int i = 0; i < NUM_READERS; i++) {
+    pthread_join(threads[i], NULL);
+    EXPECT_GT(results[i].reads, 0u);
+    EXPECT_EQ(0u, results[i].torn);
+  }
+}
+
+static volatile bool contender_done;
+
+static void hold_lock(UAVObjHandle obj)
+{
+  (void) obj;
+
+  // Stands in for telemetry or logging packing objects under the lock
+  double until = now_us() + LOCK_HOLD_US;
+  while (now_us() < until);
+}
+
+static void *contender_thread(void *ctx)
+{
+  (void) ctx;
+
+  while (!contender_done) {
+    UAVObjIterate(hold_lock);
+
+    // Short gap so the lock is not held continuously
+    struct timespec gap = { 0, 200000 };
+    nanosleep(&gap, NULL);
+  }
+
+  return NULL;
+}
+
+// Runs a loop of gets against obj while another thread holds the object
+// manager lock, and returns the sorted latencies of each get in us
+static std::vector<double> loop_latencies(UAVObjHandle obj)
+{
+  std::vector<double> latencies;
+  struct test_obj data;
+  pthread_t contender;
+
+  contender_done = false;
+  pthread_create(&contender, NULL, contender_thread, NULL);
+
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  for (int i = 0; i < LOOP_ITERATIONS; i++) {
+    // Sleep like a task waiting on its queue, so the contender runs between
+    next.tv_nsec += LOOP_PERIOD_US * 1000;
+    if (next.tv_nsec >= 1000000000) {
+      next.tv_nsec -= 1000000000;
+      next.tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+    double start = now_us();
+    UAVObjGetData(obj, &data);
+    latencies.push_back(now_us() - start);
+  }
+
+  contender_done = true;
+  pthread_join(contender, NULL);
+
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+static void print_latencies(const char *name, const std::vector<double> &l)
+{
+  int slow = l.end() - std::upper_bound(l.begin(), l.end(), (double) SLOW_GET_US);
+
+  printf("  %-8s p50 %.2f us, p90 %.2f us, p99 %.2f us, %d of %d over %d us\n",
+      name, l[l.size() / 2], l[l.size() * 9 / 10], l[l.size() * 99 / 100],
+      slow, (int) l.size(), SLOW_GET_US);
+}
+
+// Not a pass/fail test: compares the latency of a get in a control loop for
+// a data object (lock-free) and a settings object (mutex) while another
+// thread keeps taking the object manager lock
+TEST_F(UAVObjSeqlock, BenchmarkLoopJitter) {
+  std::vector<double> data = loop_latencies(data_obj);
+  std::vector<double> settings = loop_latencies(settings_obj);
+
+  printf("Get every %d us, lock held %d us per object by another thread:\n",
+      LOOP_PERIOD_US, LOCK_HOLD_US);
+  print_latencies("seqlock:", data);
+  print_latencies("mutex:", settings);
+}
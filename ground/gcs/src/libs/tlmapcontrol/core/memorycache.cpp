@@ -31,7 +31,7 @@
 namespace core {
     MemoryCache::MemoryCache()
     {
-
+        decodedTiles.setMaxCost(DEFAULT_DECODED_CAPACITY*1048576);
     }
 
 
@@ -58,4 +58,50 @@ namespace core {
         kiberCacheLock.unlock();
     }
 
+    QImage MemoryCache::GetDecodedTileFromMemoryCache(const RawTile &tile)
+    {
+        QImage image;
+        decodedTilesLock.lock();
+        // Looking a tile up makes it the most recently used
+        QImage *cached=decodedTiles.object(tile);
+        if(cached)
+            image=*cached;
+        decodedTilesLock.unlock();
+        return image;
+    }
+    void MemoryCache::AddDecodedTileToMemoryCache(const RawTile &tile, const QImage &image)
+    {
+        decodedTilesLock.lock();
+        decodedTiles.insert(tile,new QImage(image),image.bytesPerLine()*image.height());
+        decodedTilesLock.unlock();
+    }
+    /**
+     * Sets the budget for decoded tiles in Mb, dropping the least recently
+     * used ones over it
+     */
+    void MemoryCache::setDecodedCacheCapacity(const int &value)
+    {
+        decodedTilesLock.lock();
+        decodedTiles.setMaxCost(value*1048576);
+        decodedTilesLock.unlock();
+    }
+    double MemoryCache::DecodedCacheSize()
+    {
+        decodedTilesLock.lock();
+        double size=decodedTiles.totalCost()/1048576.0;
+        decodedTilesLock.unlock();
+        return size;
+    }
+    /**
+     * Decodes a downloaded tile into the format the raster paint engine
+     * draws without converting
+     */
+    QImage MemoryCache::DecodeTile(const QByteArray &pic)
+    {
+        QImage image=QImage::fromData(pic);
+        if(!image.isNull() && image.format()!=QImage::Format_RGB32 && image.format()!=QImage::Format_ARGB32_Premultiplied)
+            image=image.convertToFormat(image.hasAlphaChannel()?QImage::Format_ARGB32_Premultiplied:QImage::Format_RGB32);
+        return image;
+    }
+
 }
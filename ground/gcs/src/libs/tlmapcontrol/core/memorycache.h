@@ -32,19 +32,38 @@
 #include <QMutex>
 #include <QReadWriteLock>
 #include <QQueue>
+#include <QCache>
+#include <QImage>
 #include "kibertilecache.h"
 #include <QDebug>
 #include "debugheader.h"
 namespace core {
+    /**
+     * Tiles are kept twice: as downloaded, up to the TilesInMemory capacity,
+     * and decoded, in a least recently used cache with its own budget in
+     * bytes of image data.  Tiles are decoded by the loader threads so
+     * painting a tile that has been seen before is only a blit.
+     */
     class MemoryCache
     {
     public:
+        static const int DEFAULT_DECODED_CAPACITY = 64;
+
         MemoryCache();
 
         KiberTileCache TilesInMemory;
         QByteArray GetTileFromMemoryCache(const RawTile &tile);
         void AddTileToMemoryCache(const RawTile &tile, const QByteArray &pic);
         QReadWriteLock kiberCacheLock;
+
+        QImage GetDecodedTileFromMemoryCache(const RawTile &tile);
+        void AddDecodedTileToMemoryCache(const RawTile &tile, const QImage &image);
+        void setDecodedCacheCapacity(const int &value);
+        double DecodedCacheSize();
+        static QImage DecodeTile(const QByteArray &pic);
+    private:
+        QCache<RawTile,QImage> decodedTiles;
+        QMutex decodedTilesLock;
     };
 
 
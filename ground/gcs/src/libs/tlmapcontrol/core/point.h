@@ -30,6 +30,7 @@
 
 
 #include <QString>
+#include "corecommon.h"
 
 /**
  * For the most part, points are referenced in quadtiles. Due to integer overflow
@@ -38,7 +39,7 @@
  */
 namespace core {
     struct Size;
-    struct Point
+    struct TLMAPWIDGET_EXPORT Point
     {
         friend quint64 qHash(Point const& point);
         friend bool operator==(Point const& lhs,Point const& rhs);
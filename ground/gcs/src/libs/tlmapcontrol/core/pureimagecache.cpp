@@ -37,6 +37,12 @@ namespace core {
 
     }
 
+    PureImageCache::~PureImageCache()
+    {
+        // Other threads close their connections when they exit
+        connections.setLocalData(0);
+    }
+
     void PureImageCache::setGtileCache(const QString &value)
     {
         lock.lockForWrite();
@@ -163,6 +169,15 @@ namespace core {
             {
 #ifdef DEBUG_PUREIMAGECACHE
                 qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+                db.close();
+                return false;
+            }
+            query.exec("CREATE INDEX IF NOT EXISTS idx_Tiles_XYZoomType ON Tiles(X, Y, Zoom, Type)");
+            if(query.numRowsAffected()==-1)
+            {
+#ifdef DEBUG_PUREIMAGECACHE
+                qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
 #endif //DEBUG_PUREIMAGECACHE
                 db.close();
                 return false;
@@ -180,123 +195,183 @@ namespace core {
 #ifdef DEBUG_PUREIMAGECACHE
         qDebug()<<"PutImageToCache Start:";//<<pos;
 #endif //DEBUG_PUREIMAGECACHE
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        bool ret=false;
+        Connection *cn=connection();
+        if(cn)
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
+            if(cn->pendingWrites==0)
             {
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
-
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
-                }
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
-                }
-                cn.close();
+                cn->db.transaction();
+                cn->batchAge.start();
+            }
+            cn->insertTile->bindValue(0,pos.X());
+            cn->insertTile->bindValue(1,pos.Y());
+            cn->insertTile->bindValue(2,zoom);
+            cn->insertTile->bindValue(3,(int)type);
+            cn->insertTile->bindValue(4,QDateTime::currentDateTime().toString());
+            ret=cn->insertTile->exec();
+            if(ret)
+            {
+                cn->insertData->bindValue(0,tile);
+                ret=cn->insertData->exec();
             }
+            if(++cn->pendingWrites>=WRITE_BATCH || cn->batchAge.elapsed()>=WRITE_BATCH_MS)
+                cn->commit();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
-        return true;
+        return ret;
     }
     QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
     {
         lock.lockForRead();
         QByteArray ar;
         if(gtilecache.isEmpty()|gtilecache.isNull())
+        {
+            lock.unlock();
             return ar;
-        QString dir=gtilecache;
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        }
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"Cache dir="<<dir<<" Try to GET:"<<pos.X()+","+pos.Y();
+        qDebug()<<"Cache dir="<<gtilecache<<" Try to GET:"<<pos.X()+","+pos.Y();
 #endif //DEBUG_PUREIMAGECACHE
-
+        Connection *cn=connection();
+        if(cn)
         {
-            QString db=dir+"Data.qmdb";
-            {
-                QSqlDatabase cn;
-
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int) type));
-                        query.next();
-                        if(query.isValid())
-                        {
-                            ar=query.value(0).toByteArray();
-                        }
-                    }
-                    cn.close();
-                }
-            }
+            QSqlQuery *query=cn->selectTile;
+            query->bindValue(0,pos.X());
+            query->bindValue(1,pos.Y());
+            query->bindValue(2,zoom);
+            query->bindValue(3,(int)type);
+            if(query->exec() && query->next())
+                ar=query->value(0).toByteArray();
+            // Resets the statement so it does not hold a read transaction open
+            query->finish();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
         return ar;
     }
+    /**
+     * Commits the tiles this thread has written but not yet committed
+     */
+    void PureImageCache::Flush()
+    {
+        lock.lockForRead();
+        if(connections.hasLocalData() && connections.localData())
+            connections.localData()->commit();
+        lock.unlock();
+    }
     void PureImageCache::deleteOlderTiles(int const& days)
     {
         if(gtilecache.isEmpty()|gtilecache.isNull())
             return;
-        QList<long> add;
-        bool ret=true;
-        QString dir=gtilecache;
+        lock.lockForRead();
+        QList<qlonglong> add;
+        Connection *cn=0;
+        if(QFileInfo(gtilecache+"Data.qmdb").exists())
+            cn=connection();
+        if(cn)
         {
-            QString db=dir+"Data.qmdb";
-            ret=QFileInfo(db).exists();
-            if(ret)
+            cn->commit();
             {
-                QSqlDatabase cn;
-                Mcounter.lock();
-                qlonglong id=++ConnCounter;
-                Mcounter.unlock();
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
+                QSqlQuery query(cn->db);
+                query.exec(QString("SELECT id, Date FROM Tiles"));
+                while(query.next())
                 {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
-                        while(query.next())
-                        {
-                            if(QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime())>days)
-                                add.append(query.value(0).toLongLong());
-                        }
-                        foreach(long i,add)
-                        {
-                            query.exec(QString("DELETE FROM Tiles WHERE id = %1;").arg(i));
-                        }
-                    }
-
-                    cn.close();
+                    if(QDateTime::fromString(query.value(1).toString()).daysTo(QDateTime::currentDateTime())>days)
+                        add.append(query.value(0).toLongLong());
+                }
+            }
+            cn->db.transaction();
+            {
+                QSqlQuery query(cn->db);
+                query.prepare("DELETE FROM Tiles WHERE id = ?");
+                foreach(qlonglong i,add)
+                {
+                    query.bindValue(0,i);
+                    query.exec();
                 }
-                QSqlDatabase::removeDatabase(QString::number(id));
             }
+            cn->db.commit();
         }
+        lock.unlock();
+    }
+    /**
+     * Returns this thread's connection to the current cache file, opening it
+     * if needed.  Called with lock held.
+     */
+    PureImageCache::Connection *PureImageCache::connection()
+    {
+        QString file=gtilecache+"Data.qmdb";
+        if(connections.hasLocalData())
+        {
+            Connection *cn=connections.localData();
+            if(cn && cn->file==file)
+                return cn;
+        }
+        Mcounter.lock();
+        qlonglong id=++ConnCounter;
+        Mcounter.unlock();
+        // Replacing the local data closes the connection to the old file
+        Connection *cn=new Connection(QString("PureImageCache%1").arg(id),file);
+        if(!cn->db.isOpen())
+        {
+            connections.setLocalData(0);
+            delete cn;
+            return 0;
+        }
+        connections.setLocalData(cn);
+        return cn;
+    }
+    /**
+     * Settings for every connection to a cache file, run on open
+     */
+    void PureImageCache::prepareDB(QSqlDatabase &db)
+    {
+        QSqlQuery query(db);
+        // WAL lets the cache thread write while the map threads read.  With it
+        // a NORMAL sync can only lose the last commits on power loss, never
+        // corrupt the file, which is fine for a cache.
+        query.exec("PRAGMA journal_mode=WAL");
+        query.exec("PRAGMA synchronous=NORMAL");
+        // Caches created before the index was part of the schema
+        query.exec("CREATE INDEX IF NOT EXISTS idx_Tiles_XYZoomType ON Tiles(X, Y, Zoom, Type)");
+    }
+    PureImageCache::Connection::Connection(const QString &name, const QString &file) :
+        name(name),file(file),selectTile(0),insertTile(0),insertData(0),pendingWrites(0)
+    {
+        db=QSqlDatabase::addDatabase("QSQLITE",name);
+        db.setDatabaseName(file);
+        if(!db.open())
+        {
+#ifdef DEBUG_PUREIMAGECACHE
+            qDebug()<<"Unable to open cache database"<<file<<db.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+            return;
+        }
+        prepareDB(db);
+        selectTile=new QSqlQuery(db);
+        selectTile->prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?)");
+        insertTile=new QSqlQuery(db);
+        insertTile->prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
+        insertData=new QSqlQuery(db);
+        insertData->prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
+    }
+    PureImageCache::Connection::~Connection()
+    {
+        commit();
+        delete selectTile;
+        delete insertTile;
+        delete insertData;
+        db.close();
+        // The handle has to go before the connection can be removed
+        db=QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+    }
+    bool PureImageCache::Connection::commit()
+    {
+        if(pendingWrites==0)
+            return true;
+        pendingWrites=0;
+        return db.commit();
     }
     // PureImageCache::ExportMapDataToDB("C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data.qmdb","C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data2.qmdb");
     bool PureImageCache::ExportMapDataToDB(QString sourceFile, QString destFile)
@@ -41,25 +41,62 @@
 #include <QVariant>
 #include "pureimage.h"
 #include <QList>
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QThreadStorage>
+#include "corecommon.h"
 namespace core {
-    class PureImageCache
+    /**
+     * Tiles are kept in an SQLite file, Data.qmdb in the cache directory.
+     * Each thread that touches the cache gets its own connection, opened on
+     * first use and closed when the thread exits, with its statements
+     * prepared once.  Writes are grouped into transactions of up to
+     * WRITE_BATCH tiles, committed early by a write that finds the batch
+     * older than WRITE_BATCH_MS, since an open batch blocks the writes of
+     * other threads.  Call Flush() when a burst of writes is over to commit
+     * the rest.
+     */
+    class TLMAPWIDGET_EXPORT PureImageCache
     {
 
     public:
+        static const int WRITE_BATCH = 32;
+        static const int WRITE_BATCH_MS = 250;
+
         PureImageCache();
+        ~PureImageCache();
         static bool CreateEmptyDB(const QString &file);
         bool PutImageToCache(const QByteArray &tile,const MapType::Types &type,const core::Point &pos, const int &zoom);
         QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
+        void Flush();
         QString GtileCache();
         void setGtileCache(const QString &value);
         static bool ExportMapDataToDB(QString sourceFile, QString destFile);
         void deleteOlderTiles(int const& days);
     private:
+        struct Connection
+        {
+            Connection(const QString &name, const QString &file);
+            ~Connection();
+            bool commit();
+
+            QString name;
+            QString file;
+            QSqlDatabase db;
+            QSqlQuery *selectTile;
+            QSqlQuery *insertTile;
+            QSqlQuery *insertData;
+            int pendingWrites;
+            QElapsedTimer batchAge;
+        };
+        Connection *connection();
+        static void prepareDB(QSqlDatabase &db);
+
         QString gtilecache;
         QMutex Mcounter;
         QReadWriteLock lock;
+        QThreadStorage<Connection *> connections;
         static qlonglong ConnCounter;
 
     };
@@ -99,6 +99,8 @@ void TileCacheQueue::run()
 
         else
         {
+            // Commit the last partial batch before going idle
+            Cache::Instance()->ImageCache.Flush();
 #ifdef DEBUG_TILECACHEQUEUE
             qDebug()<<"Cache engine BEGIN WAIT";
 #endif //DEBUG_TILECACHEQUEUE
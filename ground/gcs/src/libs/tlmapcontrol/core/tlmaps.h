@@ -41,6 +41,7 @@
 #include "alllayersoftype.h"
 #include "urlfactory.h"
 #include "diagnostics.h"
+#include <QtNetwork/QNetworkRequest>
 
 #include "../internals/pureprojection.h"
 #include "../internals/projections/lks94projection.h"
@@ -67,6 +68,7 @@ namespace core {
 
 
         QByteArray GetImageFromServer(const MapType::Types &type,const core::Point &pos,const int &zoom);
+        QNetworkRequest MakeImageRequest(const MapType::Types &type,const core::Point &pos,const int &zoom);
         QByteArray GetImageFromFile(const MapType::Types &type,const core::Point &pos,const int &zoom, double hScale, double vScale, QString userImageFileName, internals::PureProjection *projection);
         bool UseMemoryCache(){return useMemoryCache;}//TODO
         void setUseMemoryCache(const bool& value){useMemoryCache=value;}
@@ -114,44 +114,44 @@ namespace internals {
 
                         foreach(MapType::Types tl,layers)
                         {
+                            // Tiles seen before are already decoded
+                            QImage tileImage;
+                            if(TLMaps::Instance()->UseMemoryCache())
+                                tileImage = TLMaps::Instance()->GetDecodedTileFromMemoryCache(RawTile(tl, task.Pos, task.Zoom));
+
                             int retry = 0;
 
-                            do
+                            while(tileImage.isNull())
                             {
-                                QByteArray tileImage;
+                                QByteArray tileData;
 
                                 // tile number inversion(BottomLeft -> TopLeft) for pergo maps
                                 if(tl == MapType::PergoTurkeyMap)
                                 {
-                                    tileImage = TLMaps::Instance()->GetImageFromServer(tl, Point(task.Pos.X(), maxOfTiles.Height() - task.Pos.Y()), task.Zoom);
+                                    tileData = TLMaps::Instance()->GetImageFromServer(tl, Point(task.Pos.X(), maxOfTiles.Height() - task.Pos.Y()), task.Zoom);
                                 }
                                 else if(tl == MapType::UserImage)
                                 {
-                                    tileImage = TLMaps::Instance()->GetImageFromFile(tl, task.Pos, task.Zoom, userImageHorizontalScale, userImageVerticalScale, userImageLocation, Projection());
+                                    tileData = TLMaps::Instance()->GetImageFromFile(tl, task.Pos, task.Zoom, userImageHorizontalScale, userImageVerticalScale, userImageLocation, Projection());
                                 }
                                 else // ok
                                 {
 #ifdef DEBUG_CORE
                                     qDebug()<<"start getting image"<<" ID="<<debug;
 #endif //DEBUG_CORE
-                                    tileImage = TLMaps::Instance()->GetImageFromServer(tl, task.Pos, task.Zoom);
+                                    tileData = TLMaps::Instance()->GetImageFromServer(tl, task.Pos, task.Zoom);
 #ifdef DEBUG_CORE
-                                    qDebug()<<"Core::run:gotimage size:"<<tileImage.count()<<" ID="<<debug;
+                                    qDebug()<<"Core::run:gotimage size:"<<tileData.count()<<" ID="<<debug;
 #endif //DEBUG_CORE
                                 }
 
-                                if(tileImage.length()!=0)
-                                {
-                                    Moverlays.lock();
-                                    {
-                                        t->Overlays.append(tileImage);
-#ifdef DEBUG_CORE
-                                        qDebug()<<"Core::run append tileImage:"<<tileImage.length()<<" to tile:"<<t->GetPos().ToString()<<" now has "<<t->Overlays.count()<<" overlays"<<" ID="<<debug;
-#endif //DEBUG_CORE
-
-                                    }
-                                    Moverlays.unlock();
+                                // Decoded here, on the loader thread, instead of on every repaint
+                                tileImage = MemoryCache::DecodeTile(tileData);
 
+                                if(!tileImage.isNull())
+                                {
+                                    if(TLMaps::Instance()->UseMemoryCache())
+                                        TLMaps::Instance()->AddDecodedTileToMemoryCache(RawTile(tl, task.Pos, task.Zoom), tileImage);
                                     break;
                                 }
                                 else if(TLMaps::Instance()->RetryLoadTile > 0)
@@ -160,8 +160,23 @@ namespace internals {
                                     qDebug()<<"ProcessLoadTask: " << task.ToString()<< " -> empty tile, retry " << retry<<" ID="<<debug;;
 #endif //DEBUG_CORE
                                 }
+
+                                if(++retry >= TLMaps::Instance()->RetryLoadTile)
+                                    break;
+                            }
+
+                            if(!tileImage.isNull())
+                            {
+                                Moverlays.lock();
+                                {
+                                    t->Overlays.append(tileImage);
+#ifdef DEBUG_CORE
+                                    qDebug()<<"Core::run append tileImage:"<<tileImage.byteCount()<<" to tile:"<<t->GetPos().ToString()<<" now has "<<t->Overlays.count()<<" overlays"<<" ID="<<debug;
+#endif //DEBUG_CORE
+
+                                }
+                                Moverlays.unlock();
                             }
-                            while(++retry < TLMaps::Instance()->RetryLoadTile);
                         }
 
                         if(t->Overlays.count() > 0)
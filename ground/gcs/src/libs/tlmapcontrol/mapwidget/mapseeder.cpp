@@ -0,0 +1,408 @@
+/**
+******************************************************************************
+*
+* @file       mapseeder.cpp
+* @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+* @brief      Fills the tile cache for an area ahead of time
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "mapseeder.h"
+#include "../core/tlmaps.h"
+#include "../internals/projections/mercatorprojection.h"
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QImageReader>
+#include <QPainterPath>
+#include <QTimer>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+#include <qmath.h>
+
+namespace mapcontrol
+{
+    MapSeeder::MapSeeder(core::MapType::Types type, core::PureImageCache *cache, QObject *parent) :
+        QObject(parent),type(type),cache(cache),minZoom(0),maxZoom(0),concurrency(DEFAULT_CONCURRENCY),
+        cancelled(0),total(0),done(0),stored(0),failed(0),storedBytes(0)
+    {
+        if(!this->cache)
+            this->cache=&core::Cache::Instance()->ImageCache;
+        projection=new projections::MercatorProjection();
+        network=new QNetworkAccessManager(this);
+        connect(network,SIGNAL(finished(QNetworkReply*)),this,SLOT(replyFinished(QNetworkReply*)));
+        // Commits what a burst of replies stored once the event loop is idle,
+        // so the write transaction is not held open while waiting on the network
+        flushTimer=new QTimer(this);
+        flushTimer->setSingleShot(true);
+        flushTimer->setInterval(0);
+        connect(flushTimer,SIGNAL(timeout()),this,SLOT(flush()));
+    }
+
+    MapSeeder::~MapSeeder()
+    {
+        delete projection;
+    }
+
+    /**
+     * Sets the area to seed.  With fewer than three points, or points on a
+     * line, the rectangle around them is used.
+     */
+    void MapSeeder::SetArea(const QList<internals::PointLatLng> &polygon)
+    {
+        area=polygon;
+    }
+
+    void MapSeeder::SetZoomRange(int minZoom, int maxZoom)
+    {
+        this->minZoom=minZoom;
+        this->maxZoom=maxZoom;
+    }
+
+    /**
+     * Sets how many tile requests may be outstanding at once
+     */
+    void MapSeeder::SetConcurrency(int requests)
+    {
+        concurrency=qMax(1,requests);
+    }
+
+    /**
+     * Fetches tiles from a URL such as http://host/{z}/{x}/{y}.png instead of
+     * from the map type's provider
+     */
+    void MapSeeder::SetUrlTemplate(const QString &urlTemplate)
+    {
+        this->urlTemplate=urlTemplate;
+    }
+
+    /**
+     * Returns the corners of the rectangle around points, widened by
+     * marginMeters on each side
+     */
+    QList<internals::PointLatLng> MapSeeder::AreaAround(const QList<internals::PointLatLng> &points, double marginMeters)
+    {
+        QList<internals::PointLatLng> corners;
+        if(points.isEmpty())
+            return corners;
+
+        double north=points[0].Lat(), south=north;
+        double east=points[0].Lng(), west=east;
+        foreach(const internals::PointLatLng &p,points)
+        {
+            north=qMax(north,p.Lat());
+            south=qMin(south,p.Lat());
+            east=qMax(east,p.Lng());
+            west=qMin(west,p.Lng());
+        }
+
+        const double metersPerDegree=111320.0;
+        double dLat=marginMeters/metersPerDegree;
+        double dLng=marginMeters/(metersPerDegree*qMax(0.01,qCos(qDegreesToRadians(qMax(qAbs(north),qAbs(south))))));
+
+        corners<<internals::PointLatLng(north+dLat,west-dLng)
+               <<internals::PointLatLng(north+dLat,east+dLng)
+               <<internals::PointLatLng(south-dLat,east+dLng)
+               <<internals::PointLatLng(south-dLat,west-dLng);
+        return corners;
+    }
+
+    /**
+     * Lists the tiles at zoom that touch the area
+     */
+    QList<core::Point> MapSeeder::TileList(int zoom)
+    {
+        QList<core::Point> tiles;
+        if(area.isEmpty())
+            return tiles;
+
+        QPolygonF polygon;
+        foreach(const internals::PointLatLng &p,area)
+        {
+            core::Point pixel=projection->FromLatLngToPixel(p,zoom);
+            polygon<<QPointF(pixel.X(),pixel.Y());
+        }
+        QRectF bounds=polygon.boundingRect();
+        bool filled=polygon.size()>=3 && bounds.width()>0 && bounds.height()>0;
+        QPainterPath path;
+        path.addPolygon(polygon);
+        path.closeSubpath();
+
+        qint64 tileSize=projection->TileSize().Width();
+        core::Size maxTile=projection->GetTileMatrixMaxXY(zoom);
+        qint64 x0=qBound((qint64)0,(qint64)qFloor(bounds.left()/tileSize),maxTile.Width());
+        qint64 x1=qBound((qint64)0,(qint64)qFloor(bounds.right()/tileSize),maxTile.Width());
+        qint64 y0=qBound((qint64)0,(qint64)qFloor(bounds.top()/tileSize),maxTile.Height());
+        qint64 y1=qBound((qint64)0,(qint64)qFloor(bounds.bottom()/tileSize),maxTile.Height());
+
+        for(qint64 x=x0;x<=x1;x++)
+        {
+            for(qint64 y=y0;y<=y1;y++)
+            {
+                if(!filled || path.intersects(QRectF(x*tileSize,y*tileSize,tileSize,tileSize)))
+                    tiles.append(core::Point(x,y));
+            }
+        }
+        return tiles;
+    }
+
+    /**
+     * Returns how many tiles Download() would fetch, counting each layer of
+     * the map type, before skipping the ones already cached
+     */
+    int MapSeeder::TileCount()
+    {
+        int count=0;
+        for(int zoom=minZoom;zoom<=maxZoom;zoom++)
+            count+=TileList(zoom).size();
+        return count*core::TLMaps::Instance()->GetAllLayersOfType(type).size();
+    }
+
+    /**
+     * Estimates the bytes the tiles of the area take, from the average of
+     * the tiles stored so far
+     */
+    qint64 MapSeeder::EstimatedSize()
+    {
+        qint64 perTile=stored>0?storedBytes/stored:DEFAULT_TILE_BYTES;
+        return TileCount()*perTile;
+    }
+
+    /**
+     * Starts fetching the tiles of the area and returns; progress() and
+     * finished() report on it
+     */
+    void MapSeeder::Download()
+    {
+        queueJobs(true);
+        network->setProxy(core::TLMaps::Instance()->Proxy);
+        fetchMore();
+    }
+
+    /**
+     * Stores the tiles of the area found in dir, as dir/zoom/x/y.png, .jpg
+     * or .jpeg, and returns how many were stored
+     */
+    int MapSeeder::ImportDirectory(const QString &dir)
+    {
+        static const char *extensions[]={"png","jpg","jpeg"};
+
+        queueJobs(false);
+        while(!jobs.isEmpty() && !cancelled.load())
+        {
+            Job job=jobs.dequeue();
+            if(!isCached(job))
+            {
+                QByteArray tile;
+                for(unsigned i=0;i<sizeof(extensions)/sizeof(extensions[0]) && tile.isEmpty();i++)
+                {
+                    QFile file(QString("%1/%2/%3/%4.%5").arg(dir).arg(job.zoom).arg(job.pos.X()).arg(job.pos.Y()).arg(extensions[i]));
+                    if(file.open(QIODevice::ReadOnly))
+                        tile=file.readAll();
+                }
+                if(!tile.isEmpty())
+                    store(job,tile);
+            }
+            jobDone();
+        }
+        finish();
+        return stored;
+    }
+
+    /**
+     * Stores the tiles of the area found in an MBTiles file and returns how
+     * many were stored, or -1 if the file cannot be read
+     */
+    int MapSeeder::ImportMBTiles(const QString &file)
+    {
+        QString connectionName=QString("MapSeeder%1").arg((quintptr)this);
+        bool opened;
+        {
+            QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE",connectionName);
+            db.setDatabaseName(file);
+            db.setConnectOptions("QSQLITE_OPEN_READONLY");
+            opened=db.open();
+            if(opened)
+            {
+                QSqlQuery query(db);
+                opened=query.prepare("SELECT tile_data FROM tiles WHERE zoom_level=? AND tile_column=? AND tile_row=?");
+
+                queueJobs(false);
+                while(opened && !jobs.isEmpty() && !cancelled.load())
+                {
+                    Job job=jobs.dequeue();
+                    if(!isCached(job))
+                    {
+                        // MBTiles rows count from the south
+                        query.bindValue(0,job.zoom);
+                        query.bindValue(1,job.pos.X());
+                        query.bindValue(2,((qint64)1<<job.zoom)-1-job.pos.Y());
+                        if(query.exec() && query.next())
+                            store(job,query.value(0).toByteArray());
+                        query.finish();
+                    }
+                    jobDone();
+                }
+            }
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+
+        if(!opened)
+            return -1;
+        finish();
+        return stored;
+    }
+
+    void MapSeeder::Cancel()
+    {
+        cancelled.store(1);
+    }
+
+    void MapSeeder::queueJobs(bool allLayers)
+    {
+        QVector<core::MapType::Types> layers;
+        if(allLayers)
+            layers=core::TLMaps::Instance()->GetAllLayersOfType(type);
+        else
+            layers.append(type);
+
+        jobs.clear();
+        for(int zoom=minZoom;zoom<=maxZoom;zoom++)
+        {
+            foreach(const core::Point &pos,TileList(zoom))
+            {
+                foreach(core::MapType::Types layer,layers)
+                {
+                    Job job;
+                    job.type=layer;
+                    job.pos=pos;
+                    job.zoom=zoom;
+                    jobs.enqueue(job);
+                }
+            }
+        }
+
+        cancelled.store(0);
+        total=jobs.size();
+        done=0;
+        stored=0;
+        failed=0;
+        storedBytes=0;
+    }
+
+    void MapSeeder::fetchMore()
+    {
+        while(inFlight.size()<concurrency && !jobs.isEmpty() && !cancelled.load())
+        {
+            Job job=jobs.dequeue();
+            if(isCached(job))
+            {
+                jobDone();
+                continue;
+            }
+
+            QNetworkReply *reply=network->get(request(job));
+            inFlight.insert(reply,job);
+            QTimer::singleShot(core::TLMaps::Instance()->Timeout,reply,SLOT(abort()));
+        }
+
+        if(inFlight.isEmpty())
+            finish();
+    }
+
+    void MapSeeder::replyFinished(QNetworkReply *reply)
+    {
+        reply->deleteLater();
+        if(!inFlight.contains(reply))
+            return;
+
+        Job job=inFlight.take(reply);
+        if(reply->error()==QNetworkReply::NoError)
+        {
+            store(job,reply->readAll());
+            flushTimer->start();
+        }
+        else
+            failed++;
+        jobDone();
+
+        fetchMore();
+    }
+
+    void MapSeeder::flush()
+    {
+        cache->Flush();
+    }
+
+    bool MapSeeder::isCached(const Job &job)
+    {
+        return !cache->GetImageFromCache(job.type,job.pos,job.zoom).isEmpty();
+    }
+
+    /**
+     * Stores a tile if it is an image; providers answer some requests they
+     * cannot serve with an error page
+     */
+    bool MapSeeder::store(const Job &job, const QByteArray &tile)
+    {
+        QByteArray data=tile;
+        QBuffer buffer(&data);
+        if(!QImageReader(&buffer).canRead() || !cache->PutImageToCache(tile,job.type,job.pos,job.zoom))
+        {
+            failed++;
+            return false;
+        }
+
+        stored++;
+        storedBytes+=tile.size();
+        return true;
+    }
+
+    QNetworkRequest MapSeeder::request(const Job &job)
+    {
+        if(urlTemplate.isEmpty())
+            return core::TLMaps::Instance()->MakeImageRequest(job.type,job.pos,job.zoom);
+
+        QString url=urlTemplate;
+        url.replace("{z}",QString::number(job.zoom));
+        url.replace("{x}",QString::number(job.pos.X()));
+        url.replace("{y}",QString::number(job.pos.Y()));
+        QNetworkRequest tileRequest((QUrl(url)));
+        tileRequest.setRawHeader("User-Agent",core::TLMaps::Instance()->UserAgent);
+        return tileRequest;
+    }
+
+    void MapSeeder::jobDone()
+    {
+        done++;
+        emit progress(done,total,storedBytes);
+    }
+
+    void MapSeeder::finish()
+    {
+        jobs.clear();
+        flushTimer->stop();
+        cache->Flush();
+        emit finished(stored,failed);
+    }
+}
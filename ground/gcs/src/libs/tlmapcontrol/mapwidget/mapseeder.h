@@ -0,0 +1,144 @@
+/**
+******************************************************************************
+*
+* @file       mapseeder.h
+* @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+* @brief      Fills the tile cache for an area ahead of time
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef MAPSEEDER_H
+#define MAPSEEDER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QHash>
+#include <QList>
+#include <QQueue>
+#include <QtNetwork/QNetworkRequest>
+#include "../internals/pointlatlng.h"
+#include "../core/maptype.h"
+#include "../core/point.h"
+#include "../core/corecommon.h"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+
+namespace core {
+    class PureImageCache;
+}
+namespace projections {
+    class MercatorProjection;
+}
+
+namespace mapcontrol
+{
+    /**
+     * Stores every tile of a map type that touches an area, for a range of
+     * zoom levels, so the map can be used where there is no connection.  The
+     * area is a polygon, or the rectangle around a set of waypoints given by
+     * AreaAround().
+     *
+     * Download() fetches the tiles from the provider, with the URLs and
+     * headers the map itself uses, a few requests at a time.  The imports
+     * read them instead from a directory laid out as zoom/x/y.png (or .jpg)
+     * or from an MBTiles file; imported tiles are stored as the seeder's map
+     * type, so it should not be one made of several layers.  Tiles already
+     * in the cache are skipped, and writes go through the cache's batched
+     * transactions.
+     *
+     * Only Mercator tiles are enumerated, which covers the web providers.
+     */
+    class TLMAPWIDGET_EXPORT MapSeeder : public QObject
+    {
+        Q_OBJECT
+    public:
+        static const int DEFAULT_CONCURRENCY = 4;
+        // Size estimate per tile until some have been stored
+        static const int DEFAULT_TILE_BYTES = 20 * 1024;
+
+        explicit MapSeeder(core::MapType::Types type, core::PureImageCache *cache = 0, QObject *parent = 0);
+        ~MapSeeder();
+
+        void SetArea(const QList<internals::PointLatLng> &polygon);
+        void SetZoomRange(int minZoom, int maxZoom);
+        void SetConcurrency(int requests);
+        void SetUrlTemplate(const QString &urlTemplate);
+
+        static QList<internals::PointLatLng> AreaAround(const QList<internals::PointLatLng> &points, double marginMeters);
+
+        QList<core::Point> TileList(int zoom);
+        int TileCount();
+        qint64 EstimatedSize();
+
+        void Download();
+        int ImportDirectory(const QString &dir);
+        int ImportMBTiles(const QString &file);
+
+    public slots:
+        void Cancel();
+
+    signals:
+        void progress(int done, int total, qint64 bytes);
+        void finished(int stored, int failed);
+
+    private slots:
+        void replyFinished(QNetworkReply *reply);
+        void flush();
+
+    private:
+        struct Job
+        {
+            core::MapType::Types type;
+            core::Point pos;
+            int zoom;
+        };
+
+        void queueJobs(bool allLayers);
+        void fetchMore();
+        bool isCached(const Job &job);
+        bool store(const Job &job, const QByteArray &tile);
+        void jobDone();
+        void finish();
+        QNetworkRequest request(const Job &job);
+
+        core::MapType::Types type;
+        core::PureImageCache *cache;
+        projections::MercatorProjection *projection;
+        QNetworkAccessManager *network;
+        QTimer *flushTimer;
+        QList<internals::PointLatLng> area;
+        int minZoom;
+        int maxZoom;
+        int concurrency;
+        QString urlTemplate;
+
+        QQueue<Job> jobs;
+        QHash<QNetworkReply *, Job> inFlight;
+        QAtomicInt cancelled;
+        int total;
+        int done;
+        int stored;
+        int failed;
+        qint64 storedBytes;
+    };
+}
+#endif // MAPSEEDER_H
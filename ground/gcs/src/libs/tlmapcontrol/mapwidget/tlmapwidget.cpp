@@ -477,6 +477,20 @@ namespace mapcontrol
         }
         return false;
     }
+    /**
+     * @brief Returns the coordinates of the waypoints, leaving out the magic waypoint
+     */
+    QList<internals::PointLatLng> TLMapWidget::WPCoordinates()
+    {
+        QList<internals::PointLatLng> coords;
+        foreach(QGraphicsItem* i,map->childItems())
+        {
+            WayPointItem* w=qgraphicsitem_cast<WayPointItem*>(i);
+            if(w && w->Number()!=-1)
+                coords.append(w->Coord());
+        }
+        return coords;
+    }
 
     void TLMapWidget::deleteAllOverlays()
     {
@@ -41,6 +41,7 @@
 #include "gpsitem.h"
 #include "homeitem.h"
 #include "mapripper.h"
+#include "mapseeder.h"
 #include "mapline.h"
 #include "mapcircle.h"
 #include "waypointcurve.h"
@@ -383,6 +384,7 @@ namespace mapcontrol
         void WPSetVisibleAll(bool value);
         WayPointItem *magicWPCreate();
         bool WPPresent();
+        QList<internals::PointLatLng> WPCoordinates();
         void WPDelete(int number);
         WayPointItem *WPFind(int number);
         void setSelectedWP(QList<WayPointItem *> list);
@@ -13,6 +13,7 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     mapwidget/homeitem.cpp \
     mapwidget/mapripform.cpp \
     mapwidget/mapripper.cpp \
+    mapwidget/mapseeder.cpp \
     mapwidget/traillineitem.cpp \
     mapwidget/mapline.cpp \
     mapwidget/mapcircle.cpp \
@@ -65,6 +66,7 @@ HEADERS += mapwidget/mapgraphicitem.h \
     mapwidget/homeitem.h \
     mapwidget/mapripform.h \
     mapwidget/mapripper.h \
+    mapwidget/mapseeder.h \
     mapwidget/traillineitem.h \
     mapwidget/mapline.h \
     mapwidget/mapcircle.h \
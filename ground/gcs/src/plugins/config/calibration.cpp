@@ -37,6 +37,7 @@
 
 #include "utils/coordinateconversions.h"
 #include <QMessageBox>
+#include <QStringList>
 #include <QDebug>
 #include <QThread>
 #include <QTimer>
@@ -71,6 +72,22 @@ enum calibrationSuccessMessages{
 Calibration::Calibration() : calibrateMags(false), accelLength(GRAVITY),
     xCurve(NULL), yCurve(NULL), zCurve(NULL)
 {
+    // Allocate the sample buffers once for the longest collection.  The
+    // int() copies keep qMax from needing definitions of the constants.
+    const int accelSamples = qMax(int(NUM_SENSOR_UPDATES_LEVELING),
+            qMax(int(NUM_SENSOR_UPDATES_YAW_ORIENTATION), int(NUM_SENSOR_UPDATES_SIX_POINT)));
+    accel_accum_x.reserve(accelSamples);
+    accel_accum_y.reserve(accelSamples);
+    accel_accum_z.reserve(accelSamples);
+    mag_accum_x.reserve(NUM_SENSOR_UPDATES_SIX_POINT);
+    mag_accum_y.reserve(NUM_SENSOR_UPDATES_SIX_POINT);
+    mag_accum_z.reserve(NUM_SENSOR_UPDATES_SIX_POINT);
+
+    const int gyroSamples = qMax(int(NUM_SENSOR_UPDATES_LEVELING), int(NUM_SENSOR_UPDATES_TEMP_CAL));
+    gyro_accum_x.reserve(gyroSamples);
+    gyro_accum_y.reserve(gyroSamples);
+    gyro_accum_z.reserve(gyroSamples);
+    gyro_accum_temp.reserve(gyroSamples);
 }
 
 Calibration::~Calibration()
@@ -192,6 +209,11 @@ void Calibration::assignUpdateRate(UAVObject* obj, quint32 updatePeriod)
  */
 void Calibration::dataUpdated(UAVObject * obj) {
 
+    // The magnetometer fit takes everything seen during six point
+    // calibration, including while the vehicle is turned between positions
+    if (calibration_state >= SIX_POINT_WAIT1 && calibration_state <= SIX_POINT_COLLECT6)
+        storeMagFitSample(obj);
+
     if (!timer.isActive()) {
         // ignore updates that come in after the timer has expired
         return;
@@ -449,9 +471,9 @@ void Calibration::timeout()
  * @brief Calibration::doStartLeveling Called by UI to start collecting data to calculate level
  */
 void Calibration::doStartOrientation() {
-    accel_accum_x.clear();
-    accel_accum_y.clear();
-    accel_accum_z.clear();
+    accel_accum_x.resize(0);
+    accel_accum_y.resize(0);
+    accel_accum_z.resize(0);
 
     calibration_state = YAW_ORIENTATION;
 
@@ -488,13 +510,13 @@ void Calibration::doStartNoBiasLeveling()
  * @brief Calibration::doStartLeveling Called by UI to start collecting data to calculate level
  */
 void Calibration::doStartLeveling() {
-    accel_accum_x.clear();
-    accel_accum_y.clear();
-    accel_accum_z.clear();
-    gyro_accum_x.clear();
-    gyro_accum_y.clear();
-    gyro_accum_z.clear();
-    gyro_accum_temp.clear();
+    accel_accum_x.resize(0);
+    accel_accum_y.resize(0);
+    accel_accum_z.resize(0);
+    gyro_accum_x.resize(0);
+    gyro_accum_y.resize(0);
+    gyro_accum_z.resize(0);
+    gyro_accum_temp.resize(0);
 
     // Disable gyro bias correction to see raw data
     AttitudeSettings *attitudeSettings = AttitudeSettings::GetInstance(getObjectManager());
@@ -583,12 +605,15 @@ void Calibration::doStartSixPoint()
     sensorSettings->setData(sensorSettingsData);
 
     // Clear the accumulators
-    accel_accum_x.clear();
-    accel_accum_y.clear();
-    accel_accum_z.clear();
-    mag_accum_x.clear();
-    mag_accum_y.clear();
-    mag_accum_z.clear();
+    accel_accum_x.resize(0);
+    accel_accum_y.resize(0);
+    accel_accum_z.resize(0);
+    mag_accum_x.resize(0);
+    mag_accum_y.resize(0);
+    mag_accum_z.resize(0);
+    accelFit.reset();
+    magFit.reset();
+    emit showSixPointFitStatus(QString());
 
     // TODO: Document why the thread needs to wait 100ms.
     QThread::usleep(100000);
@@ -695,10 +720,10 @@ void Calibration::doSaveSixPointPosition()
  */
 void Calibration::doStartTempCal()
 {
-    gyro_accum_x.clear();
-    gyro_accum_y.clear();
-    gyro_accum_z.clear();
-    gyro_accum_temp.clear();
+    gyro_accum_x.resize(0);
+    gyro_accum_y.resize(0);
+    gyro_accum_z.resize(0);
+    gyro_accum_temp.resize(0);
 
     // Disable gyro sensor bias correction to see raw data
     AttitudeSettings *attitudeSettings = AttitudeSettings::GetInstance(getObjectManager());
@@ -998,6 +1023,14 @@ bool Calibration::storeSixPointMeasurement(UAVObject * obj, int position)
         accel_accum_x.append(accelsData.x);
         accel_accum_y.append(accelsData.y);
         accel_accum_z.append(accelsData.z);
+
+        // Only the static positions go into the accelerometer fit, as
+        // moving between them adds acceleration
+        double accel_body[3] = { accelsData.x, accelsData.y, accelsData.z };
+        double accel_sensor[3];
+        rotate_vector(boardRotationMatrix, accel_body, accel_sensor, false);
+        accelFit.addSample(accel_sensor[0], accel_sensor[1], accel_sensor[2]);
+        updateSixPointFitStatus();
     }
 
     if( calibrateMags && obj->getObjID() == Magnetometer::OBJID) {
@@ -1034,9 +1067,9 @@ bool Calibration::storeSixPointMeasurement(UAVObject * obj, int position)
             accel_data_x[position] = accel_sensor[0];
             accel_data_y[position] = accel_sensor[1];
             accel_data_z[position] = accel_sensor[2];
-            accel_accum_x.clear();
-            accel_accum_y.clear();
-            accel_accum_z.clear();
+            accel_accum_x.resize(0);
+            accel_accum_y.resize(0);
+            accel_accum_z.resize(0);
         }
 
         // Store the average magnetometer value in that position
@@ -1049,9 +1082,9 @@ bool Calibration::storeSixPointMeasurement(UAVObject * obj, int position)
             mag_data_x[position] = mag_sensor[0];
             mag_data_y[position] = mag_sensor[1];
             mag_data_z[position] = mag_sensor[2];
-            mag_accum_x.clear();
-            mag_accum_y.clear();
-            mag_accum_z.clear();
+            mag_accum_x.resize(0);
+            mag_accum_y.resize(0);
+            mag_accum_z.resize(0);
         }
 
         // Indicate all data collected for this position
@@ -1060,6 +1093,50 @@ bool Calibration::storeSixPointMeasurement(UAVObject * obj, int position)
     return false;
 }
 
+/**
+ * @brief Calibration::storeMagFitSample Add a magnetometer sample, with the
+ * board rotation undone, to the ellipsoid fit
+ */
+void Calibration::storeMagFitSample(UAVObject *obj)
+{
+    if (!calibrateMags || obj->getObjID() != Magnetometer::OBJID)
+        return;
+
+    Magnetometer * mag = Magnetometer::GetInstance(getObjectManager());
+    Q_ASSERT(mag);
+    Magnetometer::DataFields magData = mag->getData();
+
+    double mag_body[3] = { magData.x, magData.y, magData.z };
+    double mag_sensor[3];
+    rotate_vector(boardRotationMatrix, mag_body, mag_sensor, false);
+    magFit.addSample(mag_sensor[0], mag_sensor[1], mag_sensor[2]);
+
+    updateSixPointFitStatus();
+}
+
+/**
+ * @brief Calibration::updateSixPointFitStatus Show how far along the
+ * ellipsoid fits are, so the operator knows which way to keep rotating
+ */
+void Calibration::updateSixPointFitStatus()
+{
+    QStringList status;
+
+    if (calibrateMags && magFit.isValid()) {
+        status << tr("Mag: %1% of directions, residual %2%, %3 rejected")
+                  .arg(qRound(magFit.coverage() * 100))
+                  .arg(magFit.residual() * 100, 0, 'f', 1)
+                  .arg(magFit.rejectedCount());
+    }
+
+    if (calibrateAccels && accelFit.isValid()) {
+        status << tr("Accel: residual %1%")
+                  .arg(accelFit.residual() * 100, 0, 'f', 1);
+    }
+
+    emit showSixPointFitStatus(status.join("  "));
+}
+
 /**
  * @brief Calibration::configureTempCurves
  * @param x
@@ -1290,7 +1367,7 @@ UAVObjectUtilManager* Calibration::getObjectUtilManager() {
  * @param list list of double values
  * @returns Mean value of the list of parameter values
  */
-double Calibration::listMean(QList<double> list)
+double Calibration::listMean(const QVector<double> &list)
 {
     double accum = 0;
     for(int i = 0; i < list.size(); i++)
@@ -1303,7 +1380,7 @@ double Calibration::listMean(QList<double> list)
  * @param list list of double values
  * @returns Mean value of the list of parameter values
  */
-double Calibration::listMin(QList<double> list)
+double Calibration::listMin(const QVector<double> &list)
 {
     double min = list[0];
     for(int i = 0; i < list.size(); i++)
@@ -1316,7 +1393,7 @@ double Calibration::listMin(QList<double> list)
  * @param list list of double values
  * @returns Mean value of the list of parameter values
  */
-double Calibration::listMax(QList<double> list)
+double Calibration::listMax(const QVector<double> &list)
 {
     double max = list[0];
     for(int i = 0; i < list.size(); i++)
@@ -1344,9 +1421,20 @@ int Calibration::computeScaleBias()
         for(int i = 0; i < 6; i++)
             qDebug() << accel_data_x[i] << ", " << accel_data_y[i] << ", " << accel_data_z[i] << ";";
 
-        // Solve for accelerometer calibration
+        // Solve for accelerometer calibration, from the fit over every
+        // sample if it converged or else from the averages of each position
         double S[3], b[3];
-        SixPointInConstFieldCal(accelLength, accel_data_x, accel_data_y, accel_data_z, S, b);
+        if (accelFit.solve()) {
+            double scale[3], bias[3];
+            accelFit.axisCalibration(accelLength, scale, bias);
+            for (int i = 0; i < 3; i++) {
+                S[i] = scale[i];
+                b[i] = -bias[i];
+            }
+            qDebug() << "Accel fit residual" << accelFit.residual();
+        } else {
+            SixPointInConstFieldCal(accelLength, accel_data_x, accel_data_y, accel_data_z, S, b);
+        }
 
         sensorSettingsData.AccelBias[SensorSettings::ACCELBIAS_X] += (-sign(S[0]) * b[0]);
         sensorSettingsData.AccelBias[SensorSettings::ACCELBIAS_Y] += (-sign(S[1]) * b[1]);
@@ -1405,9 +1493,23 @@ int Calibration::computeScaleBias()
         }
         len /= 6;
 
-        // Solve for magnetometer calibration
+        // Solve for magnetometer calibration.  The fit needs samples from
+        // all around, i.e. the vehicle turned through the positions rather
+        // than just put down in them
         double S[3], b[3];
-        SixPointInConstFieldCal(len, mag_data_x, mag_data_y, mag_data_z, S, b);
+        if (magFit.solve() && magFit.isFullValid()) {
+            double scale[3], bias[3];
+            magFit.axisCalibration(magFit.meanRadius(), scale, bias);
+            for (int i = 0; i < 3; i++) {
+                S[i] = scale[i];
+                b[i] = -bias[i];
+            }
+            // Only scale and bias per axis are applied on board
+            qDebug() << "Mag fit residual" << magFit.residual() << "coverage" << magFit.coverage()
+                     << "rejected" << magFit.rejectedCount() << "cross coupling" << magFit.crossCoupling();
+        } else {
+            SixPointInConstFieldCal(len, mag_data_x, mag_data_y, mag_data_z, S, b);
+        }
 
         //Assign calibration data
         sensorSettingsData.MagBias[SensorSettings::MAGBIAS_X] += (-sign(S[0]) * b[0]);
@@ -29,10 +29,12 @@
 #include <extensionsystem/pluginmanager.h>
 #include <uavobject.h>
 #include <tempcompcurve.h>
+#include "ellipsoidfit.h"
 
 #include <QObject>
 #include <QTimer>
 #include <QString>
+#include <QVector>
 
 /**
  * @brief The Calibration class is a UI free algorithm that can be connected
@@ -138,6 +140,9 @@ signals:
     //! Indicate what the progress is for six point collection
     void sixPointProgressChanged(int);
 
+    //! Show the coverage and residual of the ellipsoid fit while collecting
+    void showSixPointFitStatus(QString status);
+
     //! Show an instruction or message from temperature calibration
     void showTempCalMessage(QString message);
 
@@ -183,16 +188,22 @@ private:
     //! List of optimized metadata rates
     QMap<QString, UAVObject::Metadata> slowedDownMetaDataList;
 
-    QList<double> gyro_accum_x;
-    QList<double> gyro_accum_y;
-    QList<double> gyro_accum_z;
-    QList<double> gyro_accum_temp;
-    QList<double> accel_accum_x;
-    QList<double> accel_accum_y;
-    QList<double> accel_accum_z;
-    QList<double> mag_accum_x;
-    QList<double> mag_accum_y;
-    QList<double> mag_accum_z;
+    //! Sample buffers, reserved once and emptied with resize(0) so that
+    //! they keep their allocation
+    QVector<double> gyro_accum_x;
+    QVector<double> gyro_accum_y;
+    QVector<double> gyro_accum_z;
+    QVector<double> gyro_accum_temp;
+    QVector<double> accel_accum_x;
+    QVector<double> accel_accum_y;
+    QVector<double> accel_accum_z;
+    QVector<double> mag_accum_x;
+    QVector<double> mag_accum_y;
+    QVector<double> mag_accum_z;
+
+    //! Ellipsoid fits over everything seen during six point calibration
+    EllipsoidFit accelFit;
+    EllipsoidFit magFit;
 
     double gyro_data_x[6], gyro_data_y[6], gyro_data_z[6];
     double accel_data_x[6], accel_data_y[6], accel_data_z[6];
@@ -201,6 +212,7 @@ private:
     static const int NUM_SENSOR_UPDATES_LEVELING = 300;
     static const int NUM_SENSOR_UPDATES_YAW_ORIENTATION = 300;
     static const int NUM_SENSOR_UPDATES_SIX_POINT = 100;
+    static const int NUM_SENSOR_UPDATES_TEMP_CAL = 2000;
     static const int SENSOR_UPDATE_PERIOD = 25;
     static const int NON_SENSOR_UPDATE_PERIOD = 0;
     double MIN_TEMPERATURE_RANGE;
@@ -224,6 +236,12 @@ protected:
     //! Store a measurement at this position and indicate if it is the last one
     bool storeSixPointMeasurement(UAVObject * obj, int position);
 
+    //! Add a magnetometer sample to the fit, also while the vehicle is rotated
+    void storeMagFitSample(UAVObject *obj);
+
+    //! Report the state of the ellipsoid fits
+    void updateSixPointFitStatus();
+
     //! Store yaw orientation sample and compute orientation if finished
     bool storeYawOrientationMeasurement(UAVObject *obj);
 
@@ -243,13 +261,13 @@ protected:
     void Euler2R(double rpy[3], double Rbe[3][3]);
 
     //! Compute the mean value of a list
-    static double listMean(QList<double> list);
+    static double listMean(const QVector<double> &list);
 
     //! Compute the min value of a list
-    static double listMin(QList<double> list);
+    static double listMin(const QVector<double> &list);
 
     //! Compute the max value of a list
-    static double listMax(QList<double> list);
+    static double listMax(const QVector<double> &list);
 
     //! Reset sensor settings to pre-calibration values
     void resetSensorCalibrationToOriginalValues();
@@ -15,6 +15,7 @@ OTHER_FILES += Config.pluginspec \
     Config.json
 
 HEADERS += calibration.h \
+    ellipsoidfit.h \
     configplugin.h \
     configgadgetconfiguration.h \
     configgadgetwidget.h \
@@ -50,6 +51,7 @@ HEADERS += calibration.h \
     autotuneshareform.h
 
 SOURCES += calibration.cpp \
+    ellipsoidfit.cpp \
     configplugin.cpp \
     configgadgetconfiguration.cpp \
     configgadgetwidget.cpp \
@@ -0,0 +1,305 @@
+/**
+ ******************************************************************************
+ * @file       ellipsoidfit.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Streaming least squares ellipsoid fit for sensor calibration
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ConfigPlugin Config Plugin
+ * @{
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "ellipsoidfit.h"
+
+#include <Eigen/Cholesky>
+#include <Eigen/QR>
+#include <algorithm>
+#include <cmath>
+
+const double EllipsoidFit::MIN_COVERAGE = 0.5;
+const double EllipsoidFit::OUTLIER_SIGMA = 4.0;
+const double EllipsoidFit::OUTLIER_FLOOR = 0.02;
+
+// Indices of x^2, y^2, z^2, x, y and z in the general quadric
+static const int AXIS_TERMS[6] = { 0, 1, 2, 6, 7, 8 };
+
+EllipsoidFit::EllipsoidFit(int capacity) : capacity(capacity)
+{
+    samples.reserve(3 * capacity);
+    reset();
+}
+
+void EllipsoidFit::reset()
+{
+    count = 0;
+    rejected = 0;
+    samples.clear();
+    norm = 0;
+    normal.setZero();
+    rhs.setZero();
+    axisValid = false;
+    fullValid = false;
+    rmsResidual = 0;
+    coveredFraction = 0;
+}
+
+bool EllipsoidFit::addSample(double x, double y, double z)
+{
+    if (norm == 0) {
+        norm = sqrt(x * x + y * y + z * z);
+        if (norm == 0)
+            return false;
+    }
+
+    Eigen::Vector3d u(x / norm, y / norm, z / norm);
+
+    if (coveredFraction >= MIN_COVERAGE &&
+            fabs(toSphere(u).norm() - 1) > std::max(OUTLIER_SIGMA * rmsResidual, OUTLIER_FLOOR)) {
+        rejected++;
+        return false;
+    }
+
+    Eigen::Matrix<double, 9, 1> d = quadricTerms(u);
+    normal += d * d.transpose();
+    rhs += d;
+
+    if ((int) samples.size() < 3 * capacity) {
+        samples.push_back(u.x());
+        samples.push_back(u.y());
+        samples.push_back(u.z());
+    }
+    count++;
+
+    if (count >= MIN_SAMPLES && (count % SOLVE_INTERVAL) == 0)
+        solve();
+
+    return true;
+}
+
+bool EllipsoidFit::solve()
+{
+    // Samples taken before the fit was good enough to reject anything are
+    // checked again once it is
+    if (fit() && coveredFraction >= MIN_COVERAGE && prune() > 0)
+        fit();
+
+    return axisValid;
+}
+
+/**
+ * Drop stored samples that are outliers against the current fit from the
+ * normal equations
+ * @return number of samples dropped
+ */
+int EllipsoidFit::prune()
+{
+    const double threshold = std::max(OUTLIER_SIGMA * rmsResidual, OUTLIER_FLOOR);
+    const int stored = samples.size() / 3;
+    int kept = 0;
+
+    for (int n = 0; n < stored; n++) {
+        Eigen::Vector3d u(samples[3 * n], samples[3 * n + 1], samples[3 * n + 2]);
+
+        if (fabs(toSphere(u).norm() - 1) > threshold) {
+            Eigen::Matrix<double, 9, 1> d = quadricTerms(u);
+            normal -= d * d.transpose();
+            rhs -= d;
+            count--;
+            rejected++;
+            continue;
+        }
+
+        samples[3 * kept] = u.x();
+        samples[3 * kept + 1] = u.y();
+        samples[3 * kept + 2] = u.z();
+        kept++;
+    }
+
+    samples.resize(3 * kept);
+
+    return stored - kept;
+}
+
+Eigen::Matrix<double, 9, 1> EllipsoidFit::quadricTerms(const Eigen::Vector3d &u)
+{
+    Eigen::Matrix<double, 9, 1> d;
+    d << u.x() * u.x(), u.y() * u.y(), u.z() * u.z(),
+            2 * u.x() * u.y(), 2 * u.x() * u.z(), 2 * u.y() * u.z(),
+            2 * u.x(), 2 * u.y(), 2 * u.z();
+    return d;
+}
+
+bool EllipsoidFit::fit()
+{
+    axisValid = false;
+    fullValid = false;
+
+    if (count < MIN_SAMPLES)
+        return false;
+
+    // Axis aligned: a x^2 + b y^2 + c z^2 + 2g x + 2h y + 2i z = 1
+    Eigen::Matrix<double, 6, 6> axisNormal;
+    Eigen::Matrix<double, 6, 1> axisRhs, p;
+    for (int i = 0; i < 6; i++) {
+        for (int j = 0; j < 6; j++)
+            axisNormal(i, j) = normal(AXIS_TERMS[i], AXIS_TERMS[j]);
+        axisRhs(i) = rhs(AXIS_TERMS[i]);
+    }
+
+    if (axisNormal.ldlt().solve(axisRhs, &p) && p(0) > 0 && p(1) > 0 && p(2) > 0) {
+        // Completing the squares gives center -g/a and the level
+        // 1 + g^2/a + h^2/b + i^2/c of the unit ellipsoid around it
+        double k = 1;
+        for (int i = 0; i < 3; i++) {
+            axisCenter(i) = -p(i + 3) / p(i);
+            k += p(i + 3) * p(i + 3) / p(i);
+        }
+        if (k > 0) {
+            for (int i = 0; i < 3; i++)
+                axisScale(i) = sqrt(p(i) / k);
+            axisValid = true;
+        }
+    }
+
+    if (!axisValid)
+        return false;
+
+    updateStatistics();
+
+    // The general fit is only determined with samples all around
+    Eigen::Matrix<double, 9, 1> q;
+    if (coveredFraction >= MIN_COVERAGE && normal.ldlt().solve(rhs, &q)) {
+        Eigen::Matrix3d A;
+        A << q(0), q(3), q(4),
+             q(3), q(1), q(5),
+             q(4), q(5), q(2);
+        Eigen::Vector3d b(q(6), q(7), q(8));
+
+        // Center is -A^-1 b, and x'Ax + 2b'x = 1 becomes
+        // (x - c)' A (x - c) = 1 + b' A^-1 b around it
+        Eigen::Vector3d center;
+        if (A.ldlt().solve(-b, &center)) {
+            double k = 1 - b.dot(center);
+
+            Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigen(A / k);
+            Eigen::Vector3d lambda = eigen.eigenvalues();
+
+            if (k > 0 && lambda.minCoeff() > 0) {
+                // Symmetric square root maps the ellipsoid onto the unit sphere
+                Eigen::Matrix3d V = eigen.eigenvectors();
+                Eigen::Vector3d root(sqrt(lambda(0)), sqrt(lambda(1)), sqrt(lambda(2)));
+                fullTransform = V * root.asDiagonal() * V.transpose();
+                fullCenter = center;
+                fullValid = true;
+
+                // Residuals against the better model from now on
+                updateStatistics();
+            }
+        }
+    }
+
+    return axisValid;
+}
+
+Eigen::Vector3d EllipsoidFit::toSphere(const Eigen::Vector3d &u) const
+{
+    if (fullValid)
+        return fullTransform * (u - fullCenter);
+
+    return (u - axisCenter).cwise() * axisScale;
+}
+
+void EllipsoidFit::updateStatistics()
+{
+    const int stored = samples.size() / 3;
+
+    bool seen[AZIMUTH_BINS * ELEVATION_BINS] = { false };
+    double sumSquares = 0;
+
+    for (int n = 0; n < stored; n++) {
+        Eigen::Vector3d u(samples[3 * n], samples[3 * n + 1], samples[3 * n + 2]);
+
+        Eigen::Vector3d v = toSphere(u);
+        double length = v.norm();
+        sumSquares += (length - 1) * (length - 1);
+
+        // Bin the direction from the center: equal bands of z are equal
+        // areas on the sphere
+        if (length == 0)
+            continue;
+
+        double z = v.z() / length;
+        int band = (int) floor((z + 1) / 2 * ELEVATION_BINS);
+        band = std::min(std::max(band, 0), ELEVATION_BINS - 1);
+
+        double azimuth = atan2(v.y(), v.x()) + M_PI;
+        int sector = (int) floor(azimuth / (2 * M_PI) * AZIMUTH_BINS);
+        sector = std::min(std::max(sector, 0), AZIMUTH_BINS - 1);
+
+        seen[band * AZIMUTH_BINS + sector] = true;
+    }
+
+    int covered = 0;
+    for (int i = 0; i < AZIMUTH_BINS * ELEVATION_BINS; i++)
+        covered += seen[i] ? 1 : 0;
+
+    coveredFraction = (double) covered / (AZIMUTH_BINS * ELEVATION_BINS);
+    rmsResidual = stored > 0 ? sqrt(sumSquares / stored) : 0;
+}
+
+double EllipsoidFit::meanRadius() const
+{
+    if (!axisValid)
+        return 0;
+
+    return norm / pow(axisScale(0) * axisScale(1) * axisScale(2), 1.0 / 3.0);
+}
+
+double EllipsoidFit::crossCoupling() const
+{
+    if (!fullValid)
+        return 0;
+
+    double coupling = 0;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (i == j)
+                continue;
+            coupling = std::max(coupling, fabs(fullTransform(i, j)) /
+                    sqrt(fullTransform(i, i) * fullTransform(j, j)));
+        }
+    }
+
+    return coupling;
+}
+
+void EllipsoidFit::axisCalibration(double radius, double scale[3], double bias[3]) const
+{
+    // scale * raw - bias = radius * axisScale * (raw / norm - axisCenter)
+    for (int i = 0; i < 3; i++) {
+        scale[i] = radius * axisScale(i) / norm;
+        bias[i] = radius * axisScale(i) * axisCenter(i);
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,154 @@
+/**
+ ******************************************************************************
+ * @file       ellipsoidfit.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Streaming least squares ellipsoid fit for sensor calibration
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ConfigPlugin Config Plugin
+ * @{
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef ELLIPSOIDFIT_H
+#define ELLIPSOIDFIT_H
+
+#include <vector>
+
+#include <Eigen/Core>
+
+/**
+ * @brief Fits an ellipsoid to 3-axis samples of a constant field as they
+ * arrive, for the hard and soft iron calibration of magnetometers and the
+ * scale and bias of accelerometers.
+ *
+ * Each sample only adds to the normal equations of the quadric
+ *   a x^2 + b y^2 + c z^2 + 2d xy + 2e xz + 2f yz + 2g x + 2h y + 2i z = 1
+ * so the cost per sample is constant.  Every few samples the general
+ * (rotated) ellipsoid and the axis aligned one, whose normal equations are
+ * a subset of the general ones, are solved.  Once the fit covers enough
+ * directions, samples further from it than a few times the RMS residual
+ * are rejected as outliers, e.g. from the vehicle being accelerated or a
+ * nearby current.
+ */
+class EllipsoidFit
+{
+public:
+    explicit EllipsoidFit(int capacity = DEFAULT_CAPACITY);
+
+    //! Forget all samples
+    void reset();
+
+    //! Add a sample, returns false if it was rejected as an outlier
+    bool addSample(double x, double y, double z);
+
+    //! Solve for what was added so far, returns isValid()
+    bool solve();
+
+    //! Whether the axis aligned fit, which the flight code can apply, is usable
+    bool isValid() const { return axisValid; }
+
+    //! Whether the general fit is usable, which needs samples all around
+    bool isFullValid() const { return fullValid; }
+
+    int sampleCount() const { return count; }
+    int rejectedCount() const { return rejected; }
+
+    //! RMS distance of the samples from the fit, relative to its radius
+    double residual() const { return rmsResidual; }
+
+    //! Fraction of the directions from the center that samples were seen in
+    double coverage() const { return coveredFraction; }
+
+    //! Geometric mean of the semi-axes of the axis aligned fit
+    double meanRadius() const;
+
+    //! Largest normalized off-diagonal term of the general fit, i.e. how
+    //! much soft iron cross couples the axes
+    double crossCoupling() const;
+
+    /**
+     * @brief Calibration in the convention of SensorSettings, where
+     * scale * raw - bias has a length of radius
+     */
+    void axisCalibration(double radius, double scale[3], double bias[3]) const;
+
+    static const int DEFAULT_CAPACITY = 4096;
+
+private:
+    //! Samples between solutions
+    static const int SOLVE_INTERVAL = 10;
+    //! Fewest samples before solving at all
+    static const int MIN_SAMPLES = 12;
+    //! Coverage needed before rejecting outliers or trusting the general fit
+    static const double MIN_COVERAGE;
+    //! Rejection threshold in multiples of the RMS residual
+    static const double OUTLIER_SIGMA;
+    //! Rejection threshold floor, relative to the radius
+    static const double OUTLIER_FLOOR;
+
+    static const int AZIMUTH_BINS = 8;
+    static const int ELEVATION_BINS = 4;
+
+    //! Solve both models and update the statistics
+    bool fit();
+
+    //! Drop stored outliers, returns how many
+    int prune();
+
+    //! Terms of the general quadric for a normalized sample
+    static Eigen::Matrix<double, 9, 1> quadricTerms(const Eigen::Vector3d &u);
+
+    //! Map a normalized sample onto the unit sphere with the current fit
+    Eigen::Vector3d toSphere(const Eigen::Vector3d &u) const;
+
+    //! Recompute coverage and RMS residual over the stored samples
+    void updateStatistics();
+
+    int capacity;
+    int count;
+    int rejected;
+
+    //! Accepted samples, normalized, contiguous and allocated up front
+    std::vector<double> samples;
+
+    //! Inputs are divided by this to keep the normal equations well conditioned
+    double norm;
+
+    Eigen::Matrix<double, 9, 9> normal;
+    Eigen::Matrix<double, 9, 1> rhs;
+
+    bool axisValid;
+    Eigen::Vector3d axisCenter;
+    Eigen::Vector3d axisScale;
+
+    bool fullValid;
+    Eigen::Vector3d fullCenter;
+    Eigen::Matrix3d fullTransform;
+
+    double rmsResidual;
+    double coveredFraction;
+};
+
+#endif // ELLIPSOIDFIT_H
+
+/**
+ * @}
+ * @}
+ */
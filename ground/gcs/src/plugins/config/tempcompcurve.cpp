@@ -49,7 +49,7 @@ TempCompCurve::TempCompCurve(QWidget *parent) :
  * @param temp The set of temperature measurements
  * @param gyro The set of gyro measurements
  */
-void TempCompCurve::plotData(QList<double> temp, QList<double> gyro, QList <double> coeff)
+void TempCompCurve::plotData(const QVector<double> &temp, const QVector<double> &gyro, QList <double> coeff)
 {
     // TODO: Keep the curves and free them in the destructors
     const int STEPS = 100;
@@ -28,6 +28,7 @@
 #define TEMPCOMPCURVE_H
 
 #include <QWidget>
+#include <QVector>
 
 #include "qwt/src/qwt.h"
 #include "qwt/src/qwt_plot.h"
@@ -43,7 +44,7 @@ public:
     explicit TempCompCurve(QWidget *parent = 0);
     
     //! Show calibration data for one of the channels
-    void plotData(QList<double> temp, QList<double> gyro, QList<double> coefficients);
+    void plotData(const QVector<double> &temp, const QVector<double> &gyro, QList<double> coefficients);
 signals:
     
 public slots:
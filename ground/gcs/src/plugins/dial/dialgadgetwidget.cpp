@@ -31,6 +31,7 @@
 #include <math.h>
 
 #include "dialgadgetwidget.h"
+#include "uavobjectupdatebus.h"
 #include <utils/stylehelper.h>
 #include <iostream>
 #include <QDebug>
@@ -64,6 +65,11 @@ DialGadgetWidget::DialGadgetWidget(QWidget *parent) : QGraphicsView(parent)
 
     // This timer mechanism makes needles rotate smoothly
     connect(&dialTimer, SIGNAL(timeout()), this, SLOT(rotateNeedles()));
+
+    // Needles only need the latest value once per frame
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectUpdateBus *updateBus = pm->getObject<UAVObjectUpdateBus>();
+    connect(updateBus, SIGNAL(objectsUpdated(QList<UAVObject*>)), this, SLOT(objectsUpdated(QList<UAVObject*>)));
 }
 
 DialGadgetWidget::~DialGadgetWidget()
@@ -77,12 +83,9 @@ DialGadgetWidget::~DialGadgetWidget()
 void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
                                           QString object2, QString nfield2,
                                           QString object3, QString nfield3) {
-    if (obj1 != NULL)
-        disconnect(obj1,SIGNAL(objectUpdated(UAVObject*)),this,SLOT(updateNeedle1(UAVObject*)));
-    if (obj2 != NULL)
-        disconnect(obj2,SIGNAL(objectUpdated(UAVObject*)),this,SLOT(updateNeedle2(UAVObject*)));
-    if (obj3 != NULL)
-        disconnect(obj3,SIGNAL(objectUpdated(UAVObject*)),this,SLOT(updateNeedle3(UAVObject*)));
+    obj1 = NULL;
+    obj2 = NULL;
+    obj3 = NULL;
 
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
@@ -92,7 +95,6 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
         obj1 = dynamic_cast<UAVDataObject*>( objManager->getObject(object1) );
         if (obj1 != NULL ) {
             // qDebug() << "Connected Object 1 (" << object1 << ").";
-            connect(obj1, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateNeedle1(UAVObject*)));
             if(nfield1.contains("-"))
             {
                 QStringList fieldSubfield = nfield1.split("-", QString::SkipEmptyParts);
@@ -115,7 +117,6 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
         obj2 = dynamic_cast<UAVDataObject*>( objManager->getObject(object2) );
         if (obj2 != NULL ) {
             // qDebug() << "Connected Object 2 (" << object2 << ").";
-            connect(obj2, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateNeedle2(UAVObject*)));
             if(nfield2.contains("-"))
             {
                 QStringList fieldSubfield = nfield2.split("-", QString::SkipEmptyParts);
@@ -138,7 +139,6 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
         obj3 = dynamic_cast<UAVDataObject*>( objManager->getObject(object3) );
         if (obj3 != NULL ) {
             // qDebug() << "Connected Object 3 (" << object3 << ").";
-            connect(obj3, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateNeedle3(UAVObject*)));
             if(nfield3.contains("-"))
             {
                 QStringList fieldSubfield = nfield3.split("-", QString::SkipEmptyParts);
@@ -157,6 +157,19 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
     }
 }
 
+/*!
+  \brief Called by the update bus with the objects updated this frame
+  */
+void DialGadgetWidget::objectsUpdated(const QList<UAVObject*> &objects)
+{
+    if (obj1 != NULL && objects.contains(obj1))
+        updateNeedle1(obj1);
+    if (obj2 != NULL && objects.contains(obj2))
+        updateNeedle2(obj2);
+    if (obj3 != NULL && objects.contains(obj3))
+        updateNeedle3(obj3);
+}
+
 /*!
   \brief Called by the UAVObject which got updated
   */
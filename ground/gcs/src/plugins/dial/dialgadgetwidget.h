@@ -83,6 +83,7 @@ protected:
 
 private slots:
    void rotateNeedles();
+   void objectsUpdated(const QList<UAVObject*> &objects);
 
 private:
    QSvgRenderer *m_renderer;
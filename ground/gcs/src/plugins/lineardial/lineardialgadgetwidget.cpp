@@ -29,6 +29,7 @@
 #include <math.h>
 
 #include "lineardialgadgetwidget.h"
+#include "uavobjectupdatebus.h"
 #include <utils/stylehelper.h>
 #include <QFileDialog>
 #include <QDebug>
@@ -56,6 +57,11 @@ LineardialGadgetWidget::LineardialGadgetWidget(QWidget *parent) : QGraphicsView(
     connect(&dialTimer, SIGNAL(timeout()), this, SLOT(moveIndex()));
     dialTimer.start(30);
 
+    // The index only needs the latest value once per frame
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectUpdateBus *updateBus = pm->getObject<UAVObjectUpdateBus>();
+    connect(updateBus, SIGNAL(objectsUpdated(QList<UAVObject*>)), this, SLOT(objectsUpdated(QList<UAVObject*>)));
+
 }
 
 LineardialGadgetWidget::~LineardialGadgetWidget()
@@ -68,8 +74,7 @@ LineardialGadgetWidget::~LineardialGadgetWidget()
   */
 void LineardialGadgetWidget::connectInput(QString object1, QString nfield1) {
 
-    if (obj1 != NULL)
-        disconnect(obj1,SIGNAL(objectUpdated(UAVObject*)),this,SLOT(updateIndex(UAVObject*)));
+    obj1 = NULL;
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
@@ -79,7 +84,6 @@ void LineardialGadgetWidget::connectInput(QString object1, QString nfield1) {
     if (!(object1.isEmpty() || nfield1.isEmpty())) {
         obj1 = dynamic_cast<UAVDataObject*>( objManager->getObject(object1) );
         if (obj1 != NULL ) {
-            connect(obj1, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateIndex(UAVObject*)));
             if(nfield1.contains("-"))
             {
                 QStringList fieldSubfield = nfield1.split("-", QString::SkipEmptyParts);
@@ -102,6 +106,15 @@ void LineardialGadgetWidget::connectInput(QString object1, QString nfield1) {
     }
 }
 
+/*!
+  \brief Called by the update bus with the objects updated this frame
+  */
+void LineardialGadgetWidget::objectsUpdated(const QList<UAVObject*> &objects)
+{
+    if (obj1 != NULL && objects.contains(obj1))
+        updateIndex(obj1);
+}
+
 /*!
   \brief Called by the UAVObject which got updated
 
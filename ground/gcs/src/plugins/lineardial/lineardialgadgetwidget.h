@@ -70,6 +70,7 @@ private:
 
 private slots:
    void moveIndex();
+   void objectsUpdated(const QList<UAVObject*> &objects);
 
 private:
    QSvgRenderer *m_renderer;
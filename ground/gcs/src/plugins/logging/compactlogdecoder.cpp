@@ -0,0 +1,294 @@
+/**
+ ******************************************************************************
+ *
+ * @file       compactlogdecoder.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @see        The GNU Public License (GPL) Version 3
+ * @brief      Expands compact onboard logs to UAVTalk
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup   Logging
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "compactlogdecoder.h"
+
+#include <QDebug>
+
+// Mirrors flight/Modules/Logging/inc/logcompact.h
+static const char compactMagic[] = "dRLC";
+static const int compactMagicLen = 4;
+static const quint8 compactVersion = 1;
+
+static const quint8 recSchema = 0x80;
+static const quint8 recKey = 0x81;
+static const quint8 recRaw = 0x82;
+static const quint8 flagSingle = 0x01;
+
+static const char headerEnd[] = "##\n";
+
+static quint16 getU16(const QByteArray &in, int pos)
+{
+    return (quint8) in[pos] | ((quint8) in[pos + 1] << 8);
+}
+
+static quint32 getU32(const QByteArray &in, int pos)
+{
+    return getU16(in, pos) | ((quint32) getU16(in, pos + 2) << 16);
+}
+
+//! The UAVTalk CRC-8, polynomial 0x07
+static quint8 crc8(quint8 crc, const char *data, int length)
+{
+    for (int i = 0; i < length; i++) {
+        crc ^= (quint8) data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+
+    return crc;
+}
+
+//! Where the records start, after the "##" line and the magic, or -1
+int CompactLogDecoder::bodyStart(const QByteArray &log)
+{
+    // The header is a few short lines, so only look near the start
+    int end = log.indexOf(headerEnd);
+    if (end < 0 || end > 512)
+        return -1;
+
+    int magic = end + strlen(headerEnd);
+    if (log.mid(magic, compactMagicLen) != QByteArray(compactMagic, compactMagicLen))
+        return -1;
+
+    return magic;
+}
+
+/**
+ * @brief Whether a downloaded log is in the compact format
+ */
+bool CompactLogDecoder::isCompact(const QByteArray &log)
+{
+    return bodyStart(log) >= 0;
+}
+
+/**
+ * @brief Expand a compact log into the header followed by UAVTalk
+ *
+ * Logs in any other format come back unchanged. Damaged stretches are
+ * skipped, and each object resumes at its next key frame.
+ */
+QByteArray CompactLogDecoder::expand(const QByteArray &log)
+{
+    int start = bodyStart(log);
+    if (start < 0)
+        return log;
+
+    if ((quint8) log[start + compactMagicLen] != compactVersion) {
+        qDebug() << "Unknown compact log version" << (quint8) log[start + compactMagicLen];
+        return log;
+    }
+
+    CompactLogDecoder decoder(log, start);
+    return log.left(start) + decoder.run();
+}
+
+CompactLogDecoder::CompactLogDecoder(const QByteArray &log, int start) :
+    in(log), start(start), time(0)
+{
+}
+
+QByteArray CompactLogDecoder::run()
+{
+    int pos = start + compactMagicLen + 1;
+    bool synced = true;
+    int resyncs = 0;
+
+    while (pos < in.size()) {
+        int next = record(pos, synced);
+
+        if (next > 0) {
+            pos = next;
+            synced = true;
+            continue;
+        }
+
+        // Scan for a record with a good crc; deltas need a key again
+        if (synced) {
+            resyncs++;
+            for (QMap<int, Track>::iterator t = tracks.begin(); t != tracks.end(); ++t)
+                t->valid = false;
+        }
+
+        synced = false;
+        pos++;
+    }
+
+    if (resyncs)
+        qDebug() << "Compact log: skipped" << resyncs << "damaged stretches";
+
+    return out;
+}
+
+bool CompactLogDecoder::crcOk(int from, int end) const
+{
+    return end < in.size() &&
+            crc8(0, in.constData() + from, end - from) == (quint8) in[end];
+}
+
+bool CompactLogDecoder::varint(int &pos, quint32 &value) const
+{
+    value = 0;
+
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= in.size())
+            return false;
+
+        quint8 b = in[pos++];
+        value |= (quint32) (b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+//! Write a sample as the logging module would have in UAVTalk mode
+void CompactLogDecoder::emitFrame(quint32 objId, quint16 instId, bool single,
+                                  const QByteArray &data)
+{
+    int headerLen = 8 + (single ? 0 : 2) + 2;
+    int length = headerLen + data.size();
+
+    QByteArray frame;
+    frame.reserve(length + 1);
+    frame.append((char) 0x3C);
+    frame.append((char) 0xA0);          // Object, timestamped
+    frame.append((char) (length & 0xff));
+    frame.append((char) (length >> 8));
+    for (int i = 0; i < 4; i++)
+        frame.append((char) (objId >> (8 * i)));
+    if (!single) {
+        frame.append((char) (instId & 0xff));
+        frame.append((char) (instId >> 8));
+    }
+    frame.append((char) (time & 0xff));
+    frame.append((char) ((time >> 8) & 0xff));
+    frame.append(data);
+    frame.append((char) crc8(0, frame.constData(), frame.size()));
+
+    out.append(frame);
+}
+
+//! Decode the record at pos, returning where the next one starts or 0
+int CompactLogDecoder::record(int pos, bool synced)
+{
+    quint8 type = in[pos];
+
+    if (type == recSchema) {
+        int end = pos + 11;
+        if (!crcOk(pos, end))
+            return 0;
+
+        Track t;
+        t.objId = getU32(in, pos + 2);
+        t.instId = getU16(in, pos + 6);
+        t.single = (quint8) in[pos + 8] & flagSingle;
+        t.length = getU16(in, pos + 9);
+        t.valid = false;
+        tracks[(quint8) in[pos + 1]] = t;
+        return end + 1;
+    }
+
+    if (type == recKey) {
+        if (pos + 1 >= in.size() || !tracks.contains((quint8) in[pos + 1]))
+            return 0;
+
+        Track &t = tracks[(quint8) in[pos + 1]];
+        int end = pos + 6 + t.length;
+        if (!crcOk(pos, end))
+            return 0;
+
+        time = getU32(in, pos + 2);
+        t.last = in.mid(pos + 6, t.length);
+        t.valid = true;
+        emitFrame(t.objId, t.instId, t.single, t.last);
+        return end + 1;
+    }
+
+    if (type == recRaw) {
+        if (pos + 14 > in.size())
+            return 0;
+
+        quint16 length = getU16(in, pos + 12);
+        int end = pos + 14 + length;
+        if (!crcOk(pos, end))
+            return 0;
+
+        time = getU32(in, pos + 8);
+        emitFrame(getU32(in, pos + 1), getU16(in, pos + 5),
+                  (quint8) in[pos + 7] & flagSingle, in.mid(pos + 14, length));
+        return end + 1;
+    }
+
+    // Deltas start with a bare index, so only believe them in sync
+    if (type >= 0x80 || !synced || !tracks.contains(type))
+        return 0;
+
+    Track &t = tracks[type];
+    int p = pos + 1;
+    quint32 dt;
+    if (!varint(p, dt))
+        return 0;
+
+    int words = (t.length + 3) / 4;
+    int bitmap = p;
+    p += (words + 7) / 8;
+    if (p > in.size())
+        return 0;
+
+    QByteArray cur = t.last.leftJustified(words * 4, '\0');
+    for (int i = 0; i < words; i++) {
+        if (!((quint8) in[bitmap + i / 8] & (1 << (i % 8))))
+            continue;
+
+        quint32 z;
+        if (!varint(p, z))
+            return 0;
+
+        quint32 word = getU32(cur, 4 * i) + ((z >> 1) ^ -(z & 1));
+        for (int b = 0; b < 4; b++)
+            cur[4 * i + b] = (char) (word >> (8 * b));
+    }
+
+    if (!crcOk(pos, p))
+        return 0;
+
+    time += dt;
+    if (t.valid) {
+        t.last = cur.left(t.length);
+        emitFrame(t.objId, t.instId, t.single, t.last);
+    }
+
+    return p + 1;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ *
+ * @file       compactlogdecoder.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @see        The GNU Public License (GPL) Version 3
+ * @brief      Expands compact onboard logs to UAVTalk
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup   Logging
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef COMPACTLOGDECODER_H
+#define COMPACTLOGDECODER_H
+
+#include <QByteArray>
+#include <QMap>
+
+/**
+ * Turns a log the firmware wrote in its compact format (see
+ * flight/Modules/Logging/inc/logcompact.h) back into the timestamped UAVTalk
+ * it would otherwise have written, so the rest of the GCS can read it.
+ */
+class CompactLogDecoder
+{
+public:
+    static bool isCompact(const QByteArray &log);
+    static QByteArray expand(const QByteArray &log);
+
+private:
+    CompactLogDecoder(const QByteArray &log, int start);
+
+    struct Track {
+        quint32 objId;
+        quint16 instId;
+        bool single;
+        quint16 length;
+        bool valid;
+        QByteArray last;
+    };
+
+    QByteArray run();
+    int record(int pos, bool synced);
+    bool crcOk(int start, int end) const;
+    bool varint(int &pos, quint32 &value) const;
+    void emitFrame(quint32 objId, quint16 instId, bool single, const QByteArray &data);
+
+    static int bodyStart(const QByteArray &log);
+
+    const QByteArray &in;
+    int start;
+    quint32 time;
+    QMap<int, Track> tracks;
+    QByteArray out;
+};
+
+#endif // COMPACTLOGDECODER_H
+
+/**
+ * @}
+ * @}
+ */
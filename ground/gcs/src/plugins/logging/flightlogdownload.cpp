@@ -35,6 +35,7 @@
 #include <extensionsystem/pluginmanager.h>
 
 #include "loggingstats.h"
+#include "compactlogdecoder.h"
 
 #include <QDateTime>
 #include <QFile>
@@ -127,6 +128,10 @@ void FlightLogDownload::updateReceived()
         UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
         loggingStats->setMetadata(mdata);
 
+        // Store what everything else reads, whichever format was logged
+        if (CompactLogDecoder::isCompact(log))
+            log = CompactLogDecoder::expand(log);
+
         logFile->write(log);
         logFile->close();
 
@@ -1,4 +1,5 @@
 QT += xml
+QT += network
 TEMPLATE = lib
 TARGET = OPMapGadget
 include(../../gcsplugin.pri)
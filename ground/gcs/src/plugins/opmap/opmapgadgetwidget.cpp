@@ -44,6 +44,7 @@
 #include <QDir>
 #include <QFile>
 #include <QDateTime>
+#include <QProgressDialog>
 
 #include <math.h>
 
@@ -388,6 +389,8 @@ void OPMapGadgetWidget::contextMenuEvent(QContextMenuEvent *event)
     contextMenu.addAction(reloadAct);
     contextMenu.addSeparator();
     contextMenu.addAction(ripAct);
+    if (m_map->WPPresent())
+        contextMenu.addAction(seedMapAct);
     contextMenu.addSeparator();
 
     QMenu maxUpdateRateSubMenu(tr("&Max Update Rate ") + "(" + QString::number(m_maxUpdateRate) + " ms)", this);
@@ -1255,6 +1258,10 @@ void OPMapGadgetWidget::createActions()
     ripAct->setStatusTip(tr("Rip the map tiles"));
     connect(ripAct, SIGNAL(triggered()), this, SLOT(onRipAct_triggered()));
 
+    seedMapAct = new QAction(tr("&Cache map around waypoints"), this);
+    seedMapAct->setStatusTip(tr("Store the map tiles around the waypoints for use without a connection"));
+    connect(seedMapAct, SIGNAL(triggered()), this, SLOT(onSeedMapAct_triggered()));
+
     copyMouseLatLonToClipAct = new QAction(tr("Mouse latitude and longitude"), this);
     copyMouseLatLonToClipAct->setStatusTip(tr("Copy the mouse latitude and longitude to the clipboard"));
     connect(copyMouseLatLonToClipAct, SIGNAL(triggered()), this, SLOT(onCopyMouseLatLonToClipAct_triggered()));
@@ -1547,6 +1554,51 @@ void OPMapGadgetWidget::onRipAct_triggered()
     m_map->RipMap();
 }
 
+/**
+ * Caches the tiles around the waypoints from the current zoom level up to
+ * a chosen one, so the mission area can be viewed in the field
+ */
+void OPMapGadgetWidget::onSeedMapAct_triggered()
+{
+    // Tiles this far around the mission are included
+    const double margin = 500;
+
+    QList<internals::PointLatLng> waypoints = m_map->WPCoordinates();
+    if (waypoints.isEmpty())
+        return;
+
+    int minZoom = (int)m_map->ZoomTotal();
+    bool ok;
+    int maxZoom = QInputDialog::getInt(this, tr("Cache map around waypoints"),
+                                       tr("Cache tiles from zoom level %1 up to:").arg(minZoom),
+                                       qMin(minZoom + 3, m_map->MaxZoom()), minZoom, m_map->MaxZoom(), 1, &ok);
+    if (!ok)
+        return;
+
+    mapcontrol::MapSeeder *seeder = new mapcontrol::MapSeeder(m_map->GetMapType(), 0, this);
+    seeder->SetArea(mapcontrol::MapSeeder::AreaAround(waypoints, margin));
+    seeder->SetZoomRange(minZoom, maxZoom);
+
+    int tiles = seeder->TileCount();
+    if (QMessageBox::question(this, tr("Cache map around waypoints"),
+                              tr("This downloads up to %1 tiles, about %2 MB. Continue?")
+                              .arg(tiles).arg(seeder->EstimatedSize() / 1048576.0, 0, 'f', 1),
+                              QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) {
+        delete seeder;
+        return;
+    }
+
+    QProgressDialog *progress = new QProgressDialog(tr("Caching map tiles..."), tr("Cancel"), 0, tiles, this);
+    progress->setAttribute(Qt::WA_DeleteOnClose);
+    progress->setMinimumDuration(0);
+    connect(seeder, SIGNAL(progress(int,int,qint64)), progress, SLOT(setValue(int)));
+    connect(progress, SIGNAL(canceled()), seeder, SLOT(Cancel()));
+    connect(seeder, SIGNAL(finished(int,int)), progress, SLOT(close()));
+    connect(seeder, SIGNAL(finished(int,int)), seeder, SLOT(deleteLater()));
+
+    seeder->Download();
+}
+
 void OPMapGadgetWidget::onCopyMouseLatLonToClipAct_triggered()
 {
     QClipboard *clipboard = QApplication::clipboard();
@@ -31,6 +31,19 @@
 #include <QStringList>
 #include <extensionsystem/pluginmanager.h>
 
+#ifdef WITH_TESTS
+#include "tlmapcontrol/core/pureimagecache.h"
+#include "tlmapcontrol/mapwidget/mapseeder.h"
+#include <QBuffer>
+#include <QDir>
+#include <QImage>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTest>
+#endif
+
 OPMapPlugin::OPMapPlugin()
 {
    // Do nothing
@@ -61,3 +74,169 @@ void OPMapPlugin::shutdown()
 {
    // Do nothing
 }
+
+#ifdef WITH_TESTS
+/*
+ * Reads back a few thousand tiles from a cache file written the way the
+ * cache thread writes it, as panning over an area that is already cached does
+ */
+void OPMapPlugin::testBenchmarkTileCacheReads()
+{
+   const int side = 64;
+   const int zoom = 17;
+   const QByteArray tile(16 * 1024, 'x');
+
+   QTemporaryDir dir;
+   QVERIFY(dir.isValid());
+
+   core::PureImageCache cache;
+   cache.setGtileCache(dir.path() + "/");
+
+   for (int x = 0; x < side; x++) {
+      for (int y = 0; y < side; y++)
+         QVERIFY(cache.PutImageToCache(tile, core::MapType::GoogleSatellite, core::Point(x, y), zoom));
+   }
+   cache.Flush();
+
+   int found = 0;
+   QBENCHMARK {
+      found = 0;
+      for (int x = 0; x < side; x++) {
+         for (int y = 0; y < side; y++) {
+            if (cache.GetImageFromCache(core::MapType::GoogleSatellite, core::Point(x, y), zoom) == tile)
+               found++;
+         }
+      }
+   }
+   QCOMPARE(found, side * side);
+}
+
+/* A small area around a field, a few tiles at each of three zoom levels */
+static QList<internals::PointLatLng> testSeedArea()
+{
+   QList<internals::PointLatLng> field;
+   field << internals::PointLatLng(47.2590, 11.3440)
+         << internals::PointLatLng(47.2600, 11.3500)
+         << internals::PointLatLng(47.2560, 11.3520);
+   return mapcontrol::MapSeeder::AreaAround(field, 200);
+}
+
+static QByteArray testTile()
+{
+   QImage image(8, 8, QImage::Format_RGB32);
+   image.fill(Qt::green);
+
+   QByteArray png;
+   QBuffer buffer(&png);
+   buffer.open(QIODevice::WriteOnly);
+   image.save(&buffer, "PNG");
+   return png;
+}
+
+void OPMapPlugin::testSeederImportsDirectory()
+{
+   QTemporaryDir cacheDir, sourceDir;
+   QVERIFY(cacheDir.isValid() && sourceDir.isValid());
+
+   core::PureImageCache cache;
+   cache.setGtileCache(cacheDir.path() + "/");
+
+   mapcontrol::MapSeeder seeder(core::MapType::OpenStreetMap, &cache);
+   seeder.SetArea(testSeedArea());
+   seeder.SetZoomRange(14, 16);
+
+   // Leave one tile out of the source
+   const QByteArray tile = testTile();
+   int written = 0;
+   bool leftOut = false;
+   for (int zoom = 14; zoom <= 16; zoom++) {
+      foreach (const core::Point &pos, seeder.TileList(zoom)) {
+         if (zoom == 15 && !leftOut) {
+            leftOut = true;
+            continue;
+         }
+         QString dir = QString("%1/%2/%3").arg(sourceDir.path()).arg(zoom).arg(pos.X());
+         QVERIFY(QDir().mkpath(dir));
+         QFile file(QString("%1/%2.png").arg(dir).arg(pos.Y()));
+         QVERIFY(file.open(QIODevice::WriteOnly));
+         file.write(tile);
+         written++;
+      }
+   }
+   QVERIFY(written > 2);
+   QCOMPARE(written, seeder.TileCount() - 1);
+
+   QSignalSpy finished(&seeder, SIGNAL(finished(int,int)));
+   QCOMPARE(seeder.ImportDirectory(sourceDir.path()), written);
+   QCOMPARE(finished.count(), 1);
+
+   foreach (const core::Point &pos, seeder.TileList(14))
+      QCOMPARE(cache.GetImageFromCache(core::MapType::OpenStreetMap, pos, 14), tile);
+
+   // Nothing is stored twice
+   QCOMPARE(seeder.ImportDirectory(sourceDir.path()), 0);
+}
+
+/*
+ * Serves every request with the same tile, the way a tile server on the
+ * local network would, and counts the requests
+ */
+void OPMapPlugin::testSeederDownloadsFromServer()
+{
+   const QByteArray tile = testTile();
+   int requests = 0;
+
+   QTcpServer server;
+   QVERIFY(server.listen(QHostAddress::LocalHost));
+   connect(&server, &QTcpServer::newConnection, [&]() {
+      QTcpSocket *socket = server.nextPendingConnection();
+      connect(socket, &QTcpSocket::readyRead, [&, socket]() {
+         QByteArray request = socket->property("request").toByteArray() + socket->readAll();
+         socket->setProperty("request", request);
+         if (!request.contains("\r\n\r\n"))
+            return;
+
+         requests++;
+         socket->write("HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nConnection: close\r\n");
+         socket->write(QString("Content-Length: %1\r\n\r\n").arg(tile.size()).toLatin1());
+         socket->write(tile);
+         socket->disconnectFromHost();
+      });
+      connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+   });
+
+   QTemporaryDir cacheDir;
+   QVERIFY(cacheDir.isValid());
+
+   core::PureImageCache cache;
+   cache.setGtileCache(cacheDir.path() + "/");
+
+   mapcontrol::MapSeeder seeder(core::MapType::OpenStreetMap, &cache);
+   seeder.SetArea(testSeedArea());
+   seeder.SetZoomRange(14, 16);
+   seeder.SetConcurrency(2);
+   seeder.SetUrlTemplate(QString("http://127.0.0.1:%1/{z}/{x}/{y}.png").arg(server.serverPort()));
+
+   QSignalSpy finished(&seeder, SIGNAL(finished(int,int)));
+   QSignalSpy progress(&seeder, SIGNAL(progress(int,int,qint64)));
+   seeder.Download();
+   QVERIFY(finished.count() == 1 || finished.wait(10000));
+
+   int tiles = seeder.TileCount();
+   QCOMPARE(finished.at(0).at(0).toInt(), tiles);
+   QCOMPARE(finished.at(0).at(1).toInt(), 0);
+   QCOMPARE(requests, tiles);
+   QCOMPARE(progress.count(), tiles);
+   QCOMPARE(progress.last().at(2).toLongLong(), (qint64)tiles * tile.size());
+
+   foreach (const core::Point &pos, seeder.TileList(15))
+      QCOMPARE(cache.GetImageFromCache(core::MapType::OpenStreetMap, pos, 15), tile);
+
+   // A second run finds everything cached and asks for nothing
+   finished.clear();
+   seeder.Download();
+   QCOMPARE(finished.count(), 1);
+   QCOMPARE(finished.at(0).at(0).toInt(), 0);
+   QCOMPARE(requests, tiles);
+}
+#endif
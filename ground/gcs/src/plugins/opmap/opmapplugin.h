@@ -46,5 +46,12 @@ public:
    void shutdown();
 private:
    OPMapGadgetFactory *mf;
+
+#ifdef WITH_TESTS
+private slots:
+   void testBenchmarkTileCacheReads();
+   void testSeederImportsDirectory();
+   void testSeederDownloadsFromServer();
+#endif
 };
 #endif /* OPMAP_PLUGIN_H_ */
@@ -30,6 +30,7 @@
 #include "utils/stylehelper.h"
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
+#include "uavobjectupdatebus.h"
 #include "systemalarms.h"
 #include <coreplugin/icore.h>
 #include <QDebug>
@@ -52,12 +53,11 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent) : QGraphicsV
 
     paint();
 
-    // Now connect the widget to the SystemAlarms UAVObject
+    // Now connect the widget to the SystemAlarms UAVObject, through the
+    // update bus so a burst of alarm changes repaints once
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
-
-    SystemAlarms* obj = SystemAlarms::GetInstance(objManager);
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateAlarms(UAVObject*)));
+    UAVObjectUpdateBus *updateBus = pm->getObject<UAVObjectUpdateBus>();
+    connect(updateBus, SIGNAL(objectsUpdated(QList<UAVObject*>)), this, SLOT(objectsUpdated(QList<UAVObject*>)));
 
     // Listen to autopilot connection events
     TelemetryManager* telMngr = pm->getObject<TelemetryManager>();
@@ -83,6 +83,14 @@ void SystemHealthGadgetWidget::onAutopilotDisconnect()
     nolink->setVisible(true);
 }
 
+void SystemHealthGadgetWidget::objectsUpdated(const QList<UAVObject*> &objects)
+{
+    foreach (UAVObject *obj, objects) {
+        if (obj->getObjID() == SystemAlarms::OBJID)
+            updateAlarms(obj);
+    }
+}
+
 void SystemHealthGadgetWidget::updateAlarms(UAVObject* systemAlarm)
 {
     static QList<QString> warningClean;
@@ -56,6 +56,7 @@ protected:
    void mousePressEvent ( QMouseEvent * event );
 
 private slots:
+   void objectsUpdated(const QList<UAVObject*> &objects);
    void updateAlarms(UAVObject *systemAlarm); // Called by the systemalarms UAVObject
    void onAutopilotConnect();
    void onAutopilotDisconnect();
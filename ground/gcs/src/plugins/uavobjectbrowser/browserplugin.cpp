@@ -30,6 +30,13 @@
 #include <QStringList>
 #include <extensionsystem/pluginmanager.h>
 
+#ifdef WITH_TESTS
+#include "uavobjecttreemodel.h"
+#include "uavobjectmanager.h"
+#include <QSignalSpy>
+#include <QTest>
+#endif
+
 BrowserPlugin::BrowserPlugin()
 {
    // Do nothing
@@ -59,3 +66,109 @@ void BrowserPlugin::shutdown()
 {
    // Do nothing
 }
+
+#ifdef WITH_TESTS
+/* The index of an object's row, with the model not categorized */
+static QModelIndex objectIndex(UAVObjectTreeModel &model, UAVDataObject *obj)
+{
+   TopTreeItem *top = obj->isSettings() ? model.getSettingsTree() : model.getNonSettingsTree();
+   DataObjectTreeItem *item = top->findDataObjectTreeItemByObjectId(obj->getObjID());
+   if (!item)
+      return QModelIndex();
+
+   return model.index(item->row(), 0, model.index(top->row(), 0));
+}
+
+/* Objects only get their field rows when first expanded */
+void BrowserPlugin::testFieldsCreatedOnExpand()
+{
+   UAVObjectManager *objManager = ExtensionSystem::PluginManager::instance()->getObject<UAVObjectManager>();
+   UAVObjectTreeModel model;
+   model.initializeModel(false, false);
+
+   foreach (const QVector<UAVDataObject*> &instances, objManager->getDataObjectsVector()) {
+      if (instances.isEmpty() || !instances.first()->isSingleInstance())
+         continue;
+
+      UAVDataObject *obj = instances.first();
+      QModelIndex index = objectIndex(model, obj);
+      QVERIFY2(index.isValid(), qPrintable(obj->getName()));
+
+      // Only the metadata row is there up front
+      QCOMPARE(model.rowCount(index), 1);
+      QVERIFY(model.hasChildren(index));
+      QVERIFY(model.canFetchMore(index));
+
+      model.fetchMore(index);
+      QCOMPARE(model.rowCount(index), 1 + obj->getFields().count());
+      QVERIFY(!model.canFetchMore(index));
+   }
+}
+
+/* An update of several fields repaints them with one dataChanged() */
+void BrowserPlugin::testUpdateCoalescesRows()
+{
+   UAVObjectManager *objManager = ExtensionSystem::PluginManager::instance()->getObject<UAVObjectManager>();
+   UAVDataObject *obj = NULL;
+
+   // An object made of a few plain floats, so each can be changed by one
+   foreach (const QVector<UAVDataObject*> &instances, objManager->getDataObjectsVector()) {
+      if (instances.isEmpty() || !instances.first()->isSingleInstance() || instances.first()->isSettings())
+         continue;
+
+      QList<UAVObjectField*> fields = instances.first()->getFields();
+      bool plain = fields.count() >= 3;
+      foreach (UAVObjectField *field, fields)
+         plain = plain && field->getType() == UAVObjectField::FLOAT32 && field->getNumElements() == 1;
+
+      if (plain) {
+         obj = instances.first();
+         break;
+      }
+   }
+   if (!obj)
+      QSKIP("No object made of plain floats");
+
+   UAVObjectTreeModel model;
+   model.initializeModel(false, false);
+   QModelIndex index = objectIndex(model, obj);
+   model.fetchMore(index);
+
+   QByteArray saved(obj->getNumBytes(), 0);
+   obj->pack((quint8*)saved.data());
+
+   QSignalSpy spy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+
+   // The update bus hands the model these as one batch
+   foreach (UAVObjectField *field, obj->getFields())
+      field->setValue(field->getValue().toDouble() + 1);
+   emit obj->objectUpdated(obj);
+
+   QTRY_VERIFY(spy.count() > 0);
+
+   // Other objects may share the batch, but the fields are one range
+   int fieldRanges = 0;
+   foreach (const QList<QVariant> &args, spy) {
+      QModelIndex topLeft = args.at(0).value<QModelIndex>();
+      QModelIndex bottomRight = args.at(1).value<QModelIndex>();
+      if (topLeft.parent() != index)
+         continue;
+
+      fieldRanges++;
+      QCOMPARE(topLeft.row(), 1);
+      QCOMPARE(bottomRight.row(), obj->getFields().count());
+   }
+   QCOMPARE(fieldRanges, 1);
+
+   obj->unpack((const quint8*)saved.constData());
+}
+
+void BrowserPlugin::testBenchmarkModelSetup()
+{
+   UAVObjectTreeModel model;
+
+   QBENCHMARK {
+      model.initializeModel(true, false);
+   }
+}
+#endif
@@ -45,5 +45,12 @@ public:
    void shutdown();
 private:
    UAVObjectBrowserFactory *mf;
+
+#ifdef WITH_TESTS
+private slots:
+   void testFieldsCreatedOnExpand();
+   void testUpdateCoalescesRows();
+   void testBenchmarkModelSetup();
+#endif
 };
 #endif /* UAVOBJECTBROWSERPLUGIN_H_ */
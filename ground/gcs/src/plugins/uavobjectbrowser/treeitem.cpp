@@ -37,71 +37,78 @@
 #include "fieldtreeitem.h"
 #include <math.h>
 
-QTime* HighLightManager::m_currentTime = NULL;
-
 /* Constructor */
-HighLightManager::HighLightManager(long checkingInterval, QTime *currentTime)
+HighLightManager::HighLightManager()
 {
-    // Start the timer and connect it to the callback
-    m_expirationTimer.start(checkingInterval);
-    connect(&m_expirationTimer, SIGNAL(timeout()), this, SLOT(checkItemsExpired()));
-
-    if (currentTime == NULL)
-        m_currentTime = new QTime;
-    m_currentTime = currentTime;
 }
 
 /*
- * Called to add item to list. Item is only added if absent.
+ * Called to add item to the set. Item is only added if absent.
  * Returns true if item was added, otherwise false.
  */
 bool HighLightManager::add(TreeItem *itemToAdd)
 {
-    // Check so that the item isn't already in the list
-    if(!m_itemsList.contains(itemToAdd))
+    // Check so that the item isn't already in the set
+    if(!m_items.contains(itemToAdd))
     {
-        m_itemsList.append(itemToAdd);
+        m_items.insert(itemToAdd);
         return true;
     }
     return false;
 }
 
 /*
- * Called to remove item from list.
+ * Called to remove item from the set.
  * Returns true if item was removed, otherwise false.
  */
 bool HighLightManager::remove(TreeItem *itemToRemove)
 {
     // Remove item and return result
-    return m_itemsList.removeOne(itemToRemove);
+    return m_items.remove(itemToRemove);
 }
 
 /*
- * Callback called periodically by the timer.
+ * Called when an item is deleted, so neither set is
+ * left pointing at it.
+ */
+void HighLightManager::forget(TreeItem *item)
+{
+    m_items.remove(item);
+    m_changedItems.remove(item);
+}
+
+/*
+ * Called periodically by the model's timer.
  * This method checks for expired highlights and
  * removes them if they are expired.
  * Expired highlights are restored.
  */
-void HighLightManager::checkItemsExpired()
+void HighLightManager::checkItemsExpired(const QTime &now)
 {
-    // Get a mutable iterator for the list
-    QMutableLinkedListIterator<TreeItem*> iter(m_itemsList);
+    QMutableSetIterator<TreeItem*> iter(m_items);
 
     // Loop over all items, check if they expired.
     while(iter.hasNext())
     {
         TreeItem* item = iter.next();
-        if(item->getHiglightExpires() < *m_currentTime)
+        if(item->getHiglightExpires() < now)
         {
             // If expired, call removeHighlight
             item->removeHighlight();
 
-            // Remove from list since it is restored.
+            // Remove from the set since it is restored.
             iter.remove();
         }
     }
 }
 
+QSet<TreeItem*> HighLightManager::takeChangedItems()
+{
+    QSet<TreeItem*> changed;
+    changed.swap(m_changedItems);
+    return changed;
+}
+
 int TreeItem::m_highlightTimeMs = 500;
 QTime* TreeItem::m_currentTime = NULL;
 
@@ -112,7 +119,8 @@ TreeItem::TreeItem(const QList<QVariant> &data, TreeItem *parent) :
         m_parent(parent),
         m_highlight(false),
         m_changed(false),
-        m_updated(false)
+        m_updated(false),
+        m_highlightManager(NULL)
 {
 }
 
@@ -122,7 +130,8 @@ TreeItem::TreeItem(const QVariant &data, TreeItem *parent) :
         m_parent(parent),
         m_highlight(false),
         m_changed(false),
-        m_updated(false)
+        m_updated(false),
+        m_highlightManager(NULL)
 {
     m_data << data << "" << "";
 }
@@ -130,6 +139,8 @@ TreeItem::TreeItem(const QVariant &data, TreeItem *parent) :
 TreeItem::~TreeItem()
 {
     qDeleteAll(m_children);
+    if (m_highlightManager)
+        m_highlightManager->forget(this);
 }
 
 void TreeItem::appendChild(TreeItem *child)
@@ -206,19 +217,16 @@ void TreeItem::setHighlight(bool highlight) {
         else
             m_highlightExpires = QTime::currentTime().addMSecs(m_highlightTimeMs);
 
-        // Add to highlightmanager
-        if(m_highlightManager->add(this))
-        {
-            // Only emit signal if it was added
-            emit updateHighlight(this);
-        }
+        m_highlightManager->add(this);
     }
-    else if(m_highlightManager->remove(this))
+    else
     {
-        // Only emit signal if it was removed
-        emit updateHighlight(this);
+        m_highlightManager->remove(this);
     }
 
+    // The model repaints the changed items in one go
+    m_highlightManager->itemChanged(this);
+
     // If we have a parent, call recursively to update highlight status of parents.
     // This will ensure that the root of a leaf that is changed also is highlighted.
     // Only updates that really changes values will trigger highlight of parents.
@@ -256,8 +264,7 @@ void TreeItem::setUpdatedOnlyParent()
 
 void TreeItem::removeHighlight() {
     m_highlight = false;
-    //update();
-    emit updateHighlight(this);
+    m_highlightManager->itemChanged(this);
 }
 
 void TreeItem::setHighlightManager(HighLightManager *mgr)
@@ -41,8 +41,8 @@
 #include "uavmetaobject.h"
 #include "uavobjectfield.h"
 #include <QtCore/QList>
-#include <QtCore/QLinkedList>
 #include <QtCore/QMap>
+#include <QtCore/QSet>
 #include <QtCore/QVariant>
 #include <QtCore/QTime>
 #include <QtCore/QTimer>
@@ -54,24 +54,18 @@ class TreeItem;
 /*
 * Small utility class that handles the higlighting of
 * tree grid items.
-* Basicly it maintains all items due to be restored to
-* non highlighted state in a linked list.
-* A timer traverses this list periodically to find out
-* if any of the items should be restored. All items are
-* updated withan expiration timestamp when they expires.
-* An item that is beeing restored is removed from the
-* list and its removeHighlight() method is called. Items
-* that are not expired are left in the list til next time.
-* Items that are updated during the expiration time are
-* left untouched in the list. This reduces unwanted emits
-* of signals to the repaint/update function.
+* It keeps the items due to be restored to non highlighted
+* state in a set, each with its expiration timestamp. The
+* model's single timer calls checkItemsExpired() to restore
+* the ones that expired.
+* Items whose highlight or value changed are collected as
+* well, so the model can repaint them all at once with one
+* dataChanged() per run of siblings instead of one per item.
 */
-class HighLightManager : public QObject
+class HighLightManager
 {
-Q_OBJECT
 public:
-    // Constructor taking the checking interval in ms.
-    HighLightManager(long checkingInterval, QTime *currentTime);
+    HighLightManager();
 
     // This is called when an item has been set to
     // highlighted = true.
@@ -80,19 +74,26 @@ public:
     //This is called when an item is set to highlighted = false;
     bool remove(TreeItem* itemToRemove);
 
-private slots:
-    // Timer callback method.
-    void checkItemsExpired();
+    // This is called when an item needs repainting.
+    void itemChanged(TreeItem* item) { m_changedItems.insert(item); }
 
-private:
-    // The timer checking highlight expiration.
-    QTimer m_expirationTimer;
+    // This is called when an item is deleted.
+    void forget(TreeItem* item);
 
-    // The list holding all items due to be updated.
-    QLinkedList<TreeItem*> m_itemsList;
+    // Restores the items whose highlight expired before now.
+    void checkItemsExpired(const QTime &now);
 
-    // This is the timestamp to compare with
-    static QTime *m_currentTime;
+    // Returns the items to repaint and clears the set.
+    QSet<TreeItem*> takeChangedItems();
+
+    bool hasHighlightedItems() const { return !m_items.isEmpty(); }
+
+private:
+    // The items due to be restored.
+    QSet<TreeItem*> m_items;
+
+    // The items to repaint.
+    QSet<TreeItem*> m_changedItems;
 };
 
 class TreeItem : public QObject
@@ -177,11 +178,6 @@ public:
 
     void setCurrentTime(QTime *currentTime);
 
-signals:
-    void updateHighlight(TreeItem*);
-
-private slots:
-
 private:
     QList<TreeItem*> m_children;
     // m_data contains: [0] property name, [1] value, [2] unit
@@ -237,16 +233,21 @@ class ObjectTreeItem : public TreeItem
 Q_OBJECT
 public:
     ObjectTreeItem(const QList<QVariant> &data, TreeItem *parent = 0) :
-            TreeItem(data, parent), m_obj(0) { }
+            TreeItem(data, parent), m_obj(0), m_fieldsPending(false) { }
     ObjectTreeItem(const QVariant &data, TreeItem *parent = 0) :
-            TreeItem(data, parent), m_obj(0) { }
+            TreeItem(data, parent), m_obj(0), m_fieldsPending(false) { }
     virtual void setObject(UAVObject *obj) {
         m_obj = obj; setDescription(obj->getDescription());
     }
     inline UAVObject *object() { return m_obj; }
 
+    // The field rows of m_obj are only created when the item is first expanded
+    inline bool fieldsPending() { return m_fieldsPending; }
+    inline void setFieldsPending(bool pending) { m_fieldsPending = pending; }
+
 private:
     UAVObject *m_obj;
+    bool m_fieldsPending;
 };
 
 class MetaObjectTreeItem : public ObjectTreeItem
@@ -614,6 +614,10 @@ void UAVObjectBrowserWidget::enableUAVOBrowserButtons(bool enableState)
  */
 void UAVObjectBrowserWidget::searchTextChanged(QString searchText)
 {
+    // Field rows are only created on expand, and the filter has to see them
+    if (!searchText.isEmpty())
+        m_model->fetchAllFields();
+
     proxyModel->setFilterRegExp(QRegExp(searchText, Qt::CaseInsensitive, QRegExp::FixedString));
 }
 
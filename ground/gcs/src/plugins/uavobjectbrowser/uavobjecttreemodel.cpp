@@ -39,11 +39,13 @@
 #include "uavdataobject.h"
 #include "uavmetaobject.h"
 #include "uavobjectfield.h"
+#include "uavobjectupdatebus.h"
 #include "extensionsystem/pluginmanager.h"
 #include <QColor>
 //#include <QIcon>
 #include <QtCore/QTimer>
 #include <QtCore/QSignalMapper>
+#include <QtCore/QHash>
 #include <QtCore/QDebug>
 #include <math.h>
 
@@ -58,6 +60,7 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
     m_updatedOnlyColor(QColor(174,207,250,255)),
     m_isPresentOnHwColor(QApplication::palette().text().color()),
     m_notPresentOnHwColor(QColor(174,207,250,255)),
+    m_onlyHighlightChangedValues(false),
     m_useScientificFloatNotation(useScientificNotation),
     m_hideNotPresent(false),
     m_categorize(true),
@@ -67,18 +70,24 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     objManager = pm->getObject<UAVObjectManager>();
 
+    // Fast streams would otherwise repaint the tree for every sample
+    UAVObjectUpdateBus *updateBus = pm->getObject<UAVObjectUpdateBus>();
+    connect(updateBus, SIGNAL(objectsUpdated(QList<UAVObject*>)), this, SLOT(highlightUpdatedObjects(QList<UAVObject*>)));
+
     m_currentTime = QTime::currentTime();
-    // Create timer that sets the rhythm for all highlight events.
+    // Create timer that sets the rhythm for all highlight events. It only
+    // runs while something is highlighted.
     connect(&m_currentTimeTimer, SIGNAL(timeout()), this, SLOT(updateCurrentTime()));
-    m_currentTimeTimer.start(lrint(fmax(m_recentlyUpdatedTimeout / 10.0f, 10))); // Update the timer 10 times faster than the time
-                                                                                 // out. In any case, never go faster than 10ms.
+    m_currentTimeTimer.setInterval(lrint(fmax(m_recentlyUpdatedTimeout / 10.0f, 10))); // Update the timer 10 times faster than the time
+                                                                                       // out. In any case, never go faster than 10ms.
     TreeItem::setHighlightTime(m_recentlyUpdatedTimeout);
 }
 
 UAVObjectTreeModel::~UAVObjectTreeModel()
 {
-    delete m_highlightManager;
+    // Items tell the highlight manager when they are deleted
     delete m_rootItem;
+    delete m_highlightManager;
 }
 
 /**
@@ -97,14 +106,14 @@ void UAVObjectTreeModel::setupModelData(UAVObjectManager *objManager, bool categ
         disconnect(objManager, SIGNAL(newObject(UAVObject*)), this, SLOT(newObject(UAVObject*)));
         disconnect(objManager, SIGNAL(newInstance(UAVObject*)), this, SLOT(newObject(UAVObject*)));
         disconnect(objManager, SIGNAL(instanceRemoved(UAVObject*)), this, SLOT(instanceRemove(UAVObject*)));
-        delete m_highlightManager;
         int count = m_rootItem->childCount();
         beginRemoveRows(index(m_rootItem), 0, count);
         delete m_rootItem;
         endRemoveRows();
+        delete m_highlightManager;
     }
-    // Create highlight manager, let it run every 300 ms.
-    m_highlightManager = new HighLightManager(300, &m_currentTime);
+    // Create highlight manager, checked by m_currentTimeTimer
+    m_highlightManager = new HighLightManager();
     QList<QVariant> rootData;
     rootData << tr("Property") << tr("Value") << tr("Unit");
     m_rootItem = new TreeItem(rootData);
@@ -117,8 +126,6 @@ void UAVObjectTreeModel::setupModelData(UAVObjectManager *objManager, bool categ
     m_nonSettingsTree->setHighlightManager(m_highlightManager);
     m_rootItem->appendChild(m_nonSettingsTree);
     m_rootItem->setHighlightManager(m_highlightManager);
-    connect(m_settingsTree, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
-    connect(m_nonSettingsTree, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
 
     QVector< QVector<UAVDataObject*> > objList = objManager->getDataObjectsVector();
     foreach (QVector<UAVDataObject*> list, objList) {
@@ -159,8 +166,12 @@ void UAVObjectTreeModel::instanceRemove(UAVObject *obj)
             InstanceTreeItem *inst = dynamic_cast<InstanceTreeItem*>(item);
             if(inst && inst->object() == obj)
             {
+                int row = inst->row();
+                beginRemoveRows(index(existing), row, row);
                 inst->parent()->removeChild(inst);
-                inst->deleteLater();
+                endRemoveRows();
+                // Deleted now so its rows are gone from the highlight manager too
+                delete inst;
             }
         }
     }
@@ -185,7 +196,6 @@ void UAVObjectTreeModel::addDataObject(UAVDataObject *obj, bool categorize)
     } else {
         DataObjectTreeItem *dataTreeItem = new DataObjectTreeItem(obj->getName() + " (" + QString::number(obj->getNumBytes()) + " bytes)");
         dataTreeItem->setHighlightManager(m_highlightManager);
-        connect(dataTreeItem, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
         parent->insertChild(dataTreeItem);
         root->addObjectTreeItem(obj->getObjID(), dataTreeItem);
         UAVMetaObject *meta = obj->getMetaObject();
@@ -202,7 +212,6 @@ TreeItem* UAVObjectTreeModel::createCategoryItems(QStringList categoryPath, Tree
         TreeItem* existing = parent->findChildByName(category);
         if(!existing) {
             TreeItem* categoryItem = new CategoryTreeItem(category);
-            connect(categoryItem, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
             categoryItem->setHighlightManager(m_highlightManager);
             parent->insertChild(categoryItem);
             parent = categoryItem;
@@ -216,36 +225,27 @@ TreeItem* UAVObjectTreeModel::createCategoryItems(QStringList categoryPath, Tree
 
 MetaObjectTreeItem* UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
     MetaObjectTreeItem *meta = new MetaObjectTreeItem(obj, tr("Meta Data"));
 
     meta->setHighlightManager(m_highlightManager);
-    connect(meta, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
-    foreach (UAVObjectField *field, obj->getFields()) {
-        if (field->getNumElements() > 1) {
-            addArrayField(field, meta);
-        } else {
-            addSingleField(0, field, meta);
-        }
-    }
+    // Fields are added by fetchMore() when the item is first expanded
+    meta->setFieldsPending(true);
     parent->appendChild(meta);
     return meta;
 }
 
 void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
-    TreeItem *item;
+    ObjectTreeItem *item;
     DataObjectTreeItem *p = static_cast<DataObjectTreeItem*>(parent);
     if (obj->isSingleInstance()) {
-        item = parent;
+        item = p;
         p->setObject(obj);
     } else {
         p->setObject(NULL);
         QString name = tr("Instance") +  " " + QString::number(obj->getInstID());
         item = new InstanceTreeItem(obj, name);
         item->setHighlightManager(m_highlightManager);
-        connect(item, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
 
         // Inform the model that we will add a row
         beginInsertRows(index(parent), parent->childCount(), parent->childCount());
@@ -256,13 +256,8 @@ void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
         // Inform the model that the row addition is complete
         endInsertRows();
     }
-    foreach (UAVObjectField *field, obj->getFields()) {
-        if (field->getNumElements() > 1) {
-            addArrayField(field, item);
-        } else {
-            addSingleField(0, field, item);
-        }
-    }
+    // Fields are added by fetchMore() when the item is first expanded
+    item->setFieldsPending(true);
     UAVDataObject * dobj = dynamic_cast<UAVDataObject *>(obj);
     if(dobj)
     {
@@ -270,11 +265,21 @@ void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
     }
 }
 
+void UAVObjectTreeModel::addFields(UAVObject *obj, TreeItem *parent)
+{
+    foreach (UAVObjectField *field, obj->getFields()) {
+        if (field->getNumElements() > 1) {
+            addArrayField(field, parent);
+        } else {
+            addSingleField(0, field, parent);
+        }
+    }
+}
+
 void UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
 {
     TreeItem *item = new ArrayFieldTreeItem(field->getName());
     item->setHighlightManager(m_highlightManager);
-    connect(item, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
     for (uint i = 0; i < field->getNumElements(); ++i) {
         addSingleField(i, field, item);
     }
@@ -322,7 +327,6 @@ void UAVObjectTreeModel::addSingleField(int index, UAVObjectField *field, TreeIt
     }
     item->setDescription(field->getDescription());
     item->setHighlightManager(m_highlightManager);
-    connect(item, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
     parent->appendChild(item);
 }
 
@@ -351,16 +355,9 @@ QModelIndex UAVObjectTreeModel::index(TreeItem *item)
     if (item->parent() == 0)
         return QModelIndex();
 
-    QModelIndex root = index(item->parent());
-
-    for (int i = 0; i < rowCount(root); ++i) {
-        QModelIndex childIndex = index(i, 0, root);
-        TreeItem *child = static_cast<TreeItem*>(childIndex.internalPointer());
-        if (child == item)
-            return childIndex;
-    }
-    Q_ASSERT(false);
-    return QModelIndex();
+    int row = item->row();
+    Q_ASSERT(row >= 0);
+    return createIndex(row, 0, item);
 }
 
 QModelIndex UAVObjectTreeModel::parent(const QModelIndex &index) const
@@ -398,6 +395,74 @@ int UAVObjectTreeModel::columnCount(const QModelIndex &parent) const
         return m_rootItem->columnCount();
 }
 
+/**
+ * @brief Objects whose fields are not created yet still show an expander
+ */
+bool UAVObjectTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (parent.column() > 0)
+        return false;
+
+    if (canFetchMore(parent))
+        return true;
+
+    return rowCount(parent) > 0;
+}
+
+bool UAVObjectTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return false;
+
+    ObjectTreeItem *item = dynamic_cast<ObjectTreeItem*>(static_cast<TreeItem*>(parent.internalPointer()));
+    return item && item->fieldsPending();
+}
+
+/**
+ * @brief Creates the field rows of an object when the view first expands it
+ * @param parent the object's index
+ */
+void UAVObjectTreeModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+
+    ObjectTreeItem *item = static_cast<ObjectTreeItem*>(static_cast<TreeItem*>(parent.internalPointer()));
+    item->setFieldsPending(false);
+
+    UAVObject *obj = item->object();
+    int first = item->childCount();
+    int count = obj->getFields().count();
+    if (count == 0)
+        return;
+
+    beginInsertRows(parent, first, first + count - 1);
+    addFields(obj, item);
+    for (int i = first; i < item->childCount(); ++i)
+        item->getChild(i)->setIsPresentOnHardware(item->getIsPresentOnHardware());
+    endInsertRows();
+}
+
+/**
+ * @brief Creates the field rows of every object, so a search can look
+ * into them
+ */
+void UAVObjectTreeModel::fetchAllFields()
+{
+    if (m_rootItem)
+        fetchAllFields(m_rootItem);
+}
+
+void UAVObjectTreeModel::fetchAllFields(TreeItem *item)
+{
+    QModelIndex itemIndex = index(item);
+    if (canFetchMore(itemIndex))
+        fetchMore(itemIndex);
+
+    foreach (TreeItem *child, item->treeChildren())
+        fetchAllFields(child);
+}
+
 QList<QModelIndex> UAVObjectTreeModel::getMetaDataIndexes()
 {
     QList<QModelIndex> metaIndexes;
@@ -520,6 +585,28 @@ QVariant UAVObjectTreeModel::headerData(int section, Qt::Orientation orientation
     return QVariant();
 }
 
+/**
+ * @brief Refreshes the objects updated since the last frame
+ * @param objects the batch from the update bus
+ */
+void UAVObjectTreeModel::highlightUpdatedObjects(const QList<UAVObject*> &objects)
+{
+    // Nothing to refresh before the model is set up
+    if (!m_rootItem)
+        return;
+
+    // Highlights expire relative to this batch
+    m_currentTime = QTime::currentTime();
+
+    foreach (UAVObject *obj, objects)
+        highlightUpdatedObject(obj);
+
+    emitHighlightChanges();
+
+    if (m_highlightManager->hasHighlightedItems() && !m_currentTimeTimer.isActive())
+        m_currentTimeTimer.start();
+}
+
 void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
 {
     Q_ASSERT(obj);
@@ -528,11 +615,43 @@ void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
     if(!m_onlyHighlightChangedValues){
         item->setHighlight(true);
     }
+    // Only the fields created so far have rows to refresh; the rest
+    // read the object when they are created
     item->update();
-    if(!m_onlyHighlightChangedValues){
-        QModelIndex itemIndex = index(item);
-        Q_ASSERT(itemIndex != QModelIndex());
-        emit dataChanged(itemIndex, itemIndex);
+}
+
+/**
+ * @brief Repaints the items whose value or highlight changed, with one
+ * dataChanged() per parent spanning its changed rows
+ */
+void UAVObjectTreeModel::emitHighlightChanges()
+{
+    QHash<TreeItem*, QPair<int, int> > ranges;
+
+    foreach (TreeItem *item, m_highlightManager->takeChangedItems()) {
+        // The root item has no row to repaint
+        TreeItem *parent = item->parent();
+        if (!parent)
+            continue;
+
+        int row = item->row();
+        QHash<TreeItem*, QPair<int, int> >::iterator range = ranges.find(parent);
+        if (range == ranges.end()) {
+            ranges.insert(parent, qMakePair(row, row));
+        } else {
+            range->first = qMin(range->first, row);
+            range->second = qMax(range->second, row);
+        }
+    }
+
+    QHashIterator<TreeItem*, QPair<int, int> > iter(ranges);
+    while (iter.hasNext()) {
+        iter.next();
+        TreeItem *parent = iter.key();
+        int first = iter.value().first;
+        int last = iter.value().second;
+        emit dataChanged(createIndex(first, 0, parent->getChild(first)),
+                         createIndex(last, TreeItem::dataColumn, parent->getChild(last)));
     }
 }
 
@@ -566,20 +685,21 @@ MetaObjectTreeItem* UAVObjectTreeModel::findMetaObjectTreeItem(UAVMetaObject *ob
     return root->findMetaObjectTreeItemByObjectId(obj->getObjID());
 }
 
-void UAVObjectTreeModel::updateHighlight(TreeItem *item)
-{
-    QModelIndex itemIndex = index(item);
-    Q_ASSERT(itemIndex != QModelIndex());
-    emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::dataColumn));
-}
-
-
 /**
  * @brief TreeItem::updateCurrentTime  This single timer sets the rhythm for all highlight events.
  */
 void UAVObjectTreeModel::updateCurrentTime()
 {
     m_currentTime = QTime::currentTime();
+
+    if (!m_highlightManager)
+        return;
+
+    m_highlightManager->checkItemsExpired(m_currentTime);
+    emitHighlightChanges();
+
+    if (!m_highlightManager->hasHighlightedItems())
+        m_currentTimeTimer.stop();
 }
 
 void UAVObjectTreeModel::presentOnHardwareChangedCB(UAVDataObject * obj)
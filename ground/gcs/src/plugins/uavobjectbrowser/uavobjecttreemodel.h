@@ -70,6 +70,10 @@ public:
     QModelIndex parent(const QModelIndex &index) const;
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+    void fetchAllFields();
 
     TopTreeItem* getSettingsTree(){return m_settingsTree;}
     TopTreeItem* getNonSettingsTree(){return m_nonSettingsTree;}
@@ -95,8 +99,7 @@ public slots:
     void initializeModel(bool categorize = true, bool useScientificFloatNotation = true);
     void instanceRemove(UAVObject*);
 private slots:
-    void highlightUpdatedObject(UAVObject *obj);
-    void updateHighlight(TreeItem*);
+    void highlightUpdatedObjects(const QList<UAVObject*> &objects);
     void updateCurrentTime();
     void presentOnHardwareChangedCB(UAVDataObject*);
 
@@ -108,6 +111,10 @@ private:
     void addArrayField(UAVObjectField *field, TreeItem *parent);
     void addSingleField(int index, UAVObjectField *field, TreeItem *parent);
     void addInstance(UAVObject *obj, TreeItem *parent);
+    void addFields(UAVObject *obj, TreeItem *parent);
+    void fetchAllFields(TreeItem *item);
+    void highlightUpdatedObject(UAVObject *obj);
+    void emitHighlightChanges();
 
     TreeItem *createCategoryItems(QStringList categoryPath, TreeItem *root);
 
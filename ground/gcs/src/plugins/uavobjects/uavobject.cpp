@@ -273,6 +273,29 @@ UAVObjectField* UAVObject::getField(const QString& name)
  * @returns The number of bytes copied
  */
 qint32 UAVObject::pack(quint8* dataOut)
+{
+    packData(dataOut);
+    return numBytes;
+}
+
+/**
+ * Unpack the object data from a byte array
+ * @returns The number of bytes copied
+ */
+qint32 UAVObject::unpack(const quint8* dataIn)
+{
+    unpackData(dataIn);
+    emit objectUnpacked(this); // trigger object updated event
+    emit objectUpdated(this);
+
+    return numBytes;
+}
+
+/**
+ * Pack field by field; generated objects override this with a copy of
+ * their data
+ */
+void UAVObject::packData(quint8* dataOut)
 {
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
@@ -281,14 +304,13 @@ qint32 UAVObject::pack(quint8* dataOut)
         field->pack(&dataOut[offset]);
         offset += field->getNumBytes();
     }
-    return numBytes;
 }
 
 /**
- * Unpack the object data from a byte array
- * @returns The number of bytes copied
+ * Unpack field by field; generated objects override this with a copy of
+ * their data
  */
-qint32 UAVObject::unpack(const quint8* dataIn)
+void UAVObject::unpackData(const quint8* dataIn)
 {
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
@@ -297,10 +319,6 @@ qint32 UAVObject::unpack(const quint8* dataIn)
         field->unpack(&dataIn[offset]);
         offset += field->getNumBytes();
     }
-    emit objectUnpacked(this); // trigger object updated event
-    emit objectUpdated(this);
-
-    return numBytes;
 }
 
 /**
@@ -28,7 +28,14 @@
 #include "uavobjectsplugin.h"
 #include "uavobjectsinit.h"
 
-UAVObjectsPlugin::UAVObjectsPlugin()
+#ifdef WITH_TESTS
+#include "uavobjectfield.h"
+#include <QTest>
+#endif
+
+UAVObjectsPlugin::UAVObjectsPlugin() :
+    objMngr(NULL),
+    updateBus(NULL)
 {
 
 }
@@ -46,10 +53,13 @@ void UAVObjectsPlugin::extensionsInitialized()
 bool UAVObjectsPlugin::initialize(const QStringList & arguments, QString * errorString)
 {
     // Create object manager and expose object
-    UAVObjectManager* objMngr = new UAVObjectManager();
+    objMngr = new UAVObjectManager();
     addAutoReleasedObject(objMngr);
     // Initialize UAVObjects
     UAVObjectsInitialize(objMngr);
+    // Views get their updates coalesced per frame from the update bus
+    updateBus = new UAVObjectUpdateBus(objMngr);
+    addAutoReleasedObject(updateBus);
     // Done
     Q_UNUSED(arguments);
     Q_UNUSED(errorString);
@@ -60,3 +70,169 @@ void UAVObjectsPlugin::shutdown()
 {
 
 }
+
+#ifdef WITH_TESTS
+/* Packing as it was done before objects had their own routines */
+static void packFields(const QList<UAVObjectField*>& fields, quint8* dataOut)
+{
+    foreach (UAVObjectField* field, fields) {
+        field->pack(dataOut);
+        dataOut += field->getNumBytes();
+    }
+}
+
+static void unpackFields(const QList<UAVObjectField*>& fields, const quint8* dataIn)
+{
+    foreach (UAVObjectField* field, fields) {
+        field->unpack(dataIn);
+        dataIn += field->getNumBytes();
+    }
+}
+
+/* The first instance of every data object class */
+QList<UAVDataObject*> UAVObjectsPlugin::testObjects()
+{
+    QList<UAVDataObject*> objs;
+
+    foreach (const QVector<UAVDataObject*>& instances, objMngr->getDataObjectsVector()) {
+        if (!instances.isEmpty())
+            objs.append(instances.first());
+    }
+
+    return objs;
+}
+
+/* The generated routines give the same bytes as the field by field ones */
+void UAVObjectsPlugin::testPackMatchesFields()
+{
+    quint32 seed = 1;
+
+    foreach (UAVDataObject* obj, testObjects()) {
+        QList<UAVObjectField*> fields = obj->getFields();
+        QByteArray saved(obj->getNumBytes(), 0);
+        QByteArray wire(obj->getNumBytes(), 0);
+        QByteArray out(obj->getNumBytes(), 0);
+
+        obj->pack((quint8*)saved.data());
+
+        for (int i = 0; i < wire.size(); i++) {
+            seed = seed * 1103515245 + 12345;
+            wire[i] = seed >> 16;
+        }
+
+        bool blocked = obj->blockSignals(true);
+
+        obj->unpack((const quint8*)wire.constData());
+        packFields(fields, (quint8*)out.data());
+        QVERIFY2(out == wire, qPrintable(obj->getName()));
+
+        unpackFields(fields, (const quint8*)wire.constData());
+        out.fill(0);
+        obj->pack((quint8*)out.data());
+        QVERIFY2(out == wire, qPrintable(obj->getName()));
+
+        obj->unpack((const quint8*)saved.constData());
+        obj->blockSignals(blocked);
+    }
+}
+
+/* Many updates of an object within a frame reach the views once */
+void UAVObjectsPlugin::testUpdateBusCoalesces()
+{
+    QList<UAVDataObject*> objs = testObjects();
+    QVERIFY(objs.size() >= 2);
+
+    QList<UAVObject*> delivered;
+    QMetaObject::Connection conn = connect(updateBus, &UAVObjectUpdateBus::objectsUpdated,
+            [&] (const QList<UAVObject*> &objects) {
+        foreach (UAVObject* obj, objects) {
+            if (obj == objs[0] || obj == objs[1])
+                delivered.append(obj);
+        }
+    });
+
+    for (int i = 0; i < 100; i++) {
+        emit objs[1]->objectUpdated(objs[1]);
+        emit objs[0]->objectUpdated(objs[0]);
+    }
+
+    QVERIFY(delivered.isEmpty());
+    QTRY_COMPARE(delivered.size(), 2);
+    QCOMPARE(delivered[0], (UAVObject*)objs[1]);
+    QCOMPARE(delivered[1], (UAVObject*)objs[0]);
+
+    // Nothing more once the batch is out
+    QTest::qWait(3 * 1000 / updateBus->getFrameRate());
+    QCOMPARE(delivered.size(), 2);
+
+    disconnect(conn);
+}
+
+void UAVObjectsPlugin::testBenchmarkPackFields()
+{
+    QList<QList<UAVObjectField*> > fields;
+    int largest = 0;
+    foreach (UAVDataObject* obj, testObjects()) {
+        fields.append(obj->getFields());
+        largest = qMax(largest, (int)obj->getNumBytes());
+    }
+
+    QByteArray buf(largest, 0);
+
+    QBENCHMARK {
+        for (int i = 0; i < fields.size(); i++)
+            packFields(fields[i], (quint8*)buf.data());
+    }
+}
+
+void UAVObjectsPlugin::testBenchmarkPack()
+{
+    QList<UAVDataObject*> objs = testObjects();
+    int largest = 0;
+    foreach (UAVDataObject* obj, objs)
+        largest = qMax(largest, (int)obj->getNumBytes());
+
+    QByteArray buf(largest, 0);
+
+    QBENCHMARK {
+        for (int i = 0; i < objs.size(); i++)
+            objs[i]->pack((quint8*)buf.data());
+    }
+}
+
+void UAVObjectsPlugin::testBenchmarkUnpackFields()
+{
+    QList<QList<UAVObjectField*> > fields;
+    QList<QByteArray> packed;
+    foreach (UAVDataObject* obj, testObjects()) {
+        fields.append(obj->getFields());
+        packed.append(QByteArray(obj->getNumBytes(), 0));
+        obj->pack((quint8*)packed.last().data());
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < fields.size(); i++)
+            unpackFields(fields[i], (const quint8*)packed[i].constData());
+    }
+}
+
+/* Without the update signals, which cost the same either way */
+void UAVObjectsPlugin::testBenchmarkUnpack()
+{
+    QList<UAVDataObject*> objs = testObjects();
+    QList<QByteArray> packed;
+    foreach (UAVDataObject* obj, objs) {
+        packed.append(QByteArray(obj->getNumBytes(), 0));
+        obj->pack((quint8*)packed.last().data());
+        obj->blockSignals(true);
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < objs.size(); i++)
+            objs[i]->unpack((const quint8*)packed[i].constData());
+    }
+
+    foreach (UAVDataObject* obj, objs)
+        obj->blockSignals(false);
+}
+#endif
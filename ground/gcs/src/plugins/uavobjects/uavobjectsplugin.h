@@ -32,6 +32,7 @@
 #include <extensionsystem/iplugin.h>
 #include <QtPlugin>
 #include "uavobjectmanager.h"
+#include "uavobjectupdatebus.h"
 
 class UAVOBJECTS_EXPORT UAVObjectsPlugin:
         public ExtensionSystem::IPlugin
@@ -46,6 +47,22 @@ public:
     void extensionsInitialized();
     bool initialize(const QStringList & arguments, QString * errorString);
     void shutdown();
+
+private:
+    UAVObjectManager* objMngr;
+    UAVObjectUpdateBus* updateBus;
+
+#ifdef WITH_TESTS
+    QList<UAVDataObject*> testObjects();
+
+private slots:
+    void testPackMatchesFields();
+    void testUpdateBusCoalesces();
+    void testBenchmarkPackFields();
+    void testBenchmarkPack();
+    void testBenchmarkUnpackFields();
+    void testBenchmarkUnpack();
+#endif
 };
 
 #endif // UAVOBJECTSPLUGIN_H
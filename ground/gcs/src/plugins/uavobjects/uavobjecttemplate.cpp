@@ -39,6 +39,9 @@
 #include "$(NAMELC).h"
 #include "uavobjectfield.h"
 
+#include <QtEndian>
+#include <cstring>
+
 const QString $(NAME)::NAME = QString("$(NAME)");
 const QString $(NAME)::DESCRIPTION = QString("$(DESCRIPTION)");
 const QString $(NAME)::CATEGORY = QString("$(CATEGORY)");
@@ -57,6 +60,7 @@ $(FIELDSINIT)
     initializeFields(fields, (quint8*)&data, NUMBYTES);
     // Set the default field values
     setDefaultFieldValues();
+    notifiedData = data;
     // Set the object description
     setDescription(DESCRIPTION);
 
@@ -120,11 +124,40 @@ void $(NAME)::setData(const DataFields& data)
     }
 }
 
-void $(NAME)::emitNotifications()
+/**
+ * Pack the object data, which is laid out as on the wire already
+ */
+void $(NAME)::packData(quint8* dataOut)
 {
-    $(NOTIFY_PROPERTIES_CHANGED)
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    memcpy(dataOut, &data, NUMBYTES);
+#else
+$(PACK_SWAPPED)#endif
 }
 
+/**
+ * Unpack the object data, which is laid out as on the wire already
+ */
+void $(NAME)::unpackData(const quint8* dataIn)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    memcpy(&data, dataIn, NUMBYTES);
+#else
+$(UNPACK_SWAPPED)#endif
+}
+
+/**
+ * Signal the properties that changed since the last update, so that
+ * QML bindings on the others are not evaluated again
+ */
+void $(NAME)::emitNotifications()
+{
+    // Handlers may update the object again
+    DataFields oldData = notifiedData;
+    notifiedData = data;
+
+$(NOTIFY_PROPERTIES_CHANGED)}
+
 /**
  * Create a clone of this object, a new instance ID must be specified.
  * Do not use this function directly to create new instances, the
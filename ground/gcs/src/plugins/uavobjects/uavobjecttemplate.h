@@ -93,11 +93,16 @@ $(PROPERTY_SETTERS)
 signals:
 $(PROPERTY_NOTIFICATIONS)
 
+protected:
+    void packData(quint8* dataOut);
+    void unpackData(const quint8* dataIn);
+
 private slots:
     void emitNotifications();
 	
 private:
     DataFields data;
+    DataFields notifiedData; // As the property signals last reported it
 
     void setDefaultFieldValues();
 
@@ -0,0 +1,104 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectupdatebus.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Coalesces object updates into one notification per UI frame
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "uavobjectupdatebus.h"
+#include "uavobjectmanager.h"
+
+/**
+ * Watches every object registered with objMngr, now and later
+ */
+UAVObjectUpdateBus::UAVObjectUpdateBus(UAVObjectManager *objMngr, QObject *parent) :
+    QObject(parent),
+    frameRate(DEFAULT_FRAME_RATE)
+{
+    // The timer only runs while something is pending, so an idle link
+    // costs nothing and the first update of a burst waits at most a frame
+    frameTimer.setSingleShot(true);
+    frameTimer.setInterval(1000 / frameRate);
+    connect(&frameTimer, SIGNAL(timeout()), this, SLOT(deliver()));
+
+    foreach (const QVector<UAVObject*> &instances, objMngr->getObjectsVector()) {
+        foreach (UAVObject *obj, instances)
+            addObject(obj);
+    }
+
+    connect(objMngr, SIGNAL(newObject(UAVObject*)), this, SLOT(addObject(UAVObject*)));
+    connect(objMngr, SIGNAL(newInstance(UAVObject*)), this, SLOT(addObject(UAVObject*)));
+    connect(objMngr, SIGNAL(instanceRemoved(UAVObject*)), this, SLOT(removeObject(UAVObject*)));
+}
+
+/**
+ * Sets how often objectsUpdated() may be emitted
+ */
+void UAVObjectUpdateBus::setFrameRate(int hz)
+{
+    frameRate = qMax(1, hz);
+    frameTimer.setInterval(1000 / frameRate);
+}
+
+void UAVObjectUpdateBus::addObject(UAVObject *obj)
+{
+    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)),
+            Qt::UniqueConnection);
+}
+
+void UAVObjectUpdateBus::removeObject(UAVObject *obj)
+{
+    disconnect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)));
+
+    if (pendingSet.remove(obj))
+        pending.removeOne(obj);
+}
+
+void UAVObjectUpdateBus::objectUpdated(UAVObject *obj)
+{
+    if (pendingSet.contains(obj))
+        return;
+
+    pendingSet.insert(obj);
+    pending.append(obj);
+
+    if (!frameTimer.isActive())
+        frameTimer.start();
+}
+
+void UAVObjectUpdateBus::deliver()
+{
+    // Take the batch first; receivers may update objects while handling it
+    QList<UAVObject*> updated;
+    updated.swap(pending);
+    pendingSet.clear();
+
+    if (!updated.isEmpty())
+        emit objectsUpdated(updated);
+}
+
+/**
+ * @}
+ * @}
+ */
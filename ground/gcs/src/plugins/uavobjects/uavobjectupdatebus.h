@@ -0,0 +1,87 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectupdatebus.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Coalesces object updates into one notification per UI frame
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVOBJECTUPDATEBUS_H
+#define UAVOBJECTUPDATEBUS_H
+
+#include "uavobjects_global.h"
+#include <QList>
+#include <QSet>
+#include <QTimer>
+
+class UAVObject;
+class UAVObjectManager;
+
+/**
+ * Views that only show the latest value of an object (the browser, dials and
+ * the like) do not need to repaint for every sample of a fast stream.  They
+ * connect to objectsUpdated() here instead of to each object's
+ * objectUpdated(), and get at most one list per frame of the objects that
+ * were updated since the last one.
+ *
+ * Anything that needs every sample, such as logging, telemetry or the scope,
+ * keeps connecting to the objects themselves.
+ */
+class UAVOBJECTS_EXPORT UAVObjectUpdateBus : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int DEFAULT_FRAME_RATE = 60;
+
+    explicit UAVObjectUpdateBus(UAVObjectManager *objMngr, QObject *parent = 0);
+
+    void setFrameRate(int hz);
+    int getFrameRate() const { return frameRate; }
+
+signals:
+    /**
+     * The objects updated since the last frame, each listed once in the
+     * order of its first update
+     */
+    void objectsUpdated(const QList<UAVObject*> &objects);
+
+private slots:
+    void addObject(UAVObject *obj);
+    void removeObject(UAVObject *obj);
+    void objectUpdated(UAVObject *obj);
+    void deliver();
+
+private:
+    int frameRate;
+    QTimer frameTimer;
+    QList<UAVObject*> pending;
+    QSet<UAVObject*> pendingSet;
+};
+
+#endif // UAVOBJECTUPDATEBUS_H
+
+/**
+ * @}
+ * @}
+ */
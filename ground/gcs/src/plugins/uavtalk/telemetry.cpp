@@ -356,7 +356,7 @@ bool Telemetry::updateTransactionMap(UAVObject* obj, bool request)
         // Remove this transaction as it is complete.
         transInfo->timer->stop();
         transMap.remove(key);
-        delete transInfo;
+        transInfo->deleteLater();
         return true;
     }
     return false;
@@ -369,6 +369,16 @@ bool Telemetry::updateTransactionMap(UAVObject* obj, bool request)
 void Telemetry::transactionTimeout(ObjectTransactionInfo *transInfo)
 {
     transInfo->timer->stop();
+
+    // If the GUI thread was held up the reply may have arrived long ago and
+    // only be waiting behind this timer; a reply completes the transaction
+    // and drops it from transMap.  transInfo itself stays valid until we
+    // return to the event loop, as its own timer is still emitting.
+    TransactionKey key(transInfo->obj, transInfo->objRequest);
+    utalk->processPendingInput();
+    if (transMap.value(key) != transInfo)
+        return;
+
     // Check if more retries are pending
     if (transInfo->retriesRemaining > 0)
     {
@@ -410,7 +420,7 @@ void Telemetry::processObjectTransaction(ObjectTransactionInfo *transInfo)
     {
         // Stop tracking this transaction, since we're not expecting a response:
         transMap.remove(TransactionKey(transInfo->obj, transInfo->objRequest));
-        delete transInfo;
+        transInfo->deleteLater();
     }
 }
 
@@ -138,6 +138,21 @@ void UAVTalk::processInputStream()
     }
 }
 
+/**
+ * Processes whatever the device has received so far without waiting for
+ * the event loop to deliver readyRead(), for when the GUI thread was busy
+ * and a reply may be sitting unread
+ */
+void UAVTalk::processPendingInput()
+{
+    processInputStream();
+
+    // Serial ports and sockets only fill their buffers from the event loop;
+    // this polls them and handles anything new through readyRead()
+    if (io && io->isReadable())
+        io->waitForReadyRead(0);
+}
+
 void UAVTalk::dummyUDPRead()
 {
     QUdpSocket *socket=qobject_cast<QUdpSocket*>(sender());
@@ -738,12 +753,13 @@ bool UAVTalk::transmitNack(quint32 objId)
 
 
 /**
- * Send an object through the telemetry link.
- * \param[in] obj Object handle to send
+ * Frame an object for the telemetry link.
+ * \param[in] obj Object handle to frame
  * \param[in] type Transaction type
- * \return Success (true), Failure (false)
+ * \param[out] buffer Room for MAX_PACKET_LENGTH bytes
+ * \return Length of the frame, -1 on failure
  */
-bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances)
+qint32 UAVTalk::packFrame(UAVObject* obj, quint8 type, bool allInstances, quint8* buffer)
 {
     qint32 length;
     qint32 dataOffset;
@@ -753,9 +769,9 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
 
     // Setup type and object id fields
     objId = obj->getObjID();
-    txBuffer[0] = SYNC_VAL;
-    txBuffer[1] = type;
-    qToLittleEndian<quint32>(objId, &txBuffer[4]);
+    buffer[0] = SYNC_VAL;
+    buffer[1] = type;
+    qToLittleEndian<quint32>(objId, &buffer[4]);
 
     // Setup instance ID if one is required
     if ( obj->isSingleInstance() )
@@ -767,12 +783,12 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
         // Check if all instances are requested
         if (allInstances)
         {
-            qToLittleEndian<quint16>(allInstId, &txBuffer[8]);
+            qToLittleEndian<quint16>(allInstId, &buffer[8]);
         }
         else
         {
             instId = obj->getInstID();
-            qToLittleEndian<quint16>(instId, &txBuffer[8]);
+            qToLittleEndian<quint16>(instId, &buffer[8]);
         }
         dataOffset = 10;
     }
@@ -790,30 +806,64 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
     // Check length
     if (length >= MAX_PAYLOAD_LENGTH)
     {
-        return false;
+        return -1;
     }
 
     // Copy data (if any)
     if (length > 0)
     {
-        if ( !obj->pack(&txBuffer[dataOffset]) )
+        if ( !obj->pack(&buffer[dataOffset]) )
         {
-            return false;
+            return -1;
         }
     }
 
-    qToLittleEndian<quint16>(dataOffset + length, &txBuffer[2]);
+    qToLittleEndian<quint16>(dataOffset + length, &buffer[2]);
 
     // Calculate checksum
-    txBuffer[dataOffset+length] = updateCRC(0, txBuffer, dataOffset + length);
+    buffer[dataOffset+length] = updateCRC(0, buffer, dataOffset + length);
+
+    return dataOffset + length + CHECKSUM_LENGTH;
+}
+
+/**
+ * Frame an object update as transmitObject() would send it, for callers
+ * that write the same update to several links.
+ * \param[in] obj Object handle to frame
+ * \return The frame, empty on failure
+ */
+QByteArray UAVTalk::objectFrame(UAVObject* obj)
+{
+    quint8 buffer[MAX_PACKET_LENGTH];
+    qint32 size = packFrame(obj, TYPE_OBJ, false, buffer);
+
+    if (size < 0)
+        return QByteArray();
+
+    return QByteArray((const char*)buffer, size);
+}
+
+/**
+ * Send an object through the telemetry link.
+ * \param[in] obj Object handle to send
+ * \param[in] type Transaction type
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances)
+{
+    qint32 size = packFrame(obj, type, allInstances, txBuffer);
+    if (size < 0)
+    {
+        return false;
+    }
 
     // Send buffer, check that the transmit backlog does not grow above limit
     if (!io.isNull() && io->isWritable() && io->bytesToWrite() < TX_BUFFER_SIZE )
     {
-        io->write((const char*)txBuffer, dataOffset+length+CHECKSUM_LENGTH);
+        io->write((const char*)txBuffer, size);
         if(useUDPMirror)
         {
-            udpSocketRx->writeDatagram((const char*)txBuffer,dataOffset+length+CHECKSUM_LENGTH,QHostAddress::LocalHost,udpSocketTx->localPort());
+            udpSocketRx->writeDatagram((const char*)txBuffer,size,QHostAddress::LocalHost,udpSocketTx->localPort());
         }
     }
     else
@@ -824,8 +874,9 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
 
     // Update stats
     ++stats.txObjects;
-    stats.txBytes += dataOffset+length+CHECKSUM_LENGTH;
-    stats.txObjectBytes += length;
+    stats.txBytes += size;
+    if (type != TYPE_OBJ_REQ && type != TYPE_ACK)
+        stats.txObjectBytes += obj->getNumBytes();
 
     // Done
     return true;
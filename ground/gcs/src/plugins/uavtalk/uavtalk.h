@@ -68,6 +68,9 @@ public:
     void resetStats();
 
     bool processInputByte(quint8 rxbyte);
+    void processPendingInput();
+
+    static QByteArray objectFrame(UAVObject* obj);
 
 signals:
     // The only signals we send to the upper level are when we
@@ -139,8 +142,9 @@ protected:
     bool transmitNack(quint32 objId);
     bool transmitObject(UAVObject* obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances);
-    quint8 updateCRC(quint8 crc, const quint8 data);
-    quint8 updateCRC(quint8 crc, const quint8* data, qint32 length);
+    static qint32 packFrame(UAVObject* obj, quint8 type, bool allInstances, quint8* buffer);
+    static quint8 updateCRC(quint8 crc, const quint8 data);
+    static quint8 updateCRC(quint8 crc, const quint8* data, qint32 length);
 };
 
 #endif // UAVTALK_H
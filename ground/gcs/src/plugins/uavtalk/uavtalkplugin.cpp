@@ -29,6 +29,14 @@
 #include <coreplugin/icore.h>
 #include <coreplugin/connectionmanager.h>
 
+#ifdef WITH_TESTS
+#include "gyros.h"
+#include "systemstats.h"
+#include <QSignalSpy>
+#include <QTest>
+#include <QThread>
+#endif
+
 UAVTalkPlugin::UAVTalkPlugin()
 {
 
@@ -84,3 +92,82 @@ void UAVTalkPlugin::onDeviceDisconnect()
 {
     telMngr->stop();
 }
+
+#ifdef WITH_TESTS
+/* A link that only delivers what the test puts in, and never signals it */
+class LoopbackDevice : public QIODevice
+{
+public:
+    QByteArray rx;
+    QByteArray tx;
+
+    bool isSequential() const { return true; }
+    qint64 bytesAvailable() const { return rx.size() + QIODevice::bytesAvailable(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize)
+    {
+        qint64 size = qMin(maxSize, (qint64)rx.size());
+        memcpy(data, rx.constData(), size);
+        rx.remove(0, size);
+        return size;
+    }
+
+    qint64 writeData(const char *data, qint64 size)
+    {
+        tx.append(data, size);
+        return size;
+    }
+};
+
+/*
+ * The reply to a request arrives behind a saturated link while the GUI
+ * thread is blocked for longer than the request timeout, so the timer is
+ * due before the input has been read.  The reply must still complete the
+ * transaction without retries.
+ */
+void UAVTalkPlugin::testRepliesSurviveBlockedGui()
+{
+    GCSTelemetryStats *gcsStats = GCSTelemetryStats::GetInstance(objMngr);
+    SystemStats *requested = SystemStats::GetInstance(objMngr);
+    Gyros *flood = Gyros::GetInstance(objMngr);
+    QVERIFY(gcsStats && requested && flood);
+
+    // Requests are only sent on a connected link
+    GCSTelemetryStats::DataFields savedStats = gcsStats->getData();
+    GCSTelemetryStats::DataFields stats = savedStats;
+    stats.Status = GCSTelemetryStats::STATUS_CONNECTED;
+    gcsStats->setData(stats);
+
+    LoopbackDevice dev;
+    dev.open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    UAVTalk utalk(&dev, objMngr);
+    Telemetry telemetry(&utalk, objMngr);
+
+    // The flight side's traffic, framed by a UAVTalk of its own
+    LoopbackDevice remoteDev;
+    remoteDev.open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    UAVTalk remote(&remoteDev, objMngr);
+
+    QSignalSpy completed(requested, SIGNAL(transactionCompleted(UAVObject*,bool)));
+
+    requested->requestUpdate();
+    QVERIFY(!dev.tx.isEmpty());
+    QCOMPARE(completed.count(), 0);
+
+    const int backlog = 2000;
+    for (int i = 0; i < backlog; i++)
+        remote.sendObject(flood, false, false);
+    remote.sendObject(requested, false, false);
+    dev.rx = remoteDev.tx;
+
+    QThread::msleep(1000);
+
+    QTRY_COMPARE(completed.count(), 1);
+    QCOMPARE(completed.at(0).at(1).toBool(), true);
+    QCOMPARE(telemetry.getStats().txRetries, 0u);
+    QCOMPARE(telemetry.getStats().rxObjects, (quint32)backlog + 1);
+
+    gcsStats->setData(savedStats);
+}
+#endif
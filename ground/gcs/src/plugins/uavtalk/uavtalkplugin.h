@@ -56,6 +56,11 @@ protected slots:
 private:
     UAVObjectManager* objMngr;
     TelemetryManager* telMngr;
+
+#ifdef WITH_TESTS
+private slots:
+    void testRepliesSurviveBlockedGui();
+#endif
 };
 
 #endif // UAVTALKPLUGIN_H
@@ -31,23 +31,47 @@
 FilteredUavTalk::FilteredUavTalk(QIODevice *iodev, UAVObjectManager *objMngr,
                                  QHash<quint32,UavTalkRelayComon::accessType> rules,
                                  UavTalkRelayComon::accessType defaultRule) :
-    UAVTalk(iodev,objMngr),m_rules(rules),m_defaultRule(defaultRule)
+    UAVTalk(iodev,objMngr),m_rules(rules),m_defaultRule(defaultRule),m_receiving(false)
 {
+    memset(&m_relayStats, 0, sizeof(m_relayStats));
 }
 
 /**
- * @brief FilteredUavTalk::sendObjectSlot Called whenever an object is updated by
- * the local GCS and sends it to the remote GCS is the rules allow it.
- * @param obj The UAVObject to possibly send
+ * @brief FilteredUavTalk::isReadable Checks the rules for an object the master
+ * wants to relay to the remote GCS.
+ * @param objId The ID of the updated object
+ * @return True if the remote GCS may see it
  */
-void FilteredUavTalk::sendObjectSlot(UAVObject *obj)
+bool FilteredUavTalk::isReadable(quint32 objId) const
 {
-    UavTalkRelayComon::accessType access=m_rules.value(obj->getObjID(),m_defaultRule);
-    if(access==UavTalkRelayComon::WriteOnly || access==UavTalkRelayComon::None)
+    if (objId == GCSTelemetryStats::OBJID)
+        return false;
+    UavTalkRelayComon::accessType access=m_rules.value(objId,m_defaultRule);
+    return access==UavTalkRelayComon::ReadOnly || access==UavTalkRelayComon::ReadWrite;
+}
+
+/**
+ * @brief FilteredUavTalk::relayFrame Writes an object update the relay has already
+ * framed to the remote GCS.  Updates the remote GCS itself made are not echoed back,
+ * and while it has more than MAX_BACKLOG_BYTES unread new updates are dropped rather
+ * than letting the socket buffer grow without bound.
+ * @param frame The UAVTalk frame of the update
+ */
+void FilteredUavTalk::relayFrame(const QByteArray &frame)
+{
+    if (m_receiving)
+        return;
+    if (io.isNull() || !io->isWritable())
         return;
-    if(obj==GCSTelemetryStats::GetInstance(objMngr))
+
+    if (io->bytesToWrite() > MAX_BACKLOG_BYTES) {
+        ++m_relayStats.droppedFrames;
         return;
-    sendObject(obj,false,false);
+    }
+
+    io->write(frame);
+    ++m_relayStats.relayedFrames;
+    m_relayStats.relayedBytes += frame.size();
 }
 
 /**
@@ -79,12 +103,11 @@ bool FilteredUavTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
         // All instances, not allowed for OBJ messages
         if (!allInstances)
         {
-            // Get object and update its data
+            // Get object and update its data, the relay must not echo it back to us
             UAVObject* tobj = objMngr->getObject(objId);
-            bool wasCon=disconnect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
+            m_receiving = true;
             obj = updateObject(objId, instId, data);
-            if(wasCon)
-                connect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
+            m_receiving = false;
             UAVMetaObject * mobj=dynamic_cast<UAVMetaObject*>(tobj);
             if(mobj)
                 tobj->updated();
@@ -100,12 +123,11 @@ bool FilteredUavTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
         // All instances, not allowed for OBJ_ACK messages
         if (!allInstances)
         {
-            // Get object and update its data
+            // Get object and update its data, the relay must not echo it back to us
             UAVObject* tobj = objMngr->getObject(objId);
-            bool wasCon=disconnect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
+            m_receiving = true;
             obj = updateObject(objId, instId, data);
-            if(wasCon)
-                connect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
+            m_receiving = false;
             UAVMetaObject * mobj=dynamic_cast<UAVMetaObject*>(tobj);
             if(mobj)
                 tobj->updated();
@@ -40,19 +40,35 @@ class UAVTALKRELAY_EXPORT FilteredUavTalk:public UAVTalk
 {
     Q_OBJECT
 public:
+    typedef struct {
+        quint32 relayedFrames;
+        quint32 relayedBytes;
+        quint32 droppedFrames;
+    } RelayStats;
+
     FilteredUavTalk(QIODevice* iodev, UAVObjectManager* objMngr,QHash<quint32,UavTalkRelayComon::accessType> rules,UavTalkRelayComon::accessType defaultRule);
 
     //! Called when an uavtalk packet is received from the slave.  Updates master based on filtering rules
     bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length);
 
-public slots:
-    //! Called whenever an object is updated either locally in the master GCS or from the main
-    //! telemetry connection, but NOT as a consquence of the receiveObject method
-    void sendObjectSlot(UAVObject *obj);
+    //! Whether the rules let the slave see updates of this object
+    bool isReadable(quint32 objId) const;
+
+    //! Sends an update the relay framed once for all slaves, unless it came from this slave
+    //! or the slave is not keeping up
+    void relayFrame(const QByteArray &frame);
+
+    RelayStats getRelayStats() const { return m_relayStats; }
+    QIODevice *getDevice() const { return io; }
 
 private:
+    //! Frames the slave has not read yet beyond which updates are dropped
+    static const qint64 MAX_BACKLOG_BYTES = 16 * 1024;
+
     QHash<quint32,UavTalkRelayComon::accessType> m_rules;
     UavTalkRelayComon::accessType m_defaultRule;
+    bool m_receiving;
+    RelayStats m_relayStats;
 };
 
 #endif // FILTEREDUAVTALK_H
@@ -42,6 +42,13 @@ UavTalkRelay::UavTalkRelay(UAVObjectManager *ObjMngr, QString IpAdress, quint16
     }
     connect(tcpServer, SIGNAL(newConnection()), this, SLOT(newConnection()));
     qDebug()<<__FUNCTION__<<"SERVER listening on "<<tcpServer->serverAddress()<<tcpServer->serverPort();
+
+    // Every update is framed once here and fanned out to the clients
+    foreach (const QVector<UAVObject*> &instances, m_ObjMngr->getObjectsVector())
+        foreach (UAVObject *obj, instances)
+            addObject(obj);
+    connect(m_ObjMngr, SIGNAL(newObject(UAVObject*)), this, SLOT(addObject(UAVObject*)));
+    connect(m_ObjMngr, SIGNAL(newInstance(UAVObject*)), this, SLOT(addObject(UAVObject*)));
 }
 
 void UavTalkRelay::setPort(quint16 value)
@@ -81,21 +88,56 @@ void UavTalkRelay::newConnection()
     temp.unite(m_rules.value("*"));
     QPointer<FilteredUavTalk> uav=new FilteredUavTalk(clientConnection,m_ObjMngr,temp,m_DefaultRule);
     uavTalkList.append(uav);
+    connect(clientConnection, SIGNAL(disconnected()),
+            this, SLOT(clientDisconnected()));
     connect(clientConnection, SIGNAL(disconnected()),
             uav, SLOT(deleteLater()));
-    QVector< QVector<UAVObject*> > list = m_ObjMngr->getObjectsVector();
-    QVector< QVector<UAVObject*> >::const_iterator i;
-    QVector<UAVObject*>::const_iterator j;
-    int objects = 0;
-
-    const QVector< QVector<UAVObject*> >::iterator iEnd = list.end();
-    for (i = list.constBegin(); i != iEnd; ++i)
-    {
-        QVector<UAVObject*>::const_iterator jEnd = (*i).constEnd();
-        for (j = (*i).constBegin(); j != jEnd; ++j)
-        {
-            connect(*j, SIGNAL(objectUpdated(UAVObject*)), uav.data(), SLOT(sendObjectSlot(UAVObject*)));
-            objects++;
+}
+
+void UavTalkRelay::clientDisconnected()
+{
+    QTcpSocket *clientConnection = qobject_cast<QTcpSocket*>(sender());
+
+    for (int i = uavTalkList.size() - 1; i >= 0; --i) {
+        QPointer<FilteredUavTalk> uav = uavTalkList.at(i);
+        if (!uav.isNull() && uav->getDevice() != clientConnection)
+            continue;
+
+        if (!uav.isNull()) {
+            FilteredUavTalk::RelayStats stats = uav->getRelayStats();
+            qDebug()<<__FUNCTION__<<clientConnection->peerAddress().toString()<<"relayed"<<stats.relayedFrames
+                    <<"updates,"<<stats.relayedBytes<<"bytes, dropped"<<stats.droppedFrames;
+        }
+        uavTalkList.removeAt(i);
+    }
+}
+
+void UavTalkRelay::addObject(UAVObject *obj)
+{
+    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)),
+            Qt::UniqueConnection);
+}
+
+/**
+ * @brief UavTalkRelay::objectUpdated Frames an updated object once and hands the
+ * frame to every client whose rules let it read the object.
+ * @param obj The updated object
+ */
+void UavTalkRelay::objectUpdated(UAVObject *obj)
+{
+    quint32 objId = obj->getObjID();
+    QByteArray frame;
+
+    foreach (const QPointer<FilteredUavTalk> &uav, uavTalkList) {
+        if (uav.isNull() || !uav->isReadable(objId))
+            continue;
+
+        if (frame.isEmpty()) {
+            frame = UAVTalk::objectFrame(obj);
+            if (frame.isEmpty())
+                return;
         }
+
+        uav->relayFrame(frame);
     }
 }
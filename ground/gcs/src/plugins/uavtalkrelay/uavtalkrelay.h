@@ -48,6 +48,9 @@ public:
     void restartServer();
 private slots:
     void newConnection();
+    void clientDisconnected();
+    void addObject(UAVObject *obj);
+    void objectUpdated(UAVObject *obj);
 private:
     QString m_IpAddress;
     quint16 m_Port;
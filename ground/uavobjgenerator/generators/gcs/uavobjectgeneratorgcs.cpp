@@ -226,6 +226,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                                 "{\n"
                                 "   bool changed = data.%2[%5] != value;\n"
                                 "   data.%2[%5] = value;\n"
+                                "   notifiedData.%2[%5] = value;\n"
                                 "   if (changed) emit %2_%3Changed(value);\n"
                                 "}\n\n")
                         .arg(info->name).arg(field->name).arg(elementName).arg(type).arg(elementIndex);
@@ -233,8 +234,8 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                         QString("    void %1_%2Changed(%3 value);\n")
                         .arg(field->name).arg(elementName).arg(type);
                 propertyNotificationsImpl +=
-                        QString("        //if (data.%1[%2] != oldData.%1[%2])\n"
-                                "            emit %1_%3Changed(data.%1[%2]);\n")
+                        QString("    if (data.%1[%2] != oldData.%1[%2])\n"
+                                "        emit %1_%3Changed(data.%1[%2]);\n")
                         .arg(field->name).arg(elementIndex).arg(elementName);
             }
         } else {
@@ -257,6 +258,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                             "{\n"
                             "   bool changed = data.%2 != value;\n"
                             "   data.%2 = value;\n"
+                            "   notifiedData.%2 = value;\n"
                             "   if (changed) emit %2Changed(value);\n"
                             "}\n\n")
                     .arg(info->name).arg(field->name).arg(type);
@@ -264,8 +266,8 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                     QString("    void %1Changed(%2 value);\n")
                     .arg(field->name).arg(type);
             propertyNotificationsImpl +=
-                    QString("        //if (data.%1 != oldData.%1)\n"
-                            "            emit %1Changed(data.%1);\n")
+                    QString("    if (data.%1 != oldData.%1)\n"
+                            "        emit %1Changed(data.%1);\n")
                     .arg(field->name);
         }
 
@@ -363,6 +365,45 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
     }
     outCode.replace(QString("$(FIELDSINIT)"), finit);
 
+    // Replace the $(PACK_SWAPPED) and $(UNPACK_SWAPPED) tags, used where the
+    // host is big endian; the fields are laid out as on the wire, so only
+    // multi byte elements need swapping
+    QString packSwapped;
+    QString unpackSwapped;
+    int fieldOffset = 0;
+    for (int n = 0; n < info->fields.length(); ++n)
+    {
+        FieldInfo *field = info->fields[n];
+        int fieldBytes = field->numBytes * field->numElements;
+
+        if (field->numBytes == 1) {
+            packSwapped.append( QString("    memcpy(&dataOut[%1], (const quint8 *)&data + %1, %2);\n")
+                                .arg(fieldOffset).arg(fieldBytes) );
+            unpackSwapped.append( QString("    memcpy((quint8 *)&data + %1, &dataIn[%1], %2);\n")
+                                  .arg(fieldOffset).arg(fieldBytes) );
+        } else {
+            QString wordType = QString("quint%1").arg(field->numBytes * 8);
+
+            packSwapped.append( QString("    for (quint32 i = %1; i < %2; i += %3) {\n"
+                                        "        %4 value;\n"
+                                        "        memcpy(&value, (const quint8 *)&data + i, %3);\n"
+                                        "        qToLittleEndian<%4>(value, &dataOut[i]);\n"
+                                        "    }\n")
+                                .arg(fieldOffset).arg(fieldOffset + fieldBytes)
+                                .arg(field->numBytes).arg(wordType) );
+            unpackSwapped.append( QString("    for (quint32 i = %1; i < %2; i += %3) {\n"
+                                          "        %4 value = qFromLittleEndian<%4>(&dataIn[i]);\n"
+                                          "        memcpy((quint8 *)&data + i, &value, %3);\n"
+                                          "    }\n")
+                                  .arg(fieldOffset).arg(fieldOffset + fieldBytes)
+                                  .arg(field->numBytes).arg(wordType) );
+        }
+
+        fieldOffset += fieldBytes;
+    }
+    outCode.replace(QString("$(PACK_SWAPPED)"), packSwapped);
+    outCode.replace(QString("$(UNPACK_SWAPPED)"), unpackSwapped);
+
     // Replace the $(DATAFIELDINFO) tag
     QString name;
     // To be populated with the enums definition
@@ -25,9 +25,20 @@
  */
 
 #include "generator_io.h"
+#include <QFileInfo>
+#include <sys/types.h>
+#ifdef _MSC_VER
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
 
 using namespace std;
 
+// Where this run writes, and where the previous run's output can be read
+static QString currentOutput;
+static QString previousOutput;
+
 /**
  * Read a file and return its contents as a string
  */
@@ -68,12 +79,102 @@ bool writeFile(QString name, QString& str)
     return true;
 }
 
+/**
+ * Returns the bytes writeFile() would write for str
+ */
+static QByteArray encodeFile(QString& str)
+{
+    QByteArray data;
+    QTextStream fileStr(&data, QIODevice::WriteOnly);
+    fileStr << str;
+    fileStr.flush();
+    return data;
+}
+
+/**
+ * Find the file at the same place in the previous run's output.  Returns
+ * false if there is none, or if it is the very file about to be written.
+ */
+static bool findPrevious(QString name, QFileInfo& previous)
+{
+    if (previousOutput.isEmpty() || !name.startsWith(currentOutput + "/"))
+        return false;
+
+    previous = QFileInfo(previousOutput + name.mid(currentOutput.length()));
+    return previous.exists() && previous.canonicalFilePath() != QFileInfo(name).canonicalFilePath();
+}
+
+/**
+ * Returns true if the file exists and holds exactly data
+ */
+static bool fileContains(QString name, const QByteArray& data)
+{
+    QFile file(name);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    bool same = (file.readAll() == data);
+    file.close();
+    return same;
+}
+
+/**
+ * Set the modification time of a file, or make it now if time is 0
+ */
+static void setFileTime(QString name, time_t time)
+{
+    if (!time) {
+        utime(QFile::encodeName(name).constData(), NULL);
+        return;
+    }
+
+    struct utimbuf times;
+    times.actime = times.modtime = time;
+    utime(QFile::encodeName(name).constData(), &times);
+}
+
 /**
  * Write contents of string to file if the content changes
+ *
+ * The times are set against the previous run's output, which is what was
+ * last built.  A file that matches it gets its time, so make does not
+ * rebuild what depends on it.  A file that differs from it must look new,
+ * even when it is left over unchanged from an older run in this output
+ * directory: switching back to an older UAVO hash would otherwise keep
+ * objects built against the previous one.
  */
 bool writeFileIfDiffrent(QString name, QString& str)
 {
-    if (str==readFile(name,false))
+    QByteArray data = encodeFile(str);
+
+    QFileInfo previous;
+    bool hasPrevious = findPrevious(name, previous);
+    bool previousSame = hasPrevious && fileContains(previous.absoluteFilePath(), data);
+
+    if (fileContains(name, data)) {
+        if (hasPrevious && !previousSame)
+            setFileTime(name, 0);
         return true;
-    return writeFile(name,str);
+    }
+
+    QFile file(name);
+    if (!file.open(QFile::WriteOnly))
+        return false;
+    file.write(data);
+    file.close();
+
+    if (previousSame)
+        setFileTime(name, previous.lastModified().toTime_t());
+    return true;
+}
+
+/**
+ * Files written below outputPath are compared with the ones at the same
+ * place below previousPath.  The UAVO hash names the output directory, so
+ * without this every file of a new hash would look new to make.
+ */
+void setPreviousOutputPath(QString outputPath, QString previousPath)
+{
+    currentOutput = QDir(outputPath).absolutePath();
+    previousOutput = QDir(previousPath).absolutePath();
 }
@@ -38,5 +38,6 @@ QString readFile(QString name);
 QString readFile(QString name);
 bool writeFile(QString name, QString& str);
 bool writeFileIfDiffrent(QString name, QString& str);
+void setPreviousOutputPath(QString outputPath, QString previousPath);
 
 #endif
@@ -25,6 +25,7 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 #include <QtCore/QCoreApplication>
+#include <QtConcurrent/QtConcurrent>
 #include <QFile>
 #include <QString>
 #include <QStringList>
@@ -65,6 +66,28 @@ void usage() {
     cout << "\tIf no UAVObject is specified -> all are built." << endl;
 }
 
+/**
+ * An XML file parsed on its own
+ */
+struct ParsedFile {
+    UAVObjectParser* parser;
+    QString error;
+};
+
+/**
+ * Parse one XML file with a parser of its own, so that files can be
+ * parsed on several threads
+ */
+ParsedFile parseFile(const QFileInfo& fileinfo) {
+    ParsedFile result;
+    QString filename = fileinfo.fileName();
+    QString xmlstr = readFile(fileinfo.absoluteFilePath());
+
+    result.parser = new UAVObjectParser();
+    result.error = result.parser->parseXML(xmlstr, filename);
+    return result;
+}
+
 /**
  * inform user of invalid usage
  */
@@ -136,8 +159,8 @@ int main(int argc, char *argv[])
     xmlPath.setNameFilters(filters);
     QFileInfoList xmlList = xmlPath.entryInfoList();
 
-    // Read in each XML file and parse object(s) in them
-    
+    // Pick the XML files to parse
+    QFileInfoList parseList;
     for (int n = 0; n < xmlList.length(); ++n) {
         QFileInfo fileinfo = xmlList[n];
         if (!do_allObjects) {
@@ -149,18 +172,25 @@ int main(int argc, char *argv[])
         }
         if (verbose)
           cout << "Parsing XML file: " << fileinfo.fileName().toStdString() << endl;
-        QString filename = fileinfo.fileName();
-        QString xmlstr = readFile(fileinfo.absoluteFilePath());
+        parseList << fileinfo;
+    }
+
+    // Parse them in parallel, then collect the objects in file order
+    QList<ParsedFile> parsed = QtConcurrent::blockingMapped<QList<ParsedFile> >(parseList, parseFile);
 
-        QString res = parser->parseXML(xmlstr, filename);
+    for (int n = 0; n < parsed.length(); ++n) {
+        QString res = parsed[n].error;
 
         if (!res.isNull()) {
 	    if (!verbose) {
-               cout << "Error in XML file: " << fileinfo.fileName().toStdString() << endl;
+               cout << "Error in XML file: " << parseList[n].fileName().toStdString() << endl;
             }
             cout << "Error parsing " << res.toStdString() << endl;
             return RETURN_ERR_XML;
         }
+
+        parser->takeObjects(parsed[n].parser);
+        delete parsed[n].parser;
     }
 
     if (objects_stringlist.length() > 0) {
@@ -210,41 +240,61 @@ int main(int argc, char *argv[])
     if (do_none)
       return RETURN_OK;     
 
+    // Unchanged files keep the time they had in the previous output
+    QDir().mkpath(outputpath);
+    setPreviousOutputPath(outputpath, QDir::currentPath());
+
+    // The generators only read the parser, so they run in parallel
+    QList<QFuture<bool> > generators;
+
     // generate flight code if wanted
     if (do_flight|do_all) {
         cout << "generating flight code" << endl ;
-        UAVObjectGeneratorFlight flightgen;
-        flightgen.generate(parser,templatepath,outputpath);
+        generators << QtConcurrent::run([&]() {
+            UAVObjectGeneratorFlight flightgen;
+            return flightgen.generate(parser,templatepath,outputpath);
+        });
     }
 
     // generate gcs code if wanted
     if (do_gcs|do_all) {
         cout << "generating gcs code" << endl ;
-        UAVObjectGeneratorGCS gcsgen;
-        gcsgen.generate(parser,templatepath,outputpath);
+        generators << QtConcurrent::run([&]() {
+            UAVObjectGeneratorGCS gcsgen;
+            return gcsgen.generate(parser,templatepath,outputpath);
+        });
     }
 
     // generate java code if wanted
     if (do_java|do_all) {
         cout << "generating java code" << endl ;
-        UAVObjectGeneratorJava javagen;
-        javagen.generate(parser,templatepath,outputpath);
+        generators << QtConcurrent::run([&]() {
+            UAVObjectGeneratorJava javagen;
+            return javagen.generate(parser,templatepath,outputpath);
+        });
     }
 
     // generate matlab code if wanted
     if (do_matlab|do_all) {
         cout << "generating matlab code" << endl ;
-        UAVObjectGeneratorMatlab matlabgen;
-        matlabgen.generate(parser,templatepath,outputpath);
+        generators << QtConcurrent::run([&]() {
+            UAVObjectGeneratorMatlab matlabgen;
+            return matlabgen.generate(parser,templatepath,outputpath);
+        });
     }
 
     // generate wireshark plugin if wanted
     if (do_wireshark|do_all) {
         cout << "generating wireshark code" << endl ;
-        UAVObjectGeneratorWireshark wiresharkgen;
-        wiresharkgen.generate(parser,templatepath,outputpath);
+        generators << QtConcurrent::run([&]() {
+            UAVObjectGeneratorWireshark wiresharkgen;
+            return wiresharkgen.generate(parser,templatepath,outputpath);
+        });
     }
 
+    foreach (QFuture<bool> generator, generators)
+        generator.waitForFinished();
+
     bool changed = false;
 
     /* Symlink each of these to the current dir */
@@ -264,13 +314,9 @@ int main(int argc, char *argv[])
 #endif
     }
 
-    /* If anything has changed, ensure flight stuff gets rebuilt */
-    if (changed) {
-        cout << "UAVO version updated, forcing rebuild of all" << endl ;
-        QFile touch(QString("flight/uavoversion.h"));
-        /* This updates the file modification time, so make knows */
-        touch.resize(touch.size());
-    }
+    /* Files that kept their content kept their times, so make rebuilds only what changed */
+    if (changed)
+        cout << "UAVO version updated" << endl ;
 
     return RETURN_OK;
 }
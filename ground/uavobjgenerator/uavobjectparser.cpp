@@ -465,6 +465,19 @@ QString UAVObjectParser::parseXML(QString& xml, QString& filename)
     return QString();
 }
 
+/**
+ * Move the objects parsed by another parser after this one's
+ * @param other The parser to take the objects from
+ */
+void UAVObjectParser::takeObjects(UAVObjectParser* other)
+{
+    objInfo.append(other->objInfo);
+    other->objInfo.clear();
+
+    all_units.append(other->all_units);
+    all_units.removeDuplicates();
+}
+
 int UAVObjectParser::findOptionIndex(FieldInfo *field, quint32 inputIdx) {
     if (!field->parent) {
         return inputIdx;
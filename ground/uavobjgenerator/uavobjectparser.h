@@ -124,6 +124,7 @@ public:
     // Functions
     UAVObjectParser();
     QString parseXML(QString& xml, QString& filename);
+    void takeObjects(UAVObjectParser* other);
     QString resolveParents();
     void calculateAllIds();
     int getNumObjects();
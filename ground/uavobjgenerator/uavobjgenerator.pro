@@ -1,4 +1,4 @@
-QT += xml
+QT += xml concurrent
 QT -= gui
 
 macx {
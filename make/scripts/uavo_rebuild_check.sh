@@ -0,0 +1,94 @@
+#!/bin/bash
+#
+# Checks that going back to older UAVO definitions rebuilds what changed.
+#
+# The generator writes into a directory named by the UAVO hash and keeps
+# the time of every file that matches the previous run's output.  After
+# definitions A, then B, then A again, A's directory is reused as it was.
+# Every file in it that differs from B must then be newer than anything
+# built against B, while files B shares with A keep their time.
+#
+# usage: uavo_rebuild_check.sh <uavobjgenerator> <xml dir> <root dir>
+
+GENERATOR=$1
+XML_DIR=$2
+ROOT_DIR=$3
+
+# The object that is changed for B; adding a field changes the UAVO hash
+XML_FILE=picocsettings.xml
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+cp -r "$XML_DIR" "$WORK/xml"
+mkdir "$WORK/out"
+
+function generate()
+{
+  ( cd "$WORK/out" && "$GENERATOR" "$WORK/xml" "$ROOT_DIR" > /dev/null ) || exit 1
+
+  # The hash directory the flight code now links to
+  dirname "$(readlink "$WORK/out/flight")"
+}
+
+hash_a=$(generate)
+sleep 1
+
+sed -i 's|^\(\t*\)\(<field name="CyclePeriod".*\)$|\1\2\n\1<field name="RebuildCheck" units="" type="uint8" elements="1" defaultvalue="0"/>|' \
+  "$WORK/xml/$XML_FILE"
+hash_b=$(generate)
+
+# Stands in for the objects make built against B
+sleep 1
+touch "$WORK/built"
+sleep 1
+
+cp "$XML_DIR/$XML_FILE" "$WORK/xml/$XML_FILE"
+hash_back=$(generate)
+
+if [ "$hash_a" == "$hash_b" ] || [ "$hash_a" != "$hash_back" ]
+then
+  echo "Expected a new UAVO hash for B and the first one back, got $hash_a $hash_b $hash_back"
+  exit 1
+fi
+
+failed=0
+changed=0
+
+for link in "$WORK"/out/*
+do
+  [ -L "$link" ] || continue
+  tree=$(basename "$link")
+
+  for file in $(cd "$hash_a/$tree" && find . -type f -printf '%P\n')
+  do
+    if cmp -s "$hash_a/$tree/$file" "$hash_b/$tree/$file"
+    then
+      if [ "$hash_a/$tree/$file" -nt "$WORK/built" ]
+      then
+        echo "Unchanged but rebuilt: $tree/$file"
+        failed=1
+      fi
+    else
+      changed=$((changed + 1))
+      if [ ! "$hash_a/$tree/$file" -nt "$WORK/built" ]
+      then
+        echo "Changed but not rebuilt: $tree/$file"
+        failed=1
+      fi
+    fi
+  done
+done
+
+if [ $changed -eq 0 ]
+then
+  echo "Changing $XML_FILE did not change any generated file"
+  exit 1
+fi
+
+if [ $failed -ne 0 ]
+then
+  exit 1
+fi
+
+echo "Going back to older UAVO definitions rebuilds the $changed files that changed"
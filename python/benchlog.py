@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+"""
+Decodes a log both per object and columnar, compares the results and
+reports how long each took.
+
+Usage: benchlog.py [-t] [-g githash] logfile
+"""
+
+def same_column(a, b):
+    """ Compares two columns, counting NaNs in the same places as equal """
+    import numpy as np
+
+    if a.shape != b.shape:
+        return False
+
+    if a.dtype.kind == 'f':
+        nan = np.isnan(a)
+        return np.array_equal(nan, np.isnan(b)) and \
+            np.array_equal(a[~nan], b[~nan])
+
+    return np.array_equal(a, b)
+
+def main():
+    import argparse
+    import time
+
+    parser = argparse.ArgumentParser(description="Benchmark log decoding")
+
+    parser.add_argument("-t", "--timestamped",
+                        action  = 'store_false',
+                        default = True,
+                        help    = "indicate that this is not timestamped in GCS format")
+
+    parser.add_argument("-g", "--githash",
+                        action  = "store",
+                        dest    = "githash",
+                        help    = "override githash for UAVO XML definitions")
+
+    parser.add_argument("source",
+                        help  = "log file to decode")
+
+    args = parser.parse_args()
+
+    from dronin import telemetry
+
+    parse_header = args.githash is None
+
+    start = time.time()
+    with open(args.source, 'rb') as f:
+        cols = telemetry.ColumnarLog(f, parse_header=parse_header,
+            githash=args.githash, gcs_timestamps=args.timestamped)
+    columnar_time = time.time() - start
+
+    start = time.time()
+    f = open(args.source, 'rb')
+    t = telemetry.FileTelemetry(f, parse_header=parse_header,
+        githash=args.githash, gcs_timestamps=args.timestamped)
+    rows = dict((cls, t.as_numpy_array(cls)) for cls in t.uavo_defs.values())
+    per_object_time = time.time() - start
+
+    samples = 0
+    mismatched = 0
+
+    for cls, arr in rows.iteritems():
+        if len(arr) == 0:
+            continue
+
+        samples += len(arr)
+
+        # ColumnarLog finds its own class for this one by the object id
+        other = cols.as_numpy_array(cls)
+
+        if len(other) != len(arr) or any(not same_column(arr[n], other[n])
+                                         for n in arr.dtype.names):
+            print "Mismatch in %s" % (cls._name)
+            mismatched += 1
+
+    print "%d samples of %d objects" % (samples, len(cols))
+    print "per object: %.2f s" % (per_object_time)
+    print "columnar:   %.2f s (%.1fx)" % (columnar_time,
+        per_object_time / columnar_time)
+
+    if mismatched:
+        raise SystemExit(1)
+
+#-------------------------------------------------------------------------------
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,135 @@
+#!/usr/bin/env python
+"""
+Replays a log the way the GCS receives it and counts the property change
+signals the generated UAVObjects emit, signalling every property on each
+update against only the properties whose value changed.
+
+This counts signals at the source.  It says nothing about how many QML
+bindings those signals re-evaluate; that depends on the views open.
+
+Usage: benchnotify.py [-t] [-g githash] logfile
+"""
+
+# The GCS generator gives these fields no property
+RESERVED = ("Description", "Metadata")
+
+def properties(cls):
+    """ Lists (property, field, element) as the GCS generator names them """
+    props = []
+    first_field = len(cls._fields) - len(cls._num_subelems)
+
+    for i, field in enumerate(cls._fields[first_field:]):
+        if field in RESERVED:
+            continue
+
+        if cls._num_subelems[i] > 1:
+            for n, element in enumerate(cls._element_names[i]):
+                props.append((field + '_' + element, field, n))
+        else:
+            props.append((field, field, None))
+
+    return props
+
+class NotifyCounter(object):
+    """ Tracks the last value of each instance and counts the signals """
+
+    def __init__(self):
+        self.class_props = {}
+        self.last = {}
+
+        self.updates = 0
+        self.every = 0
+        self.changed = 0
+        self.first_time = None
+        self.last_time = None
+
+    def update(self, obj):
+        cls = type(obj)
+
+        if cls not in self.class_props:
+            self.class_props[cls] = [(field, element)
+                                     for prop, field, element in properties(cls)]
+
+        key = (cls, getattr(obj, 'inst_id', 0))
+        prev = self.last.get(key)
+        self.last[key] = obj
+
+        self.updates += 1
+        if self.first_time is None:
+            self.first_time = obj.time
+        self.last_time = obj.time
+
+        for field, element in self.class_props[cls]:
+            self.every += 1
+
+            # Count the first update as a change from the defaults
+            if prev is None:
+                self.changed += 1
+                continue
+
+            value = getattr(obj, field)
+            old = getattr(prev, field)
+
+            if element is not None:
+                value = value[element]
+                old = old[element]
+
+            if value != old:
+                self.changed += 1
+
+    def report(self):
+        duration = self.last_time - self.first_time if self.updates else 0
+
+        if duration <= 0:
+            print "Log has no time span to measure rates over"
+            return False
+
+        print "%d updates of %d objects over %.1f s" % (
+            self.updates, len(self.last), duration)
+        print "                 notifications/s"
+
+        for name, count in (("every property", self.every),
+                            ("changed only", self.changed)):
+            print "%-16s %15.0f" % (name, count / duration)
+
+        return True
+
+def main():
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Benchmark QML notifications")
+
+    parser.add_argument("-t", "--timestamped",
+                        action  = 'store_false',
+                        default = True,
+                        help    = "indicate that this is not timestamped in GCS format")
+
+    parser.add_argument("-g", "--githash",
+                        action  = "store",
+                        dest    = "githash",
+                        help    = "override githash for UAVO XML definitions")
+
+    parser.add_argument("source",
+                        help  = "log file to replay")
+
+    args = parser.parse_args()
+
+    from dronin import telemetry
+
+    counter = NotifyCounter()
+
+    f = open(args.source, 'rb')
+    t = telemetry.FileTelemetry(f, parse_header=args.githash is None,
+        githash=args.githash, gcs_timestamps=args.timestamped)
+
+    for obj in t:
+        # Settings are not updated at telemetry rate
+        if not obj._is_settings:
+            counter.update(obj)
+
+    if not counter.report():
+        raise SystemExit(1)
+
+#-------------------------------------------------------------------------------
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,220 @@
+"""
+Expands onboard logs written in the compact format back to UAVTalk.
+
+The firmware can store each object as small deltas from its previous sample
+(see flight/Modules/Logging/inc/logcompact.h for the layout).  Everything else
+here reads UAVTalk, so compact logs are turned into the timestamped UAVTalk
+stream the logging module would otherwise have written.
+
+Copyright (C) 2016 dRonin, http://dronin.org
+Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+"""
+
+from struct import Struct
+
+import uavtalk
+
+__all__ = [ "MAGIC", "is_compact", "expand" ]
+
+MAGIC = 'dRLC'
+VERSION = 1
+
+(REC_SCHEMA, REC_KEY, REC_RAW) = (0x80, 0x81, 0x82)
+(FLAG_SINGLE) = (0x01)
+
+# index, objid, instid, flags, length
+schema_fmt = Struct("<BLHBH")
+# index, time
+key_fmt = Struct("<BL")
+# objid, instid, flags, time, length
+raw_fmt = Struct("<LHBLH")
+word_fmt = Struct("<L")
+
+def is_compact(buf):
+    """ Whether buf, positioned after the log header, starts a compact log """
+    return buf[:len(MAGIC)] == MAGIC
+
+def _frame(obj_id, inst_id, single, time, data):
+    """ The UAVTalk frame the logging module writes for one sample """
+    header_len = uavtalk.header_fmt.size + (0 if single else 2) + 2
+
+    packet = uavtalk.header_fmt.pack(uavtalk.SYNC_VAL,
+        uavtalk.TYPE_OBJ_TS | uavtalk.TYPE_VER,
+        header_len + len(data), obj_id)
+
+    if not single:
+        packet += uavtalk.instance_fmt.pack(inst_id)
+
+    packet += uavtalk.timestamp_fmt.pack(time & 0xffff)
+    packet += data
+
+    return packet + uavtalk.calcCRC(packet)
+
+def _crc_ok(buf, start, end):
+    return end < len(buf) and uavtalk.calcCRC(buf[start:end]) == buf[end]
+
+def _varint(buf, pos):
+    value = 0
+    shift = 0
+
+    while shift < 35:
+        if pos >= len(buf):
+            return None, pos
+
+        b = ord(buf[pos])
+        pos += 1
+        value |= (b & 0x7f) << shift
+        if not b & 0x80:
+            return value, pos
+
+        shift += 7
+
+    return None, pos
+
+class _Track(object):
+    def __init__(self, obj_id, inst_id, single, length):
+        self.obj_id = obj_id
+        self.inst_id = inst_id
+        self.single = single
+        self.length = length
+        self.last = None        # None until a key frame is seen
+
+class _Expander(object):
+    def __init__(self, buf):
+        self.buf = buf
+        self.tracks = {}
+        self.time = 0
+        self.out = []
+        self.resyncs = 0
+
+    def _emit(self, track):
+        self.out.append(_frame(track.obj_id, track.inst_id, track.single,
+            self.time, track.last))
+
+    def record(self, pos, synced):
+        """ Decodes the record at pos, returning where the next one starts
+        or None if there is no good record there """
+        buf = self.buf
+        rec = ord(buf[pos])
+
+        if rec == REC_SCHEMA:
+            end = pos + 1 + schema_fmt.size
+            if not _crc_ok(buf, pos, end):
+                return None
+
+            (index, obj_id, inst_id, flags, length) = schema_fmt.unpack_from(buf, pos + 1)
+            self.tracks[index] = _Track(obj_id, inst_id, bool(flags & FLAG_SINGLE), length)
+            return end + 1
+
+        if rec == REC_KEY:
+            if pos + 1 >= len(buf):
+                return None
+
+            track = self.tracks.get(ord(buf[pos + 1]))
+            if track is None:
+                return None
+
+            data_pos = pos + 1 + key_fmt.size
+            end = data_pos + track.length
+            if not _crc_ok(buf, pos, end):
+                return None
+
+            (index, self.time) = key_fmt.unpack_from(buf, pos + 1)
+            track.last = buf[data_pos:end]
+            self._emit(track)
+            return end + 1
+
+        if rec == REC_RAW:
+            data_pos = pos + 1 + raw_fmt.size
+            if data_pos > len(buf):
+                return None
+
+            (obj_id, inst_id, flags, time, length) = raw_fmt.unpack_from(buf, pos + 1)
+            end = data_pos + length
+            if not _crc_ok(buf, pos, end):
+                return None
+
+            self.time = time
+            self.out.append(_frame(obj_id, inst_id, bool(flags & FLAG_SINGLE),
+                time, buf[data_pos:end]))
+            return end + 1
+
+        # Deltas start with a bare index, so only believe them in sync
+        track = self.tracks.get(rec)
+        if rec >= 0x80 or not synced or track is None:
+            return None
+
+        (dt, p) = _varint(buf, pos + 1)
+        if dt is None:
+            return None
+
+        words = (track.length + 3) // 4
+        bitmap = buf[p:p + (words + 7) // 8]
+        p += len(bitmap)
+
+        cur = bytearray((track.last or '').ljust(words * 4, '\0'))
+        for i in range(words):
+            if i // 8 >= len(bitmap):
+                return None
+            if not ord(bitmap[i // 8]) & (1 << (i % 8)):
+                continue
+
+            (z, p) = _varint(buf, p)
+            if z is None:
+                return None
+
+            (word,) = word_fmt.unpack_from(bytes(cur), 4 * i)
+            word = (word + ((z >> 1) ^ -(z & 1))) & 0xffffffff
+            cur[4 * i:4 * i + 4] = word_fmt.pack(word)
+
+        if not _crc_ok(buf, pos, p):
+            return None
+
+        self.time += dt
+        if track.last is not None:
+            track.last = bytes(cur[:track.length])
+            self._emit(track)
+
+        return p + 1
+
+    def run(self):
+        pos = len(MAGIC) + 1
+        synced = True
+
+        while pos < len(self.buf):
+            next_pos = self.record(pos, synced)
+
+            if next_pos is not None:
+                pos = next_pos
+                synced = True
+                continue
+
+            # Scan for a record with a good crc; deltas need a key again
+            if synced:
+                self.resyncs += 1
+                for track in self.tracks.values():
+                    track.last = None
+
+            synced = False
+            pos += 1
+
+        return ''.join(self.out)
+
+def expand(buf):
+    """ Expands a compact log, starting at its magic, into UAVTalk.
+
+    Damaged stretches are skipped; each object resumes at its next key frame.
+    """
+    if not is_compact(buf):
+        raise ValueError("not a compact log")
+
+    if ord(buf[len(MAGIC)]) != VERSION:
+        raise ValueError("unknown compact log version %d" % (ord(buf[len(MAGIC)])))
+
+    expander = _Expander(buf)
+    out = expander.run()
+
+    if expander.resyncs:
+        print "Compact log: skipped %d damaged stretches" % (expander.resyncs)
+
+    return out
@@ -10,12 +10,82 @@ import socket
 import time
 import errno
 
-import uavtalk, uavo_collection, uavo
+import uavtalk, uavo_collection, uavo, logcompact
 
 import os
 
 from abc import ABCMeta, abstractmethod
 
+def _load_uavo_defs(githash=None):
+    """ Loads the UAVO definitions for githash, or those in this tree. """
+    uavo_defs = uavo_collection.UAVOCollection()
+
+    if githash:
+        uavo_defs.from_git_hash(githash)
+    else:
+        xml_path = os.path.join(os.path.dirname(__file__), "..", "..",
+                                "shared", "uavobjectdefinition")
+        uavo_defs.from_uavo_xml_path(xml_path)
+
+    return uavo_defs
+
+def _read_log_header(f):
+    """ Reads the header the GCS writes at the start of a log file.
+
+    Returns the git hash the log is based on, and leaves f positioned at
+    the first packet.
+    """
+
+    # Check the header signature
+    #    First line is "dRonin git hash:" or "Tau Labs git hash:"
+    #    Second line is the actual git hash
+    #    Third line is the UAVO hash
+    #    Fourth line is "##"a
+
+    # Scan up to 100 "lines" looking for the signature, in case
+    # there's garbage at the beginning of the log
+    found = False
+
+    for i in range(100):
+        sig = f.readline()
+        if sig.endswith('dRonin git hash:\n') or sig.endswith('Tau Labs git hash:\n'):
+            found = True
+            break;
+
+    if not found:
+        print "Source file does not have a recognized header signature"
+        raise IOError("no header signature")
+
+    # Determine the git hash that this log file is based on
+    githash = f.readline()[:-1]
+    if githash.find(':') != -1:
+        import re
+        githash = re.search(':(\w*)\W', githash).group(1)
+
+    print "Log file is based on git hash: %s" % githash
+
+    uavohash = f.readline()
+    divider = f.readline()
+
+    return githash
+
+def _open_log_body(f):
+    """ Returns a file to read the packets after the header from.
+
+    That is f itself, or the expanded UAVTalk if the log is in the firmware's
+    compact format.
+    """
+
+    start = f.tell()
+    magic = f.read(len(logcompact.MAGIC))
+
+    if not logcompact.is_compact(magic):
+        f.seek(start)
+        return f
+
+    from cStringIO import StringIO
+    return StringIO(logcompact.expand(magic + f.read()))
+
 class TelemetryBase():
     """
     Basic (abstract) implementation of telemetry used by all stream types.
@@ -46,14 +116,7 @@ class TelemetryBase():
          - name: a filename to store into .filename for legacy purposes
         """
 
-        uavo_defs = uavo_collection.UAVOCollection()
-
-        if githash:
-            uavo_defs.from_git_hash(githash)
-        else:
-            xml_path = os.path.join(os.path.dirname(__file__), "..", "..",
-                                    "shared", "uavobjectdefinition")
-            uavo_defs.from_uavo_xml_path(xml_path)
+        uavo_defs = _load_uavo_defs(githash)
 
         self.githash = githash
 
@@ -495,36 +558,8 @@ class FileTelemetry(TelemetryBase):
         self.f = file_obj
 
         if parse_header:
-            # Check the header signature
-            #    First line is "dRonin git hash:" or "Tau Labs git hash:"
-            #    Second line is the actual git hash
-            #    Third line is the UAVO hash
-            #    Fourth line is "##"a
-
-            # Scan up to 100 "lines" looking for the signature, in case
-            # there's garbage at the beginning of the log
-            found = False
-
-            for i in range(100):
-                sig = self.f.readline()
-                if sig.endswith('dRonin git hash:\n') or sig.endswith('Tau Labs git hash:\n'):
-                    found = True
-                    break;
-
-            if not found:
-                print "Source file does not have a recognized header signature"
-                raise IOError("no header signature")
-
-            # Determine the git hash that this log file is based on
-            githash = self.f.readline()[:-1]
-            if githash.find(':') != -1:
-                import re
-                githash = re.search(':(\w*)\W', githash).group(1)
-
-            print "Log file is based on git hash: %s" % githash
-
-            uavohash = self.f.readline()
-            divider = self.f.readline()
+            githash = _read_log_header(self.f)
+            self.f = _open_log_body(self.f)
 
             TelemetryBase.__init__(self, service_in_iter=False, iter_blocks=True,
                 do_handshaking=False, githash=githash, use_walltime=False,
@@ -543,6 +578,85 @@ class FileTelemetry(TelemetryBase):
 
         return buf
 
+class ColumnarLog(dict):
+    """
+    A log file decoded in one pass into numpy arrays, one per UAVO class.
+
+    This is much faster than iterating over a FileTelemetry and creating an
+    object for every sample, which matters for long, high rate logs.  It only
+    offers the array view of the data.
+    """
+
+    def __init__(self, file_obj, parse_header=False, githash=None,
+            gcs_timestamps=False):
+        """ Reads and decodes an entire log file.
+
+         - file_obj: the file object to read from
+         - parse_header: whether to read a header like the GCS writes from the
+           file.
+         - githash: revision control id of the UAVO's used to decode, if
+           there's no header to get it from.
+         - gcs_timestamps: if true, this means we are reading from a file with
+           the GCS timestamp protocol.
+        """
+
+        dict.__init__(self)
+
+        if parse_header:
+            githash = _read_log_header(file_obj)
+            file_obj = _open_log_body(file_obj)
+
+        self.githash = githash
+        self.uavo_defs = _load_uavo_defs(githash)
+
+        self.update(uavtalk.decode_columnar(self.uavo_defs, file_obj.read(),
+            gcs_timestamps=gcs_timestamps))
+
+    def as_numpy_array(self, match_class, filter_cond=None):
+        """ Returns all received instances of a given object as a numpy array.
+
+        match_class: the UAVO_* class you'd like to match.  Classes loaded
+            elsewhere from the same definitions match by their id.
+        filter_cond: optionally, a function taking an object and returning
+            whether to keep it.
+
+        The result is the same as TelemetryBase.as_numpy_array() gives.
+        """
+
+        import numpy as np
+
+        # Get the class decoded here, which is what the arrays are keyed by
+        cls = self.uavo_defs.get('{0:08x}'.format(match_class._id))
+
+        arr = self.get(cls)
+
+        if arr is None:
+            return np.array([])
+
+        if filter_cond is not None:
+            # The condition takes objects like the other telemetry sources
+            # give, so build one for each row
+            keep = [ filter_cond(_row_to_object(cls, row)) for row in arr ]
+
+            if not any(keep):
+                return np.array([])
+
+            arr = arr[np.array(keep, dtype=bool)]
+
+        return arr
+
+def _row_to_object(cls, row):
+    """ Builds a UAVO object from one row of its numpy array. """
+    values = row.tolist()
+
+    # name, time, uavo_id and any instance id come first, then the fields
+    head = len(values) - len(cls._num_subelems)
+
+    fields = [ v[0] if n == 1 else tuple(v)
+               for v, n in zip(values[head:], cls._num_subelems) ]
+
+    return cls._make(tuple(values[:head]) + tuple(fields))
+
 def get_telemetry_by_args(desc="Process telemetry", service_in_iter=True,
         iter_blocks=True):
     """ Parses command line to decide how to get a telemetry object. """
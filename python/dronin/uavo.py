@@ -176,6 +176,18 @@ type_numpy_map = {
     'enum'    : 'uint8',
     }
 
+# Little endian, unpadded numpy types matching the wire format
+type_packed_numpy_map = {
+    'int8'    : 'i1',
+    'int16'   : '<i2',
+    'int32'   : '<i4',
+    'uint8'   : 'u1',
+    'uint16'  : '<u2',
+    'uint32'  : '<u4',
+    'float'   : '<f4',
+    'enum'    : 'u1',
+    }
+
 struct_element_map = {
     'int8'    : 'b',
     'int16'   : 'h',
@@ -338,6 +350,7 @@ def make_class(collection, xml_file, update_globals=True):
     ##### FORM A STRUCT TO PACK/UNPACK THIS UAVO'S CONTENT #####
     formats = []
     num_subelems = []
+    element_names = []
 
     is_flat = True
 
@@ -347,6 +360,8 @@ def make_class(collection, xml_file, update_globals=True):
             is_flat = False
 
         num_subelems.append(f['elements'])
+        element_names.append(f['elementnames'] or
+                             [str(n) for n in range(f['elements'])])
 
         formats.append('' + f['elements'].__str__() + struct_element_map[f['type']])
 
@@ -361,6 +376,10 @@ def make_class(collection, xml_file, update_globals=True):
     for f in fields:
         dtype += [(f['name'], '(' + `f['elements']` + ",)" + type_numpy_map[f['type']])]
 
+    # and the one that overlays the packed object data directly
+    packed_dtype = [(f['name'], type_packed_numpy_map[f['type']], (f['elements'],))
+                    for f in fields]
+
 
     ##### DYNAMICALLY CREATE A CLASS TO CONTAIN THIS OBJECT #####
     tuple_fields = ['name', 'time', 'uavo_id']
@@ -378,7 +397,9 @@ def make_class(collection, xml_file, update_globals=True):
         _id = uavo_id
         _single = is_single_inst
         _num_subelems = num_subelems
+        _element_names = element_names
         _dtype = dtype
+        _packed_dtype = packed_dtype
         _is_settings = is_settings
 
     # This is magic for two reasons.  First, we create the class to have
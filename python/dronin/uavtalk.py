@@ -17,7 +17,7 @@ except:
 
 import time
 
-__all__ = [ "send_object", "process_stream" ]
+__all__ = [ "send_object", "process_stream", "decode_columnar" ]
 
 # Constants used for UAVTalk parsing
 (MIN_HEADER_LENGTH, MAX_HEADER_LENGTH, MAX_PAYLOAD_LENGTH) = (8, 12, (256-12))
@@ -257,6 +257,163 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=False):
         if next_recv is not None and next_recv != '':
             pending_pieces.append(next_recv)
 
+def decode_columnar(uavo_defs, buf, gcs_timestamps=False,
+        segment_len=1 << 22):
+    """Decodes a whole buffer of uavtalk at once into numpy arrays.
+
+    Returns a dict mapping each UAVO class seen to a structured array with
+    the class' _dtype, the same as TelemetryBase.as_numpy_array() gives.
+    Framing, resync and timestamp handling follow process_stream(), but
+    every step is done on arrays of frame candidates instead of per byte,
+    and no per-sample objects are created.
+
+    The buffer is worked through segment_len bytes at a time, so the
+    temporaries stay a small multiple of that however long the log is."""
+
+    import numpy as np
+
+    data = np.frombuffer(buf, dtype=np.uint8)
+    log_hdr_len = logheader_fmt.size if gcs_timestamps else 0
+
+    def field(offsets, dtype):
+        """ Gathers a little endian value of the given type at each offset """
+        size = np.dtype(dtype).itemsize
+        raw = data[offsets[:, np.newaxis] + np.arange(size)]
+        return raw.copy().view('<' + np.dtype(dtype).str[1:]).reshape(-1)
+
+    # Look up each object id among the known definitions
+    classes = sorted(uavo_defs.values(), key=lambda c: c._id)
+    known_ids = np.array([c._id for c in classes], dtype=np.uint32)
+    known_sizes = np.array([c.get_size_of_data() for c in classes], dtype=np.int64)
+    known_single = np.array([bool(c._single) for c in classes])
+
+    table = np.array(crc_table, dtype=np.uint8)
+
+    # Where the next frame may start, and the timestamp unwrapping state,
+    # carried from one segment to the next
+    cursor = log_hdr_len
+    last_raw_ts = 0
+    ts_wraps = 0
+
+    pieces = {}
+
+    while cursor < len(data):
+        end = min(cursor + segment_len, len(data))
+
+        # Every sync byte that has room for a header may start a frame
+        pos = cursor + np.flatnonzero(data[cursor:end] == SYNC_VAL)
+        pos = pos[pos + header_fmt.size <= len(data)]
+
+        if len(pos) == 0:
+            cursor = end
+            continue
+
+        pack_type = data[pos + 1]
+        pack_len = field(pos + 2, np.uint16).astype(np.int64)
+        obj_id = field(pos + 4, np.uint32)
+
+        valid = (pack_type & TYPE_MASK) == TYPE_VER
+        valid &= (pack_len >= MIN_HEADER_LENGTH)
+        valid &= (pack_len <= MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH)
+        pack_type = pack_type & ~TYPE_MASK
+
+        cls_idx = np.minimum(np.searchsorted(known_ids, obj_id), len(classes) - 1)
+        known = known_ids[cls_idx] == obj_id
+
+        has_data = ~np.isin(pack_type, [TYPE_OBJ_REQ, TYPE_ACK, TYPE_NACK])
+        is_obj = known & has_data
+
+        timestamp_len = np.where(is_obj & np.isin(pack_type, [TYPE_OBJ_TS, TYPE_OBJ_ACK_TS]),
+            timestamp_fmt.size, 0)
+        obj_len = np.where(has_data,
+            np.where(known, known_sizes[cls_idx], pack_len - header_fmt.size), 0)
+        instance_len = np.where(is_obj & ~known_single[cls_idx], instance_fmt.size, 0)
+
+        calc_size = header_fmt.size + instance_len + timestamp_len + obj_len
+
+        valid &= obj_len < MAX_PAYLOAD_LENGTH
+        valid &= calc_size == pack_len
+        valid &= pos + calc_size + 1 <= len(data)
+
+        # Check the CRC of all plausible frames, a column of bytes at a time
+        # for each frame size
+        for size in np.unique(calc_size[valid]):
+            sel = np.flatnonzero(valid & (calc_size == size))
+            frame = data[pos[sel, np.newaxis] + np.arange(size + 1)].T.copy()
+            cs = np.zeros(len(sel), dtype=np.uint8)
+            for i in range(size):
+                cs = table[cs ^ frame[i]]
+            valid[sel] = cs == frame[size]
+
+        # Walk the chain of frames.  A good frame is followed by the first
+        # sync after it, a bad one by the next sync, just as process_stream
+        # resyncs.  Where the chain leaves this segment, the next one starts.
+        next_start = pos + np.where(valid, calc_size + 1, 1) + log_hdr_len
+        next_cand = np.searchsorted(pos, next_start).tolist()
+
+        path = []
+        i = 0
+        while i < len(next_cand):
+            path.append(i)
+            i = next_cand[i]
+
+        cursor = max(int(next_start[path[-1]]), end)
+
+        path = np.array(path, dtype=np.int64)
+        frames = path[valid[path] & is_obj[path]]
+
+        # Timestamps: 16 bit on-wire values are unwrapped across all
+        # timestamped frames; frames without one reuse the last value seen,
+        # as process_stream does.
+        if gcs_timestamps:
+            timestamps = field(pos[frames] - log_hdr_len, np.uint32).astype(np.int64)
+        else:
+            has_ts = timestamp_len[frames] > 0
+            ts_frames = frames[has_ts]
+            raw = field(pos[ts_frames] + header_fmt.size + instance_len[ts_frames],
+                np.uint16).astype(np.int64)
+            prev = np.concatenate(([last_raw_ts], raw[:-1]))
+            wrapped = np.cumsum(raw < prev)
+            unwrapped = raw + 65536 * (ts_wraps + wrapped)
+
+            last = np.cumsum(has_ts) - 1
+            last_raw = np.where(last >= 0, np.concatenate((raw, [0]))[last],
+                last_raw_ts)
+            timestamps = np.where(has_ts, np.concatenate((unwrapped, [0]))[last],
+                last_raw)
+
+            if len(raw):
+                last_raw_ts = raw[-1]
+                ts_wraps += wrapped[-1]
+
+        frame_cls = cls_idx[frames]
+        for idx in np.unique(frame_cls):
+            cls = classes[idx]
+            sel = np.flatnonzero(frame_cls == idx)
+            start = pos[frames[sel]]
+
+            offset = start + header_fmt.size + instance_len[frames[sel]] + \
+                timestamp_len[frames[sel]]
+            payload = data[offset[:, np.newaxis] + np.arange(cls.get_size_of_data())]
+            values = payload.view(np.dtype(cls._packed_dtype)).reshape(-1)
+
+            out = np.zeros(len(sel), dtype=cls._dtype)
+            out['name'] = cls._name
+            out['time'] = timestamps[sel] / 1000.0
+            out['uavo_id'] = cls._id
+
+            if not cls._single:
+                out['inst_id'] = field(start + header_fmt.size, np.uint16)
+
+            # Widening a signalling NaN is not worth a warning
+            with np.errstate(invalid='ignore'):
+                for name in values.dtype.names:
+                    out[name] = values[name].reshape(out[name].shape)
+
+            pieces.setdefault(cls, []).append(out)
+
+    return dict((cls, np.concatenate(arrs)) for cls, arrs in pieces.items())
+
 def send_object(obj):
     """Generates a string containing a UAVTalk packet describing this object"""
 
@@ -0,0 +1,138 @@
+#!/usr/bin/env python
+"""
+Feeds sensor frames to the simulation target built with
+SIM_SENSOR_INJECTION=YES, in the format of
+flight/PiOS.posix/inc/sim_sensor_frame.h.
+
+Without a simulator attached this sends a vehicle sitting level, or rocking
+about roll with -r, which is enough to exercise the sensor and attitude
+processing at full rate.  Other feeds can reuse SensorFrameSender.
+
+Usage: simbridge.py [-H host] [-p port] [-R rate] [-b batch] [-r amplitude]
+"""
+
+import math
+import socket
+import struct
+import time
+
+FRAME_MAGIC = 0x46535264
+FRAME_VERSION = 1
+FRAME_MAX_SAMPLES = 16
+
+VALID_GYRO = 1 << 0
+VALID_ACCEL = 1 << 1
+VALID_MAG = 1 << 2
+VALID_BARO = 1 << 3
+
+header_fmt = struct.Struct('<IBBHI')
+sample_fmt = struct.Struct('<IB3x3f3f3fff')
+
+GRAVITY = 9.81
+
+class SensorFrameSender(object):
+    """ Batches samples into frames and sends them over UDP """
+
+    def __init__(self, host, port, batch):
+        if batch < 1 or batch > FRAME_MAX_SAMPLES:
+            raise ValueError("batch must be 1 to %d samples" % FRAME_MAX_SAMPLES)
+
+        self.address = (host, port)
+        self.batch = batch
+        self.sequence = 0
+        self.pending = []
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+
+    def add(self, time_us, valid, gyro, accel, mag, baro_altitude, temperature):
+        """ Queue one sample, the frame goes out once the batch is full """
+        self.pending.append(sample_fmt.pack(time_us & 0xffffffff, valid,
+            *(tuple(gyro) + tuple(accel) + tuple(mag) + (baro_altitude, temperature))))
+
+        if len(self.pending) >= self.batch:
+            self.flush()
+
+    def flush(self):
+        if not self.pending:
+            return
+
+        header = header_fmt.pack(FRAME_MAGIC, FRAME_VERSION, len(self.pending),
+                0, self.sequence & 0xffffffff)
+        self.sock.sendto(header + b''.join(self.pending), self.address)
+
+        self.sequence += 1
+        self.pending = []
+
+def main():
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Send simulated sensor frames")
+
+    parser.add_argument("-H", "--host",
+                        action  = "store",
+                        default = "127.0.0.1",
+                        help    = "address the simulation listens on")
+
+    parser.add_argument("-p", "--port",
+                        action  = "store",
+                        type    = int,
+                        default = 9004,
+                        help    = "port the simulation listens on")
+
+    parser.add_argument("-R", "--rate",
+                        action  = "store",
+                        type    = float,
+                        default = 1000.0,
+                        help    = "gyro and accel sample rate in Hz")
+
+    parser.add_argument("-b", "--batch",
+                        action  = "store",
+                        type    = int,
+                        default = 8,
+                        help    = "samples per datagram")
+
+    parser.add_argument("-r", "--rock",
+                        action  = "store",
+                        type    = float,
+                        default = 0.0,
+                        help    = "roll amplitude in degrees, rocking at 0.5 Hz")
+
+    args = parser.parse_args()
+
+    sender = SensorFrameSender(args.host, args.port, args.batch)
+
+    period = 1.0 / args.rate
+    # Mag and baro come at rates like real parts
+    mag_every = max(1, int(round(args.rate / 75)))
+    baro_every = max(1, int(round(args.rate / 50)))
+
+    start = time.time()
+    n = 0
+
+    while True:
+        t = n * period
+
+        roll = math.radians(args.rock) * math.sin(math.pi * t)
+        roll_rate = math.degrees(math.radians(args.rock) * math.pi * math.cos(math.pi * t))
+
+        valid = VALID_GYRO | VALID_ACCEL
+        if n % mag_every == 0:
+            valid |= VALID_MAG
+        if n % baro_every == 0:
+            valid |= VALID_BARO
+
+        sender.add(int(t * 1e6), valid,
+                (roll_rate, 0.0, 0.0),
+                (0.0, -GRAVITY * math.sin(roll), -GRAVITY * math.cos(roll)),
+                (400.0, 400.0 * math.sin(roll), 400.0 * math.cos(roll)),
+                100.0, 25.0)
+
+        n += 1
+
+        # Send a batch ahead of when its first sample is due, the flight side
+        # paces the samples by their timestamps
+        ahead = start + (n - args.batch) * period - time.time()
+        if ahead > 0:
+            time.sleep(ahead)
+
+if __name__ == "__main__":
+    main()
@@ -1,5 +1,143 @@
 #!/usr/bin/env python
 
+def decode_per_packet(uavo_defs, buf, gcs_timestamps):
+    """ Decodes buf through process_stream into one array per class """
+    import numpy as np
+    from dronin import uavtalk
+
+    import sys
+    from cStringIO import StringIO
+
+    parser = uavtalk.process_stream(uavo_defs, gcs_timestamps=gcs_timestamps)
+    parser.send(None)
+
+    objs = []
+
+    # process_stream reports every bad frame on stdout; keep that quiet.
+    # The whole log is buffered, so this drains every frame in it.
+    stdout = sys.stdout
+    sys.stdout = StringIO()
+
+    try:
+        obj = parser.send(buf)
+        while obj:
+            objs.append(obj)
+            obj = parser.send('')
+    finally:
+        sys.stdout = stdout
+
+    decoded = {}
+
+    for obj in objs:
+        decoded.setdefault(type(obj), []).append(obj)
+
+    return dict((cls, np.array(l, dtype=cls._dtype))
+                for cls, l in decoded.iteritems())
+
+def make_log(uavo_defs, gcs_timestamps):
+    """ Builds a log of random objects.
+
+    Logs without GCS timestamps get some corruption mixed in.  With GCS
+    timestamps, process_stream takes the timestamp after a bad frame from
+    whatever follows it, where decode_columnar uses the record header, so
+    those are only compared clean.
+    """
+    import random
+    import struct
+    from dronin import uavtalk
+
+    rnd = random.Random(1)
+
+    names = [ 'Gyros', 'Accels', 'AttitudeActual', 'ActuatorCommand',
+              'Waypoint', 'FlightStatus' ]
+    classes = [ uavo_defs.find_by_name(n) for n in names ]
+
+    pieces = []
+    time_ms = 0
+
+    for i in range(20000):
+        cls = classes[i % len(classes)]
+        time_ms += rnd.randint(0, 40)
+
+        body = ''
+        pack_type = uavtalk.TYPE_OBJ
+
+        if not cls._single:
+            body += struct.pack('<H', i % 3)
+
+        if not gcs_timestamps and rnd.random() < 0.8:
+            body += uavtalk.timestamp_fmt.pack(time_ms & 0xffff)
+            pack_type = uavtalk.TYPE_OBJ_TS
+
+        body += ''.join(chr(rnd.getrandbits(8))
+                        for _ in range(cls.get_size_of_data()))
+
+        packet = uavtalk.header_fmt.pack(uavtalk.SYNC_VAL,
+            pack_type | uavtalk.TYPE_VER,
+            uavtalk.header_fmt.size + len(body), cls._id) + body
+        packet += uavtalk.calcCRC(packet)
+
+        damage = 1.0 if gcs_timestamps else rnd.random()
+
+        if damage < 0.005:
+            # Bad CRC
+            packet = packet[:-1] + chr(ord(packet[-1]) ^ 1)
+        elif damage < 0.01:
+            # Garbage that starts like a frame
+            packet = chr(uavtalk.SYNC_VAL) + '\x20garbage' + packet
+
+        if gcs_timestamps:
+            packet = uavtalk.logheader_fmt.pack(time_ms, len(packet)) + packet
+
+        pieces.append(packet)
+
+    return ''.join(pieces)
+
+def same_column(a, b):
+    """ Compares two columns, counting NaNs in the same places as equal """
+    import numpy as np
+
+    if a.shape != b.shape:
+        return False
+
+    if a.dtype.kind == 'f':
+        nan = np.isnan(a)
+        return np.array_equal(nan, np.isnan(b)) and \
+            np.array_equal(a[~nan], b[~nan])
+
+    return np.array_equal(a, b)
+
+def test_columnar(uavo_defs):
+    """ Checks decode_columnar against the per packet decoder """
+    from dronin import uavtalk
+
+    failed = False
+
+    for gcs_timestamps in (False, True):
+        buf = make_log(uavo_defs, gcs_timestamps)
+
+        expected = decode_per_packet(uavo_defs, buf, gcs_timestamps)
+
+        # One segment, and frames straddling many segment boundaries
+        for segment_len in (len(buf), 4096):
+            decoded = uavtalk.decode_columnar(uavo_defs, buf,
+                gcs_timestamps=gcs_timestamps, segment_len=segment_len)
+
+            if set(expected) != set(decoded):
+                print "columnar: decoded a different set of objects"
+                failed = True
+                continue
+
+            for cls, arr in expected.iteritems():
+                for name in arr.dtype.names:
+                    if not same_column(arr[name], decoded[cls][name]):
+                        print "columnar: %s.%s differs (gcs_timestamps=%s, " \
+                            "segment_len=%d)" % (cls._name, name,
+                            gcs_timestamps, segment_len)
+                        failed = True
+
+    return not failed
+
 def main():
 
     # Load the UAVO xml files in the workspace
@@ -7,6 +145,9 @@ def main():
     uavo_defs = dronin.uavo_collection.UAVOCollection()
     uavo_defs.from_uavo_xml_path('shared/uavobjectdefinition')
 
+    if not test_columnar(uavo_defs):
+        raise SystemExit(1)
+
 #-------------------------------------------------------------------------------
 if __name__ == "__main__":
     main()